@@ -6,7 +6,11 @@
 
 //#include "gl_core_4.2.h"
 
+// Wrap the GL entry points to gather per-frame call statistics (see gl_trace.h).
+//#define GL_LOADER_INSTRUMENTED
+
 #include <GL/glew.h>
+#include <gl_loader/gl_trace.h>
 
 
 bool glInitLibrary();
@@ -0,0 +1,103 @@
+// Per-frame statistics for the GL calls the engine makes, available when the loader is
+// built with GL_LOADER_INSTRUMENTED (see gl_loader.h).
+//
+// The instrumented loader wraps each entry point it knows about: GLEW's function pointers
+// are swapped for wrappers once they've been loaded, and the GL 1.1 functions (which are
+// called directly) are redirected to wrappers by macros below. Each wrapper counts the call,
+// times it, and for binds and state sets checks it against the last value set to flag calls
+// which change nothing.
+//
+// Without GL_LOADER_INSTRUMENTED the functions here do nothing and the reports are empty,
+// so callers needn't check.
+
+#if ! defined(GL_TRACE)
+#define GL_TRACE
+
+#include <string>
+
+#if defined(GL_LOADER_INSTRUMENTED)
+
+// Close the current frame's statistics, adding them to the running totals.
+void glTraceEndFrame();
+
+// The calls made in the last complete frame, most expensive first: for each function the
+// number of calls, how many of those were redundant, and the CPU time spent in them.
+std::string glTraceFrameReport();
+
+// The calls made per frame on average since the last reset, and a histogram of the CPU time
+// each frame spent in the driver.
+std::string glTraceRunningReport();
+
+void glTraceReset();
+
+// Swap GLEW's function pointers for the wrappers; called by glInitLibrary once they're loaded.
+void glTraceInstall();
+
+#if ! defined(GL_TRACE_IMPLEMENTATION)
+
+void GLAPIENTRY glTraceBindTexture(GLenum target, GLuint texture);
+void GLAPIENTRY glTraceClear(GLbitfield mask);
+void GLAPIENTRY glTraceClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+void GLAPIENTRY glTraceClearDepth(GLclampd depth);
+void GLAPIENTRY glTraceColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+void GLAPIENTRY glTraceCullFace(GLenum mode);
+void GLAPIENTRY glTraceDeleteTextures(GLsizei n, const GLuint* textures);
+void GLAPIENTRY glTraceDepthFunc(GLenum func);
+void GLAPIENTRY glTraceDepthMask(GLboolean flag);
+void GLAPIENTRY glTraceDisable(GLenum cap);
+void GLAPIENTRY glTraceDrawArrays(GLenum mode, GLint first, GLsizei count);
+void GLAPIENTRY glTraceDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+void GLAPIENTRY glTraceEnable(GLenum cap);
+void GLAPIENTRY glTraceFrontFace(GLenum mode);
+void GLAPIENTRY glTraceGenTextures(GLsizei n, GLuint* textures);
+GLenum GLAPIENTRY glTraceGetError();
+void GLAPIENTRY glTraceGetIntegerv(GLenum pname, GLint* params);
+const GLubyte* GLAPIENTRY glTraceGetString(GLenum name);
+void GLAPIENTRY glTracePixelStorei(GLenum pname, GLint param);
+void GLAPIENTRY glTracePolygonMode(GLenum face, GLenum mode);
+void GLAPIENTRY glTraceReadBuffer(GLenum mode);
+void GLAPIENTRY glTraceReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels);
+void GLAPIENTRY glTraceTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels);
+void GLAPIENTRY glTraceTexParameteri(GLenum target, GLenum pname, GLint param);
+void GLAPIENTRY glTraceTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+void GLAPIENTRY glTraceViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#define glBindTexture glTraceBindTexture
+#define glClear glTraceClear
+#define glClearColor glTraceClearColor
+#define glClearDepth glTraceClearDepth
+#define glColorMask glTraceColorMask
+#define glCullFace glTraceCullFace
+#define glDeleteTextures glTraceDeleteTextures
+#define glDepthFunc glTraceDepthFunc
+#define glDepthMask glTraceDepthMask
+#define glDisable glTraceDisable
+#define glDrawArrays glTraceDrawArrays
+#define glDrawElements glTraceDrawElements
+#define glEnable glTraceEnable
+#define glFrontFace glTraceFrontFace
+#define glGenTextures glTraceGenTextures
+#define glGetError glTraceGetError
+#define glGetIntegerv glTraceGetIntegerv
+#define glGetString glTraceGetString
+#define glPixelStorei glTracePixelStorei
+#define glPolygonMode glTracePolygonMode
+#define glReadBuffer glTraceReadBuffer
+#define glReadPixels glTraceReadPixels
+#define glTexImage2D glTraceTexImage2D
+#define glTexParameteri glTraceTexParameteri
+#define glTexSubImage2D glTraceTexSubImage2D
+#define glViewport glTraceViewport
+
+#endif // GL_TRACE_IMPLEMENTATION
+
+#else
+
+inline void glTraceEndFrame() {}
+inline std::string glTraceFrameReport() { return std::string(); }
+inline std::string glTraceRunningReport() { return std::string(); }
+inline void glTraceReset() {}
+
+#endif // GL_LOADER_INSTRUMENTED
+
+#endif // GL_TRACE
@@ -15,6 +15,13 @@ bool glInitLibrary()
   {
     initialised = true;
   }
+
+#if defined(GL_LOADER_INSTRUMENTED)
+  if (initialised)
+  {
+    glTraceInstall();
+  }
+#endif
 #endif
 
   return initialised;
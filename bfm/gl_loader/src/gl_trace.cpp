@@ -0,0 +1,559 @@
+#define GL_TRACE_IMPLEMENTATION
+#include <gl_loader/gl_loader.h>
+
+#if defined(GL_LOADER_INSTRUMENTED)
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <SDL.h>
+
+//------------------------------------------------------------------------
+
+// The entry points wrapped. GL_TRACE_CORE(return type, name, parameters, arguments, check)
+// for GL 1.1 functions, which are called directly; GL_TRACE_GLEW(return type, name, pointer
+// type, parameters, arguments, check) for those GLEW loads. The check is evaluated before the
+// call, and is true if it would change nothing. Add a line here to trace another function.
+#define GL_TRACE_FUNCTIONS \
+  GL_TRACE_CORE(void, BindTexture, (GLenum target, GLuint texture), (target, texture), shadow.BindTexture(target, texture)) \
+  GL_TRACE_CORE(void, Clear, (GLbitfield mask), (mask), false) \
+  GL_TRACE_CORE(void, ClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha), shadow.Same(Slot::ClearColour, 0, 0, red, green, blue, alpha)) \
+  GL_TRACE_CORE(void, ClearDepth, (GLclampd depth), (depth), shadow.Same(Slot::ClearDepth, 0, 0, depth)) \
+  GL_TRACE_CORE(void, ColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha), shadow.Same(Slot::ColourMask, 0, 0, red, green, blue, alpha)) \
+  GL_TRACE_CORE(void, CullFace, (GLenum mode), (mode), shadow.Same(Slot::CullFace, 0, 0, mode)) \
+  GL_TRACE_CORE(void, DeleteTextures, (GLsizei n, const GLuint* textures), (n, textures), shadow.Forget(Slot::Texture)) \
+  GL_TRACE_CORE(void, DepthFunc, (GLenum func), (func), shadow.Same(Slot::DepthFunction, 0, 0, func)) \
+  GL_TRACE_CORE(void, DepthMask, (GLboolean flag), (flag), shadow.Same(Slot::DepthMask, 0, 0, flag)) \
+  GL_TRACE_CORE(void, Disable, (GLenum cap), (cap), shadow.Same(Slot::Capability, cap, 0, GLboolean(GL_FALSE))) \
+  GL_TRACE_CORE(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), false) \
+  GL_TRACE_CORE(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices), (mode, count, type, indices), false) \
+  GL_TRACE_CORE(void, Enable, (GLenum cap), (cap), shadow.Same(Slot::Capability, cap, 0, GLboolean(GL_TRUE))) \
+  GL_TRACE_CORE(void, FrontFace, (GLenum mode), (mode), shadow.Same(Slot::FrontFace, 0, 0, mode)) \
+  GL_TRACE_CORE(void, GenTextures, (GLsizei n, GLuint* textures), (n, textures), false) \
+  GL_TRACE_CORE(GLenum, GetError, (), (), false) \
+  GL_TRACE_CORE(void, GetIntegerv, (GLenum pname, GLint* params), (pname, params), false) \
+  GL_TRACE_CORE(const GLubyte*, GetString, (GLenum name), (name), false) \
+  GL_TRACE_CORE(void, PixelStorei, (GLenum pname, GLint param), (pname, param), shadow.Same(Slot::PixelStore, pname, 0, param)) \
+  GL_TRACE_CORE(void, PolygonMode, (GLenum face, GLenum mode), (face, mode), shadow.Same(Slot::PolygonMode, face, 0, mode)) \
+  GL_TRACE_CORE(void, ReadBuffer, (GLenum mode), (mode), false) \
+  GL_TRACE_CORE(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels), (x, y, width, height, format, type, pixels), false) \
+  GL_TRACE_CORE(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels), (target, level, internalformat, width, height, border, format, type, pixels), false) \
+  GL_TRACE_CORE(void, TexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param), false) \
+  GL_TRACE_CORE(void, TexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels), false) \
+  GL_TRACE_CORE(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), shadow.Same(Slot::Viewport, 0, 0, x, y, GLint(width), GLint(height))) \
+  \
+  GL_TRACE_GLEW(void, ActiveTexture, PFNGLACTIVETEXTUREPROC, (GLenum texture), (texture), shadow.ActiveTexture(texture)) \
+  GL_TRACE_GLEW(void, BindBuffer, PFNGLBINDBUFFERPROC, (GLenum target, GLuint buffer), (target, buffer), shadow.Same(Slot::Buffer, target, 0, buffer)) \
+  GL_TRACE_GLEW(void, BindBufferBase, PFNGLBINDBUFFERBASEPROC, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), shadow.BindBufferRange(target, index, buffer, 0, 0)) \
+  GL_TRACE_GLEW(void, BindBufferRange, PFNGLBINDBUFFERRANGEPROC, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size), shadow.BindBufferRange(target, index, buffer, offset, size)) \
+  GL_TRACE_GLEW(void, BindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, (GLenum target, GLuint framebuffer), (target, framebuffer), shadow.BindFramebuffer(target, framebuffer)) \
+  GL_TRACE_GLEW(void, BindRenderbuffer, PFNGLBINDRENDERBUFFERPROC, (GLenum target, GLuint renderbuffer), (target, renderbuffer), shadow.Same(Slot::Renderbuffer, target, 0, renderbuffer)) \
+  GL_TRACE_GLEW(void, BindSampler, PFNGLBINDSAMPLERPROC, (GLuint unit, GLuint sampler), (unit, sampler), shadow.Same(Slot::Sampler, unit, 0, sampler)) \
+  GL_TRACE_GLEW(void, BindVertexArray, PFNGLBINDVERTEXARRAYPROC, (GLuint array), (array), shadow.BindVertexArray(array)) \
+  GL_TRACE_GLEW(void, BlendEquationSeparate, PFNGLBLENDEQUATIONSEPARATEPROC, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha), shadow.Same(Slot::BlendEquation, 0, 0, modeRGB, modeAlpha)) \
+  GL_TRACE_GLEW(void, BlendFuncSeparate, PFNGLBLENDFUNCSEPARATEPROC, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha), shadow.Same(Slot::BlendFunction, 0, 0, sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha)) \
+  GL_TRACE_GLEW(void, BufferData, PFNGLBUFFERDATAPROC, (GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage), (target, size, data, usage), false) \
+  GL_TRACE_GLEW(void, BufferStorage, PFNGLBUFFERSTORAGEPROC, (GLenum target, GLsizeiptr size, const GLvoid* data, GLbitfield flags), (target, size, data, flags), false) \
+  GL_TRACE_GLEW(void, BufferSubData, PFNGLBUFFERSUBDATAPROC, (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data), (target, offset, size, data), false) \
+  GL_TRACE_GLEW(GLenum, CheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC, (GLenum target), (target), false) \
+  GL_TRACE_GLEW(GLenum, ClientWaitSync, PFNGLCLIENTWAITSYNCPROC, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout), false) \
+  GL_TRACE_GLEW(void, DeleteBuffers, PFNGLDELETEBUFFERSPROC, (GLsizei n, const GLuint* buffers), (n, buffers), shadow.Forget(Slot::Buffer) || shadow.Forget(Slot::IndexedBuffer)) \
+  GL_TRACE_GLEW(void, DeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), shadow.Forget(Slot::Framebuffer)) \
+  GL_TRACE_GLEW(void, DeleteQueries, PFNGLDELETEQUERIESPROC, (GLsizei n, const GLuint* ids), (n, ids), false) \
+  GL_TRACE_GLEW(void, DeleteProgram, PFNGLDELETEPROGRAMPROC, (GLuint program), (program), shadow.DeleteProgram(program)) \
+  GL_TRACE_GLEW(void, DeleteRenderbuffers, PFNGLDELETERENDERBUFFERSPROC, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), shadow.Forget(Slot::Renderbuffer)) \
+  GL_TRACE_GLEW(void, DeleteSamplers, PFNGLDELETESAMPLERSPROC, (GLsizei count, const GLuint* samplers), (count, samplers), shadow.Forget(Slot::Sampler) || shadow.Forget(Slot::SamplerParameter)) \
+  GL_TRACE_GLEW(void, DeleteSync, PFNGLDELETESYNCPROC, (GLsync sync), (sync), false) \
+  GL_TRACE_GLEW(void, DeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC, (GLsizei n, const GLuint* arrays), (n, arrays), shadow.Forget(Slot::VertexArray) || shadow.Forget(Slot::Buffer, GL_ELEMENT_ARRAY_BUFFER)) \
+  GL_TRACE_GLEW(void, DrawArraysInstancedBaseInstance, PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount, GLuint baseinstance), (mode, first, count, instancecount, baseinstance), false) \
+  GL_TRACE_GLEW(void, DrawElementsBaseVertex, PFNGLDRAWELEMENTSBASEVERTEXPROC, (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLint basevertex), (mode, count, type, indices, basevertex), false) \
+  GL_TRACE_GLEW(void, EnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC, (GLuint index), (index), false) \
+  GL_TRACE_GLEW(GLsync, FenceSync, PFNGLFENCESYNCPROC, (GLenum condition, GLbitfield flags), (condition, flags), false) \
+  GL_TRACE_GLEW(void, FramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer), false) \
+  GL_TRACE_GLEW(void, FramebufferTexture2D, PFNGLFRAMEBUFFERTEXTURE2DPROC, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level), false) \
+  GL_TRACE_GLEW(void, GenBuffers, PFNGLGENBUFFERSPROC, (GLsizei n, GLuint* buffers), (n, buffers), false) \
+  GL_TRACE_GLEW(void, GenFramebuffers, PFNGLGENFRAMEBUFFERSPROC, (GLsizei n, GLuint* framebuffers), (n, framebuffers), false) \
+  GL_TRACE_GLEW(void, GenQueries, PFNGLGENQUERIESPROC, (GLsizei n, GLuint* ids), (n, ids), false) \
+  GL_TRACE_GLEW(void, GenRenderbuffers, PFNGLGENRENDERBUFFERSPROC, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers), false) \
+  GL_TRACE_GLEW(void, GenSamplers, PFNGLGENSAMPLERSPROC, (GLsizei count, GLuint* samplers), (count, samplers), false) \
+  GL_TRACE_GLEW(void, GenVertexArrays, PFNGLGENVERTEXARRAYSPROC, (GLsizei n, GLuint* arrays), (n, arrays), false) \
+  GL_TRACE_GLEW(void, GenerateMipmap, PFNGLGENERATEMIPMAPPROC, (GLenum target), (target), false) \
+  GL_TRACE_GLEW(void, GetActiveUniformName, PFNGLGETACTIVEUNIFORMNAMEPROC, (GLuint program, GLuint uniformIndex, GLsizei bufSize, GLsizei* length, GLchar* uniformName), (program, uniformIndex, bufSize, length, uniformName), false) \
+  GL_TRACE_GLEW(void, GetActiveUniformsiv, PFNGLGETACTIVEUNIFORMSIVPROC, (GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname, GLint* params), (program, uniformCount, uniformIndices, pname, params), false) \
+  GL_TRACE_GLEW(void, GetQueryObjectiv, PFNGLGETQUERYOBJECTIVPROC, (GLuint id, GLenum pname, GLint* params), (id, pname, params), false) \
+  GL_TRACE_GLEW(void, GetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params), false) \
+  GL_TRACE_GLEW(void, GetProgramiv, PFNGLGETPROGRAMIVPROC, (GLuint program, GLenum pname, GLint* params), (program, pname, params), false) \
+  GL_TRACE_GLEW(GLuint, GetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC, (GLuint program, const GLchar* uniformBlockName), (program, uniformBlockName), false) \
+  GL_TRACE_GLEW(GLint, GetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC, (GLuint program, const GLchar* name), (program, name), false) \
+  GL_TRACE_GLEW(GLvoid*, MapBufferRange, PFNGLMAPBUFFERRANGEPROC, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access), false) \
+  GL_TRACE_GLEW(void, PrimitiveRestartIndex, PFNGLPRIMITIVERESTARTINDEXPROC, (GLuint index), (index), shadow.Same(Slot::PrimitiveRestartIndex, 0, 0, index)) \
+  GL_TRACE_GLEW(void, ProgramUniform1iv, PFNGLPROGRAMUNIFORM1IVPROC, (GLuint program, GLint location, GLsizei count, const GLint* value), (program, location, count, value), shadow.Uniform(program, location, value, count * sizeof(GLint))) \
+  GL_TRACE_GLEW(void, ProgramUniform1uiv, PFNGLPROGRAMUNIFORM1UIVPROC, (GLuint program, GLint location, GLsizei count, const GLuint* value), (program, location, count, value), shadow.Uniform(program, location, value, count * sizeof(GLuint))) \
+  GL_TRACE_GLEW(void, ProgramUniform1fv, PFNGLPROGRAMUNIFORM1FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), shadow.Uniform(program, location, value, count * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniform2fv, PFNGLPROGRAMUNIFORM2FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 2 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniform3fv, PFNGLPROGRAMUNIFORM3FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 3 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniform4fv, PFNGLPROGRAMUNIFORM4FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 4 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniform1dv, PFNGLPROGRAMUNIFORM1DVPROC, (GLuint program, GLint location, GLsizei count, const GLdouble* value), (program, location, count, value), shadow.Uniform(program, location, value, count * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniform2dv, PFNGLPROGRAMUNIFORM2DVPROC, (GLuint program, GLint location, GLsizei count, const GLdouble* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 2 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniform3dv, PFNGLPROGRAMUNIFORM3DVPROC, (GLuint program, GLint location, GLsizei count, const GLdouble* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 3 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniform4dv, PFNGLPROGRAMUNIFORM4DVPROC, (GLuint program, GLint location, GLsizei count, const GLdouble* value), (program, location, count, value), shadow.Uniform(program, location, value, count * 4 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix2fv, PFNGLPROGRAMUNIFORMMATRIX2FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 4 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix3fv, PFNGLPROGRAMUNIFORMMATRIX3FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 9 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix4fv, PFNGLPROGRAMUNIFORMMATRIX4FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 16 * sizeof(GLfloat))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix2dv, PFNGLPROGRAMUNIFORMMATRIX2DVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLdouble* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 4 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix3dv, PFNGLPROGRAMUNIFORMMATRIX3DVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLdouble* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 9 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, ProgramUniformMatrix4dv, PFNGLPROGRAMUNIFORMMATRIX4DVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLdouble* value), (program, location, count, transpose, value), shadow.Uniform(program, location, value, count * 16 * sizeof(GLdouble))) \
+  GL_TRACE_GLEW(void, QueryCounter, PFNGLQUERYCOUNTERPROC, (GLuint id, GLenum target), (id, target), false) \
+  GL_TRACE_GLEW(void, RenderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height), false) \
+  GL_TRACE_GLEW(void, SamplerParameteri, PFNGLSAMPLERPARAMETERIPROC, (GLuint sampler, GLenum pname, GLint param), (sampler, pname, param), shadow.Same(Slot::SamplerParameter, sampler, pname, param)) \
+  GL_TRACE_GLEW(void, TexStorage2D, PFNGLTEXSTORAGE2DPROC, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height), false) \
+  GL_TRACE_GLEW(void, TexStorage3D, PFNGLTEXSTORAGE3DPROC, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (target, levels, internalformat, width, height, depth), false) \
+  GL_TRACE_GLEW(void, TexSubImage3D, PFNGLTEXSUBIMAGE3DPROC, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid* pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels), false) \
+  GL_TRACE_GLEW(void, UniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding), false) \
+  GL_TRACE_GLEW(GLboolean, UnmapBuffer, PFNGLUNMAPBUFFERPROC, (GLenum target), (target), false) \
+  GL_TRACE_GLEW(void, UseProgram, PFNGLUSEPROGRAMPROC, (GLuint program), (program), shadow.UseProgram(program)) \
+  GL_TRACE_GLEW(void, VertexAttribDivisor, PFNGLVERTEXATTRIBDIVISORPROC, (GLuint index, GLuint divisor), (index, divisor), false) \
+  GL_TRACE_GLEW(void, VertexAttribIPointer, PFNGLVERTEXATTRIBIPOINTERPROC, (GLuint index, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer), (index, size, type, stride, pointer), false) \
+  GL_TRACE_GLEW(void, VertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer), (index, size, type, normalized, stride, pointer), false)
+
+//------------------------------------------------------------------------
+
+namespace Function
+{
+  enum Enum
+  {
+#define GL_TRACE_CORE(type, name, parameters, arguments, check) name,
+#define GL_TRACE_GLEW(type, name, pointer, parameters, arguments, check) name,
+    GL_TRACE_FUNCTIONS
+#undef GL_TRACE_CORE
+#undef GL_TRACE_GLEW
+    Count
+  };
+
+  static const char* const names[] =
+  {
+#define GL_TRACE_CORE(type, name, parameters, arguments, check) "gl" #name,
+#define GL_TRACE_GLEW(type, name, pointer, parameters, arguments, check) "gl" #name,
+    GL_TRACE_FUNCTIONS
+#undef GL_TRACE_CORE
+#undef GL_TRACE_GLEW
+  };
+}
+
+//------------------------------------------------------------------------
+
+// Pieces of GL state whose last value is kept, each indexed by up to two numbers (a target
+// and binding index, say).
+struct Slot
+{
+  enum Enum
+  {
+    ActiveTexture, Texture, Sampler, SamplerParameter,
+    Buffer, IndexedBuffer, VertexArray, Program, Uniform,
+    Framebuffer, Renderbuffer,
+    Capability, ColourMask, DepthMask, DepthFunction, CullFace, FrontFace, PolygonMode,
+    BlendFunction, BlendEquation, ClearColour, ClearDepth, Viewport, PixelStore,
+    PrimitiveRestartIndex
+  };
+};
+
+//------------------------------------------------------------------------
+
+// The last value set for each piece of state tracked, so that calls setting the same value
+// again can be flagged. Nothing is known to start with, so the first call setting a value
+// is never flagged.
+class Shadow
+{
+public:
+  Shadow() : activeTexture(GL_TEXTURE0) {}
+
+  // True if the value is the one last set for a slot; records it otherwise.
+  bool SameBytes(Slot::Enum slot, GLuint a, GLuint b, const void* value, size_t size);
+
+  template <typename T> bool Same(Slot::Enum slot, GLuint a, GLuint b, T x)
+  {
+    return SameBytes(slot, a, b, &x, sizeof(x));
+  }
+
+  template <typename T> bool Same(Slot::Enum slot, GLuint a, GLuint b, T x, T y)
+  {
+    const T values[] = { x, y };
+    return SameBytes(slot, a, b, values, sizeof(values));
+  }
+
+  template <typename T> bool Same(Slot::Enum slot, GLuint a, GLuint b, T x, T y, T z, T w)
+  {
+    const T values[] = { x, y, z, w };
+    return SameBytes(slot, a, b, values, sizeof(values));
+  }
+
+  // Forget the values kept for a slot, as when objects which may be bound are deleted.
+  // Returns false so that it can stand as the check for a call.
+  bool Forget(Slot::Enum slot);
+  bool Forget(Slot::Enum slot, GLuint a);
+
+  // State which affects, or is affected by, other state.
+  bool ActiveTexture(GLenum unit);
+  bool BindTexture(GLenum target, GLuint texture);
+  bool BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+  bool BindFramebuffer(GLenum target, GLuint framebuffer);
+  bool BindVertexArray(GLuint array);
+  bool UseProgram(GLuint program);
+  bool DeleteProgram(GLuint program);
+  bool Uniform(GLuint program, GLint location, const void* value, size_t size);
+
+private:
+  struct Key
+  {
+    Key(Slot::Enum slot, GLuint a, GLuint b) : slot(slot), a(a), b(b) {}
+
+    bool operator<(const Key& other) const
+    {
+      if (slot != other.slot) { return slot < other.slot; }
+      if (a != other.a)       { return a < other.a; }
+      return b < other.b;
+    }
+
+    Slot::Enum slot;
+    GLuint a;
+    GLuint b;
+  };
+
+  typedef std::map<Key, std::vector<unsigned char> > Values;
+
+  void Erase(const Key& first, const Key& last);
+
+  Values values;
+  GLenum activeTexture;
+};
+
+//------------------------------------------------------------------------
+
+struct Counter
+{
+  unsigned int calls;
+  unsigned int redundant;
+  Uint64 ticks;
+};
+
+// Buckets of the driver time histogram: the first is frames under HistogramFirstMS, each
+// after that double the one before, and the last everything above.
+static const unsigned int HistogramBuckets = 10;
+static const double HistogramFirstMS = 0.125;
+
+static Counter frameCounters[Function::Count];
+static Counter lastFrameCounters[Function::Count];
+static Counter totalCounters[Function::Count];
+static unsigned int framesCounted = 0;
+static unsigned int histogram[HistogramBuckets];
+static Shadow shadow;
+
+//------------------------------------------------------------------------
+
+// Counts and times a call for as long as it's in scope.
+class Call
+{
+public:
+  Call(Function::Enum function, bool redundant)
+    : counter(frameCounters[function]), start(SDL_GetPerformanceCounter())
+  {
+    ++counter.calls;
+    if (redundant)
+    {
+      ++counter.redundant;
+    }
+  }
+
+  ~Call()
+  {
+    counter.ticks += SDL_GetPerformanceCounter() - start;
+  }
+
+private:
+  Call& operator=(const Call&);
+
+  Counter& counter;
+  const Uint64 start;
+};
+
+//------------------------------------------------------------------------
+
+// The wrappers: those for GL 1.1 functions are called in place of them by gl_trace.h's
+// macros, the others replace GLEW's function pointers (see glTraceInstall).
+#define GL_TRACE_CORE(type, name, parameters, arguments, check) \
+  type GLAPIENTRY glTrace##name parameters \
+  { \
+    const Call call(Function::name, check); \
+    return gl##name arguments; \
+  }
+#define GL_TRACE_GLEW(type, name, pointer, parameters, arguments, check) \
+  static pointer real##name = NULL; \
+  static type GLAPIENTRY Trace##name parameters \
+  { \
+    const Call call(Function::name, check); \
+    return real##name arguments; \
+  }
+GL_TRACE_FUNCTIONS
+#undef GL_TRACE_CORE
+#undef GL_TRACE_GLEW
+
+//------------------------------------------------------------------------
+
+static double TicksToMS(double ticks);
+static void AppendTable(std::string& report, const Counter* const counters, double frames);
+
+//------------------------------------------------------------------------
+
+void glTraceInstall()
+{
+#define GL_TRACE_CORE(type, name, parameters, arguments, check)
+#define GL_TRACE_GLEW(type, name, pointer, parameters, arguments, check) \
+  real##name = __glew##name; \
+  if (NULL != real##name) { __glew##name = Trace##name; }
+  GL_TRACE_FUNCTIONS
+#undef GL_TRACE_CORE
+#undef GL_TRACE_GLEW
+}
+
+//------------------------------------------------------------------------
+
+void glTraceEndFrame()
+{
+  Uint64 ticks = 0;
+  for (unsigned int f = 0; f < Function::Count; ++f)
+  {
+    totalCounters[f].calls += frameCounters[f].calls;
+    totalCounters[f].redundant += frameCounters[f].redundant;
+    totalCounters[f].ticks += frameCounters[f].ticks;
+    ticks += frameCounters[f].ticks;
+  }
+
+  std::memcpy(lastFrameCounters, frameCounters, sizeof(frameCounters));
+  std::memset(frameCounters, 0, sizeof(frameCounters));
+
+  unsigned int bucket = 0;
+  for (double limit = HistogramFirstMS; (bucket < (HistogramBuckets - 1)) && (TicksToMS(double(ticks)) >= limit); limit *= 2.0)
+  {
+    ++bucket;
+  }
+  ++histogram[bucket];
+  ++framesCounted;
+}
+
+//------------------------------------------------------------------------
+
+std::string glTraceFrameReport()
+{
+  std::string report("GL calls in the last frame\n");
+  AppendTable(report, lastFrameCounters, 1.0);
+  return report;
+}
+
+//------------------------------------------------------------------------
+
+std::string glTraceRunningReport()
+{
+  if (0 == framesCounted)
+  {
+    return std::string();
+  }
+
+  char line[128];
+  sprintf(line, "GL calls per frame, averaged over %u frames\n", framesCounted);
+  std::string report(line);
+  AppendTable(report, totalCounters, double(framesCounted));
+
+  unsigned int most = 0;
+  for (unsigned int bucket = 0; bucket < HistogramBuckets; ++bucket)
+  {
+    most = std::max(most, histogram[bucket]);
+  }
+
+  static const unsigned int BarLength = 50;
+  report += "driver time per frame\n";
+  double limit = HistogramFirstMS;
+  for (unsigned int bucket = 0; bucket < HistogramBuckets; ++bucket, limit *= 2.0)
+  {
+    const bool last = ((HistogramBuckets - 1) == bucket);
+    sprintf(line, "  %s %8.3fms %8u", last ? ">=" : "< ", last ? (limit / 2.0) : limit, histogram[bucket]);
+    report += line;
+    if (histogram[bucket] > 0)
+    {
+      report += " ";
+      report.append((histogram[bucket] * BarLength) / most, '#');
+    }
+    report += "\n";
+  }
+
+  return report;
+}
+
+//------------------------------------------------------------------------
+
+void glTraceReset()
+{
+  std::memset(totalCounters, 0, sizeof(totalCounters));
+  std::memset(histogram, 0, sizeof(histogram));
+  framesCounted = 0;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::SameBytes(Slot::Enum slot, GLuint a, GLuint b, const void* value, size_t size)
+{
+  const unsigned char* const bytes = static_cast<const unsigned char*>(value);
+  std::vector<unsigned char>& last = values[Key(slot, a, b)];
+  if ((last.size() == size) && ((0 == size) || (0 == std::memcmp(&last[0], bytes, size))))
+  {
+    return !last.empty();
+  }
+
+  last.assign(bytes, bytes + size);
+  return false;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::Forget(Slot::Enum slot)
+{
+  Erase(Key(slot, 0, 0), Key(slot, ~0u, ~0u));
+  return false;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::Forget(Slot::Enum slot, GLuint a)
+{
+  Erase(Key(slot, a, 0), Key(slot, a, ~0u));
+  return false;
+}
+
+//------------------------------------------------------------------------
+
+void Shadow::Erase(const Key& first, const Key& last)
+{
+  values.erase(values.lower_bound(first), values.upper_bound(last));
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::ActiveTexture(GLenum unit)
+{
+  const bool same = Same(Slot::ActiveTexture, 0, 0, unit);
+  activeTexture = unit;
+  return same;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::BindTexture(GLenum target, GLuint texture)
+{
+  return Same(Slot::Texture, activeTexture, target, texture);
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+  // Binding to an index binds the target too, so both are checked (and recorded)...
+  const GLintptr range[] = { GLintptr(buffer), offset, GLintptr(size) };
+  const bool sameTarget = Same(Slot::Buffer, target, 0, buffer);
+  const bool sameIndex = SameBytes(Slot::IndexedBuffer, target, index, range, sizeof(range));
+  return sameTarget && sameIndex;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+  if (GL_FRAMEBUFFER != target)
+  {
+    return Same(Slot::Framebuffer, target, 0, framebuffer);
+  }
+
+  const bool sameDraw = Same(Slot::Framebuffer, GL_DRAW_FRAMEBUFFER, 0, framebuffer);
+  const bool sameRead = Same(Slot::Framebuffer, GL_READ_FRAMEBUFFER, 0, framebuffer);
+  return sameDraw && sameRead;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::BindVertexArray(GLuint array)
+{
+  if (Same(Slot::VertexArray, 0, 0, array))
+  {
+    return true;
+  }
+
+  // The element array binding belongs to the vertex array...
+  Forget(Slot::Buffer, GL_ELEMENT_ARRAY_BUFFER);
+  return false;
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::UseProgram(GLuint program)
+{
+  return Same(Slot::Program, 0, 0, program);
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::DeleteProgram(GLuint program)
+{
+  Forget(Slot::Program);
+  return Forget(Slot::Uniform, program);
+}
+
+//------------------------------------------------------------------------
+
+bool Shadow::Uniform(GLuint program, GLint location, const void* value, size_t size)
+{
+  return (location >= 0) && SameBytes(Slot::Uniform, program, GLuint(location), value, size);
+}
+
+//------------------------------------------------------------------------
+
+static double TicksToMS(double ticks)
+{
+  return (ticks * 1000.0) / double(SDL_GetPerformanceFrequency());
+}
+
+//------------------------------------------------------------------------
+
+// Append a line for each function called, most time first, with its counts divided by the
+// number of frames they cover.
+static void AppendTable(std::string& report, const Counter* const counters, double frames)
+{
+  std::vector<std::pair<Uint64, unsigned int> > order;
+  Counter total = { 0, 0, 0 };
+  for (unsigned int f = 0; f < Function::Count; ++f)
+  {
+    if (counters[f].calls > 0)
+    {
+      order.push_back(std::make_pair(counters[f].ticks, f));
+      total.calls += counters[f].calls;
+      total.redundant += counters[f].redundant;
+      total.ticks += counters[f].ticks;
+    }
+  }
+  std::sort(order.rbegin(), order.rend());
+
+  char line[128];
+  sprintf(line, "  %-36s %10s %10s %10s\n", "function", "calls", "redundant", "ms");
+  report += line;
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    const Counter& counter = counters[order[i].second];
+    sprintf(line, "  %-36s %10.1f %10.1f %10.3f\n", Function::names[order[i].second],
+      counter.calls / frames, counter.redundant / frames, TicksToMS(double(counter.ticks)) / frames);
+    report += line;
+  }
+  sprintf(line, "  %-36s %10.1f %10.1f %10.3f\n", "total",
+    total.calls / frames, total.redundant / frames, TicksToMS(double(total.ticks)) / frames);
+  report += line;
+}
+
+#endif // GL_LOADER_INSTRUMENTED
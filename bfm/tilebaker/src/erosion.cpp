@@ -0,0 +1,283 @@
+#include <cmath>
+#include <cstdio>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include "erosion.h"
+
+//----------------------------------------------------------------------
+
+// Cells along the edge of a tile. Must be more than twice a droplet's halo so that tiles
+// of the same colour stay apart.
+static const unsigned int TileSize = 256;
+
+//----------------------------------------------------------------------
+
+struct Tile
+{
+  unsigned int x;   // in tiles
+  unsigned int y;
+};
+
+//----------------------------------------------------------------------
+
+// What every tile job needs to know.
+struct ErosionContext
+{
+  float* heights;
+  unsigned int size;
+  Erosion::Parameters parameters;
+  unsigned int halo;              // cells beyond its tile a droplet can reach
+  unsigned int seed;
+  unsigned int round;
+  const std::vector<Tile>* tiles; // those of the colour being processed
+};
+
+//----------------------------------------------------------------------
+
+static boost::uint32_t Hash(boost::uint32_t x);
+static void HydraulicTiles(const ErosionContext& context, size_t begin, size_t end);
+static void ThermalTiles(const ErosionContext& context, size_t begin, size_t end);
+static void RunDroplet(const ErosionContext& context, float x, float y, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY);
+static float HeightAndGradient(const ErosionContext& context, float x, float y, float& gradientX, float& gradientY);
+static void AddBilinear(const ErosionContext& context, unsigned int x, unsigned int y, float fx, float fy, float amount);
+
+//----------------------------------------------------------------------
+
+void Erosion::Erode(std::vector<float>& heights, unsigned int size, const Parameters& parameters, WorkerPool& workers, unsigned int seed)
+{
+  ErosionContext context;
+  context.heights = &heights[0];
+  context.size = size;
+  context.parameters = parameters;
+  context.seed = seed;
+  context.round = 0;
+
+  // A droplet moves at most one cell per step, and changes the cells either side of where
+  // it is...
+  const unsigned int maxLifetime = (TileSize / 2) - 3;
+  if (context.parameters.maxLifetime > maxLifetime)
+  {
+    std::printf("droplet lifetime limited to %u steps\n", maxLifetime);
+    context.parameters.maxLifetime = maxLifetime;
+  }
+  context.halo = context.parameters.maxLifetime + 2;
+
+  // The tiles of each colour...
+  const unsigned int tilesPerEdge = (size + TileSize - 1) / TileSize;
+  std::vector<Tile> colours[4];
+  for (unsigned int y = 0; y < tilesPerEdge; ++y)
+  {
+    for (unsigned int x = 0; x < tilesPerEdge; ++x)
+    {
+      const Tile tile = { x, y };
+      colours[(x & 1) + ((y & 1) * 2)].push_back(tile);
+    }
+  }
+
+  for (context.round = 0; context.round < context.parameters.rounds; ++context.round)
+  {
+    for (unsigned int colour = 0; colour < 4; ++colour)
+    {
+      context.tiles = &colours[colour];
+      workers.ParallelFor(colours[colour].size(), boost::bind(HydraulicTiles, boost::cref(context), _1, _2));
+    }
+  }
+
+  for (unsigned int i = 0; i < context.parameters.thermalIterations; ++i)
+  {
+    for (unsigned int colour = 0; colour < 4; ++colour)
+    {
+      context.tiles = &colours[colour];
+      workers.ParallelFor(colours[colour].size(), boost::bind(ThermalTiles, boost::cref(context), _1, _2));
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Integer hash (Wellons' "lowbias32").
+static boost::uint32_t Hash(boost::uint32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+//----------------------------------------------------------------------
+
+static void HydraulicTiles(const ErosionContext& context, size_t begin, size_t end)
+{
+  for (size_t t = begin; t < end; ++t)
+  {
+    const Tile& tile = (*context.tiles)[t];
+
+    // Droplets start inside the tile and may wander into its halo. Bilinear lookups read
+    // one cell beyond a droplet's position, so it stays short of the map's far edges...
+    const unsigned int tileX = tile.x * TileSize;
+    const unsigned int tileY = tile.y * TileSize;
+    const unsigned int tileWidth = ((tileX + TileSize) < context.size) ? TileSize : (context.size - tileX);
+    const unsigned int tileHeight = ((tileY + TileSize) < context.size) ? TileSize : (context.size - tileY);
+    const unsigned int minX = (tileX > context.halo) ? (tileX - context.halo) : 0;
+    const unsigned int minY = (tileY > context.halo) ? (tileY - context.halo) : 0;
+    const unsigned int maxX = ((tileX + tileWidth + context.halo) < (context.size - 1)) ? (tileX + tileWidth + context.halo) : (context.size - 1);
+    const unsigned int maxY = ((tileY + tileHeight + context.halo) < (context.size - 1)) ? (tileY + tileHeight + context.halo) : (context.size - 1);
+
+    // Each tile's droplets come from its own sequence, whichever thread runs it...
+    boost::uint32_t random = Hash(context.seed ^ Hash(tile.x ^ Hash(tile.y ^ Hash(context.round))));
+    const float droplets = (context.parameters.dropletsPerCell * tileWidth * tileHeight) / context.parameters.rounds;
+    for (unsigned int i = 0; i < (unsigned int)(droplets + 0.5f); ++i)
+    {
+      random = Hash(random);
+      const float x = tileX + ((random & 0xFFFF) * (tileWidth / 65536.0f));
+      const float y = tileY + ((random >> 16) * (tileHeight / 65536.0f));
+      if ((x < (context.size - 1)) && (y < (context.size - 1)))
+      {
+        RunDroplet(context, x, y, minX, minY, maxX, maxY);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Follow a droplet downhill until it evaporates, stops or leaves the region it may change.
+static void RunDroplet(const ErosionContext& context, float x, float y, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY)
+{
+  const Erosion::Parameters& p = context.parameters;
+
+  float directionX = 0.0f;
+  float directionY = 0.0f;
+  float speed = 1.0f;
+  float water = 1.0f;
+  float sediment = 0.0f;
+
+  for (unsigned int step = 0; step < p.maxLifetime; ++step)
+  {
+    const unsigned int cellX = (unsigned int)x;
+    const unsigned int cellY = (unsigned int)y;
+    const float fx = x - cellX;
+    const float fy = y - cellY;
+
+    float gradientX, gradientY;
+    const float height = HeightAndGradient(context, x, y, gradientX, gradientY);
+
+    // Turn downhill, keeping some of the old direction...
+    directionX = (directionX * p.inertia) - (gradientX * (1.0f - p.inertia));
+    directionY = (directionY * p.inertia) - (gradientY * (1.0f - p.inertia));
+    const float length = std::sqrt((directionX * directionX) + (directionY * directionY));
+    if (length < 1e-6f)
+    {
+      break;  // in a pit or on a flat; nowhere to go
+    }
+    directionX /= length;
+    directionY /= length;
+
+    x += directionX;
+    y += directionY;
+    if ((x < minX) || (y < minY) || (x >= maxX) || (y >= maxY))
+    {
+      break;
+    }
+
+    float unused[2];
+    const float heightChange = HeightAndGradient(context, x, y, unused[0], unused[1]) - height;
+
+    // Going uphill or carrying more than it can hold, the droplet drops sediment where it
+    // was; otherwise it picks more up, never digging deeper than the drop it just made...
+    const float capacity = ((-heightChange > p.minSlope) ? -heightChange : p.minSlope) * speed * water * p.capacity;
+    if ((sediment > capacity) || (heightChange > 0.0f))
+    {
+      const float amount = (heightChange > 0.0f) ? ((heightChange < sediment) ? heightChange : sediment) : ((sediment - capacity) * p.depositSpeed);
+      sediment -= amount;
+      AddBilinear(context, cellX, cellY, fx, fy, amount);
+    }
+    else
+    {
+      const float wanted = (capacity - sediment) * p.erodeSpeed;
+      const float amount = (wanted < -heightChange) ? wanted : -heightChange;
+      sediment += amount;
+      AddBilinear(context, cellX, cellY, fx, fy, -amount);
+    }
+
+    const float speedSquared = (speed * speed) - (heightChange * p.gravity);
+    speed = (speedSquared > 0.0f) ? std::sqrt(speedSquared) : 0.0f;
+    water *= 1.0f - p.evaporateSpeed;
+  }
+}
+
+//----------------------------------------------------------------------
+
+static float HeightAndGradient(const ErosionContext& context, float x, float y, float& gradientX, float& gradientY)
+{
+  const unsigned int cellX = (unsigned int)x;
+  const unsigned int cellY = (unsigned int)y;
+  const float fx = x - cellX;
+  const float fy = y - cellY;
+
+  const float* const h = &context.heights[cellX + (cellY * context.size)];
+  const float h00 = h[0];
+  const float h10 = h[1];
+  const float h01 = h[context.size];
+  const float h11 = h[context.size + 1];
+
+  gradientX = ((h10 - h00) * (1.0f - fy)) + ((h11 - h01) * fy);
+  gradientY = ((h01 - h00) * (1.0f - fx)) + ((h11 - h10) * fx);
+
+  return (((h00 * (1.0f - fx)) + (h10 * fx)) * (1.0f - fy)) + (((h01 * (1.0f - fx)) + (h11 * fx)) * fy);
+}
+
+//----------------------------------------------------------------------
+
+static void AddBilinear(const ErosionContext& context, unsigned int x, unsigned int y, float fx, float fy, float amount)
+{
+  float* const h = &context.heights[x + (y * context.size)];
+  h[0] += amount * (1.0f - fx) * (1.0f - fy);
+  h[1] += amount * fx * (1.0f - fy);
+  h[context.size] += amount * (1.0f - fx) * fy;
+  h[context.size + 1] += amount * fx * fy;
+}
+
+//----------------------------------------------------------------------
+
+// One iteration of thermal erosion over each tile: wherever a cell stands more than the
+// talus above its lowest neighbour, part of the excess slides down onto it.
+static void ThermalTiles(const ErosionContext& context, size_t begin, size_t end)
+{
+  const int size = int(context.size);
+  const float talus = context.parameters.talus;
+  const float rate = context.parameters.thermalRate * 0.5f;
+
+  for (size_t t = begin; t < end; ++t)
+  {
+    const Tile& tile = (*context.tiles)[t];
+    const int tileX = int(tile.x * TileSize);
+    const int tileY = int(tile.y * TileSize);
+    const int endX = ((tileX + int(TileSize)) < size) ? (tileX + int(TileSize)) : size;
+    const int endY = ((tileY + int(TileSize)) < size) ? (tileY + int(TileSize)) : size;
+
+    for (int y = tileY; y < endY; ++y)
+    {
+      for (int x = tileX; x < endX; ++x)
+      {
+        float* const h = &context.heights[x + (y * size)];
+
+        float* lowest = NULL;
+        float lowestHeight = *h - talus;
+        if ((x > 0) && (h[-1] < lowestHeight))                { lowest = &h[-1]; lowestHeight = *lowest; }
+        if ((x < (size - 1)) && (h[1] < lowestHeight))        { lowest = &h[1]; lowestHeight = *lowest; }
+        if ((y > 0) && (h[-size] < lowestHeight))             { lowest = &h[-size]; lowestHeight = *lowest; }
+        if ((y < (size - 1)) && (h[size] < lowestHeight))     { lowest = &h[size]; lowestHeight = *lowest; }
+
+        if (lowest)
+        {
+          const float amount = ((*h - lowestHeight) - talus) * rate;
+          *h -= amount;
+          *lowest += amount;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ Hydraulic and thermal erosion of a square heightmap, run across all CPU cores.
+
+ Hydraulic erosion simulates individual water droplets (Beyer, "Implementation of a method
+ for hydraulic erosion", 2015): each runs downhill picking up sediment where it speeds up
+ and dropping it where it slows, carving channels and filling valleys. Thermal erosion then
+ slumps any slope steeper than the angle of repose.
+
+ The map is split into tiles, each with a halo as wide as a droplet can travel. Tiles are
+ processed in four colours by the parity of their coordinates, so any two tiles running at
+ once are a whole tile apart and their halos never meet: tiles change the shared map
+ directly with no locking, and the result does not depend on the number of threads.
+
+ Heights are in units of the map's cell spacing, so slopes are simple differences.
+ */
+
+#if ! defined(__EROSION__)
+#define __EROSION__
+
+#include <vector>
+#include <core/workerpool.h>
+
+namespace Erosion
+{
+  struct Parameters
+  {
+    Parameters()
+      : dropletsPerCell(0.5f),
+        rounds(4),
+        maxLifetime(30),
+        inertia(0.05f),
+        capacity(4.0f),
+        minSlope(0.01f),
+        depositSpeed(0.3f),
+        erodeSpeed(0.3f),
+        evaporateSpeed(0.01f),
+        gravity(4.0f),
+        thermalIterations(8),
+        talus(0.7f),
+        thermalRate(0.5f)
+    {
+    }
+
+    // Hydraulic erosion...
+    float dropletsPerCell;        // droplets started per map cell, over all rounds
+    unsigned int rounds;          // passes over the four colours, spreading the droplets out
+    unsigned int maxLifetime;     // steps of one cell a droplet takes at most
+    float inertia;                // how much a droplet keeps its direction rather than turning downhill
+    float capacity;               // sediment carried per unit of slope, speed and water
+    float minSlope;               // slope below which a droplet still carries a little
+    float depositSpeed;           // fraction of excess sediment dropped per step
+    float erodeSpeed;             // fraction of spare capacity picked up per step
+    float evaporateSpeed;         // fraction of water lost per step
+    float gravity;
+
+    // Thermal erosion...
+    unsigned int thermalIterations;
+    float talus;                  // steepest stable height difference between neighbouring cells
+    float thermalRate;            // fraction of the excess moved per iteration
+  };
+
+  // Erode a size x size heightmap (row-major) in place.
+  void Erode(std::vector<float>& heights, unsigned int size, const Parameters& parameters, WorkerPool& workers, unsigned int seed);
+}
+
+#endif // __EROSION__
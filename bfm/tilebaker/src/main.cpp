@@ -0,0 +1,683 @@
+/*
+ Pre-bakes the height and normal data of every planet quadtree tile down to a given depth
+ and writes them to a single file which the game maps into memory at runtime (see
+ game/planet/tilecache.h for the file layout).
+
+ With -pages, bakes the pages of the planet's virtual texture instead (see
+ game/planet/pagesource.h for the file layout).
+
+ With -erode, bakes tiles as usual but from heightmaps which have been through hydraulic
+ and thermal erosion (see erosion.h). Each cube face is generated in full at the bake's
+ deepest level, eroded, and baked before moving on to the next. Erosion fades out towards
+ the edges of a face so that neighbouring faces still meet, and tiles deeper than the bake
+ (generated at runtime) carry on from the uneroded heights.
+
+ With -benchmark, times the batched SIMD noise kernels (see core/noise.h) against
+ evaluating the same points one at a time, and checks that the two agree; then times fBm
+ and the planet's heights against the scalar glm::simplex code the kernels replaced.
+
+ Tiles are generated in batches across all CPU cores and written out in index order, so
+ the whole pyramid never needs to be held in memory at once.
+ */
+
+#include <SDL.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <boost/bind.hpp>
+#include <core/noise.h>
+#include <core/workerpool.h>
+#include "erosion.h"
+#include <game/planet/pagesource.h>
+#include <game/planet/planetpage.h>
+#include <game/planet/planettile.h>
+#include <game/planet/tilecache.h>
+
+//----------------------------------------------------------------------
+
+// Deepest level accepted. Offsets are 64-bit, and the 32-bit tile index would hold depth 14
+// (TileCache::MaxLevels), so the limit is the file's size: over 300GB at depth 12, and four
+// times that for each level deeper. The game maps the file a window at a time as it reads
+// tiles (see MappedFile), so even a 32-bit build can load a cache of any depth accepted.
+static const unsigned int MaxDepth = 12;
+
+// Deepest level of pages accepted; a page is 64KB so even this is a very large file.
+static const unsigned int MaxPageDepth = 8;
+
+// Deepest level accepted when eroding. A whole face is held in memory at once: 16K
+// vertices square (1GB) at level 10, which needs the x64 build; a Win32 one stops at 9.
+// The depth 10 cache (19.5GB) loads in the game like any other.
+static const unsigned int MaxErosionDepth = (sizeof(void*) > 4) ? 10 : 9;
+
+// Cells over which erosion fades out towards the edges of a face.
+static const unsigned int ErosionEdgeBand = 64;
+
+// Tiles generated per batch before being written to disk.
+static const unsigned int BatchSize = 4096;
+
+// Points evaluated by each benchmark unless told otherwise.
+static const unsigned int DefaultBenchmarkPoints = 1 << 20;
+
+//----------------------------------------------------------------------
+
+static double radius;
+static unsigned int levels;
+static unsigned int tilesPerFace;
+static unsigned int tileStride;
+static std::vector<unsigned char> batch;
+
+// The face being baked with -erode: its heights at the deepest level's vertex spacing...
+static bool erode;
+static unsigned int erodedFace;
+static unsigned int faceSize;
+static std::vector<float> faceHeights;
+
+//----------------------------------------------------------------------
+
+static boost::uint64_t RoundUp(boost::uint64_t value, boost::uint64_t multiple);
+static void Write(FILE* file, const void* const data, size_t size, size_t count);
+static void WritePadding(FILE* file, boost::uint64_t count);
+static void CloseOutput(FILE* file);
+static void GenerateTiles(unsigned int firstTile, size_t begin, size_t end);
+static void GeneratePages(unsigned int firstPage, size_t begin, size_t end);
+static void GetTileAddress(unsigned int tileIndex, unsigned int& face, unsigned int& level, unsigned int& x, unsigned int& y);
+static int BakePages(const char* const outputFilename, unsigned int depth, unsigned int threadCount);
+static int Benchmark(unsigned int pointCount);
+static void ErodeFace(unsigned int face, WorkerPool& workers);
+static void GenerateFaceRows(unsigned int face, size_t begin, size_t end);
+static void FadeFaceEdgeRows(unsigned int face, size_t begin, size_t end);
+static double SampleFace(const glm::dvec3& direction);
+
+//----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+  if ((argc > 1) && (0 == std::strcmp(argv[1], "-benchmark")))
+  {
+    return Benchmark((argc > 2) ? (unsigned int)std::atoi(argv[2]) : DefaultBenchmarkPoints);
+  }
+
+  const bool bakePages = (argc > 1) && (0 == std::strcmp(argv[1], "-pages"));
+  erode = (argc > 1) && (0 == std::strcmp(argv[1], "-erode"));
+  if (bakePages || erode)
+  {
+    --argc;
+    ++argv;
+  }
+
+  if (argc < 4)
+  {
+    std::printf("%s [-pages | -erode] radius depth output_file [thread_count]\n", argv[0]);
+    std::printf("%s -benchmark [point_count]\n", argv[0]);
+    return 0;
+  }
+
+  radius = std::atof(argv[1]);
+  const unsigned int depth = (unsigned int)std::atoi(argv[2]);
+  const char* const outputFilename = argv[3];
+  const unsigned int threadCount = (argc > 4) ? (unsigned int)std::atoi(argv[4]) : 0;
+
+  const unsigned int maxDepth = bakePages ? MaxPageDepth : (erode ? MaxErosionDepth : MaxDepth);
+  if ((radius <= 0.0) || (depth > maxDepth))
+  {
+    std::printf("radius must be positive and depth no greater than %u\n", maxDepth);
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (bakePages)
+  {
+    return BakePages(outputFilename, depth, threadCount);
+  }
+
+  levels = depth + 1;
+  tilesPerFace = PlanetTile::TilesAboveLevel(levels);
+  tileStride = (unsigned int)RoundUp(sizeof(PlanetTile::Data), 16);
+
+  TileCache::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "BFMT", 4);
+  header.version = TileCache::Version;
+  header.gridSize = PlanetTile::GridSize;
+  header.levels = levels;
+  header.tileCount = 6 * tilesPerFace;
+  header.tileStride = tileStride;
+  header.indexOffset = TileCache::PageSize;
+  header.dataOffset = RoundUp(header.indexOffset + (boost::uint64_t(header.tileCount) * sizeof(boost::uint64_t)), TileCache::PageSize);
+  header.radius = radius;
+
+  FILE* file = fopen(outputFilename, "wb");
+  if (!file)
+  {
+    std::printf("cannot create %s\n", outputFilename);
+    std::exit(EXIT_FAILURE);
+  }
+
+  Write(file, &header, sizeof(header), 1);
+  WritePadding(file, header.indexOffset - sizeof(header));
+
+  // Tiles are written contiguously so the index is trivial, but it still lets the reader
+  // (and any future sparse bakes) locate each tile without knowing the ordering...
+  for (unsigned int i = 0; i < header.tileCount; ++i)
+  {
+    const boost::uint64_t offset = header.dataOffset + (boost::uint64_t(i) * tileStride);
+    Write(file, &offset, sizeof(offset), 1);
+  }
+  WritePadding(file, header.dataOffset - (header.indexOffset + (boost::uint64_t(header.tileCount) * sizeof(boost::uint64_t))));
+
+  WorkerPool workers(threadCount);
+  std::printf("baking %u tiles (%u levels) with %u threads into %s\n", header.tileCount, levels, workers.ThreadCount(), outputFilename);
+
+  batch.resize(size_t(BatchSize) * tileStride);
+
+  // A face at a time, so that when eroding only one face's heightmap is ever needed...
+  const unsigned int startTime = SDL_GetTicks();
+  for (unsigned int face = 0; face < 6; ++face)
+  {
+    if (erode)
+    {
+      ErodeFace(face, workers);
+    }
+
+    const unsigned int faceEnd = (face + 1) * tilesPerFace;
+    for (unsigned int first = face * tilesPerFace; first < faceEnd; first += BatchSize)
+    {
+      const unsigned int count = ((faceEnd - first) < BatchSize) ? (faceEnd - first) : BatchSize;
+
+      workers.ParallelFor(count, boost::bind(GenerateTiles, first, _1, _2));
+      Write(file, batch.data(), tileStride, count);
+
+      std::printf("\r%u / %u", first + count, header.tileCount);
+    }
+  }
+
+  CloseOutput(file);
+
+  std::printf("\ndone in %.1f seconds\n", (SDL_GetTicks() - startTime) / 1000.0);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------
+
+static boost::uint64_t RoundUp(boost::uint64_t value, boost::uint64_t multiple)
+{
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+//----------------------------------------------------------------------
+
+// Write to the output, giving up on the whole bake if it fails (e.g. the disk is full) so
+// that a partial file is never mistaken for a good one.
+static void Write(FILE* file, const void* const data, size_t size, size_t count)
+{
+  if (fwrite(data, size, count, file) != count)
+  {
+    std::printf("\nwriting the output file failed\n");
+    fclose(file);
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Close the output, which may flush the last of it to disk and so fail as a write can.
+static void CloseOutput(FILE* file)
+{
+  if (0 != fclose(file))
+  {
+    std::printf("\nwriting the output file failed\n");
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+//----------------------------------------------------------------------
+
+static void WritePadding(FILE* file, boost::uint64_t count)
+{
+  static const char zeros[TileCache::PageSize] = { 0 };
+  while (count > 0)
+  {
+    const size_t chunk = (count < sizeof(zeros)) ? size_t(count) : sizeof(zeros);
+    Write(file, zeros, 1, chunk);
+    count -= chunk;
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Bake the virtual texture's pages. Much as for tiles, but the pages are fixed size and
+// already a whole number of OS pages long so need no index or padding.
+static int BakePages(const char* const outputFilename, unsigned int depth, unsigned int threadCount)
+{
+  levels = depth + 1;
+  tilesPerFace = PlanetTile::TilesAboveLevel(levels);
+
+  PageFile::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "BFMP", 4);
+  header.version = PageFile::Version;
+  header.pageSize = PlanetPage::Size;
+  header.levels = levels;
+  header.pageCount = 6 * tilesPerFace;
+  header.dataOffset = PageFile::Alignment;
+  header.radius = radius;
+
+  FILE* file = fopen(outputFilename, "wb");
+  if (!file)
+  {
+    std::printf("cannot create %s\n", outputFilename);
+    std::exit(EXIT_FAILURE);
+  }
+
+  Write(file, &header, sizeof(header), 1);
+  WritePadding(file, header.dataOffset - sizeof(header));
+
+  WorkerPool workers(threadCount);
+  std::printf("baking %u pages (%u levels) with %u threads into %s\n", header.pageCount, levels, workers.ThreadCount(), outputFilename);
+
+  // Pages are much bigger than tiles, so batch fewer of them...
+  const unsigned int pageBatchSize = BatchSize / 16;
+  batch.resize(size_t(pageBatchSize) * PlanetPage::ByteSize);
+
+  const unsigned int startTime = SDL_GetTicks();
+  for (unsigned int first = 0; first < header.pageCount; first += pageBatchSize)
+  {
+    const unsigned int count = ((header.pageCount - first) < pageBatchSize) ? (header.pageCount - first) : pageBatchSize;
+
+    workers.ParallelFor(count, boost::bind(GeneratePages, first, _1, _2));
+    Write(file, batch.data(), PlanetPage::ByteSize, count);
+
+    std::printf("\r%u / %u", first + count, header.pageCount);
+  }
+
+  CloseOutput(file);
+
+  std::printf("\ndone in %.1f seconds\n", (SDL_GetTicks() - startTime) / 1000.0);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------
+
+// Turn a linear tile (or page) index back into its (face, level, x, y) address.
+static void GetTileAddress(unsigned int tileIndex, unsigned int& face, unsigned int& level, unsigned int& x, unsigned int& y)
+{
+  face = tileIndex / tilesPerFace;
+  const unsigned int faceTile = tileIndex % tilesPerFace;
+
+  level = 0;
+  while (faceTile >= PlanetTile::TilesAboveLevel(level + 1))
+  {
+    ++level;
+  }
+
+  const unsigned int levelTile = faceTile - PlanetTile::TilesAboveLevel(level);
+  x = levelTile & ((1U << level) - 1);
+  y = levelTile >> level;
+}
+
+//----------------------------------------------------------------------
+
+// Generate the pages [firstPage + begin, firstPage + end) into the batch buffer.
+static void GeneratePages(unsigned int firstPage, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    unsigned int face, level, x, y;
+    GetTileAddress(firstPage + (unsigned int)i, face, level, x, y);
+    PlanetPage::Generate(face, level, x, y, radius, &batch[i * PlanetPage::ByteSize]);
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Generate the tiles [firstTile + begin, firstTile + end) into the batch buffer.
+static void GenerateTiles(unsigned int firstTile, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    unsigned int face, level, x, y;
+    GetTileAddress(firstTile + (unsigned int)i, face, level, x, y);
+
+    PlanetTile::Data* const tile = (PlanetTile::Data*)&batch[i * tileStride];
+    std::memset(tile, 0, tileStride);
+
+    if (erode)
+    {
+      glm::dvec3 directions[PlanetTile::ApronVertexCount];
+      double heights[PlanetTile::ApronVertexCount];
+      PlanetTile::GetApronDirections(face, level, x, y, directions);
+      for (unsigned int v = 0; v < PlanetTile::ApronVertexCount; ++v)
+      {
+        heights[v] = SampleFace(directions[v]);
+      }
+      PlanetTile::Build(directions, heights, radius, *tile);
+    }
+    else
+    {
+      PlanetTile::Generate(face, level, x, y, radius, *tile);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Generate a face's heightmap, erode it and fade the result back into the uneroded
+// heights around its edges.
+static void ErodeFace(unsigned int face, WorkerPool& workers)
+{
+  faceSize = ((PlanetTile::GridSize - 1) << (levels - 1)) + 1;
+  faceHeights.resize(size_t(faceSize) * faceSize);
+  erodedFace = face;
+
+  std::printf("\reroding face %u (%u x %u)...", face, faceSize, faceSize);
+  const unsigned int startTime = SDL_GetTicks();
+
+  workers.ParallelFor(faceSize, boost::bind(GenerateFaceRows, face, _1, _2));
+
+  // Erosion works in units of the distance between vertices, which is near enough the
+  // same all over a face...
+  const double cellSize = (radius * 0.5 * glm::pi<double>()) / (faceSize - 1);
+  for (size_t i = 0; i < faceHeights.size(); ++i)
+  {
+    faceHeights[i] = float(faceHeights[i] / cellSize);
+  }
+
+  Erosion::Erode(faceHeights, faceSize, Erosion::Parameters(), workers, face);
+
+  const float maxHeight = float(radius * PlanetTile::MaxRelativeHeight);
+  for (size_t i = 0; i < faceHeights.size(); ++i)
+  {
+    faceHeights[i] = glm::clamp(float(faceHeights[i] * cellSize), 0.0f, maxHeight);
+  }
+
+  workers.ParallelFor(faceSize, boost::bind(FadeFaceEdgeRows, face, _1, _2));
+
+  std::printf(" %.1f seconds\n", (SDL_GetTicks() - startTime) / 1000.0);
+}
+
+//----------------------------------------------------------------------
+
+// Direction of a vertex of a face's heightmap.
+static glm::dvec3 FaceDirection(unsigned int face, unsigned int i, unsigned int j)
+{
+  glm::dvec3 right, forward, up;
+  PlanetTile::GetFaceBasis(face, right, forward, up);
+
+  const double u = -1.0 + ((2.0 * i) / (faceSize - 1));
+  const double v = -1.0 + ((2.0 * j) / (faceSize - 1));
+  return glm::normalize(up + (right * u) + (forward * v));
+}
+
+//----------------------------------------------------------------------
+
+// Fill rows [begin, end) of the face's heightmap with uneroded heights.
+static void GenerateFaceRows(unsigned int face, size_t begin, size_t end)
+{
+  std::vector<glm::dvec3> directions(faceSize);
+  std::vector<double> heights(faceSize);
+
+  for (size_t j = begin; j < end; ++j)
+  {
+    for (unsigned int i = 0; i < faceSize; ++i)
+    {
+      directions[i] = FaceDirection(face, i, (unsigned int)j);
+    }
+
+    PlanetTile::ComputeHeights(&directions[0], &heights[0], faceSize, radius);
+
+    float* const row = &faceHeights[j * faceSize];
+    for (unsigned int i = 0; i < faceSize; ++i)
+    {
+      row[i] = float(heights[i]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Blend rows [begin, end) of the face's heightmap from eroded, away from the face's edges,
+// to uneroded at the edges themselves.
+static void FadeFaceEdgeRows(unsigned int face, size_t begin, size_t end)
+{
+  std::vector<glm::dvec3> directions;
+  std::vector<unsigned int> columns;
+  std::vector<double> heights;
+
+  for (size_t j = begin; j < end; ++j)
+  {
+    const unsigned int rowDistance = glm::min((unsigned int)j, (unsigned int)(faceSize - 1 - j));
+
+    // The cells of the row within the band...
+    directions.clear();
+    columns.clear();
+    for (unsigned int i = 0; i < faceSize; ++i)
+    {
+      const unsigned int distance = glm::min(rowDistance, glm::min(i, faceSize - 1 - i));
+      if (distance < ErosionEdgeBand)
+      {
+        directions.push_back(FaceDirection(face, i, (unsigned int)j));
+        columns.push_back(i);
+      }
+    }
+
+    if (directions.empty())
+    {
+      continue;
+    }
+
+    heights.resize(directions.size());
+    PlanetTile::ComputeHeights(&directions[0], &heights[0], directions.size(), radius);
+
+    float* const row = &faceHeights[j * faceSize];
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+      const unsigned int i = columns[c];
+      const unsigned int distance = glm::min(rowDistance, glm::min(i, faceSize - 1 - i));
+      const float weight = glm::smoothstep(0.0f, 1.0f, float(distance) / ErosionEdgeBand);
+      row[i] = glm::mix(float(heights[c]), row[i], weight);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
+// Height at a direction from the eroded face's heightmap, or from the planet's height
+// function for directions off the face (tiles' aprons along its edges).
+static double SampleFace(const glm::dvec3& direction)
+{
+  glm::dvec3 right, forward, up;
+  PlanetTile::GetFaceBasis(erodedFace, right, forward, up);
+
+  const double along = glm::dot(direction, up);
+  const double u = glm::dot(direction, right) / along;
+  const double v = glm::dot(direction, forward) / along;
+  if ((along <= 0.0) || (glm::abs(u) > 1.0) || (glm::abs(v) > 1.0))
+  {
+    return PlanetTile::ComputeHeight(direction, radius);
+  }
+
+  const double gx = (u + 1.0) * 0.5 * (faceSize - 1);
+  const double gy = (v + 1.0) * 0.5 * (faceSize - 1);
+  const unsigned int x0 = glm::min((unsigned int)gx, faceSize - 2);
+  const unsigned int y0 = glm::min((unsigned int)gy, faceSize - 2);
+  const float fx = float(gx - x0);
+  const float fy = float(gy - y0);
+
+  const float* const h = &faceHeights[x0 + (size_t(y0) * faceSize)];
+  return glm::mix(
+    glm::mix(h[0], h[1], fx),
+    glm::mix(h[faceSize], h[faceSize + 1], fx),
+    fy);
+}
+
+//----------------------------------------------------------------------
+
+// Adapters giving plain simplex noise the same signatures as the fractals...
+static float SimplexPoint(const glm::vec3& p, const Noise::Fractal&, unsigned int seed)
+{
+  return Noise::Simplex(p, seed);
+}
+
+static void SimplexBatch(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Noise::Fractal&, unsigned int seed)
+{
+  Noise::Simplex(x, y, z, results, count, seed);
+}
+
+//----------------------------------------------------------------------
+
+// fBm as it was computed before core/noise.h, from glm::simplex one point at a time...
+static float GlmFBm(const glm::vec3& position, const Noise::Fractal& fractal)
+{
+  glm::vec3 p = position;
+  float amplitude = 1.0f;
+  float result = 0.0f;
+  for (unsigned int octave = 0; octave < fractal.octaves; ++octave)
+  {
+    result += glm::simplex(p) * amplitude;
+    amplitude *= fractal.gain;
+    p *= fractal.lacunarity;
+  }
+  return result;
+}
+
+//----------------------------------------------------------------------
+
+static double Seconds(Uint64 start)
+{
+  return double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+}
+
+//----------------------------------------------------------------------
+
+// Time each noise function over the same random points, one point at a time and batched,
+// then the planet's height function as tiles use it. fBm and the heights are also timed
+// with the scalar glm::simplex code the kernels replaced; its noise differs, so only the
+// speeds compare.
+static int Benchmark(unsigned int pointCount)
+{
+  typedef float (*PointFunction)(const glm::vec3&, const Noise::Fractal&, unsigned int);
+  typedef void (*BatchFunction)(const float* const, const float* const, const float* const, float* const, size_t, const Noise::Fractal&, unsigned int);
+
+  struct Test
+  {
+    const char* name;
+    PointFunction point;
+    BatchFunction batch;
+  };
+
+  static const Test tests[] =
+  {
+    { "simplex", SimplexPoint, SimplexBatch },
+    { "fbm", Noise::FBm, Noise::FBm },
+    { "hybrid multifractal", Noise::HybridMultifractal, Noise::HybridMultifractal },
+    { "ridged multifractal", Noise::Ridged, Noise::Ridged }
+  };
+
+  if (0 == pointCount)
+  {
+    pointCount = DefaultBenchmarkPoints;
+  }
+
+  std::vector<float> x(pointCount);
+  std::vector<float> y(pointCount);
+  std::vector<float> z(pointCount);
+  std::vector<float> pointResults(pointCount);
+  std::vector<float> batchResults(pointCount);
+
+  // Points spread over a good many lattice cells, from a fixed sequence so runs compare...
+  boost::uint32_t random = 1;
+  for (unsigned int i = 0; i < pointCount; ++i)
+  {
+    random = (random * 1664525u) + 1013904223u; x[i] = ((random >> 8) * (200.0f / 16777216.0f)) - 100.0f;
+    random = (random * 1664525u) + 1013904223u; y[i] = ((random >> 8) * (200.0f / 16777216.0f)) - 100.0f;
+    random = (random * 1664525u) + 1013904223u; z[i] = ((random >> 8) * (200.0f / 16777216.0f)) - 100.0f;
+  }
+
+  const Noise::Fractal fractal;
+  std::printf("%u points, %u octaves, %s kernels\n", pointCount, fractal.octaves, Noise::KernelName());
+
+  for (size_t t = 0; t < (sizeof(tests) / sizeof(tests[0])); ++t)
+  {
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      pointResults[i] = tests[t].point(glm::vec3(x[i], y[i], z[i]), fractal, 0);
+    }
+    const double pointSeconds = Seconds(start);
+
+    start = SDL_GetPerformanceCounter();
+    tests[t].batch(&x[0], &y[0], &z[0], &batchResults[0], pointCount, fractal, 0);
+    const double batchSeconds = Seconds(start);
+
+    float maxDifference = 0.0f;
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      maxDifference = glm::max(maxDifference, glm::abs(pointResults[i] - batchResults[i]));
+    }
+
+    std::printf("%-20s %8.2f Mpoints/s one at a time, %8.2f Mpoints/s batched (%.1fx), max difference %g\n",
+      tests[t].name, (pointCount / pointSeconds) * 1e-6, (pointCount / batchSeconds) * 1e-6, pointSeconds / batchSeconds, maxDifference);
+  }
+
+  // fBm against the scalar code it replaced...
+  {
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      pointResults[i] = GlmFBm(glm::vec3(x[i], y[i], z[i]), fractal);
+    }
+    const double glmSeconds = Seconds(start);
+
+    start = SDL_GetPerformanceCounter();
+    Noise::FBm(&x[0], &y[0], &z[0], &batchResults[0], pointCount, fractal);
+    const double batchSeconds = Seconds(start);
+
+    std::printf("%-20s %8.2f Mpoints/s scalar glm,   %8.2f Mpoints/s batched (%.1fx)\n",
+      "fbm", (pointCount / glmSeconds) * 1e-6, (pointCount / batchSeconds) * 1e-6, glmSeconds / batchSeconds);
+  }
+
+  // The planet's heights, as used when generating tiles and pages...
+  {
+    std::vector<glm::dvec3> directions(pointCount);
+    std::vector<double> pointHeights(pointCount);
+    std::vector<double> batchHeights(pointCount);
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      directions[i] = glm::normalize(glm::dvec3(x[i], y[i], z[i]));
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      pointHeights[i] = PlanetTile::ComputeHeight(directions[i], 1.0);
+    }
+    const double pointSeconds = Seconds(start);
+
+    start = SDL_GetPerformanceCounter();
+    PlanetTile::ComputeHeights(&directions[0], &batchHeights[0], pointCount, 1.0);
+    const double batchSeconds = Seconds(start);
+
+    double maxDifference = 0.0;
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      maxDifference = glm::max(maxDifference, glm::abs(pointHeights[i] - batchHeights[i]));
+    }
+
+    std::printf("%-20s %8.2f Mpoints/s one at a time, %8.2f Mpoints/s batched (%.1fx), max difference %g\n",
+      "planet height", (pointCount / pointSeconds) * 1e-6, (pointCount / batchSeconds) * 1e-6, pointSeconds / batchSeconds, maxDifference);
+
+    start = SDL_GetPerformanceCounter();
+    for (unsigned int i = 0; i < pointCount; ++i)
+    {
+      pointHeights[i] = PlanetTile::ComputeHeightGlm(directions[i], 1.0);
+    }
+    const double glmSeconds = Seconds(start);
+
+    std::printf("%-20s %8.2f Mpoints/s scalar glm,   %8.2f Mpoints/s batched (%.1fx)\n",
+      "planet height", (pointCount / glmSeconds) * 1e-6, (pointCount / batchSeconds) * 1e-6, glmSeconds / batchSeconds);
+  }
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+// Effect file for rendering the sky from the precomputed scattering tables.
+// The sky is one triangle covering the screen, generated from gl_VertexID, drawn at the
+// far plane so that everything else is drawn over it.
+
+#include "common.glsl"
+#include "scattering.glsl"
+
+//---------------------------------------------------------
+
+// Maps clip space to a world space view direction (the view matrix without its translation).
+uniform mat4 InverseViewProjection;
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec3 direction;
+};
+
+//---------------------------------------------------------
+
+shader VS(out VSOut vsOut)
+{
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+  gl_Position = vec4(position, 1, 1);
+
+  vec4 farPoint = InverseViewProjection * vec4(position, 1, 1);
+  vsOut.direction = farPoint.xyz / farPoint.w;
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  vec3 direction = normalize(inputs.direction);
+  vec3 viewer = CameraPosition;
+  float distance = 0.0;
+
+  if (!EnterAtmosphere(viewer, direction, distance))
+  {
+    colour = vec4(0, 0, 0, 1);
+    return;
+  }
+
+  vec3 sun = -SunDirection;
+  float r = length(viewer);
+  float mu = dot(viewer, direction) / r;
+  float muS = dot(viewer, sun) / r;
+  float nu = dot(direction, sun);
+
+  vec3 sky = InScatter(Scattering(r, mu, muS), nu);
+
+  // The sun's disc, dimmed by the atmosphere in front of it...
+  if (nu > 0.99999)
+  {
+    sky += Transmittance(r, mu) * SunIntensity;
+  }
+
+  colour = vec4(ToneMap(sky), 1);
+}
+
+//---------------------------------------------------------
+
+program atmosphere
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
@@ -0,0 +1,97 @@
+// Effect file for drawing one level of a geometry clipmap (see ClipmapTerrain).
+//
+// There is no vertex data: each vertex's grid position comes from gl_VertexID and its height
+// from the level's toroidally addressed height texture. Positions are computed relative to
+// the camera so that they stay precise however far it is from the world origin.
+
+#include "semantics.glsl"
+#include "common.glsl"
+
+//---------------------------------------------------------
+
+// Must match ClipmapTerrain.
+const int TextureSize = 256;
+const int GridQuads = 252;
+
+// Width, in quads, of the band around a level's edge over which it blends into the next
+// coarser level.
+const int BlendWidth = GridQuads / 10;
+
+// Size, in world units, of the coarsest lattice cell of the surface colour detail.
+const float DetailCellSize = 16.0;
+
+uniform sampler2D LevelHeights;     // this level; read with texelFetch
+uniform sampler2D CoarserHeights;   // the next coarser level; bilinear, wrapping
+uniform int HasCoarser;
+
+// World XZ position of the grid's first vertex relative to the camera, and the distance
+// between vertices.
+uniform vec2 LevelOffset;
+uniform float LevelSpacing;
+
+// Texels of the grid's first vertex in this level's texture and in the coarser one's.
+uniform vec2 TexelOrigin;
+uniform vec2 CoarserTexelOrigin;
+
+uniform float CameraHeight;
+uniform vec3 SunDirection;
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec3 position;
+  float height;
+};
+
+//---------------------------------------------------------
+
+shader VS(out VSOut vsOut)
+{
+  ivec2 grid = ivec2(gl_VertexID % (GridQuads + 1), gl_VertexID / (GridQuads + 1));
+  ivec2 texel = (ivec2(TexelOrigin) + grid) & (TextureSize - 1);
+  float height = texelFetch(LevelHeights, texel, 0).r;
+
+  // Towards the edge, move to the height the coarser level has here. Its vertices are every
+  // other one of ours, so at the very edge the two agree exactly...
+  if (0 != HasCoarser)
+  {
+    vec2 fromCentre = abs(vec2(grid) - (GridQuads * 0.5));
+    float alpha = clamp((max(fromCentre.x, fromCentre.y) - ((GridQuads * 0.5) - BlendWidth)) / BlendWidth, 0.0, 1.0);
+    vec2 coarseCoord = (CoarserTexelOrigin + (vec2(grid) * 0.5) + 0.5) / TextureSize;
+    height = mix(height, textureLod(CoarserHeights, coarseCoord, 0).r, alpha);
+  }
+
+  vec3 position = vec3(LevelOffset.x + (grid.x * LevelSpacing), height - CameraHeight, LevelOffset.y + (grid.y * LevelSpacing));
+  gl_Position = WorldViewProjectionMatrix * vec4(position, 1);
+
+  vsOut.position = position;
+  vsOut.height = height;
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  vec3 normal = normalize(cross(dFdy(inputs.position), dFdx(inputs.position)));
+  if (normal.y < 0.0) { normal = -normal; }
+
+  // Grass on the flat, rock on the slopes and snow up high...
+  vec3 albedo = mix(vec3(0.25, 0.35, 0.15), vec3(0.4, 0.37, 0.33), smoothstep(0.75, 0.6, normal.y));
+  albedo = mix(albedo, vec3(0.9), smoothstep(300.0, 350.0, inputs.height) * smoothstep(0.6, 0.8, normal.y));
+
+  // Break up the flat colours with a little detail, at a few scales...
+  vec2 world = inputs.position.xz + CameraPosition.xz;
+  albedo *= 1.0 + (0.15 * TextureFBm(world / DetailCellSize, 4, 2.0, 0.5));
+
+  float light = (max(dot(normal, -SunDirection), 0.0) * 0.9) + 0.1;
+  colour = vec4(albedo * light, 1);
+}
+
+//---------------------------------------------------------
+
+program clipmap
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
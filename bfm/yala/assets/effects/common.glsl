@@ -3,21 +3,27 @@
 //---------------------------------------------------------
 
 
-// World space camera position.
-uniform vec3 CameraPosition;
+// Values which are the same for every draw in a frame, written once per frame to a
+// buffer shared by all effects. Must match struct FrameConstants.
+layout(std140) uniform FrameConstants
+{
+  mat4 ViewMatrix;
+  mat4 ProjectionMatrix;
+  mat4 ViewProjectionMatrix;
+
+  // World space camera position.
+  vec3 CameraPosition;
 
-// Transforms.
+  // Controls for the computation of logarithmic depth.
+  float LogDepthConstant;
+  float LogDepthOffset;
+  float LogDepthDivisor;
+};
+
+// Per-draw transforms.
 uniform mat4 WorldMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ViewProjectionMatrix;
 uniform mat4 WorldViewProjectionMatrix;
 
-// Per-frame constants controlling the computation of logarithmic depth.
-uniform float LogDepthConstant;
-uniform float LogDepthOffset;
-uniform float LogDepthDivisor;
-
 //---------------------------------------------------------
 // Compute logarithmic depth instead of the default gl_FragCoord.z emitted by GL.
 // See http://www.gamedev.net/blog/73/entry-2006307-tip-of-the-day-logarithmic-zbuffer-artifacts-fix
@@ -40,3 +46,97 @@ float ComputeDepth(float Zclip)
 {
   return log((LogDepthConstant * Zclip) + LogDepthOffset) * LogDepthDivisor;
 }
+
+//---------------------------------------------------------
+// Noise and fractals from the tiling noise textures (see NoiseTextures). Each octave is a
+// single filtered fetch, and the results are the same on every driver.
+
+uniform sampler2D NoiseTexture2D;
+uniform sampler3D NoiseTexture3D;
+
+// Lattice cells across each noise texture (must match NoiseTextures).
+const float NoiseCells2D = 32.0;
+const float NoiseCells3D = 16.0;
+
+// Successive octaves are rotated as well as scaled so that their lattices (and the
+// textures' repeats) don't line up.
+const mat2 OctaveRotation2D = mat2(0.8, 0.6, -0.6, 0.8);
+const mat3 OctaveRotation3D = mat3(0.00, 0.80, 0.60, -0.80, 0.36, -0.48, -0.60, -0.48, 0.64);
+
+//---------------------------------------------------------
+// Gradient noise in [-1,1] with one lattice cell per unit of p.
+float TextureNoise(vec2 p)
+{
+  return texture(NoiseTexture2D, p / NoiseCells2D).r;
+}
+
+float TextureNoise(vec3 p)
+{
+  return texture(NoiseTexture3D, p / NoiseCells3D).r;
+}
+
+//---------------------------------------------------------
+// Fractional Brownian motion: octaves of noise, each lacunarity times the frequency and
+// gain times the amplitude of the one before.
+float TextureFBm(vec2 p, int octaves, float lacunarity, float gain)
+{
+  float sum = 0.0;
+  float amplitude = 1.0;
+  for (int i = 0; i < octaves; ++i)
+  {
+    sum += TextureNoise(p) * amplitude;
+    p = (OctaveRotation2D * p) * lacunarity;
+    amplitude *= gain;
+  }
+  return sum;
+}
+
+float TextureFBm(vec3 p, int octaves, float lacunarity, float gain)
+{
+  float sum = 0.0;
+  float amplitude = 1.0;
+  for (int i = 0; i < octaves; ++i)
+  {
+    sum += TextureNoise(p) * amplitude;
+    p = (OctaveRotation3D * p) * lacunarity;
+    amplitude *= gain;
+  }
+  return sum;
+}
+
+//---------------------------------------------------------
+// Hybrid multifractal (Musgrave): each octave is weighted by those before it, so low
+// areas stay smooth while high ones get rough. The same as the CPU terrain generators use.
+float TextureHybridMultifractal(vec2 p, int octaves, float lacunarity, float gain, float offset)
+{
+  float amplitude = 1.0;
+  float result = (TextureNoise(p) + offset) * amplitude;
+  float weight = result;
+  for (int i = 1; i < octaves; ++i)
+  {
+    p = (OctaveRotation2D * p) * lacunarity;
+    amplitude *= gain;
+    weight = min(weight, 1.0);
+    float signal = (TextureNoise(p) + offset) * amplitude;
+    result += weight * signal;
+    weight *= signal;
+  }
+  return result;
+}
+
+float TextureHybridMultifractal(vec3 p, int octaves, float lacunarity, float gain, float offset)
+{
+  float amplitude = 1.0;
+  float result = (TextureNoise(p) + offset) * amplitude;
+  float weight = result;
+  for (int i = 1; i < octaves; ++i)
+  {
+    p = (OctaveRotation3D * p) * lacunarity;
+    amplitude *= gain;
+    weight = min(weight, 1.0);
+    float signal = (TextureNoise(p) + offset) * amplitude;
+    result += weight * signal;
+    weight *= signal;
+  }
+  return result;
+}
@@ -0,0 +1,88 @@
+// Effect file for drawing a distant planet as a low-polygon sphere (see FarField), coloured
+// from the virtual texture's resident pages. Also renders the planet's impostor.
+
+#include "semantics.glsl"
+#include "common.glsl"
+#include "scattering.glsl"
+#include "virtualtexture.glsl"
+
+//---------------------------------------------------------
+
+uniform double Radius;
+
+// Axes of the cube faces in face order (must match Planet::Initialise); each face's up
+// axis is right x forward.
+const vec3 FaceRights[6] = vec3[6](
+  vec3( 1, 0, 0), vec3( 0, 0, 1), vec3(-1, 0, 0),
+  vec3( 0, 0,-1), vec3( 1, 0, 0), vec3( 1, 0, 0));
+
+const vec3 FaceForwards[6] = vec3[6](
+  vec3( 0, 1, 0), vec3( 0, 1, 0), vec3( 0, 1, 0),
+  vec3( 0, 1, 0), vec3( 0, 0, 1), vec3( 0, 0,-1));
+
+//---------------------------------------------------------
+// The cube face a direction from the planet's centre passes through, and the position
+// within it in [0,1] along the face's axes (as FaceCoord in patch.glsl).
+int CubeFace(vec3 direction, out vec2 faceCoord)
+{
+  int face = 0;
+  float best = -2.0;
+  for (int i = 0; i < 6; ++i)
+  {
+    float alignment = dot(direction, cross(FaceRights[i], FaceForwards[i]));
+    if (alignment > best)
+    {
+      best = alignment;
+      face = i;
+    }
+  }
+
+  faceCoord = ((vec2(dot(direction, FaceRights[face]), dot(direction, FaceForwards[face])) / best) + 1.0) * 0.5;
+  return face;
+}
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec3 position;
+};
+
+//---------------------------------------------------------
+
+shader VS(in vec3 Position : SHADER_SEMANTIC_POSITION, out VSOut vsOut)
+{
+  // The mesh is a unit sphere...
+  vec3 position = normalize(Position) * float(Radius);
+  gl_Position = WorldViewProjectionMatrix * vec4(position, 1);
+  vsOut.position = position;
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  // Normals are taken per pixel so the silhouette is the only sign of the low polygon count...
+  vec3 normal = normalize(inputs.position);
+  float r = length(inputs.position);
+  float muS = dot(normal, -SunDirection);
+
+  vec2 faceCoord;
+  int face = CubeFace(normal, faceCoord);
+  int level = VirtualLevel(dFdx(faceCoord), dFdy(faceCoord), 0.0);
+  vec3 albedo = VirtualTexture(face, faceCoord, level);
+
+  vec3 sunLight = Transmittance(r, muS) * SunIntensity * max(muS, 0.0);
+  vec3 skyLight = Irradiance(r, muS);
+  vec3 ground = (albedo / Pi) * (sunLight + skyLight);
+
+  colour = vec4(ToneMap(AerialPerspective(CameraPosition, inputs.position, ground)), 1);
+}
+
+//---------------------------------------------------------
+
+program farfield
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
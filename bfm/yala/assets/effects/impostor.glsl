@@ -0,0 +1,51 @@
+// Effect file for drawing a distant planet's impostor: a billboard through the planet's
+// centre showing a picture of it rendered earlier by FarField. The billboard is a quad
+// generated from gl_VertexID and drawn as a triangle strip.
+
+#include "common.glsl"
+
+//---------------------------------------------------------
+
+// Half-extents of the billboard along the picture's x and y axes.
+uniform vec3 ImpostorRight;
+uniform vec3 ImpostorUp;
+
+uniform sampler2D ImpostorTexture;
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec2 texCoord;
+};
+
+//---------------------------------------------------------
+
+shader VS(out VSOut vsOut)
+{
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vec2 offset = (corner * 2.0) - 1.0;
+  gl_Position = ViewProjectionMatrix * vec4((ImpostorRight * offset.x) + (ImpostorUp * offset.y), 1);
+  vsOut.texCoord = corner;
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  colour = texture(ImpostorTexture, inputs.texCoord);
+
+  // The picture was cleared to transparent around the planet...
+  if (colour.a < 0.5)
+  {
+    discard;
+  }
+}
+
+//---------------------------------------------------------
+
+program impostor
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
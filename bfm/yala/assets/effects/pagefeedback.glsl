@@ -0,0 +1,50 @@
+// Effect file for the virtual texture's feedback pass: planet patches are drawn into a
+// small off-screen buffer, each pixel recording the address of the page it wants.
+// The address packing must match virtualtexture.cpp.
+
+#include "common.glsl"
+#include "patch.glsl"
+#include "virtualtexture.glsl"
+
+//---------------------------------------------------------
+
+// Corrects the level selection for the feedback buffer being smaller than the screen.
+uniform float FeedbackBias;
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec2 faceCoord;
+};
+
+//---------------------------------------------------------
+
+shader VS(out VSOut vsOut)
+{
+  dvec3 cubePos = PatchCubePosition(gl_VertexID);
+  dvec3 spherePos = normalize(cubePos) * Radius;
+
+  gl_Position = ViewProjectionMatrix * vec4(spherePos, 1);
+
+  vsOut.faceCoord = FaceCoord(cubePos);
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  int level = VirtualLevel(dFdx(inputs.faceCoord), dFdy(inputs.faceCoord), FeedbackBias);
+  ivec2 page = PageAt(inputs.faceCoord, level);
+
+  uint key = uint(Face) | (uint(level) << 3) | (uint(page.x) << 7) | (uint(page.y) << 19);
+  colour = vec4(uvec4(key, key >> 8, key >> 16, key >> 24) & 0xFFu) / 255.0;
+}
+
+//---------------------------------------------------------
+
+program pagefeedback
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
@@ -0,0 +1,49 @@
+// Placement of planet patch vertices, shared by every effect which draws patches.
+// Patches have no vertex buffer: every patch is the same regular grid, so the vertex
+// shader derives each vertex's grid position from gl_VertexID and maps it onto the
+// sphere using the patch's centre and width on its cube face.
+
+//---------------------------------------------------------
+
+// Vertices along each edge of a patch (must match PlanetTile::GridSize).
+const int GridSize = 17;
+
+uniform double Radius;
+
+// Per-patch constants, a block per patch in a buffer written once per frame (see
+// Planet::Impl::WritePatchConstants). Must match struct PatchConstants.
+layout(std140) uniform PatchConstants
+{
+  // The patch's centre on the cube and its edge length.
+  dvec3 Centre;
+  double Width;
+
+  // The cube face's axes and index.
+  dvec3 FaceRight;
+  int Face;
+  dvec3 FaceForward;
+};
+
+//---------------------------------------------------------
+// Grid coordinates in [0,1] of a vertex, x along the face's right axis and y along its
+// forward axis.
+vec2 PatchGridCoord(int vertexID)
+{
+  return vec2(vertexID % GridSize, vertexID / GridSize) / float(GridSize - 1);
+}
+
+//---------------------------------------------------------
+// Position on the cube of a vertex. Done in double precision since the cube is
+// planet-sized and patches may be only a few metres across.
+dvec3 PatchCubePosition(int vertexID)
+{
+  vec2 uv = PatchGridCoord(vertexID);
+  return Centre + (((FaceRight * (uv.x - 0.5)) + (FaceForward * (uv.y - 0.5))) * Width);
+}
+
+//---------------------------------------------------------
+// Position of a point on the cube within its face, in [0,1] along the face's axes.
+vec2 FaceCoord(dvec3 cubePos)
+{
+  return vec2(((dvec2(dot(cubePos, FaceRight), dot(cubePos, FaceForward)) / Radius) + 1.0) * 0.5);
+}
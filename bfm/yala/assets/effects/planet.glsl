@@ -0,0 +1,100 @@
+// Effect file for rendering a planet's quadtree patches (see patch.glsl), coloured from
+// the virtual texture and shadowed by each patch's horizon map.
+
+#include "semantics.glsl"
+#include "common.glsl"
+#include "patch.glsl"
+#include "scattering.glsl"
+#include "virtualtexture.glsl"
+
+//---------------------------------------------------------
+
+// Per-patch horizon map: the sines of the horizon's elevation in 8 azimuths, 0-3 in the
+// left half and 4-7 in the right. Dimensions must match HorizonMaps.
+uniform sampler2D HorizonMap;
+
+const int HorizonSize = 9;
+const int HorizonAzimuths = 8;
+
+// Angular softness (as a sine) of shadow edges.
+const float HorizonSoftness = 0.02;
+
+//---------------------------------------------------------
+// How much of the sun is above the horizon at a point on the patch.
+// gridCoord - position on the patch in [0,1]
+// up - the sphere normal at the point
+// sun - unit vector towards the sun
+float HorizonShadow(vec2 gridCoord, vec3 up, vec3 sun)
+{
+  // Texel centres of the left half; the right half is the same shifted by half the width...
+  vec2 coord = ((gridCoord * (HorizonSize - 1)) + 0.5) / vec2(2 * HorizonSize, HorizonSize);
+  vec4 near = (texture(HorizonMap, coord) * 2.0) - 1.0;
+  vec4 far = (texture(HorizonMap, coord + vec2(0.5, 0.0)) * 2.0) - 1.0;
+  float horizons[HorizonAzimuths] = float[HorizonAzimuths](near.x, near.y, near.z, near.w, far.x, far.y, far.z, far.w);
+
+  // The sun's azimuth in the same tangent frame as HorizonMaps used...
+  vec3 east = normalize(vec3(FaceRight) - (up * dot(vec3(FaceRight), up)));
+  vec3 north = cross(up, east);
+  float azimuth = atan(dot(sun, north), dot(sun, east)) * (HorizonAzimuths / (2.0 * Pi));
+  azimuth = mod(azimuth + HorizonAzimuths, float(HorizonAzimuths));
+
+  int a0 = int(azimuth) % HorizonAzimuths;
+  int a1 = (a0 + 1) % HorizonAzimuths;
+  float horizon = mix(horizons[a0], horizons[a1], fract(azimuth));
+
+  return smoothstep(horizon - HorizonSoftness, horizon + HorizonSoftness, dot(sun, up));
+}
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec3 position;
+  vec3 normal;
+  vec2 faceCoord;
+  vec2 gridCoord;
+};
+
+//---------------------------------------------------------
+
+shader VS(out VSOut vsOut)
+{
+  // Position on the cube, then pushed out onto the sphere...
+  dvec3 cubePos = PatchCubePosition(gl_VertexID);
+  dvec3 spherePos = normalize(cubePos) * Radius;
+
+  gl_Position = ViewProjectionMatrix * vec4(spherePos, 1);
+
+  vsOut.position = vec3(spherePos);
+  vsOut.normal = vec3(normalize(cubePos));
+  vsOut.faceCoord = FaceCoord(cubePos);
+  vsOut.gridCoord = PatchGridCoord(gl_VertexID);
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  vec3 normal = normalize(inputs.normal);
+  float r = length(inputs.position);
+  float muS = dot(inputs.position, -SunDirection) / r;
+
+  // Direct sunlight attenuated on its way down through the atmosphere and blocked by the
+  // surrounding terrain, plus sky light...
+  float shadow = HorizonShadow(inputs.gridCoord, normal, -SunDirection);
+  vec3 sunLight = Transmittance(r, muS) * SunIntensity * max(dot(normal, -SunDirection), 0.0) * shadow;
+  vec3 skyLight = Irradiance(r, muS);
+  int level = VirtualLevel(dFdx(inputs.faceCoord), dFdy(inputs.faceCoord), 0.0);
+  vec3 albedo = VirtualTexture(Face, inputs.faceCoord, level);
+  vec3 ground = (albedo / Pi) * (sunLight + skyLight);
+
+  colour = vec4(ToneMap(AerialPerspective(CameraPosition, inputs.position, ground)), 1);
+}
+
+//---------------------------------------------------------
+
+program planet
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
@@ -0,0 +1,113 @@
+// Effect file for rendering instanced ground detail scattered over planet patches.
+// The meshes are built from gl_VertexID; only the per-instance data comes from a buffer.
+// Mesh vertex counts must match scatter.cpp.
+
+#include "semantics.glsl"
+#include "common.glsl"
+#include "scattering.glsl"
+
+//---------------------------------------------------------
+
+#define MESH_ROCK   0
+#define MESH_SHRUB  1
+
+uniform dvec3 Origin;       // patch centre on the sphere; instance offsets are relative to it
+uniform vec3 FaceRight;     // reference direction for each instance's yaw
+uniform int MeshType;
+
+// Rock: an octahedron, squashed vertically when drawn.
+const vec3 RockCorners[6] = vec3[6](
+  vec3( 1, 0, 0), vec3(-1, 0, 0),
+  vec3( 0, 1, 0), vec3( 0,-1, 0),
+  vec3( 0, 0, 1), vec3( 0, 0,-1));
+
+const int RockIndices[24] = int[24](
+  0, 5, 2,   5, 1, 2,   1, 4, 2,   4, 0, 2,
+  5, 0, 3,   1, 5, 3,   4, 1, 3,   0, 4, 3);
+
+// Shrub: two crossed upright quads.
+const vec3 ShrubVertices[12] = vec3[12](
+  vec3(-0.5, 0, 0), vec3( 0.5, 0, 0), vec3( 0.5, 1, 0),
+  vec3(-0.5, 0, 0), vec3( 0.5, 1, 0), vec3(-0.5, 1, 0),
+  vec3(0, 0,-0.5), vec3(0, 0, 0.5), vec3(0, 1, 0.5),
+  vec3(0, 0,-0.5), vec3(0, 1, 0.5), vec3(0, 1,-0.5));
+
+const vec3 RockAlbedo = vec3(0.25, 0.23, 0.2);
+const vec3 ShrubAlbedo = vec3(0.08, 0.15, 0.04);
+
+//---------------------------------------------------------
+
+interface VSOut
+{
+  vec3 position;
+  vec3 normal;
+};
+
+//---------------------------------------------------------
+
+shader VS
+  (
+    in vec4 OffsetScale : SHADER_SEMANTIC_TEXCOORD,
+    in vec2 Yaw : SHADER_SEMANTIC_TEXCOORD1,
+    out VSOut vsOut
+  )
+{
+  vec3 local;
+  vec3 localNormal;
+  if (MESH_ROCK == MeshType)
+  {
+    local = RockCorners[RockIndices[gl_VertexID]] * vec3(1.0, 0.6, 1.0);
+    localNormal = normalize(RockCorners[RockIndices[gl_VertexID]]);
+  }
+  else
+  {
+    local = ShrubVertices[gl_VertexID];
+    localNormal = vec3(0, 1, 0);
+  }
+
+  // Local frame: y up from the planet centre, x towards the face's right axis...
+  dvec3 base = Origin + dvec3(OffsetScale.xyz);
+  vec3 up = vec3(normalize(base));
+  vec3 right = normalize(FaceRight - (up * dot(FaceRight, up)));
+  vec3 forward = cross(right, up);
+  mat3 frame = mat3(right, up, forward);
+
+  mat3 yaw = mat3(
+    Yaw.x, 0, Yaw.y,
+    0,     1, 0,
+   -Yaw.y, 0, Yaw.x);
+
+  dvec3 position = base + dvec3(frame * (yaw * (local * OffsetScale.w)));
+  gl_Position = ViewProjectionMatrix * vec4(position, 1);
+
+  vsOut.position = vec3(position);
+  vsOut.normal = frame * (yaw * localNormal);
+}
+
+//---------------------------------------------------------
+
+shader FS(in VSOut inputs, out vec4 colour)
+{
+  vec3 normal = normalize(inputs.normal);
+  float r = length(inputs.position);
+  float muS = dot(inputs.position, -SunDirection) / r;
+
+  // Shrubs are lit from either side...
+  float diffuse = dot(normal, -SunDirection);
+  diffuse = (MESH_SHRUB == MeshType) ? abs(diffuse) : max(diffuse, 0.0);
+
+  vec3 sunLight = Transmittance(r, muS) * SunIntensity * diffuse;
+  vec3 skyLight = Irradiance(r, muS);
+  vec3 albedo = (MESH_ROCK == MeshType) ? RockAlbedo : ShrubAlbedo;
+  vec3 surface = (albedo / Pi) * (sunLight + skyLight);
+
+  colour = vec4(ToneMap(AerialPerspective(CameraPosition, inputs.position, surface)), 1);
+}
+
+//---------------------------------------------------------
+
+program scatter
+{
+  vs(420) = VS();
+  fs(420) = FS();
+};
@@ -0,0 +1,159 @@
+// Atmospheric scattering using the lookup tables built by the Atmosphere class.
+// Table sizes and coordinate mappings must match atmosphere.cpp.
+
+//---------------------------------------------------------
+
+uniform vec3 SunDirection;    // direction the sunlight travels
+uniform vec3 SunIntensity;
+
+uniform float GroundRadius;
+uniform float TopRadius;
+uniform vec3 RayleighScattering;
+uniform float MieG;
+
+uniform sampler2D TransmittanceTable;   // (view zenith cosine, altitude)
+uniform sampler3D ScatteringTable;      // (view zenith cosine, sun zenith cosine, altitude)
+uniform sampler2D IrradianceTable;      // (sun zenith cosine, altitude)
+
+const ivec2 TransmittanceSize = ivec2(256, 64);
+const ivec3 ScatteringSize = ivec3(128, 32, 32);
+const ivec2 IrradianceSize = ivec2(64, 16);
+
+const float Pi = 3.14159265;
+
+//---------------------------------------------------------
+// Map a coordinate in [0,1] so that 0 and 1 fall on the centres of the end texels.
+float TableCoord(float u, int size)
+{
+  return (0.5 + (clamp(u, 0.0, 1.0) * (size - 1))) / size;
+}
+
+float RCoord(float r)     { return sqrt(clamp((r - GroundRadius) / (TopRadius - GroundRadius), 0.0, 1.0)); }
+float MuCoord(float mu)   { return (mu + 1.0) * 0.5; }
+float MuSCoord(float muS) { return (muS + 0.2) / 1.2; }
+
+//---------------------------------------------------------
+// Light surviving from a point at radius r to the top of the atmosphere along a ray with
+// zenith cosine mu.
+vec3 Transmittance(float r, float mu)
+{
+  vec2 uv = vec2(TableCoord(MuCoord(mu), TransmittanceSize.x), TableCoord(RCoord(r), TransmittanceSize.y));
+  return texture(TransmittanceTable, uv).rgb;
+}
+
+//---------------------------------------------------------
+// Light surviving between a point at radius r and the point a distance d along a ray with
+// zenith cosine mu. Built from two upward-looking table entries.
+vec3 Transmittance(float r, float mu, float d)
+{
+  float r1 = sqrt((r * r) + (d * d) + (2.0 * r * mu * d));
+  float mu1 = ((r * mu) + d) / r1;
+  if (mu > 0.0)
+  {
+    return min(Transmittance(r, mu) / max(Transmittance(r1, mu1), 1e-6), 1.0);
+  }
+  return min(Transmittance(r1, -mu1) / max(Transmittance(r, -mu), 1e-6), 1.0);
+}
+
+//---------------------------------------------------------
+
+vec4 Scattering(float r, float mu, float muS)
+{
+  vec3 uvw = vec3(
+    TableCoord(MuCoord(mu), ScatteringSize.x),
+    TableCoord(MuSCoord(muS), ScatteringSize.y),
+    TableCoord(RCoord(r), ScatteringSize.z));
+  return texture(ScatteringTable, uvw);
+}
+
+//---------------------------------------------------------
+// Sky light reaching a horizontal surface at radius r.
+vec3 Irradiance(float r, float muS)
+{
+  vec2 uv = vec2(TableCoord(MuSCoord(muS), IrradianceSize.x), TableCoord(RCoord(r), IrradianceSize.y));
+  return texture(IrradianceTable, uv).rgb * SunIntensity;
+}
+
+//---------------------------------------------------------
+
+float RayleighPhase(float nu)
+{
+  return (3.0 / (16.0 * Pi)) * (1.0 + (nu * nu));
+}
+
+float MiePhase(float nu)
+{
+  float g2 = MieG * MieG;
+  return ((3.0 / (8.0 * Pi)) * (1.0 - g2) * (1.0 + (nu * nu))) / ((2.0 + g2) * pow(1.0 + g2 - (2.0 * MieG * nu), 1.5));
+}
+
+//---------------------------------------------------------
+// Convert a scattering table entry to radiance. Only the red channel of Mie scattering is
+// stored; the others are recovered from the ratios of the Rayleigh channels.
+vec3 InScatter(vec4 scattering, float nu)
+{
+  vec3 mie = scattering.rgb * (scattering.a / max(scattering.r, 1e-6)) * (RayleighScattering.r / RayleighScattering);
+  return ((scattering.rgb * RayleighPhase(nu)) + (mie * MiePhase(nu))) * SunIntensity;
+}
+
+//---------------------------------------------------------
+// Move a viewer outside the atmosphere to where the view ray enters it.
+// Returns false if the ray misses the atmosphere altogether.
+bool EnterAtmosphere(inout vec3 position, vec3 direction, inout float distance)
+{
+  float r = length(position);
+  if (r <= TopRadius)
+  {
+    return true;
+  }
+
+  float rMu = dot(position, direction);
+  float discriminant = (rMu * rMu) - (r * r) + (TopRadius * TopRadius);
+  float entry = -rMu - sqrt(max(discriminant, 0.0));
+  if ((discriminant < 0.0) || (entry < 0.0))
+  {
+    return false;
+  }
+
+  position += direction * entry;
+  distance -= entry;
+  return true;
+}
+
+//---------------------------------------------------------
+// Apply aerial perspective to the colour of a surface point seen from the viewer.
+vec3 AerialPerspective(vec3 viewer, vec3 surface, vec3 colour)
+{
+  vec3 direction = surface - viewer;
+  float distance = length(direction);
+  direction /= distance;
+
+  if (!EnterAtmosphere(viewer, direction, distance))
+  {
+    return colour;
+  }
+
+  vec3 sun = -SunDirection;
+  float r = length(viewer);
+  float mu = dot(viewer, direction) / r;
+  float muS = dot(viewer, sun) / r;
+  float nu = dot(direction, sun);
+
+  vec3 transmittance = Transmittance(r, mu, distance);
+
+  // Light scattered in between the two points is that scattered along the whole ray from
+  // the viewer less what the ray beyond the surface would have contributed...
+  float r1 = length(surface);
+  float mu1 = dot(surface, direction) / r1;
+  float muS1 = dot(surface, sun) / r1;
+  vec4 scattering = max(Scattering(r, mu, muS) - (transmittance.rgbr * Scattering(r1, mu1, muS1)), 0.0);
+
+  return (colour * transmittance) + InScatter(scattering, nu);
+}
+
+//---------------------------------------------------------
+
+vec3 ToneMap(vec3 colour)
+{
+  return vec3(1.0) - exp(-colour);
+}
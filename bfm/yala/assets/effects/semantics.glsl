@@ -3,3 +3,4 @@
 #define SHADER_SEMANTIC_POSITION      0
 #define SHADER_SEMANTIC_NORMAL        1
 #define SHADER_SEMANTIC_TEXCOORD      2
+#define SHADER_SEMANTIC_TEXCOORD1     3
@@ -5,6 +5,13 @@
 
 uniform float MaxHeight = 1000.0f;
 
+// Every node's heights as fractions of MaxHeight, one layer per node, with a texel per
+// grid vertex. GridSize must match terrain.cpp.
+uniform sampler2DArray HeightPool;
+uniform int HeightLayer;
+
+const int GridSize = 17;
+
 //---------------------------------------------------------
 
 interface VSOut
@@ -14,25 +21,6 @@ interface VSOut
 
 //---------------------------------------------------------
 
-float fBm(vec2 point, float maxRoughness, float lacunarity, float octaves)
-{
-  float value = 0;
-  int i;
-  for (i = 0; i < int(octaves); ++i)
-  {
-    value += noise1(point) * pow(lacunarity, -maxRoughness * i);
-    point *= lacunarity;
-  }
-  float remainder = octaves - int(octaves);
-  if (remainder > 0)
-  {
-    value += remainder * noise1(point) * pow(lacunarity, -maxRoughness * i);
-  }
-  return value;
-}
-
-//---------------------------------------------------------
-
 // Vertex shader: computes clip-space position and forwards model-space coordinate to fragment shader.
 shader VS
   (
@@ -41,7 +29,10 @@ shader VS
   )
 {
   vec4 P = WorldMatrix * vec4(Position.x, 0.0f, Position.y, 1.0f);
-  float height = MaxHeight * fBm(P.xz, 0.8f, 0.516273f, 6.3f);
+
+  // The node's heights were generated when it was created; fetch this vertex's...
+  ivec2 texel = ivec2(round((Position + 0.5f) * (GridSize - 1)));
+  float height = MaxHeight * texelFetch(HeightPool, ivec3(texel, HeightLayer), 0).r;
   vec4 worldPos = vec4(P.x, height, P.z, 1.0f);
   gl_Position = ViewProjectionMatrix * worldPos;
 
@@ -0,0 +1,73 @@
+// Virtual texture lookups. Page sizes and addressing must match planetpage.h and
+// virtualtexture.cpp.
+
+//---------------------------------------------------------
+
+// One texel per page: the page's position in the cache (xy), its level (z) and whether it
+// is resident (w). Level L of the quadtree is in mip (VirtualLevels - 1 - L), with the six
+// faces laid out in a 3x2 grid.
+uniform usampler2D PageTable;
+uniform sampler2D PageCache;
+
+uniform int VirtualLevels;
+uniform int CachePages;       // pages along each edge of the cache
+
+const int PageSize = 128;
+const int PageBorder = 4;
+const int PageContentSize = PageSize - (2 * PageBorder);
+
+//---------------------------------------------------------
+// The level whose texel density best matches a pixel's footprint, given the screen-space
+// derivatives of the face coordinates.
+// bias - added to the log2 of the footprint (negative for finer)
+int VirtualLevel(vec2 dx, vec2 dy, float bias)
+{
+  float finestTexels = float(PageContentSize << (VirtualLevels - 1));
+  float footprint = max(length(dx), length(dy)) * finestTexels;
+  float lod = max(log2(max(footprint, 1e-6)) + bias, 0.0);
+  return clamp(VirtualLevels - 1 - int(lod), 0, VirtualLevels - 1);
+}
+
+//---------------------------------------------------------
+// The page of a level covering a point on a face.
+ivec2 PageAt(vec2 faceCoord, int level)
+{
+  int pages = 1 << level;
+  return clamp(ivec2(faceCoord * pages), ivec2(0), ivec2(pages - 1));
+}
+
+//---------------------------------------------------------
+
+uvec4 PageTableEntry(int face, int level, ivec2 page)
+{
+  ivec2 faceOffset = ivec2(face % 3, face / 3) << level;
+  return texelFetch(PageTable, faceOffset + page, VirtualLevels - 1 - level);
+}
+
+//---------------------------------------------------------
+// Sample the virtual texture at a point on a face, using the page of the given level or,
+// if that isn't resident, its nearest resident ancestor.
+vec3 VirtualTexture(int face, vec2 faceCoord, int level)
+{
+  uvec4 entry = uvec4(0);
+  ivec2 page = ivec2(0);
+  for (; level >= 0; --level)
+  {
+    page = PageAt(faceCoord, level);
+    entry = PageTableEntry(face, level, page);
+    if (0u != entry.w)
+    {
+      break;
+    }
+  }
+
+  if (0u == entry.w)
+  {
+    // Not even the root page is resident...
+    return vec3(0.1);
+  }
+
+  vec2 pageCoord = (faceCoord * float(1 << level)) - vec2(page);
+  vec2 texel = (vec2(entry.xy) * PageSize) + PageBorder + (clamp(pageCoord, 0.0, 1.0) * PageContentSize);
+  return textureLod(PageCache, texel / float(CachePages * PageSize), 0.0).rgb;
+}
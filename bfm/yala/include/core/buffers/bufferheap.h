@@ -0,0 +1,64 @@
+// Hands out ranges of a few large GL buffers, so that many small vertex and index buffers
+// share buffer objects rather than each having its own.
+//
+// Each block (GL buffer) keeps a list of its free ranges by offset; an allocation takes the
+// first that fits, and a freed range is merged with the free ranges either side of it so
+// the block doesn't fragment into pieces too small to use. An allocation bigger than the
+// block size gets a block to itself. Blocks other than the first are deleted once empty.
+//
+// Device keeps a heap per buffer usage; see Device::NewVertexBuffer.
+
+#if ! defined(__BUFFER_HEAP__)
+#define __BUFFER_HEAP__
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gl_loader/gl_loader.h>
+
+class BufferHeap : public boost::noncopyable
+{
+public:
+  // Part of one of the heap's buffers.
+  struct Range
+  {
+    GLuint buffer;
+    size_t offset;              // bytes from the start of buffer
+    size_t size;
+    unsigned int block;
+  };
+
+  // usage - as for glBufferData (e.g. GL_STATIC_DRAW)
+  // blockSize - bytes in each buffer
+  BufferHeap(GLenum usage, size_t blockSize);
+  ~BufferHeap();
+
+  // A range of at least one byte, starting at a multiple of alignment.
+  Range Allocate(size_t size, size_t alignment);
+  void Free(const Range& range);
+
+  // Bytes allocated, and in blocks.
+  size_t Allocated() const { return allocated; }
+  size_t Reserved() const;
+
+private:
+  struct Block
+  {
+    GLuint buffer;              // 0 once deleted, for reuse
+    size_t size;
+    std::map<size_t, size_t> free;  // offset to size of each free range
+  };
+
+  unsigned int NewBlock(size_t size);
+
+  const GLenum usage;
+  const size_t blockSize;
+  std::vector<Block> blocks;
+  size_t allocated;
+};
+
+typedef boost::shared_ptr<BufferHeap> BufferHeapPtr;
+
+#endif // __BUFFER_HEAP__
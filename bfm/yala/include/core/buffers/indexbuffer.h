@@ -4,11 +4,18 @@
 #include <cstddef>
 #include <gl_loader/gl_loader.h>
 #include <boost/shared_ptr.hpp>
+#include <core/buffers/bufferheap.h>
+#include <core/buffers/streamingbuffer.h>
 
+// Indices in a range of a GL buffer shared with others; see BufferHeap.
 class IndexBuffer
 {
 public:
-  IndexBuffer(size_t indexCount, GLenum indexType, GLenum usage);
+  IndexBuffer(size_t indexCount, GLenum indexType, BufferHeapPtr heap);
+
+  // Indices written with Stream to a streaming buffer, rather than with SetData.
+  IndexBuffer(GLenum indexType, StreamingBufferPtr streamingBuffer);
+
   ~IndexBuffer();
 
   void Enable() { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer); }
@@ -16,14 +23,27 @@ public:
 
   void SetData(const void* const data, size_t indexCount, size_t startIndex = 0);
 
+  // Write indices to the streaming buffer, setting startIndex to the first of them (to draw
+  // from). Needn't be enabled.
+  bool Stream(const void* const data, size_t indexCount, size_t& startIndex);
+
   GLenum  GetIndexType() const { return indexType; }
   size_t GetIndexCount() const { return indexCount; }
+  size_t GetIndexSize() const { return typeSize; }
+
+  // Where the indices start in the GL buffer, in bytes and in whole indices.
+  GLuint GetBuffer() const { return buffer; }
+  size_t GetOffset() const { return range.offset; }
+  size_t GetBaseIndex() const { return range.offset / typeSize; }
 
 private:
   const GLenum indexType;
   const size_t indexCount;
   const size_t typeSize;
   GLuint buffer;
+  const StreamingBufferPtr streamingBuffer;
+  const BufferHeapPtr heap;
+  BufferHeap::Range range;
 };
 
 typedef boost::shared_ptr<IndexBuffer> IndexBufferPtr;
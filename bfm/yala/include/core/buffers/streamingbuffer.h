@@ -0,0 +1,75 @@
+// A ring of bytes in one GL buffer, for data written afresh every frame: vertices, indices
+// or uniform blocks.
+//
+// Write copies data to the part of the ring after the last write and returns the offset it
+// starts at, to draw from or bind. Nothing waits in glBufferSubData: with GL 4.4 (or
+// ARB_buffer_storage) the buffer is mapped once, persistently and coherently, and written
+// directly; otherwise each write maps just its own range, unsynchronised. The GPU may still
+// be reading earlier parts of the ring, so EndFrame puts a fence after each frame's
+// commands, and a write which would overtake a region still in use first waits for that
+// region's fence. Sized for a few frames' data, that should never happen; Stalls counts the
+// times it did.
+//
+// A VertexBuffer or IndexBuffer may be made in a streaming buffer (both may share one), so
+// dynamic geometry is drawn through a VertexArray as usual; see VertexBuffer::Stream.
+
+#if ! defined(__STREAMING_BUFFER__)
+#define __STREAMING_BUFFER__
+
+#include <cstddef>
+#include <deque>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gl_loader/gl_loader.h>
+
+class StreamingBuffer : public boost::noncopyable
+{
+public:
+  explicit StreamingBuffer(size_t size);
+  ~StreamingBuffer();
+
+  // Copy bytes to the ring at a multiple of alignment, setting offset to where they start.
+  // False if they can never fit.
+  bool Write(const void* const data, size_t bytes, size_t alignment, size_t& offset);
+
+  // Fence what every streaming buffer has had written this frame. Called once a frame, after
+  // the last command that reads them (see Context::EndFrame).
+  static void EndFrame();
+
+  GLuint GetBuffer() const { return buffer; }
+  size_t GetSize() const { return size; }
+  bool Persistent() const { return NULL != mapping; }
+
+  // Writes which had to wait for the GPU to finish with their part of the ring.
+  unsigned int Stalls() const { return stalls; }
+
+private:
+  // Writes up to end, which the GPU is done with once fence is signalled.
+  struct Region
+  {
+    GLsync fence;
+    boost::uint64_t end;
+  };
+
+  void Fence();
+  void Retire();
+
+  const size_t size;
+  GLuint buffer;
+  unsigned char* mapping;       // the whole buffer when persistently mapped, else NULL
+
+  // Positions count bytes written since the ring was made, so never wrap; the offset of a
+  // position is it modulo size. Everything from retired to position may be in use.
+  boost::uint64_t position;
+  boost::uint64_t fenced;       // position when last fenced
+  boost::uint64_t retired;
+  std::deque<Region> regions;   // fenced, oldest first
+
+  unsigned int stalls;
+  bool overfilled;              // reported a frame too big for the ring (only done once)
+};
+
+typedef boost::shared_ptr<StreamingBuffer> StreamingBufferPtr;
+
+#endif // __STREAMING_BUFFER__
@@ -0,0 +1,57 @@
+// A ring of fixed size uniform blocks inside one streaming buffer, for values which change
+// with every draw (e.g. a planet patch's position).
+//
+// Rather than each draw uploading its values with glUniform calls, a frame's blocks are
+// gathered on the CPU with Add, written to the buffer in one go by Upload, and each draw
+// then binds its own block with Bind (glBindBufferRange). The buffer holds several frames'
+// blocks, each frame writing the part after the last, and its fences keep a frame from
+// overwriting blocks the GPU is still reading.
+
+#if ! defined(__UNIFORM_RING__)
+#define __UNIFORM_RING__
+
+#include <cstddef>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gl_loader/gl_loader.h>
+#include <core/buffers/streamingbuffer.h>
+
+class UniformRing : public boost::noncopyable
+{
+public:
+  // Frames whose blocks fit in the buffer at once.
+  static const unsigned int Frames = 3;
+
+  // blockSize - bytes in each block (the size of the uniform block in the shader)
+  // blocksPerFrame - blocks a frame is expected to need (at least one is allowed for); the
+  //                  ring grows if more are added
+  UniformRing(size_t blockSize, size_t blocksPerFrame);
+  ~UniformRing();
+
+  // Start gathering a new frame's blocks, forgetting the last frame's.
+  void BeginFrame();
+
+  // Copy a block into the frame, returning its index for Bind.
+  size_t Add(const void* const block);
+
+  // Write the frame's blocks to the buffer. Must be called after the last Add and before
+  // the first Bind.
+  void Upload();
+
+  // Bind a block of the current frame to a uniform buffer binding point.
+  void Bind(GLuint bindingPoint, size_t index);
+
+  size_t Count() const { return count; }
+
+private:
+  const size_t blockSize;
+  size_t stride;                // blockSize rounded up to the GL's offset alignment
+  size_t blocksPerFrame;
+  size_t count;                 // blocks added to the current frame
+  size_t offset;                // where Upload wrote the current frame's blocks
+  std::vector<unsigned char> blocks;
+  boost::scoped_ptr<StreamingBuffer> buffer;
+};
+
+#endif // __UNIFORM_RING__
@@ -4,11 +4,18 @@
 #include <gl_loader/gl_loader.h>
 #include <boost/shared_ptr.hpp>
 #include <core/vertexlayout.h>
+#include <core/buffers/bufferheap.h>
+#include <core/buffers/streamingbuffer.h>
 
+// Vertices in a range of a GL buffer shared with others; see BufferHeap.
 class VertexBuffer
 {
 public:
-  VertexBuffer(const VertexLayout& vertexLayout, size_t vertexCount, GLenum usage);
+  VertexBuffer(const VertexLayout& vertexLayout, size_t vertexCount, BufferHeapPtr heap);
+
+  // Vertices written with Stream to a streaming buffer, rather than with SetData.
+  VertexBuffer(const VertexLayout& vertexLayout, StreamingBufferPtr streamingBuffer);
+
   ~VertexBuffer();
 
   void Enable() { glBindBuffer(GL_ARRAY_BUFFER, buffer); }
@@ -16,14 +23,27 @@ public:
 
   void SetData(const void* const data, size_t vertexCount, size_t startVertex = 0);
 
+  // Write vertices to the streaming buffer, setting startVertex to the first of them (to
+  // draw from). Needn't be enabled.
+  bool Stream(const void* const data, size_t vertexCount, size_t& startVertex);
+
   size_t GetVertexCount() const { return vertexCount; }
 
+  // Where the vertices start in the GL buffer, in bytes and in whole vertices (to draw with a
+  // vertex array shared with others in the buffer).
+  GLuint GetBuffer() const { return buffer; }
+  size_t GetOffset() const { return range.offset; }
+  size_t GetBaseVertex() const { return range.offset / vertexLayout.GetStride(); }
+
   const VertexLayout& GetVertexLayout() const { return vertexLayout; }
 
 private:
   GLuint buffer;
   const size_t vertexCount;
   const VertexLayout vertexLayout;
+  const StreamingBufferPtr streamingBuffer;
+  const BufferHeapPtr heap;
+  BufferHeap::Range range;
 };
 
 typedef boost::shared_ptr<VertexBuffer> VertexBufferPtr;
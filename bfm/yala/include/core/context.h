@@ -14,6 +14,10 @@
 #include <core/drawstate.h>
 #include <core/clearstate.h>
 #include <core/scenestate.h>
+#include <core/frameconstants.h>
+#include <core/renderqueue.h>
+#include <core/gpuprofiler.h>
+#include <core/buffers/uniformbuffer.h>
 
 class Context : public boost::noncopyable
 {
@@ -22,14 +26,42 @@ public:
   ~Context();
 
   void Clear(const ClearState& clearState);
+
+  // Write the values shared by every effect for the frame about to be drawn. Called once
+  // per frame, before any draws.
+  void SetFrameConstants(const FrameConstants& frameConstants);
   void Draw(GLenum primitiveType, size_t vertexCount, const DrawState& drawState);
   void Draw(GLenum primitiveType, size_t vertexCount, size_t vertexStart, const DrawState& drawState);
   void DrawIndexed(GLenum primitiveType, size_t vertexCount, const DrawState& drawState);
   void DrawIndexed(GLenum primitiveType, size_t vertexCount, size_t vertexStart, const DrawState& drawState);
 
+  // Draw indexCount indices starting at indexStart, adding baseVertex to every index fetched.
+  // Strips may be split with the largest value of the index type (e.g. 0xFFFF for
+  // GL_UNSIGNED_SHORT) which restarts the primitive.
+  void DrawIndexed(GLenum primitiveType, size_t indexCount, size_t indexStart, size_t baseVertex, const DrawState& drawState);
+
+  // Draw instanceCount copies of vertexCount vertices. Per-instance attributes (those with a
+  // divisor) start at instance baseInstance.
+  void DrawInstanced(GLenum primitiveType, size_t vertexCount, size_t instanceCount, size_t baseInstance, const DrawState& drawState);
+
+  // Sort a queue's packets by key and draw them, then empty it.
+  void Execute(RenderQueue& queue);
+
+  // Time the GL work issued between these on the GPU, under a name (see GpuProfiler).
+  void BeginGpuScope(const char* const name);
+  void EndGpuScope();
+  GpuProfiler& Profiler() { return profiler; }
+
+  // Called once the frame's GL work has been issued, before the window's buffers are swapped.
+  // Fences the streaming buffers' writes.
+  void EndFrame();
+
 private:
   ClearState clearState;
   DrawState drawState;
+  GLenum restartIndexType;
+  boost::scoped_ptr<UniformBuffer> frameConstantBuffer;
+  GpuProfiler profiler;
 };
 
 typedef boost::shared_ptr<Context> ContextPtr;
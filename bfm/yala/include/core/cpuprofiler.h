@@ -0,0 +1,68 @@
+// Times named zones of CPU work on any thread, for viewing as a Chrome trace (chrome://tracing
+// or the Perfetto UI).
+//
+// PROFILE_ZONE("name") times the rest of the enclosing block. While recording, each thread
+// writes the zones it completes into its own ring buffer without locking; EndFrame, called
+// by the main thread once a frame, gathers every thread's zones into the capture which
+// WriteTrace saves. While not recording a zone costs a test of a flag. Only the first 64
+// threads to record a zone get a buffer; WriteTrace logs how many zones any others lost.
+//
+// Zone and thread names are kept by pointer, so must be string literals (or otherwise live
+// for the rest of the program).
+
+#if ! defined(__CPU_PROFILER__)
+#define __CPU_PROFILER__
+
+#include <SDL.h>
+#include <boost/noncopyable.hpp>
+
+namespace CpuProfiler
+{
+  // Start a new capture, forgetting the last.
+  void StartRecording();
+  void StopRecording();
+  bool Recording();
+
+  // Name the calling thread in the trace.
+  void NameThread(const char* const name);
+
+  // Gather the zones every thread has completed since the last call. Called once a frame by
+  // the main thread.
+  void EndFrame();
+
+  // Save the capture as Chrome trace event JSON.
+  bool WriteTrace(const char* const filename);
+
+  // Used by CpuZone.
+  extern volatile int recording;
+  void Record(const char* const name, Uint64 start, Uint64 end);
+}
+
+//------------------------------------------------------------------------
+
+class CpuZone : public boost::noncopyable
+{
+public:
+  explicit CpuZone(const char* const name)
+    : name(name), start(CpuProfiler::recording ? SDL_GetPerformanceCounter() : 0)
+  {
+  }
+
+  ~CpuZone()
+  {
+    if (0 != start)
+    {
+      CpuProfiler::Record(name, start, SDL_GetPerformanceCounter());
+    }
+  }
+
+private:
+  const char* const name;
+  const Uint64 start;
+};
+
+#define PROFILE_ZONE_JOIN2(a, b) a##b
+#define PROFILE_ZONE_JOIN(a, b) PROFILE_ZONE_JOIN2(a, b)
+#define PROFILE_ZONE(name) const CpuZone PROFILE_ZONE_JOIN(profileZone, __LINE__)(name)
+
+#endif // __CPU_PROFILER__
@@ -4,9 +4,15 @@
 #include <glm/glm.hpp>
 
 #include <core/effect/effect.h>
+#include <core/framebuffer.h>
+#include <core/renderstate/renderstateobject.h>
 #include <core/vertexarray.h>
 #include <core/buffers/indexbuffer.h>
+#include <core/buffers/streamingbuffer.h>
 #include <core/buffers/vertexbuffer.h>
+#include <core/textures/sampler.h>
+#include <core/textures/texture2d.h>
+#include <core/textures/texture3d.h>
 #include <core/window.h>
 
 //----------------------------------------------------------
@@ -27,12 +33,42 @@ namespace Device
     bool fullScreen,
     bool visible);
 
+  // The vertex buffer may be null for attributeless drawing, where the vertex shader
+  // generates vertices from gl_VertexID.
   VertexArrayPtr NewVertexArray(VertexBufferPtr vertexBuffer);
   VertexArrayPtr NewVertexArray(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer);
 
+  // A vertex array for drawing any vertex buffer with the same layout in the same GL buffer
+  // (and likewise index buffer), adding its GetBaseVertex (or, for instance data,
+  // passing it as the base instance) and GetBaseIndex to the draw. Saves a vertex array per
+  // buffer, and binding them.
+  VertexArrayPtr NewSharedVertexArray(VertexBufferPtr vertexBuffer);
+  VertexArrayPtr NewSharedVertexArray(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer);
+
+  // Vertex and index buffers are ranges of a few large GL buffers, shared between buffers of
+  // the same usage (see BufferHeap).
   VertexBufferPtr NewVertexBuffer(const VertexLayout& layout, size_t vertexCount, GLenum usage);
 
   IndexBufferPtr NewIndexBuffer(size_t indexCount, GLenum indexType, GLenum usage);
+
+  // size - bytes in the ring; enough for a few frames' data
+  StreamingBufferPtr NewStreamingBuffer(size_t size);
+
+  // Vertex and index buffers for data written every frame, which may share a streaming
+  // buffer.
+  VertexBufferPtr NewVertexBuffer(const VertexLayout& layout, StreamingBufferPtr streamingBuffer);
+  IndexBufferPtr NewIndexBuffer(GLenum indexType, StreamingBufferPtr streamingBuffer);
+
+  Texture2DPtr NewTexture2D(const Texture2DDescription& description);
+  Texture3DPtr NewTexture3D(const Texture3DDescription& description);
+
+  SamplerPtr NewSampler();
+
+  // Render states are immutable once made; identical descriptions give the same object.
+  RenderStatePtr NewRenderState(const RenderState& description);
+
+  // colourFormat - internal format of the colour texture (e.g. GL_RGBA8)
+  FramebufferPtr NewFramebuffer(const glm::uvec2& size, GLenum colourFormat);
 };
 
 #endif // __DEVICE__
@@ -2,14 +2,20 @@
 #define __DRAW_STATE__
 
 #include <core/vertexarray.h>
+#include <core/textureunit.h>
 #include <core/effect/effect.h>
-#include <core/renderstate/renderstate.h>
+#include <core/renderstate/renderstateobject.h>
 
 struct DrawState
 {
+  DrawState() : effect(NULL), renderState(RenderStateObject::Default()) { }
+
+  static const unsigned int MaxTextureUnits = 8;
+
   Effect*         effect;
-  RenderState     renderState;
+  RenderStatePtr  renderState;    // see Device::NewRenderState
   VertexArrayPtr  vertexArray;
+  TextureUnit     textureUnits[MaxTextureUnits];  // unit N is sampled by a sampler uniform set to N
 };
 
 #endif // __DRAW_STATE__
@@ -21,43 +21,39 @@ public:
 
   // Update any changes to the effect's parameters which have happened since the last time
   // Apply was called.
-  // Called automatically by Device::Draw to ensure the GPU remains sync'd with the CPU.
+  // Called automatically by Context's draws, once the effect's program is bound, to ensure
+  // the GPU remains sync'd with the CPU.
   void Apply();
 
+  // Uniform uploads over all effects since the last ResetCounters: those Apply issued, and
+  // those skipped because a parameter was Set to the value it already had.
+  struct Counters
+  {
+    unsigned int uploadsIssued;
+    unsigned int uploadsSkipped;
+  };
+
+  static Counters GetCounters();
+  static void ResetCounters();
+
+  // Make the effect's uniform block of the given name read from a uniform buffer binding
+  // point. Returns false if the effect has no such block.
+  bool BindBlock(const char* const blockName, GLuint bindingPoint);
+
+  // Per-draw transforms. The camera's transforms and position, and the logarithmic depth
+  // constants, are the same for every draw in a frame and come from the FrameConstants
+  // block instead (see Context::SetFrameConstants).
   EffectUniform* WorldMatrix;
-  EffectUniform* ViewMatrix;
-  EffectUniform* ProjectionMatrix;
-  EffectUniform* ViewProjectionMatrix;
   EffectUniform* WorldViewProjectionMatrix;
 
-  EffectUniform* CameraPosition;
-
-  // Values to configure the computation of logarithmic rather than linear depth.
-  // See http://www.gamedev.net/blog/73/entry-2006307-tip-of-the-day-logarithmic-zbuffer-artifacts-fix
-  // but basically:
-  //
-  //          | log((C * zClip) + offset) |
-  //  depth = | ------------------------- |
-  //          |  log((C * far) + offset)  |
-  //
-  // where,
-  // - C is a constant controlling depth precision (smaller increases precision at
-  //    distance at the expense of loosing precision close-in.
-  // - zClip is the clip-space (ie. post-projection transform) z coordinate
-  // - offset controls how close the near clip plane can be to the camera (bigger == less near clipping)
-  //    (e.g. 2.0 gives a clip plane of a few centimeters)
-  // - far is the distance from the camera to the far clip plane (in world units).
-
-  // Since the divisor is constant for a whole render frame, it is precomputed on the CPU.
-  EffectUniform* LogDepthConstant;
-  EffectUniform* LogDepthOffset;
-  EffectUniform* LogDepthDivisor;
+  // Tiling noise textures used by the fractal functions in common.glsl (see NoiseTextures).
+  EffectUniform* NoiseTexture2D;
+  EffectUniform* NoiseTexture3D;
 
 protected:
   virtual void Initialise();
 
-  typedef std::map<std::string, EffectUniform> ParameterList;
-  ParameterList parameters;
+  UniformTable parameters;
 
   GLuint programHandle;
 
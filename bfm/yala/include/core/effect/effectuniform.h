@@ -1,8 +1,14 @@
 #if ! defined(__EFFECT_UNIFORM__)
 #define __EFFECT_UNIFORM__
 
+#include <map>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include <gl_loader/gl_loader.h>
+#include <boost/noncopyable.hpp>
+
+class UniformTable;
 
 //---------------------------------------------------------------------------------------
 
@@ -10,7 +16,7 @@ class EffectUniform
 {
 public:
   EffectUniform()
-    : location(-1), modified(false)
+    : table(NULL), location(-1), type(GL_NONE), size(0), offset(0), index(0), dirty(false)
   {
   }
 
@@ -32,11 +38,50 @@ public:
   void Set(const glm::dmat4& value);
 
 private:
+  void SetValue(const void* const value, size_t valueSize);
+
+  UniformTable* table;    // NULL for names the program doesn't have
   GLint location;
   GLenum type;
-  bool modified;
-  double cache[16];
+  unsigned int size;      // bytes in the value of the uniform's GL type
+  unsigned int offset;    // of the value in the table's storage
+  unsigned int index;     // in the table
+  bool dirty;             // on the table's dirty list
+
+  friend class UniformTable;
+  friend class Effect;
+};
+
+//---------------------------------------------------------------------------------------
+
+// All of an effect's uniforms, stored densely: an entry per active uniform in one array,
+// their values packed into one block with each sized for its GL type, and a list of those
+// Set to a new value since the effect was last applied. Applying the effect then costs
+// only as much as the uniforms which changed.
+class UniformTable : public boost::noncopyable
+{
+public:
+  // Add a uniform. All are added when the program is loaded, before any are looked up.
+  void Add(const char* const name, GLint location, GLenum type);
+
+  // Look up a uniform by name. A name the program doesn't have (e.g. one the compiler
+  // optimised away) gives a uniform which ignores Set.
+  EffectUniform& operator[](const char* const name);
+
+private:
+  unsigned char* Value(unsigned int offset) { return (unsigned char*)&values[0] + offset; }
+
+  std::vector<EffectUniform> uniforms;
+  std::vector<double> values;           // doubles so that every value is 8 byte aligned
+  std::vector<unsigned int> dirty;      // indices of uniforms to upload
+  std::map<std::string, unsigned int> names;
+  EffectUniform missing;
+
+  // Over all tables since Effect::ResetCounters.
+  static unsigned int uploadsIssued;
+  static unsigned int uploadsSkipped;
 
+  friend class EffectUniform;
   friend class Effect;
 };
 
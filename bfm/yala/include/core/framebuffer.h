@@ -0,0 +1,65 @@
+// An off-screen render target: a colour texture plus a depth buffer.
+//
+// Drawing goes to the framebuffer between Bind and Unbind; the context's Clear and Draw
+// methods work as normal. The colour texture can be read back to the CPU without stalling
+// the pipeline by queuing a read one frame and collecting it a frame or two later.
+
+#if ! defined(__FRAMEBUFFER__)
+#define __FRAMEBUFFER__
+
+#include <glm/glm.hpp>
+#include <gl_loader/gl_loader.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/textures/texture2d.h>
+
+class Framebuffer : public boost::noncopyable
+{
+public:
+  // colourFormat - internal format of the colour texture (e.g. GL_RGBA8)
+  Framebuffer(const glm::uvec2& size, GLenum colourFormat);
+  ~Framebuffer();
+
+  // Direct drawing to the framebuffer and set the viewport to cover it.
+  void Bind();
+
+  // Direct drawing back to the window and restore the viewport in use when Bind was called.
+  void Unbind();
+
+  // Queue a copy of the colour texture into CPU-visible memory.
+  // dataFormat, dataType - format to read the pixels as (e.g. GL_RGBA, GL_UNSIGNED_BYTE)
+  // Must be called while the framebuffer is bound.
+  void ReadColour(GLenum dataFormat, GLenum dataType);
+
+  // Copy out the oldest queued read if the GPU has finished it.
+  // Returns true if data was filled in, otherwise false (nothing queued, or not yet done).
+  bool GetColour(void* const data, size_t size);
+
+  Texture2DPtr GetColourTexture() const { return colour; }
+  const glm::uvec2& GetSize() const { return size; }
+
+  // Reads which may be in flight at once; any more overwrite the oldest.
+  static const unsigned int ReadBufferCount = 2;
+
+private:
+  const glm::uvec2 size;
+  GLuint framebuffer;
+  GLuint depth;
+  Texture2DPtr colour;
+  GLint savedViewport[4];
+
+  struct ReadBuffer
+  {
+    GLuint buffer;
+    GLsync fence;
+    size_t size;
+  };
+
+  ReadBuffer reads[ReadBufferCount];
+  unsigned int nextRead;        // next buffer to queue a read into
+  unsigned int queuedReads;
+};
+
+typedef boost::shared_ptr<Framebuffer> FramebufferPtr;
+
+#endif // __FRAMEBUFFER__
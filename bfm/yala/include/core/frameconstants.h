@@ -0,0 +1,32 @@
+// Values which are the same for every draw in a frame, shared by all effects through the
+// FrameConstants uniform block declared in common.glsl.
+//
+// Context::SetFrameConstants writes them to a uniform buffer once per frame; every effect's
+// block is bound to the same binding point when it is loaded, so nothing is set per effect.
+
+#if ! defined(__FRAME_CONSTANTS__)
+#define __FRAME_CONSTANTS__
+
+#include <glm/glm.hpp>
+
+struct FrameConstants
+{
+  // Uniform buffer binding point which every effect's FrameConstants block reads from.
+  static const unsigned int BindingPoint = 0;
+
+  // Must match the std140 layout of the block in common.glsl: matrices are four vec4
+  // columns, and the vec3 is padded out to a vec4 by the float after it.
+  glm::mat4 viewMatrix;
+  glm::mat4 projectionMatrix;
+  glm::mat4 viewProjectionMatrix;
+  glm::vec3 cameraPosition;
+
+  // Logarithmic depth (see ComputeDepth in common.glsl).
+  float logDepthConstant;
+  float logDepthOffset;
+  float logDepthDivisor;
+
+  float padding[2];
+};
+
+#endif // __FRAME_CONSTANTS__
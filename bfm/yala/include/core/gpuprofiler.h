@@ -0,0 +1,82 @@
+// Times named scopes of GL work on the GPU.
+//
+// BeginScope and EndScope each write a GL_TIMESTAMP query into the command stream, so
+// scopes may nest. A frame's queries aren't read until Frames frames later, when the GPU
+// has long since finished them, so reading results never waits on the GPU; if it is so far
+// behind that they're still not ready the frame's timings are dropped rather than waited
+// for. Timings of scopes with the same name are summed over the frame.
+//
+// A context owns a profiler; see Context::BeginGpuScope, and GpuScope below.
+
+#if ! defined(__GPU_PROFILER__)
+#define __GPU_PROFILER__
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+class GpuProfiler : public boost::noncopyable
+{
+public:
+  // Frames of queries in flight at once.
+  static const unsigned int Frames = 4;
+
+  // Frames of timings kept for each scope's statistics.
+  static const unsigned int HistoryFrames = 240;
+
+  struct Stats
+  {
+    std::string name;
+    unsigned int depth;         // scopes open around it when first seen
+    unsigned int samples;       // frames it was timed in, at most HistoryFrames
+    double averageMS;
+    double minimumMS;
+    double maximumMS;
+    double medianMS;
+    double percentile95MS;
+    double percentile99MS;
+  };
+
+  GpuProfiler();
+  ~GpuProfiler();
+
+  void BeginScope(const char* const name);
+  void EndScope();
+
+  // Close the frame's scopes, and collect the timings of the oldest frame in flight.
+  void EndFrame();
+
+  // Statistics for each scope timed in the last HistoryFrames frames, in the order they
+  // were first seen (so nested scopes follow those they're nested in).
+  std::vector<Stats> GetStats() const;
+
+  // Write each frame's timings to a CSV file as they're collected: a line per scope with
+  // the frame number, scope name, depth and milliseconds.
+  bool StartLog(const char* const filename);
+  void StopLog();
+  bool Logging() const;
+
+  // Frames whose timings weren't ready in time.
+  unsigned int FramesDropped() const;
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+//------------------------------------------------------------------------
+
+// Times its own scope, e.g. GpuScope scope(*context, "planet").
+class Context;
+class GpuScope : public boost::noncopyable
+{
+public:
+  GpuScope(Context& context, const char* const name);
+  ~GpuScope();
+
+private:
+  Context& context;
+};
+
+#endif // __GPU_PROFILER__
@@ -0,0 +1,41 @@
+// Reorders index buffers to make best use of the GPU's post-transform vertex cache and
+// measures how well a given ordering uses that cache.
+
+#if ! defined(__INDEX_OPTIMISER__)
+#define __INDEX_OPTIMISER__
+
+#include <cstddef>
+#include <vector>
+#include <gl_loader/gl_loader.h>
+
+namespace IndexOptimiser
+{
+  // Typical post-transform cache size to optimise for. Smaller than most hardware caches
+  // since an ordering tuned for a small cache degrades gracefully on a bigger one.
+  static const unsigned int DefaultCacheSize = 16;
+
+  // Index used to restart triangle strips (see Context::DrawIndexed).
+  static const unsigned short RestartIndex = 0xFFFF;
+
+  struct CacheStats
+  {
+    unsigned int triangles;
+    unsigned int transforms;  // vertex shader invocations (cache misses)
+    double acmr;              // average cache miss ratio: transforms per triangle (0.5 is ideal)
+    double atvr;              // average transform to vertex ratio: transforms per unique vertex (1.0 is ideal)
+  };
+
+  // Reorder the triangles of an indexed triangle list in place using Tipsify
+  // (Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+  // Overdraw", 2007).
+  void OptimiseTriangles(std::vector<unsigned short>& indices, size_t vertexCount, unsigned int cacheSize = DefaultCacheSize);
+
+  // Simulate a FIFO vertex cache over an indexed triangle list or strip (GL_TRIANGLES or
+  // GL_TRIANGLE_STRIP, the latter optionally split with RestartIndex).
+  CacheStats Measure(const std::vector<unsigned short>& indices, size_t vertexCount, GLenum primitiveType, unsigned int cacheSize = DefaultCacheSize);
+
+  // Write a before/after comparison to the log.
+  void Report(const char* const name, const CacheStats& before, const CacheStats& after);
+}
+
+#endif // __INDEX_OPTIMISER__
@@ -0,0 +1,59 @@
+#if ! defined(__MAPPED_FILE__)
+#define __MAPPED_FILE__
+
+#include <cstddef>
+#include <map>
+#include <SDL.h>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+// Read-only access to a file mapped into the address space a window at a time.
+// Pages are faulted in by the OS on first access, and a window is only mapped once something
+// in it is read, so opening even a file far bigger than a 32-bit address space is cheap; only
+// the windows actually read take up address space.
+class MappedFile : public boost::noncopyable
+{
+public:
+  // Bytes of the file each window starts, and the most Read hands out at once. Each window
+  // runs on MaxRead bytes into the next, so no read ever straddles two.
+  static const size_t WindowSize = 16 * 1024 * 1024;
+  static const size_t MaxRead = 1024 * 1024;
+
+  MappedFile();
+  ~MappedFile();
+
+  // Returns true if the file was opened for mapping, otherwise false.
+  bool Open(const char* const filename);
+
+  // Unmap every window, invalidating every pointer Read has returned.
+  void Close();
+
+  bool IsOpen() const;
+
+  boost::uint64_t Size() const { return size; }
+
+  // Pointer to the bytes (at most MaxRead) from offset, mapping the window they lie in if it
+  // isn't already. Valid until Close. NULL if they aren't all in the file or the window
+  // can't be mapped (e.g. the address space is full). May be called from several threads
+  // at once.
+  const void* Read(boost::uint64_t offset, size_t bytes) const;
+
+private:
+  // Map or unmap the window starting at WindowSize * window.
+  const char* MapWindow(boost::uint64_t window) const;
+  void UnmapWindow(boost::uint64_t window, const char* const view) const;
+  size_t WindowBytes(boost::uint64_t window) const;
+
+  boost::uint64_t size;
+  mutable std::map<boost::uint64_t, const char*> windows;  // views mapped, by window
+  mutable SDL_SpinLock windowLock;
+
+#if defined(_WIN32)
+  void* file;
+  void* mapping;
+#else
+  int file;
+#endif
+};
+
+#endif // __MAPPED_FILE__
@@ -0,0 +1,19 @@
+// Minimal reader for the meshes in 3D Studio (.3ds) files: vertex positions and
+// triangles only. Materials, texture coordinates, smoothing groups and the keyframer
+// are skipped.
+
+#if ! defined(__MODEL_3DS__)
+#define __MODEL_3DS__
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Model3ds
+{
+  // Read every mesh in a file into one indexed triangle list.
+  // The output is modified on successful return only.
+  // Returns true if the file held at least one mesh, otherwise false.
+  bool Load(const char* const filename, std::vector<glm::vec3>& positions, std::vector<unsigned short>& indices);
+}
+
+#endif // __MODEL_3DS__
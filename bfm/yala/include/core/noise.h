@@ -0,0 +1,58 @@
+// Simplex noise and fractals built from it, evaluated on the CPU.
+//
+// Each function comes in two forms: one point at a time, and batched over arrays of points
+// held as separate x, y and z arrays. The batched forms run several points at once through
+// SIMD kernels (AVX2 when the compiler targets it, otherwise SSE2) and give the same
+// results as the single point forms, so the two can be mixed freely.
+//
+// Nothing is cached between calls: every function may be called from any number of
+// threads at once.
+
+#if ! defined(__NOISE__)
+#define __NOISE__
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+namespace Noise
+{
+  // Parameters of the fractals. Each octave is lacunarity times the frequency and gain
+  // times the amplitude of the one before, and uses its own seed so that the octaves'
+  // lattices don't line up.
+  struct Fractal
+  {
+    Fractal() : octaves(8), lacunarity(2.0f), gain(0.5f), offset(0.7f) { }
+
+    unsigned int octaves;
+    float lacunarity;
+    float gain;
+    float offset;     // hybrid multifractal: raises the signal; ridged: height of the ridges
+  };
+
+  // 3D simplex noise in [-1,1].
+  float Simplex(const glm::vec3& p, unsigned int seed = 0);
+
+  // Fractional Brownian motion: the sum of octaves of noise.
+  float FBm(const glm::vec3& p, const Fractal& fractal, unsigned int seed = 0);
+
+  // Hybrid multifractal (Musgrave, Texturing & Modeling, p502): each octave is weighted by
+  // those before it, so low areas stay smooth while high ones get rough. Roughly in [0,2]
+  // for an offset of 0.7.
+  float HybridMultifractal(const glm::vec3& p, const Fractal& fractal, unsigned int seed = 0);
+
+  // Ridged multifractal (ibid., p504): sharp crests where the noise crosses zero, each
+  // octave weighted by those before it so that detail gathers on the ridges.
+  float Ridged(const glm::vec3& p, const Fractal& fractal, unsigned int seed = 0);
+
+  // Batched forms: evaluate count points, writing one result per point. Arrays may have
+  // any alignment; results may not overlap the inputs.
+  void Simplex(const float* const x, const float* const y, const float* const z, float* const results, size_t count, unsigned int seed = 0);
+  void FBm(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed = 0);
+  void HybridMultifractal(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed = 0);
+  void Ridged(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed = 0);
+
+  // Name of the instruction set the batched forms were built for, e.g. "SSE2".
+  const char* KernelName();
+}
+
+#endif // __NOISE__
@@ -0,0 +1,84 @@
+// A queue of draws executed by Context::Execute in the order of their sort keys rather than
+// the order they were submitted, so that draws sharing an effect, vertex array or textures
+// run together and the context's state diffing has as little to change as possible.
+//
+// A packet captures everything its draw needs: a copy of the draw state, and optionally a
+// block of a UniformRing for its per-draw uniforms. Effect parameters set with
+// EffectUniform::Set are not captured, so they must be the same for every packet using an
+// effect; per-draw values go in a uniform ring block instead.
+
+#if ! defined(__RENDER_QUEUE__)
+#define __RENDER_QUEUE__
+
+#include <cstddef>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <gl_loader/gl_loader.h>
+#include <core/drawstate.h>
+#include <core/buffers/uniformring.h>
+
+//------------------------------------------------------------------------
+
+struct DrawPacket
+{
+  DrawPacket()
+    : key(0), primitiveType(GL_TRIANGLES), indexed(false), count(0), start(0), baseVertex(0),
+      uniformRing(NULL), uniformBinding(0), uniformBlock(0)
+  {
+  }
+
+  boost::uint64_t key;          // see RenderQueue::MakeKey
+
+  GLenum primitiveType;
+  bool indexed;                 // drawn with Context::DrawIndexed rather than Context::Draw
+  size_t count;                 // vertices, or indices if indexed
+  size_t start;                 // first vertex, or first index if indexed
+  size_t baseVertex;            // added to each index if indexed
+  DrawState drawState;
+
+  // Uniform ring block bound for the draw, if uniformRing isn't NULL.
+  UniformRing* uniformRing;
+  GLuint uniformBinding;
+  size_t uniformBlock;
+};
+
+//------------------------------------------------------------------------
+
+class RenderQueue : public boost::noncopyable
+{
+public:
+  // Fields of a sort key, most significant first. Effects, vertex arrays and textures are
+  // hashed into their fields, so unrelated ones may share a value; that only costs a state
+  // change, since draws with equal keys run in the order they were submitted.
+  static const unsigned int PassBits = 4;
+  static const unsigned int EffectBits = 12;
+  static const unsigned int VertexArrayBits = 12;
+  static const unsigned int TextureBits = 16;
+  static const unsigned int DepthBits = 20;
+
+  // pass - draws of a lower pass run before any of a higher one
+  // depth - in [0,1]; nearer draws run first within a group sharing state (e.g. the
+  //  distance to the camera over the far clip distance), or 0 where order doesn't matter
+  static boost::uint64_t MakeKey(unsigned int pass, const DrawState& drawState, float depth);
+
+  void Submit(const DrawPacket& packet);
+
+  bool Empty() const { return packets.empty(); }
+  void Clear();
+
+  // Order the packets by key, stable for equal keys.
+  void Sort();
+
+  // The packets in sorted order (after Sort).
+  size_t Count() const { return packets.size(); }
+  const DrawPacket& operator[](size_t i) const { return packets[order[i]]; }
+
+private:
+  std::vector<DrawPacket> packets;
+  std::vector<boost::uint64_t> keys;
+  std::vector<unsigned int> order;
+  std::vector<unsigned int> scratch;
+};
+
+#endif // __RENDER_QUEUE__
@@ -1,6 +1,7 @@
 #if ! defined(__RENDER_STATE__)
 #define __RENDER_STATE__
 
+#include <glm/glm.hpp>
 #include <core/renderstate/blending.h>
 #include <core/renderstate/culling.h>
 #include <core/renderstate/depthtest.h>
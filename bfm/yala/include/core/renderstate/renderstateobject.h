@@ -0,0 +1,60 @@
+// An immutable render state: a RenderState description baked once (by
+// Device::NewRenderState) into an object with a small integer id.
+//
+// Identical descriptions give the same object, so two states are equal exactly when their
+// ids are, and the context compares only ids per draw. Whenever an object is created the
+// GL state groups it differs in from every other object are worked out, so changing from
+// one state to another makes only the GL calls for the groups which actually change.
+
+#if ! defined(__RENDER_STATE_OBJECT__)
+#define __RENDER_STATE_OBJECT__
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/renderstate/renderstate.h>
+
+class RenderStateObject;
+typedef boost::shared_ptr<const RenderStateObject> RenderStatePtr;
+
+class RenderStateObject : public boost::noncopyable
+{
+public:
+  // Groups of GL state which may differ between two objects.
+  struct Change
+  {
+    enum Enum
+    {
+      ColourMask      = 1 << 0,
+      DepthMask       = 1 << 1,
+      DepthTest       = 1 << 2,
+      DepthFunction   = 1 << 3,
+      Culling         = 1 << 4,
+      CullFace        = 1 << 5,
+      FrontFace       = 1 << 6,
+      PolygonMode     = 1 << 7,
+      Blending        = 1 << 8,
+      BlendFunction   = 1 << 9,
+      BlendEquation   = 1 << 10
+    };
+  };
+
+  // The object for a description, creating it if no identical one exists yet.
+  static RenderStatePtr Get(const RenderState& description);
+
+  // The object for a default constructed description.
+  static RenderStatePtr Default();
+
+  // Change flags for going from one object to another.
+  static unsigned int Changes(const RenderStateObject& from, const RenderStateObject& to);
+
+  unsigned int Id() const { return id; }
+  const RenderState& Description() const { return description; }
+
+private:
+  RenderStateObject(unsigned int id, const RenderState& description);
+
+  const unsigned int id;
+  const RenderState description;
+};
+
+#endif // __RENDER_STATE_OBJECT__
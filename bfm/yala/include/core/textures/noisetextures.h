@@ -0,0 +1,53 @@
+// Tiling gradient noise held in textures.
+//
+// Shaders build fractals from a filtered fetch or two per octave rather than evaluating
+// noise arithmetically, which is both quicker and the same on every driver (GLSL's noise
+// functions are deprecated and return zero on some). The textures are generated on the CPU
+// when initialised: Perlin gradient noise over a lattice which wraps at the texture's edges,
+// so the noise tiles seamlessly with a repeating sampler.
+//
+// common.glsl declares the samplers and the fractal functions which use them; Apply binds
+// the textures for any effect.
+
+#if ! defined(__NOISE_TEXTURES__)
+#define __NOISE_TEXTURES__
+
+#include <boost/noncopyable.hpp>
+#include <core/drawstate.h>
+#include <core/textures/texture2d.h>
+#include <core/textures/texture3d.h>
+#include <core/textures/sampler.h>
+
+class NoiseTextures : public boost::noncopyable
+{
+public:
+  // Texels along each edge of the textures and lattice cells they cover (must match
+  // common.glsl). Sizes must be multiples of 4 and cells powers of 2 no more than 256.
+  static const unsigned int Size2D = 256;
+  static const unsigned int Cells2D = 32;
+  static const unsigned int Size3D = 64;
+  static const unsigned int Cells3D = 16;
+
+  // Texture units the textures are bound to by Apply.
+  static const unsigned int Unit2D = 6;
+  static const unsigned int Unit3D = 7;
+
+  NoiseTextures();
+  ~NoiseTextures();
+
+  void Initialise(unsigned int seed = 0);
+
+  void Apply(Effect& effect, DrawState& drawState) const;
+
+  // Fill output with noise in [-1,1] sampled at the centres of size texels (x varying
+  // fastest) spanning the given number of lattice cells. Four texels at a time with SSE2.
+  static void Generate2D(unsigned int size, unsigned int cells, unsigned int seed, float* const output);
+  static void Generate3D(unsigned int size, unsigned int cells, unsigned int seed, float* const output);
+
+private:
+  Texture2DPtr texture2D;
+  Texture3DPtr texture3D;
+  SamplerPtr sampler;
+};
+
+#endif // __NOISE_TEXTURES__
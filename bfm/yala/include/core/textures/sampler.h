@@ -0,0 +1,36 @@
+// Texture sampler object.
+
+#if ! defined(__SAMPLER__)
+#define __SAMPLER__
+
+#include <gl_loader/gl_loader.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+class Sampler : public boost::noncopyable
+{
+public:
+  Sampler();
+  ~Sampler();
+
+  void Bind(GLuint textureUnit) { glBindSampler(textureUnit, sampler); }
+  static void Unbind(GLuint textureUnit) { glBindSampler(textureUnit, 0); }
+
+  void SetMinFilter(GLenum value);
+  void SetMagFilter(GLenum value);
+
+  // Wrap modes for the s, t and r texture coordinates.
+  void SetWrap(GLenum s, GLenum t, GLenum r = GL_REPEAT);
+
+  GLenum GetMinFilter() const { return minFilter; }
+  GLenum GetMagFilter() const { return magFilter; }
+
+private:
+  GLuint sampler;
+  GLenum minFilter;
+  GLenum magFilter;
+};
+
+typedef boost::shared_ptr<Sampler> SamplerPtr;
+
+#endif // __SAMPLER__
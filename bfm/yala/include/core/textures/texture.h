@@ -0,0 +1,46 @@
+#if ! defined(__TEXTURE__)
+#define __TEXTURE__
+
+#include <gl_loader/gl_loader.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+// Base class for textures.
+class Texture : public boost::noncopyable
+{
+public:
+  virtual ~Texture() { glDeleteTextures(1, &texture); }
+
+  void Bind() { glBindTexture(type, texture); }
+  void Unbind() { glBindTexture(type, 0); }
+
+  GLenum GetTextureType() const { return type; }
+  GLenum GetInternalFormat() const { return internalFormat; }
+  GLuint GetHandle() const { return texture; }
+
+  // Texture unit used while creating and updating textures so that the bindings made by
+  // a context's draw state are left undisturbed.
+  static const GLuint ScratchUnit = 31;
+
+protected:
+  Texture(GLenum type, GLenum internalFormat)
+    : type(type), internalFormat(internalFormat)
+  {
+    glGenTextures(1, &texture);
+  }
+
+  // Bind the texture to the scratch unit ready for an update.
+  void BindForUpdate()
+  {
+    glActiveTexture(GL_TEXTURE0 + ScratchUnit);
+    Bind();
+  }
+
+  GLuint texture;
+  const GLenum type;
+  const GLenum internalFormat;
+};
+
+typedef boost::shared_ptr<Texture> TexturePtr;
+
+#endif // __TEXTURE__
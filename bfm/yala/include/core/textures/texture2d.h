@@ -0,0 +1,50 @@
+#if ! defined(__TEXTURE_2D__)
+#define __TEXTURE_2D__
+
+#include <glm/glm.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/textures/texture.h>
+
+struct Texture2DDescription
+{
+  Texture2DDescription() { }
+
+  Texture2DDescription(GLenum internalFormat, const glm::uvec2& size, bool makeMipMaps = false)
+    : makeMipMaps(makeMipMaps),
+      internalFormat(internalFormat),
+      size(size)
+  {
+  }
+
+  bool makeMipMaps;
+  GLenum internalFormat;
+  glm::uvec2 size;
+};
+
+class Texture2D : public Texture
+{
+public:
+  Texture2D(const Texture2DDescription& description);
+  virtual ~Texture2D();
+
+  // Replace the whole of the top level image, regenerating mip maps if the texture has them.
+  // dataFormat - format of the input data (e.g. GL_RGBA)
+  // dataType - type of the input data (e.g. GL_FLOAT, GL_UNSIGNED_BYTE)
+  void SetData(const void* const data, GLenum dataFormat, GLenum dataType);
+
+  // Replace a rectangle of one mip level, leaving the rest of the texture (and any other
+  // levels) untouched.
+  void SetData(unsigned int level, const glm::uvec2& offset, const glm::uvec2& size, const void* const data, GLenum dataFormat, GLenum dataType);
+
+  // Number of mip levels in the texture.
+  unsigned int GetLevelCount() const;
+
+  const glm::uvec2& GetSize() const { return description.size; }
+
+private:
+  const Texture2DDescription description;
+};
+
+typedef boost::shared_ptr<Texture2D> Texture2DPtr;
+
+#endif // __TEXTURE_2D__
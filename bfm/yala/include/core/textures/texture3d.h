@@ -0,0 +1,41 @@
+#if ! defined(__TEXTURE_3D__)
+#define __TEXTURE_3D__
+
+#include <glm/glm.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/textures/texture.h>
+
+struct Texture3DDescription
+{
+  Texture3DDescription() { }
+
+  Texture3DDescription(GLenum internalFormat, const glm::uvec3& size)
+    : internalFormat(internalFormat),
+      size(size)
+  {
+  }
+
+  GLenum internalFormat;
+  glm::uvec3 size;
+};
+
+class Texture3D : public Texture
+{
+public:
+  Texture3D(const Texture3DDescription& description);
+  virtual ~Texture3D();
+
+  // Replace the whole volume.
+  // dataFormat - format of the input data (e.g. GL_RGBA)
+  // dataType - type of the input data (e.g. GL_FLOAT, GL_UNSIGNED_BYTE)
+  void SetData(const void* const data, GLenum dataFormat, GLenum dataType);
+
+  const glm::uvec3& GetSize() const { return description.size; }
+
+private:
+  const Texture3DDescription description;
+};
+
+typedef boost::shared_ptr<Texture3D> Texture3DPtr;
+
+#endif // __TEXTURE_3D__
@@ -1,12 +1,13 @@
 #if ! defined(__TEXTURE_UNIT__)
 #define __TEXTURE_UNIT__
 
-#include <boost/shared_ptr.hpp>
+#include <core/textures/texture.h>
+#include <core/textures/sampler.h>
 
 struct TextureUnit
 {
-  boost::shared_ptr<class Texture> texture;
-  boost::shared_ptr<class Sampler> sampler;
+  TexturePtr texture;
+  SamplerPtr sampler;
 };
 
 #endif // __TEXTURE_UNIT__
@@ -13,6 +13,11 @@ public:
   VertexArray(VertexBufferPtr vertexBuffer);
   VertexArray(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer);
 
+  // shared - address the buffers' GL buffers from their starts rather than from the vertex
+  // and index buffers themselves, so that any others with the same layout in the same GL
+  // buffers can be drawn with it by their base vertex and index; see Device::NewSharedVertexArray
+  VertexArray(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer, bool shared);
+
   ~VertexArray();
 
   void Enable() { glBindVertexArray(vao); }
@@ -23,12 +28,16 @@ public:
 
   const VertexLayout& GetVertexLayout() const { return vertexBuffer->GetVertexLayout(); }
 
+  // Bytes from the start of the GL buffer to index 0 of a draw.
+  size_t GetIndexOffset() const { return indexOffset; }
+
 private:
   GLuint vao;
   VertexBufferPtr vertexBuffer;
   IndexBufferPtr indexBuffer;
+  size_t indexOffset;
 
-  void Initialise(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer);
+  void Initialise(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer, bool shared);
 };
 
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
@@ -29,12 +29,25 @@ namespace VertexSemantic
   };
 }
 
+// How the shader sees an attribute's components.
+namespace VertexFormat
+{
+  enum Enum
+  {
+    Float,        // converted to float as-is (e.g. GL_FLOAT, GL_HALF_FLOAT)
+    Normalised,   // fixed point mapped to [0,1] (unsigned types) or [-1,1] (signed types, e.g. snorm16)
+    Integer       // passed through unconverted to an int/uint shader input
+  };
+}
+
 struct VertexAttribute
 {
   VertexSemantic::Enum semantic;
   GLenum type;                    // float, uint, etc.
   size_t elements;                // 1 for float, 2 for vec2, etc.
   size_t offset;                  // byte offset from start of vertex structure
+  VertexFormat::Enum format;      // defaults to Float if omitted from an initialiser
+  unsigned int divisor;           // 0 = per vertex, N = advance once every N instances
 };
 
 #endif // __VERTEX_ATTRIBUTE__
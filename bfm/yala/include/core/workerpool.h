@@ -0,0 +1,46 @@
+// A fixed set of worker threads which execute queued jobs.
+// Jobs must not make GL calls since the workers have no GL context.
+
+#if ! defined(__WORKER_POOL__)
+#define __WORKER_POOL__
+
+#include <cstddef>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+class WorkerPool : public boost::noncopyable
+{
+public:
+  typedef boost::function<void ()> Job;
+
+  // Process a range of items [begin, end).
+  typedef boost::function<void (size_t begin, size_t end)> RangeJob;
+
+  // Create the pool.
+  // threadCount - number of worker threads, or 0 for one per CPU core.
+  explicit WorkerPool(unsigned int threadCount = 0);
+  ~WorkerPool();
+
+  // Queue a job for execution on the next available worker.
+  void Submit(const Job& job);
+
+  // Block the calling thread until every job submitted so far has completed.
+  void Wait();
+
+  // Split [0, count) into contiguous batches, process them across all workers and
+  // wait for completion. The batches go ahead of any jobs already queued and only they
+  // are waited for, so a ParallelFor isn't held up by long-running background jobs.
+  void ParallelFor(size_t count, const RangeJob& job);
+
+  unsigned int ThreadCount() const;
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+typedef boost::shared_ptr<WorkerPool> WorkerPoolPtr;
+
+#endif // __WORKER_POOL__
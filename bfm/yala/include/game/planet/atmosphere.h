@@ -0,0 +1,95 @@
+// Precomputed atmospheric scattering.
+//
+// Single scattering through a Rayleigh + Mie atmosphere is integrated on the CPU into three
+// lookup tables which the sky and planet shaders sample instead of integrating per pixel
+// (after Bruneton & Neyret, "Precomputed Atmospheric Scattering", 2008):
+//
+//    transmittance   2D, (view zenith cosine, altitude) - light surviving to the top of the atmosphere
+//    scattering      3D, (view zenith cosine, sun zenith cosine, altitude) - light scattered
+//                    towards the viewer along a ray; Rayleigh in rgb, Mie red in alpha
+//    irradiance      2D, (sun zenith cosine, altitude) - sky light reaching the ground
+//
+// The scattering table drops Bruneton's fourth (view/sun azimuth) dimension by assuming the
+// sun lies in the view's vertical plane while integrating; the phase functions are applied
+// in the shaders using the true angle.
+//
+// The tables are built across a WorkerPool. Changing the parameters rebuilds only the
+// tables that depend on what changed, in the background, and the new tables replace the
+// old ones once complete.
+
+#if ! defined(__ATMOSPHERE__)
+#define __ATMOSPHERE__
+
+#include <glm/glm.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <core/context.h>
+#include <core/drawstate.h>
+#include <core/workerpool.h>
+#include <game/cameras/camera.h>
+#include <game/planet/atmosphereeffect.h>
+
+// Distances are in the same units as the planet radius (km).
+struct AtmosphereParameters
+{
+  // An Earth-like atmosphere scaled to a planet of the given radius.
+  explicit AtmosphereParameters(double groundRadius);
+
+  double groundRadius;
+  double topRadius;
+
+  glm::dvec3 rayleighScattering;  // scattering coefficient per unit distance at ground level
+  double rayleighScaleHeight;
+
+  double mieScattering;           // scattering coefficient per unit distance at ground level
+  double mieExtinction;           // scattering + absorption
+  double mieScaleHeight;
+  double mieG;                    // Mie phase function asymmetry, in (-1, 1)
+
+  glm::dvec3 sunIntensity;        // only used by the shaders; changing it rebuilds nothing
+};
+
+class Atmosphere : public boost::noncopyable
+{
+public:
+  // Table dimensions (must match scattering.glsl).
+  static const unsigned int TransmittanceMuSize = 256;
+  static const unsigned int TransmittanceRSize = 64;
+  static const unsigned int ScatteringMuSize = 128;
+  static const unsigned int ScatteringMuSSize = 32;
+  static const unsigned int ScatteringRSize = 32;
+  static const unsigned int IrradianceMuSSize = 64;
+  static const unsigned int IrradianceRSize = 16;
+
+  // Texture units the tables are bound to by Apply.
+  static const unsigned int TransmittanceUnit = 0;
+  static const unsigned int ScatteringUnit = 1;
+  static const unsigned int IrradianceUnit = 2;
+
+  explicit Atmosphere(WorkerPool& workers);
+  ~Atmosphere();
+
+  // Build every table, blocking until they are ready, and load the sky effect.
+  void Initialise(const AtmosphereParameters& parameters);
+
+  // Schedule a background rebuild of the tables affected by the new parameters.
+  void SetParameters(const AtmosphereParameters& parameters);
+  const AtmosphereParameters& GetParameters() const;
+
+  // Swap in any tables finished since the last call and start pending rebuilds.
+  // Call once per frame from the thread which owns the GL context.
+  void Update();
+
+  // Set the atmosphere uniforms of an effect and bind the tables to the draw state.
+  void Apply(AtmosphereEffect& effect, DrawState& drawState) const;
+
+  // Draw the sky behind everything else.
+  // sunDirection - unit vector indicating direction of light (from its source).
+  void Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection);
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __ATMOSPHERE__
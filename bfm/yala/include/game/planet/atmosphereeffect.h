@@ -0,0 +1,31 @@
+#if ! defined(__ATMOSPHERE_EFFECT__)
+#define __ATMOSPHERE_EFFECT__
+
+#include <core/effect/effect.h>
+
+// Uniforms shared by every effect which includes scattering.glsl.
+class AtmosphereEffect : public Effect
+{
+public:
+  AtmosphereEffect();
+  virtual ~AtmosphereEffect();
+
+  EffectUniform* SunDirection;
+  EffectUniform* GroundRadius;
+  EffectUniform* TopRadius;
+  EffectUniform* RayleighScattering;
+  EffectUniform* MieG;
+  EffectUniform* SunIntensity;
+
+  EffectUniform* TransmittanceTable;
+  EffectUniform* ScatteringTable;
+  EffectUniform* IrradianceTable;
+
+  // Sky only: maps clip space to a world space view direction.
+  EffectUniform* InverseViewProjection;
+
+protected:
+  virtual void Initialise();
+};
+
+#endif // __ATMOSPHERE_EFFECT__
@@ -0,0 +1,65 @@
+// Cheap stand-ins for a planet too small on screen to need its quadtree.
+//
+// Below a few hundred pixels across the planet is drawn as a low-polygon sphere, coloured
+// from whatever the virtual texture has resident (its root pages always are) and lit like
+// the patches. Smaller still, the sphere is rendered into a texture and the planet becomes
+// a billboard showing it. The texture is only re-rendered once the view direction, the
+// sun or the distance have changed enough for the old picture to show.
+
+#if ! defined(__FAR_FIELD__)
+#define __FAR_FIELD__
+
+#include <glm/glm.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <core/context.h>
+#include <game/cameras/camera.h>
+#include <game/planet/atmosphere.h>
+#include <game/planet/virtualtexture.h>
+
+// How a planet is drawn.
+namespace PlanetRepresentation
+{
+  enum Enum
+  {
+    Quadtree,     // the full quadtree of patches
+    Mesh,         // one low-polygon sphere
+    Impostor      // a billboard of a cached picture of the sphere
+  };
+}
+
+class FarField : public boost::noncopyable
+{
+public:
+  // Diameters on screen, in pixels, below which each stand-in takes over. Switching back
+  // needs the planet to grow a little past the threshold so it doesn't flicker at the edge.
+  static const unsigned int MeshDiameter = 384;
+  static const unsigned int ImpostorDiameter = 96;
+
+  // Edge length of the impostor's texture.
+  static const unsigned int ImpostorSize = 256;
+
+  FarField(double radius);
+  ~FarField();
+
+  void Initialise();
+
+  // Pick the representation for the planet's size on screen this frame.
+  // viewportHeight - in pixels
+  PlanetRepresentation::Enum Select(const Camera& camera, unsigned int viewportHeight);
+
+  // Draw the planet as a sphere or impostor (Quadtree draws nothing).
+  void Draw(
+    ContextPtr context,
+    const Camera& camera,
+    const glm::vec3& sunDirection,
+    const Atmosphere& atmosphere,
+    const VirtualTexture& virtualTexture,
+    PlanetRepresentation::Enum representation);
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __FAR_FIELD__
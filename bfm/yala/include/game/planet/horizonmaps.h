@@ -0,0 +1,55 @@
+// Terrain self-shadowing from precomputed horizon maps.
+//
+// For points on a grid over each patch, the elevation of the horizon is found in a fixed
+// number of azimuth directions by marching outwards over the terrain. A point is in shadow
+// when the sun is below the horizon in its direction, so the planet effect can shadow the
+// surface with a couple of texture fetches and the maps stay valid however the sun moves.
+//
+// Maps are generated on worker threads when a patch first becomes visible and uploaded as
+// one small texture per patch: the sines of the horizon elevations, azimuths 0-3 in the
+// left half and 4-7 in the right. Until a patch's map is ready it is drawn unshadowed.
+
+#if ! defined(__HORIZON_MAPS__)
+#define __HORIZON_MAPS__
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/drawstate.h>
+#include <core/workerpool.h>
+#include <game/planet/patchinfo.h>
+#include <game/planet/planeteffect.h>
+
+// A patch's horizon map. Owned by the patch and freed with it.
+struct PatchHorizon;
+typedef boost::shared_ptr<PatchHorizon> PatchHorizonPtr;
+
+class HorizonMaps : public boost::noncopyable
+{
+public:
+  // Map dimensions (must match planet.glsl). Azimuth 0 is along the face's right axis,
+  // increasing towards its forward axis.
+  static const unsigned int Size = 9;
+  static const unsigned int Azimuths = 8;
+
+  // Texture unit a patch's map is bound to by Apply.
+  static const unsigned int HorizonUnit = 5;
+
+  HorizonMaps(WorkerPool& workers, double radius);
+  ~HorizonMaps();
+
+  void Initialise();
+
+  // Start generating a patch's map in the background.
+  PatchHorizonPtr Generate(const PatchInfo& patch);
+
+  // Bind a patch's map for drawing, uploading it first if it has just been generated.
+  // A patch with no map (or whose map is not ready) is bound a map which shadows nothing.
+  void Apply(PlanetEffect& effect, DrawState& drawState, PatchHorizon* const patch);
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __HORIZON_MAPS__
@@ -0,0 +1,20 @@
+#if ! defined(__IMPOSTOR_EFFECT__)
+#define __IMPOSTOR_EFFECT__
+
+#include <core/effect/effect.h>
+
+class ImpostorEffect : public Effect
+{
+public:
+  ImpostorEffect();
+  virtual ~ImpostorEffect();
+
+  EffectUniform* ImpostorRight;
+  EffectUniform* ImpostorUp;
+  EffectUniform* ImpostorTexture;
+
+private:
+  virtual void Initialise();
+};
+
+#endif // __IMPOSTOR_EFFECT__
@@ -0,0 +1,19 @@
+#if ! defined(__PAGE_FEEDBACK_EFFECT__)
+#define __PAGE_FEEDBACK_EFFECT__
+
+#include <game/planet/planeteffect.h>
+
+// Draws planet patches into the virtual texture's feedback buffer (pagefeedback.glsl).
+class PageFeedbackEffect : public PlanetEffect
+{
+public:
+  PageFeedbackEffect();
+  virtual ~PageFeedbackEffect();
+
+  EffectUniform* FeedbackBias;
+
+protected:
+  virtual void Initialise();
+};
+
+#endif // __PAGE_FEEDBACK_EFFECT__
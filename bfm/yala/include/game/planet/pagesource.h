@@ -0,0 +1,87 @@
+// Where the pages of a planet's virtual texture come from.
+//
+// Pages are loaded on worker threads, so every source must be safe to call from several
+// threads at once.
+//
+// A page file, as written by the tilebaker tool with -pages, has the layout (all offsets in
+// bytes from the start of the file):
+//
+//    page 0          FileHeader
+//    dataOffset      pageCount x PlanetPage::ByteSize texels, in PlanetTile::TileIndex order
+//
+// Pages are a whole number of OS pages long, so each one can be copied straight out of the
+// file mapping (see MappedFile), which is mapped a window at a time as pages are read.
+
+#if ! defined(__PAGE_SOURCE__)
+#define __PAGE_SOURCE__
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/mappedfile.h>
+#include <game/planet/planetpage.h>
+
+class PageSource : public boost::noncopyable
+{
+public:
+  virtual ~PageSource() { }
+
+  // Fill in the PlanetPage::ByteSize bytes of a page.
+  // Returns true if the page was loaded, otherwise false.
+  virtual bool Load(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned char* const texels) const = 0;
+};
+
+typedef boost::shared_ptr<PageSource> PageSourcePtr;
+
+//---------------------------------------------------------------------------
+
+// Generates every page as it is asked for.
+class ProceduralPageSource : public PageSource
+{
+public:
+  explicit ProceduralPageSource(double radius);
+
+  virtual bool Load(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned char* const texels) const;
+
+private:
+  const double radius;
+};
+
+//---------------------------------------------------------------------------
+
+// Serves pages from a baked file, handing anything deeper than the bake to another source.
+class PageFile : public PageSource
+{
+public:
+  static const boost::uint32_t Version = 2;
+  static const boost::uint32_t Alignment = 4096;
+
+  struct FileHeader
+  {
+    char magic[4];                  // "BFMP"
+    boost::uint32_t version;
+    boost::uint32_t pageSize;       // must equal PlanetPage::Size
+    boost::uint32_t levels;         // number of quadtree levels baked, starting at 0
+    boost::uint32_t pageCount;
+    boost::uint32_t reserved;
+    boost::uint64_t dataOffset;
+    double radius;                  // planet radius the pages were baked for
+  };
+
+  // fallback - source of pages deeper than the file holds (may be null)
+  explicit PageFile(PageSourcePtr fallback);
+  virtual ~PageFile();
+
+  // Open the file and validate its header against the planet it is going to serve.
+  // Returns true if the file is usable, otherwise false.
+  bool Open(const char* const filename, double radius);
+
+  virtual bool Load(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned char* const texels) const;
+
+private:
+  MappedFile file;
+  const FileHeader* header;
+  PageSourcePtr fallback;
+};
+
+#endif // __PAGE_SOURCE__
@@ -0,0 +1,25 @@
+#if ! defined(__PATCH_INFO__)
+#define __PATCH_INFO__
+
+#include <glm/glm.hpp>
+#include <boost/shared_ptr.hpp>
+#include <game/planet/planettile.h>
+
+// Everything about a planet patch needed by jobs which work on it in the background.
+struct PatchInfo
+{
+  unsigned int face;
+  unsigned int level;
+  unsigned int x;
+  unsigned int y;
+  glm::dvec3 centre;      // on the cube
+  double width;
+  glm::dvec3 right;       // face axes
+  glm::dvec3 forward;
+
+  // Heights; tileOwner keeps generated tiles alive while a worker reads them.
+  const PlanetTile::Data* tile;
+  boost::shared_ptr<const PlanetTile::Data> tileOwner;
+};
+
+#endif // __PATCH_INFO__
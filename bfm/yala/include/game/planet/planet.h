@@ -5,27 +5,84 @@
 #include <boost/scoped_ptr.hpp>
 #include <core/context.h>
 #include <game/cameras/camera.h>
+#include <game/planet/atmosphere.h>
 
 class Planet
 {
 public:
+  // A ray for Intersect. The direction must be unit length.
+  struct Ray
+  {
+    glm::dvec3 origin;
+    glm::dvec3 direction;
+    double maxDistance;
+  };
+
+  struct RayHit
+  {
+    bool hit;
+    double distance;
+    glm::dvec3 position;
+    glm::dvec3 normal;      // of the terrain surface
+  };
+
   Planet(double radius);
   ~Planet();
 
-  void Initialise();
+  // Serve patch heights from a file created by the tilebaker tool instead of generating
+  // them as the quadtree splits. Call before Initialise.
+  // Returns true if the file matches this planet and will be used, otherwise false.
+  bool UseTileCache(const char* const filename);
+
+  // Serve surface colour pages from a file created by the tilebaker tool with -pages,
+  // generating only those deeper than the file holds. Call before Initialise.
+  // Returns true if the file matches this planet and will be used, otherwise false.
+  bool UsePageFile(const char* const filename);
+
+  // viewportSize - size of the window the planet is drawn into, used to size the virtual
+  //                texture's feedback buffer
+  // Starts the level of detail thread.
+  void Initialise(const glm::ivec2& viewportSize);
+
+  // Change the atmosphere (an Earth-like one scaled to the planet's radius by default).
+  // The affected scattering tables are rebuilt in the background by Update.
+  void SetAtmosphere(const AtmosphereParameters& parameters);
 
+  // Hand the camera to the level of detail thread, which picks the patches to draw for it
+  // in the background. Returns straight away.
   void Update(float elapsedMS, const Camera& camera);
 
+  // Draw the patches most recently picked by the level of detail thread. If it has fallen
+  // behind, the last set it finished is drawn again.
   // context
   // camera
   // sunDirection - unit vector indicating direction of light (from its source).
   void Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection);
 
-  // Return the deepest level of detail for the current frame.
+  // Terrain queries, answered from the most detailed patches the quadtree has split down to
+  // so far (so are most accurate near the camera). Safe from any thread; they wait while
+  // the level of detail thread is splitting the quadtree.
+
+  // Height of the terrain above the planet's radius in a direction from its centre.
+  double SurfaceHeight(const glm::dvec3& direction) const;
+
+  // Height of a position above the terrain directly beneath (or above) it.
+  double Altitude(const glm::dvec3& position) const;
+
+  // Find the nearest point at which a ray meets the terrain.
+  // Returns hit.hit.
+  bool Intersect(const Ray& ray, RayHit& hit) const;
+
+  // Batched versions of the above, spread across the worker threads. They return once every
+  // query has been answered.
+  void SurfaceHeights(const glm::dvec3* const directions, double* const heights, size_t count) const;
+  void Intersect(const Ray* const rays, RayHit* const hits, size_t count) const;
+
+  // Return the deepest level of detail of the set being drawn.
   unsigned int DeepestLoDLevel() const;
 
-  // Return the total number of visible patches as well as the number of visible patches
-  // per cube face.
+  // Return the total number of patches in the set being drawn as well as the number per
+  // cube face.
   unsigned int PatchCount(unsigned int patchesPerFace[6]);
 
 private:
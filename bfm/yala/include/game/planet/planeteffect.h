@@ -1,20 +1,28 @@
 #if ! defined(__PLANET_EFFECT__)
 #define __PLANET_EFFECT__
 
-#include <core/effect/effect.h>
+#include <game/planet/atmosphereeffect.h>
 
-class PlanetEffect : public Effect
+class PlanetEffect : public AtmosphereEffect
 {
 public:
   PlanetEffect();
   virtual ~PlanetEffect();
 
-  EffectUniform* SunDirection;
+  // Per-patch values (centre, width and face) come from the PatchConstants uniform block
+  // instead (see patch.glsl).
   EffectUniform* Radius;
-  EffectUniform* Centre;
-  EffectUniform* Width;
 
-private:
+  // Virtual texture (see virtualtexture.glsl).
+  EffectUniform* PageTable;
+  EffectUniform* PageCache;
+  EffectUniform* VirtualLevels;
+  EffectUniform* CachePages;
+
+  // Per-patch horizon map (see HorizonMaps).
+  EffectUniform* HorizonMap;
+
+protected:
   virtual void Initialise();
 };
 
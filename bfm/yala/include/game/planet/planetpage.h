@@ -0,0 +1,25 @@
+// Surface colour for a single page of a planet's virtual texture, together with the
+// function that generates it.
+// Pages share their (face, level, x, y) addressing with PlanetTile: the page at an address
+// covers exactly the same area of the cube face as the tile there. Shared by the runtime
+// and the offline tilebaker tool.
+
+#if ! defined(__PLANET_PAGE__)
+#define __PLANET_PAGE__
+
+namespace PlanetPage
+{
+  // Texels along one edge of a page, including a border on each side which repeats the
+  // neighbouring pages' texels so that bilinear filtering never reads across a page edge.
+  static const unsigned int Size = 128;
+  static const unsigned int Border = 4;
+  static const unsigned int ContentSize = Size - (2 * Border);
+
+  // Pages are sRGB encoded RGBA, 8 bits per channel (alpha unused).
+  static const unsigned int ByteSize = Size * Size * 4;
+
+  // Evaluate the texels of a single page.
+  void Generate(unsigned int face, unsigned int level, unsigned int x, unsigned int y, double radius, unsigned char* const texels);
+}
+
+#endif // __PLANET_PAGE__
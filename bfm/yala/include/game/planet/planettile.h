@@ -0,0 +1,76 @@
+// Height and normal data for a single planet quadtree patch ("tile"), together with the
+// functions that generate it.
+// Shared by the runtime Planet and the offline tilebaker tool so that both agree exactly
+// on how a (face, level, x, y) tile address maps onto the sphere.
+
+#if ! defined(__PLANET_TILE__)
+#define __PLANET_TILE__
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+namespace PlanetTile
+{
+  // Vertices along one edge of a patch grid.
+  static const unsigned int GridSize = 17;
+  static const unsigned int VertexCount = GridSize * GridSize;
+
+  // Tiles are generated with a one vertex apron around the grid so that the normals at the
+  // edges match those of the neighbouring tiles.
+  static const unsigned int ApronSize = GridSize + 2;
+  static const unsigned int ApronVertexCount = ApronSize * ApronSize;
+
+  // Tallest possible terrain feature as a fraction of the planet's radius.
+  static const double MaxRelativeHeight = 0.01;
+
+  struct Data
+  {
+    // Height above the planet's radius in world units, row-major with x along the
+    // face's "right" axis and y along its "forward" axis.
+    float heights[VertexCount];
+
+    // Unit surface normals scaled to [-127, 127] (w is unused).
+    glm::i8vec4 normals[VertexCount];
+
+    float minHeight;
+    float maxHeight;
+  };
+
+  // Get the axes of a cube face. Face order is front, right, back, left, top, bottom.
+  void GetFaceBasis(unsigned int face, glm::dvec3& right, glm::dvec3& forward, glm::dvec3& up);
+
+  // Number of tiles on one face from level 0 down to (but not including) the given level.
+  inline unsigned int TilesAboveLevel(unsigned int level) { return ((1U << (2 * level)) - 1) / 3; }
+
+  // Linear index of a tile within a complete pyramid of the given number of levels.
+  inline unsigned int TileIndex(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned int levels)
+  {
+    return (face * TilesAboveLevel(levels)) + TilesAboveLevel(level) + (y << level) + x;
+  }
+
+  // Height above the planet's radius at a point on the unit sphere.
+  double ComputeHeight(const glm::dvec3& unitPosition, double radius);
+
+  // Heights of many points at once, as ComputeHeight but evaluated in SIMD batches.
+  void ComputeHeights(const glm::dvec3* const unitPositions, double* const heights, size_t count, double radius);
+
+  // The height function as it was before core/noise.h: glm::simplex, one point at a time.
+  // Its noise differs from ComputeHeight's; it's kept only as the baseline for
+  // tilebaker -benchmark.
+  double ComputeHeightGlm(const glm::dvec3& unitPosition, double radius);
+
+  // Bilinearly interpolated height at (u, v) in [0,1] across a tile.
+  float SampleHeight(const Data& tile, double u, double v);
+
+  // Evaluate the heights and normals of a single tile.
+  void Generate(unsigned int face, unsigned int level, unsigned int x, unsigned int y, double radius, Data& tile);
+
+  // The two halves of Generate, for callers with heights of their own: the unit sphere
+  // directions of a tile's grid and apron (ApronSize vertices square, row-major like the
+  // tile's heights), and the tile built from one height per direction.
+  void GetApronDirections(unsigned int face, unsigned int level, unsigned int x, unsigned int y, glm::dvec3* const directions);
+  void Build(const glm::dvec3* const directions, const double* const heights, double radius, Data& tile);
+}
+
+#endif // __PLANET_TILE__
@@ -0,0 +1,59 @@
+// Ground detail (rocks, shrubs) scattered over the most detailed planet patches.
+//
+// Each patch's instances are generated on a worker thread from a hash seeded by the patch's
+// address, so a patch always gets the same instances however often it is recreated. They
+// are kept in one instance buffer per patch, grouped by mesh and shuffled within each
+// group, and drawn with one instanced call per mesh. Density falls off with distance by
+// drawing only a leading fraction of each group. A patch's instance buffer is released once
+// the patch has gone undrawn for a while (split, or out of range), and its instances are
+// generated again if it's drawn after that.
+//
+// The meshes are simple enough to be generated in the vertex shader from gl_VertexID, so
+// the instance buffer is the only vertex data.
+
+#if ! defined(__SCATTER__)
+#define __SCATTER__
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <core/context.h>
+#include <core/workerpool.h>
+#include <game/cameras/camera.h>
+#include <game/planet/atmosphere.h>
+#include <game/planet/patchinfo.h>
+
+// Instances belonging to one patch. Owned by the patch; the GPU copy is released by Draw.
+struct PatchScatter;
+typedef boost::shared_ptr<PatchScatter> PatchScatterPtr;
+
+class Scatter : public boost::noncopyable
+{
+public:
+  Scatter(WorkerPool& workers, double radius);
+  ~Scatter();
+
+  void Initialise();
+
+  // Distances over which instance density falls from full to nothing.
+  void SetFadeDistances(double start, double end);
+
+  // Start generating a patch's instances in the background.
+  PatchScatterPtr Generate(const PatchInfo& patch);
+
+  // Draw the instances of those patches whose generation has finished.
+  void Draw(
+    ContextPtr context,
+    const Camera& camera,
+    const glm::vec3& sunDirection,
+    const Atmosphere& atmosphere,
+    const std::vector<PatchScatter*>& patches);
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __SCATTER__
@@ -0,0 +1,20 @@
+#if ! defined(__SCATTER_EFFECT__)
+#define __SCATTER_EFFECT__
+
+#include <game/planet/atmosphereeffect.h>
+
+class ScatterEffect : public AtmosphereEffect
+{
+public:
+  ScatterEffect();
+  virtual ~ScatterEffect();
+
+  EffectUniform* Origin;
+  EffectUniform* FaceRight;
+  EffectUniform* MeshType;
+
+private:
+  virtual void Initialise();
+};
+
+#endif // __SCATTER_EFFECT__
@@ -0,0 +1,69 @@
+// Read-only access to a file of pre-baked planet tiles, as written by the tilebaker tool.
+//
+// File layout (all offsets in bytes from the start of the file):
+//
+//    page 0          FileHeader
+//    indexOffset     tileCount x 64-bit offsets to each tile, in PlanetTile::TileIndex order
+//    dataOffset      tileCount x PlanetTile::Data, each padded to tileStride bytes
+//
+// Both the index and the tile data start on a page boundary. The file is mapped a window at
+// a time as tiles are read (see MappedFile), so even a cache far bigger than a 32-bit
+// address space can be used, and tiles are handed out as pointers straight into the
+// mapping.
+
+#if ! defined(__TILE_CACHE__)
+#define __TILE_CACHE__
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <core/mappedfile.h>
+#include <game/planet/planettile.h>
+
+class TileCache : public boost::noncopyable
+{
+public:
+  static const boost::uint32_t Version = 2;
+  static const boost::uint32_t PageSize = 4096;
+
+  // Most levels a cache may have; any more and tile indices overflow 32 bits.
+  static const boost::uint32_t MaxLevels = 15;
+
+  struct FileHeader
+  {
+    char magic[4];                  // "BFMT"
+    boost::uint32_t version;
+    boost::uint32_t gridSize;       // must equal PlanetTile::GridSize
+    boost::uint32_t levels;         // number of quadtree levels baked, starting at 0
+    boost::uint32_t tileCount;
+    boost::uint32_t tileStride;
+    boost::uint64_t indexOffset;
+    boost::uint64_t dataOffset;
+    double radius;                  // planet radius the tiles were baked for
+  };
+
+  TileCache();
+  ~TileCache();
+
+  // Open the file and validate its header against the planet it is going to serve, and its
+  // layout against the file's size, so that a truncated or corrupt cache is rejected here
+  // rather than read out of bounds later. Returns true if the cache is usable, otherwise
+  // false.
+  bool Open(const char* const filename, double radius);
+  void Close();
+
+  bool IsOpen() const { return NULL != header; }
+
+  unsigned int Levels() const { return header ? header->levels : 0; }
+
+  // Get a tile, or NULL if it is not in the cache (including a face, level, x or y out of
+  // range, an index entry outside the tile data, or a window of the file that can't be
+  // mapped).
+  // The pointer refers directly into the file mapping and remains valid until Close is called.
+  const PlanetTile::Data* GetTile(unsigned int face, unsigned int level, unsigned int x, unsigned int y) const;
+
+private:
+  MappedFile file;
+  const FileHeader* header;
+};
+
+#endif // __TILE_CACHE__
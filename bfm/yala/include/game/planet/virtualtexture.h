@@ -0,0 +1,88 @@
+// Virtual texturing of a planet's surface colour.
+//
+// Each cube face is covered by a quadtree of pages sharing PlanetTile's addressing, so
+// unique texels can be had at any resolution while GPU memory stays fixed:
+//
+//    page cache      one large texture holding a fixed number of resident pages
+//    page table      RGBA8UI, one texel per virtual page giving where (if anywhere) in the
+//                    cache the page lives; one mip level per quadtree level, with the six
+//                    faces laid out in a 3x2 grid
+//
+// Shaders (virtualtexture.glsl) pick a level from the screen-space footprint and walk up
+// the page table until they find a resident page, so a missing page shows its nearest
+// resident ancestor rather than nothing.
+//
+// Which pages are needed is found by a feedback pass: the surface is drawn into a small
+// off-screen buffer writing the address of the page each pixel wants. The buffer is read
+// back asynchronously a frame or two later, the pages it names (and their ancestors) are
+// marked as used, and missing ones are loaded on worker threads from a PageSource. Finished
+// pages are uploaded a few per frame, replacing the least recently used.
+
+#if ! defined(__VIRTUAL_TEXTURE__)
+#define __VIRTUAL_TEXTURE__
+
+#include <glm/glm.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <core/context.h>
+#include <core/drawstate.h>
+#include <core/workerpool.h>
+#include <game/planet/pagefeedbackeffect.h>
+#include <game/planet/pagesource.h>
+#include <game/planet/planeteffect.h>
+
+class VirtualTexture : public boost::noncopyable
+{
+public:
+  struct Description
+  {
+    Description()
+      : levels(10),
+        cachePages(32),
+        feedbackDivisor(8),
+        uploadsPerFrame(8),
+        loadsInFlight(16)
+    {
+    }
+
+    unsigned int levels;            // quadtree levels of pages, at most MaxLevels
+    unsigned int cachePages;        // pages along each edge of the page cache, at most 256
+    unsigned int feedbackDivisor;   // the feedback buffer is this many times smaller than the viewport
+    unsigned int uploadsPerFrame;   // most pages copied into the cache in one frame
+    unsigned int loadsInFlight;     // most pages being loaded by the workers at once
+  };
+
+  // The feedback pass packs page coordinates into 12 bits each.
+  static const unsigned int MaxLevels = 13;
+
+  // Texture units the page table and cache are bound to by Apply.
+  static const unsigned int PageTableUnit = 3;
+  static const unsigned int PageCacheUnit = 4;
+
+  explicit VirtualTexture(WorkerPool& workers);
+  ~VirtualTexture();
+
+  // Create the textures and feedback buffer and load the root page of each face, blocking
+  // until they are resident. The root pages are never evicted.
+  void Initialise(PageSourcePtr source, const Description& description, const glm::ivec2& viewportSize);
+
+  // Bracket the feedback pass, in which the surface is drawn with effect.
+  void BeginFeedback(ContextPtr context, PageFeedbackEffect& effect);
+  void EndFeedback();
+
+  // Act on any feedback which has arrived, upload finished pages and start loading missing
+  // ones. Call once per frame from the thread which owns the GL context.
+  void Update();
+
+  // Set the virtual texture uniforms of an effect and bind the textures to the draw state.
+  void Apply(PlanetEffect& effect, DrawState& drawState) const;
+
+  // Number of pages currently in the cache.
+  unsigned int ResidentPages() const;
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __VIRTUAL_TEXTURE__
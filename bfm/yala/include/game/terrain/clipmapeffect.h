@@ -0,0 +1,26 @@
+#if ! defined(__CLIPMAP_EFFECT__)
+#define __CLIPMAP_EFFECT__
+
+#include <core/effect/effect.h>
+
+class ClipmapEffect : public Effect
+{
+public:
+  ClipmapEffect();
+  virtual ~ClipmapEffect();
+
+  EffectUniform* LevelHeights;
+  EffectUniform* CoarserHeights;
+  EffectUniform* HasCoarser;
+  EffectUniform* LevelOffset;
+  EffectUniform* LevelSpacing;
+  EffectUniform* TexelOrigin;
+  EffectUniform* CoarserTexelOrigin;
+  EffectUniform* CameraHeight;
+  EffectUniform* SunDirection;
+
+private:
+  virtual void Initialise();
+};
+
+#endif // __CLIPMAP_EFFECT__
@@ -0,0 +1,67 @@
+// Terrain over a flat world drawn as a geometry clipmap (Losasso & Hoppe, "Geometry
+// Clipmaps: Terrain Rendering Using Nested Regular Grids").
+//
+// The terrain is a stack of square grids, all with the same number of vertices and each
+// twice the spacing of the one inside it, centred on the camera. Each level's heights are
+// kept in a texture addressed toroidally: a vertex's texel is its world grid position modulo
+// the texture size, so as the camera moves only the rows and columns which have just come
+// into a level are evaluated and uploaded. The rest of the texture stays where it is.
+//
+// Drawing is one call per level with no vertex data: the finest level in use is a full grid
+// and every coarser level a ring around the level inside it. Over its outer edge each level
+// blends its heights towards those of the next coarser level so that they meet without
+// cracks. There is no tree to traverse; which levels are drawn depends only on how high
+// the camera is above the ground.
+
+#if ! defined(__CLIPMAP_TERRAIN__)
+#define __CLIPMAP_TERRAIN__
+
+#include <glm/glm.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <core/context.h>
+#include <game/cameras/camera.h>
+
+class ClipmapTerrain : public boost::noncopyable
+{
+public:
+  // Height of the ground, in world units, at a point on the XZ plane.
+  typedef boost::function<float (const glm::dvec2&)> HeightFunction;
+
+  struct Description
+  {
+    Description() : levels(8), spacing(1.0) { }
+
+    unsigned int levels;
+    double spacing;         // between vertices of the finest level, in world units
+  };
+
+  // Texels along each edge of a level's height texture, and quads along each edge of its
+  // grid. The grid is a multiple of 4 quads so that the level inside it lies on its grid
+  // lines, and a little smaller than the texture so that there is room to move. Both must
+  // match clipmap.glsl.
+  static const unsigned int TextureSize = 256;
+  static const unsigned int GridQuads = 252;
+
+  ClipmapTerrain(const Description& description, const HeightFunction& height);
+  ~ClipmapTerrain();
+
+  void Initialise();
+
+  // Recentre the levels on the camera, evaluating heights for whatever has come into each
+  // level since the last update.
+  void Update(const Camera& camera);
+
+  void Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection);
+
+  // A hybrid multifractal of simplex noise: rolling hills with rougher high ground. Usable
+  // as the height function when there is nothing better.
+  static float FractalHeight(const glm::dvec2& position);
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> impl;
+};
+
+#endif // __CLIPMAP_TERRAIN__
@@ -0,0 +1,35 @@
+#if ! defined(__TERRAIN_HEIGHT_POOL__)
+#define __TERRAIN_HEIGHT_POOL__
+
+#include <vector>
+#include <textures/texture.h>
+#include <gl_loader/gl_loader.h>
+
+// Height maps for terrain nodes, one per layer of a single 2D array texture so that every
+// node's heights stay bound at once and a node selects its own with a layer index.
+// A node takes a layer when it is created and hands it back when it is merged away.
+class TerrainHeightPool : public Texture
+{
+public:
+  TerrainHeightPool();
+  virtual ~TerrainHeightPool();
+
+  // @param size [in] texels along each edge of a layer (one per grid vertex)
+  // @param layers [in] most nodes which may have heights at once (clamped to what GL allows)
+  void Initialise(size_t size, size_t layers);
+
+  // Take a free layer and fill it with a node's heights.
+  // @param heights [in] size*size values, row-major
+  // @return the layer, or -1 if every layer is in use
+  int Allocate(const float* const heights);
+
+  void Release(int layer);
+
+  size_t FreeLayers() const { return freeLayers.size(); }
+
+private:
+  size_t size;
+  std::vector<int> freeLayers;
+};
+
+#endif // __TERRAIN_HEIGHT_POOL__
@@ -7,6 +7,7 @@
 #include <camera.h>
 #include <scenestate.h>
 #include <vertexarray.h>
+#include <terrain/heightpool.h>
 #include <terrain/terraineffect.h>
 #include <boost/shared_ptr.hpp>
 
@@ -35,16 +36,20 @@ private:
   RenderState renderState;
   VertexArray geometry;
 
+  // Every node's heights, generated once when the node is created.
+  TerrainHeightPool heightPool;
+
   // The angle at which the horizon curves away, as seen by the camera.
   float horizonAngle;
 
   struct Node
   {
-    Node(float width, size_t startLoDLevel);
-    Node(const Node* const parent, size_t corner);
+    Node(float width, size_t startLoDLevel, TerrainHeightPool& heightPool);
+    Node(const Node* const parent, size_t corner, TerrainHeightPool& heightPool);
 
-    void Split();
-    void Merge();
+    // Nodes are only split if the pool has room for all four children's heights.
+    void Split(TerrainHeightPool& heightPool);
+    void Merge(TerrainHeightPool& heightPool);
 
     const Node* const parent;
     const float width;          // world-space unit width of the node
@@ -54,6 +59,7 @@ private:
     const glm::mat4 transform;  // places the node at the correct position and scale in world units
     glm::vec3 corners[4];
     boost::shared_ptr<Node> children[4];
+    int heightLayer;            // the node's layer in the height pool
   };
 
   boost::shared_ptr<Node> rootNode;
@@ -15,6 +15,8 @@ public:
   EffectUniform* MaxHeight;
   EffectUniform* TileWidth;
   EffectUniform* TileCentre;
+  EffectUniform* HeightPool;
+  EffectUniform* HeightLayer;
 
 private:
   virtual void Initialise()
@@ -22,6 +24,8 @@ private:
     MaxHeight = &parameters["MaxHeight"];
     TileWidth = &parameters["TileWidth"];
     TileCentre = &parameters["TileCentre"];
+    HeightPool = &parameters["HeightPool"];
+    HeightLayer = &parameters["HeightLayer"];
 
     Effect::Initialise();
   }
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <core/logging.h>
+#include <core/buffers/bufferheap.h>
+
+//------------------------------------------------------------------------
+
+BufferHeap::BufferHeap(GLenum usage, size_t blockSize)
+  : usage(usage),
+    blockSize(blockSize),
+    allocated(0)
+{
+}
+
+//------------------------------------------------------------------------
+
+BufferHeap::~BufferHeap()
+{
+  for (size_t b = 0; b < blocks.size(); ++b)
+  {
+    if (0 != blocks[b].buffer)
+    {
+      glDeleteBuffers(1, &blocks[b].buffer);
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+BufferHeap::Range BufferHeap::Allocate(size_t size, size_t alignment)
+{
+  size = std::max(size, size_t(1));
+  alignment = std::max(alignment, size_t(1));
+
+  Range range;
+  range.size = size;
+
+  for (unsigned int b = 0; b <= blocks.size(); ++b)
+  {
+    // Nothing fits in the blocks there are, so add one...
+    if (blocks.size() == b)
+    {
+      b = NewBlock(std::max(size, blockSize));
+    }
+
+    Block& block = blocks[b];
+    for (std::map<size_t, size_t>::iterator i = block.free.begin(); i != block.free.end(); ++i)
+    {
+      const size_t start = i->first;
+      const size_t end = i->first + i->second;
+      const size_t offset = ((start + alignment - 1) / alignment) * alignment;
+      if ((offset + size) > end)
+      {
+        continue;
+      }
+
+      // Whatever's left either side stays free...
+      block.free.erase(i);
+      if (offset > start)
+      {
+        block.free[start] = offset - start;
+      }
+      if ((offset + size) < end)
+      {
+        block.free[offset + size] = end - (offset + size);
+      }
+
+      range.buffer = block.buffer;
+      range.offset = offset;
+      range.block = b;
+      allocated += size;
+      return range;
+    }
+  }
+
+  // Never reached; a new block always fits...
+  range.buffer = 0;
+  range.offset = 0;
+  range.block = 0;
+  return range;
+}
+
+//------------------------------------------------------------------------
+
+void BufferHeap::Free(const Range& range)
+{
+  Block& block = blocks[range.block];
+  allocated -= range.size;
+
+  // Merge with the free ranges either side...
+  size_t offset = range.offset;
+  size_t size = range.size;
+
+  std::map<size_t, size_t>::iterator after = block.free.lower_bound(offset);
+  if ((block.free.end() != after) && ((offset + size) == after->first))
+  {
+    size += after->second;
+    block.free.erase(after++);
+  }
+
+  if (block.free.begin() != after)
+  {
+    std::map<size_t, size_t>::iterator before = after;
+    --before;
+    if ((before->first + before->second) == offset)
+    {
+      offset = before->first;
+      size += before->second;
+      block.free.erase(before);
+    }
+  }
+
+  block.free[offset] = size;
+
+  // The first block is kept for the next allocation, the others given back...
+  if ((0 != range.block) && (block.size == size))
+  {
+    glDeleteBuffers(1, &block.buffer);
+    block.buffer = 0;
+    block.size = 0;
+    block.free.clear();
+  }
+}
+
+//------------------------------------------------------------------------
+
+size_t BufferHeap::Reserved() const
+{
+  size_t reserved = 0;
+  for (size_t b = 0; b < blocks.size(); ++b)
+  {
+    reserved += blocks[b].size;
+  }
+  return reserved;
+}
+
+//------------------------------------------------------------------------
+
+// Add a block of size bytes, reusing a deleted block's slot if there is one, and return its
+// index.
+unsigned int BufferHeap::NewBlock(size_t size)
+{
+  unsigned int b = 0;
+  while ((b < blocks.size()) && (0 != blocks[b].buffer))
+  {
+    ++b;
+  }
+  if (blocks.size() == b)
+  {
+    blocks.push_back(Block());
+  }
+
+  Block& block = blocks[b];
+  block.size = size;
+  block.free[0] = size;
+
+  // Bound to the copy target so as not to disturb any vertex array's bindings...
+  glGenBuffers(1, &block.buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, block.buffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, usage);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  LOG("buffer heap block %u: %u bytes\n", b, (unsigned int)size);
+  return b;
+}
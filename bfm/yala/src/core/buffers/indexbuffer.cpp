@@ -16,27 +16,59 @@ static size_t SizeOf(GLenum indexType)
 
 //--------------------------------------------------------------------------------
 
-IndexBuffer::IndexBuffer(size_t indexCount, GLenum indexType, GLenum usage)
+IndexBuffer::IndexBuffer(size_t indexCount, GLenum indexType, BufferHeapPtr heap)
   : indexCount(indexCount),
     indexType(indexType),
-    typeSize(SizeOf(indexType))
+    typeSize(SizeOf(indexType)),
+    heap(heap)
 {
-  glGenBuffers(1, &buffer);
-  Enable();
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, typeSize * indexCount, NULL, usage);
-  Disable();
+  range = heap->Allocate(typeSize * indexCount, typeSize);
+  buffer = range.buffer;
+}
+
+//--------------------------------------------------------------------------------
+
+IndexBuffer::IndexBuffer(GLenum indexType, StreamingBufferPtr streamingBuffer)
+  : indexCount(streamingBuffer->GetSize() / SizeOf(indexType)),
+    indexType(indexType),
+    typeSize(SizeOf(indexType)),
+    buffer(streamingBuffer->GetBuffer()),
+    streamingBuffer(streamingBuffer)
+{
+  range.buffer = buffer;
+  range.offset = 0;
+  range.size = streamingBuffer->GetSize();
+  range.block = 0;
 }
 
 //--------------------------------------------------------------------------------
 
 IndexBuffer::~IndexBuffer()
 {
-  glDeleteBuffers(1, &buffer);
+  // A streaming buffer's own buffer is deleted with it...
+  if (heap)
+  {
+    heap->Free(range);
+  }
 }
 
 //--------------------------------------------------------------------------------
 
 void IndexBuffer::SetData(const void* const data, size_t indexCount, size_t startIndex)
 {
-  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, typeSize * startIndex, typeSize * indexCount, data);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.offset + (typeSize * startIndex), typeSize * indexCount, data);
+}
+
+//--------------------------------------------------------------------------------
+
+bool IndexBuffer::Stream(const void* const data, size_t indexCount, size_t& startIndex)
+{
+  size_t offset = 0;
+  if (!streamingBuffer->Write(data, typeSize * indexCount, typeSize, offset))
+  {
+    return false;
+  }
+
+  startIndex = offset / typeSize;
+  return true;
 }
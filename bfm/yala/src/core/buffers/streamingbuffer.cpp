@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <core/logging.h>
+#include <core/buffers/streamingbuffer.h>
+
+//------------------------------------------------------------------------
+
+// Every streaming buffer, for EndFrame. GL objects are only used by the main thread, so
+// there's no lock.
+static std::vector<StreamingBuffer*> streamingBuffers;
+
+//------------------------------------------------------------------------
+
+static bool Signalled(GLsync fence, GLbitfield flags, GLuint64 timeout);
+
+//------------------------------------------------------------------------
+
+StreamingBuffer::StreamingBuffer(size_t size)
+  : size(size),
+    mapping(NULL),
+    position(0),
+    fenced(0),
+    retired(0),
+    stalls(0),
+    overfilled(false)
+{
+  // Bound to the copy target so as not to disturb any vertex array's bindings...
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+  if (GLEW_ARB_buffer_storage)
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+    mapping = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+    if (!mapping)
+    {
+      LOG("couldn't persistently map a %u byte streaming buffer\n", (unsigned int)size);
+    }
+  }
+
+  if (!mapping)
+  {
+    glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  streamingBuffers.push_back(this);
+}
+
+//------------------------------------------------------------------------
+
+StreamingBuffer::~StreamingBuffer()
+{
+  streamingBuffers.erase(std::remove(streamingBuffers.begin(), streamingBuffers.end(), this), streamingBuffers.end());
+
+  for (size_t r = 0; r < regions.size(); ++r)
+  {
+    glDeleteSync(regions[r].fence);
+  }
+
+  if (mapping)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  glDeleteBuffers(1, &buffer);
+}
+
+//------------------------------------------------------------------------
+
+bool StreamingBuffer::Write(const void* const data, size_t bytes, size_t alignment, size_t& offset)
+{
+  if (bytes > size)
+  {
+    LOG("%u bytes won't fit in a %u byte streaming buffer\n", (unsigned int)bytes, (unsigned int)size);
+    return false;
+  }
+
+  // Align the start, going back to the start of the ring if there isn't room before the
+  // end...
+  const size_t current = size_t(position % size);
+  offset = ((current + alignment - 1) / alignment) * alignment;
+  boost::uint64_t start = position + (offset - current);
+  if ((offset + bytes) > size)
+  {
+    offset = 0;
+    start = position + (size - current);
+  }
+  const boost::uint64_t end = start + bytes;
+
+  // Wait for the GPU to finish with anything the write would overtake...
+  Retire();
+  while ((retired != position) && ((end - retired) > size))
+  {
+    if (regions.empty())
+    {
+      // The frame so far and this write fill the ring by themselves, so fence what's been
+      // written and wait for it...
+      if (!overfilled)
+      {
+        LOG("a frame overfilled a %u byte streaming buffer\n", (unsigned int)size);
+        overfilled = true;
+      }
+      Fence();
+    }
+
+    const Region& oldest = regions.front();
+    if (!Signalled(oldest.fence, 0, 0))
+    {
+      ++stalls;
+      while (!Signalled(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000))
+      {
+      }
+    }
+    Retire();
+  }
+
+  if (mapping)
+  {
+    std::memcpy(mapping + offset, data, bytes);
+  }
+  else
+  {
+    // The range is no longer in use, so there's no need for the GL to check...
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* const range = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes, access);
+    if (range)
+    {
+      std::memcpy(range, data, bytes);
+      glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  position = end;
+  return true;
+}
+
+//------------------------------------------------------------------------
+
+void StreamingBuffer::EndFrame()
+{
+  for (size_t b = 0; b < streamingBuffers.size(); ++b)
+  {
+    streamingBuffers[b]->Fence();
+    streamingBuffers[b]->Retire();
+  }
+}
+
+//------------------------------------------------------------------------
+
+void StreamingBuffer::Fence()
+{
+  if (fenced == position)
+  {
+    return;
+  }
+
+  Region region;
+  region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region.end = position;
+  regions.push_back(region);
+  fenced = position;
+}
+
+//------------------------------------------------------------------------
+
+// Forget the regions the GPU has finished with, oldest first. Until one is finished, those
+// after it can't be.
+void StreamingBuffer::Retire()
+{
+  while (!regions.empty() && Signalled(regions.front().fence, 0, 0))
+  {
+    retired = regions.front().end;
+    glDeleteSync(regions.front().fence);
+    regions.pop_front();
+  }
+
+  // Nothing in flight, so the whole ring is free...
+  if (regions.empty() && (fenced == position))
+  {
+    retired = position;
+  }
+}
+
+//------------------------------------------------------------------------
+
+// Whether the GPU has passed a fence, waiting up to timeout nanoseconds for it. A failed
+// wait counts as signalled, so that a lost context can't hang the caller.
+static bool Signalled(GLsync fence, GLbitfield flags, GLuint64 timeout)
+{
+  const GLenum status = glClientWaitSync(fence, flags, timeout);
+  if (GL_WAIT_FAILED == status)
+  {
+    LOG("%s\n", "waiting on a streaming buffer fence failed");
+    return true;
+  }
+  return (GL_ALREADY_SIGNALED == status) || (GL_CONDITION_SATISFIED == status);
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cstring>
+#include <core/logging.h>
+#include <core/buffers/uniformring.h>
+
+//------------------------------------------------------------------------
+
+UniformRing::UniformRing(size_t blockSize, size_t blocksPerFrame)
+  : blockSize(blockSize),
+    blocksPerFrame(std::max(blocksPerFrame, size_t(1))),
+    count(0),
+    offset(0)
+{
+  // Every block must start at a multiple of the GL's offset alignment (256 bytes on many
+  // GPUs)...
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  alignment = (alignment > 0) ? alignment : 1;
+  stride = ((blockSize + alignment - 1) / alignment) * alignment;
+
+  blocks.resize(stride * this->blocksPerFrame);
+  buffer.reset(new StreamingBuffer(stride * this->blocksPerFrame * Frames));
+}
+
+//------------------------------------------------------------------------
+
+UniformRing::~UniformRing()
+{
+}
+
+//------------------------------------------------------------------------
+
+void UniformRing::BeginFrame()
+{
+  count = 0;
+}
+
+//------------------------------------------------------------------------
+
+size_t UniformRing::Add(const void* const block)
+{
+  if (blocks.size() < (stride * (count + 1)))
+  {
+    blocks.resize(std::max(stride * (count + 1), blocks.size() * 2));
+  }
+
+  std::memcpy(&blocks[stride * count], block, blockSize);
+  return count++;
+}
+
+//------------------------------------------------------------------------
+
+void UniformRing::Upload()
+{
+  // The frame outgrew the buffer; replace it with one big enough to hold as many blocks
+  // for every frame (the GL keeps the old one until the GPU is done with it)...
+  if (count > blocksPerFrame)
+  {
+    blocksPerFrame = blocks.size() / stride;
+    buffer.reset(new StreamingBuffer(stride * blocksPerFrame * Frames));
+    LOG("uniform ring grown to %u blocks per frame\n", (unsigned int)blocksPerFrame);
+  }
+
+  // Every block is at a multiple of stride, so aligned...
+  if (count > 0)
+  {
+    buffer->Write(&blocks[0], stride * count, stride, offset);
+  }
+}
+
+//------------------------------------------------------------------------
+
+void UniformRing::Bind(GLuint bindingPoint, size_t index)
+{
+  glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer->GetBuffer(), offset + (stride * index), blockSize);
+}
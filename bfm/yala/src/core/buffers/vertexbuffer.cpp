@@ -2,23 +2,54 @@
 #include <core/buffers/vertexbuffer.h>
 #include <memory>
 
-VertexBuffer::VertexBuffer(const VertexLayout& vertexLayout, size_t vertexCount, GLenum usage)
+VertexBuffer::VertexBuffer(const VertexLayout& vertexLayout, size_t vertexCount, BufferHeapPtr heap)
   : vertexCount(vertexCount),
-    vertexLayout(vertexLayout)
+    vertexLayout(vertexLayout),
+    heap(heap)
 {
-  glGenBuffers(1, &buffer);
-  Enable();
-  glBufferData(GL_ARRAY_BUFFER, vertexLayout.GetStride() * vertexCount, NULL, usage);
-  Disable();
+  // Starting on a whole vertex, so that a shared vertex array can reach it by base vertex...
+  const size_t stride = vertexLayout.GetStride();
+  range = heap->Allocate(stride * vertexCount, stride);
+  buffer = range.buffer;
+}
+
+VertexBuffer::VertexBuffer(const VertexLayout& vertexLayout, StreamingBufferPtr streamingBuffer)
+  : buffer(streamingBuffer->GetBuffer()),
+    vertexCount(streamingBuffer->GetSize() / vertexLayout.GetStride()),
+    vertexLayout(vertexLayout),
+    streamingBuffer(streamingBuffer)
+{
+  range.buffer = buffer;
+  range.offset = 0;
+  range.size = streamingBuffer->GetSize();
+  range.block = 0;
 }
 
 VertexBuffer::~VertexBuffer()
 {
-  glDeleteBuffers(1, &buffer);
+  // A streaming buffer's own buffer is deleted with it...
+  if (heap)
+  {
+    heap->Free(range);
+  }
 }
 
 void VertexBuffer::SetData(const void* const data, size_t vertexCount, size_t startVertex)
 {
   const size_t stride = vertexLayout.GetStride();
-  glBufferSubData(GL_ARRAY_BUFFER, stride * startVertex, stride * vertexCount, data);
+  glBufferSubData(GL_ARRAY_BUFFER, range.offset + (stride * startVertex), stride * vertexCount, data);
+}
+
+bool VertexBuffer::Stream(const void* const data, size_t vertexCount, size_t& startVertex)
+{
+  // Starting on a whole vertex, attributes can stay pointing at the start of the buffer...
+  const size_t stride = vertexLayout.GetStride();
+  size_t offset = 0;
+  if (!streamingBuffer->Write(data, stride * vertexCount, stride, offset))
+  {
+    return false;
+  }
+
+  startVertex = offset / stride;
+  return true;
 }
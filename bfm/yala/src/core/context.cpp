@@ -1,5 +1,6 @@
 
 #include <core/context.h>
+#include <core/buffers/streamingbuffer.h>
 
 //------------------------------------------------------------------------
 
@@ -11,18 +12,24 @@ static void ApplyDrawState(const DrawState& newState, DrawState& oldState);
 
 static void ApplyEffect(Effect* const effect, DrawState& oldState);
 static void ApplyVertexArray(VertexArrayPtr vertexArray, DrawState& oldState);
-static void ApplyRenderState(const RenderState& newState, RenderState& oldState);
-static void ApplyColourMask(const glm::bvec4& newState, glm::bvec4& oldState);
-static void ApplyDepthMask(bool newState, bool& oldState);
-static void ApplyCulling(const Culling& newState, Culling& oldState);
-static void ApplyPolygonMode(GLenum newMode, GLenum& oldMode);
+static void ApplyTextureUnits(const TextureUnit newUnits[], TextureUnit oldUnits[]);
+static void ApplyRenderState(const RenderStatePtr& newState, RenderStatePtr& oldState);
+static void ApplyRestartIndex(GLenum indexType, GLenum& oldIndexType);
 
 //------------------------------------------------------------------------
 
 Context::Context()
+  : restartIndexType(GL_UNSIGNED_INT)
 {
   ForceClearState(clearState);
   ForceDrawState(drawState);
+
+  glEnable(GL_PRIMITIVE_RESTART);
+  glPrimitiveRestartIndex(0xFFFFFFFF);
+
+  // Bound once and left bound; effects' blocks are all assigned to the same binding point...
+  frameConstantBuffer.reset(new UniformBuffer(sizeof(FrameConstants)));
+  frameConstantBuffer->BindTo(FrameConstants::BindingPoint);
 }
 
 //------------------------------------------------------------------------
@@ -36,7 +43,33 @@ Context::~Context()
 void Context::Clear(const ClearState& clearState)
 {
   ApplyClearState(clearState, this->clearState);
+
+  // The write masks apply to clears as well as draws. Use the clear's for the clear, then
+  // put back those of the current render state...
+  const RenderState& current = drawState.renderState->Description();
+  const bool masksDiffer = (clearState.colourMask != current.colourMask) || (clearState.depthBufferMask != current.depthMask);
+  if (masksDiffer)
+  {
+    glColorMask(clearState.colourMask.r, clearState.colourMask.g, clearState.colourMask.b, clearState.colourMask.a);
+    glDepthMask(clearState.depthBufferMask);
+  }
+
   glClear(clearState.buffers);
+
+  if (masksDiffer)
+  {
+    glColorMask(current.colourMask.r, current.colourMask.g, current.colourMask.b, current.colourMask.a);
+    glDepthMask(current.depthMask);
+  }
+}
+
+//------------------------------------------------------------------------
+
+void Context::SetFrameConstants(const FrameConstants& frameConstants)
+{
+  frameConstantBuffer->Enable();
+  frameConstantBuffer->SetData(&frameConstants, sizeof(frameConstants));
+  frameConstantBuffer->Disable();
 }
 
 //------------------------------------------------------------------------
@@ -57,6 +90,15 @@ void Context::Draw(GLenum primitiveType, size_t vertexCount, size_t vertexStart,
 
 //------------------------------------------------------------------------
 
+void Context::DrawInstanced(GLenum primitiveType, size_t vertexCount, size_t instanceCount, size_t baseInstance, const DrawState& drawState)
+{
+  ApplyDrawState(drawState, this->drawState);
+
+  glDrawArraysInstancedBaseInstance(primitiveType, 0, vertexCount, instanceCount, baseInstance);
+}
+
+//------------------------------------------------------------------------
+
 void Context::DrawIndexed(GLenum primitiveType, size_t vertexCount, const DrawState& drawState)
 {
   DrawIndexed(primitiveType, vertexCount, 0, drawState);
@@ -65,11 +107,79 @@ void Context::DrawIndexed(GLenum primitiveType, size_t vertexCount, const DrawSt
 //------------------------------------------------------------------------
 
 void Context::DrawIndexed(GLenum primitiveType, size_t vertexCount, size_t vertexStart, const DrawState& drawState)
+{
+  DrawIndexed(primitiveType, vertexCount, vertexStart, 0, drawState);
+}
+
+//------------------------------------------------------------------------
+
+void Context::DrawIndexed(GLenum primitiveType, size_t indexCount, size_t indexStart, size_t baseVertex, const DrawState& drawState)
 {
   ApplyDrawState(drawState, this->drawState);
 
-  const GLenum indexType = drawState.vertexArray->GetIndexBuffer()->GetIndexType();
-  glDrawElements(primitiveType, vertexCount, indexType, (const void*)vertexStart);
+  const IndexBufferPtr indexBuffer = drawState.vertexArray->GetIndexBuffer();
+  const GLenum indexType = indexBuffer->GetIndexType();
+  ApplyRestartIndex(indexType, restartIndexType);
+
+  const void* const offset = (const void*)(drawState.vertexArray->GetIndexOffset() + (indexStart * indexBuffer->GetIndexSize()));
+  if (0 == baseVertex)
+  {
+    glDrawElements(primitiveType, indexCount, indexType, offset);
+  }
+  else
+  {
+    glDrawElementsBaseVertex(primitiveType, indexCount, indexType, offset, baseVertex);
+  }
+}
+
+//------------------------------------------------------------------------
+
+void Context::Execute(RenderQueue& queue)
+{
+  queue.Sort();
+
+  for (size_t i = 0; i < queue.Count(); ++i)
+  {
+    const DrawPacket& packet = queue[i];
+
+    if (packet.uniformRing)
+    {
+      packet.uniformRing->Bind(packet.uniformBinding, packet.uniformBlock);
+    }
+
+    if (packet.indexed)
+    {
+      DrawIndexed(packet.primitiveType, packet.count, packet.start, packet.baseVertex, packet.drawState);
+    }
+    else
+    {
+      Draw(packet.primitiveType, packet.count, packet.start, packet.drawState);
+    }
+  }
+
+  queue.Clear();
+}
+
+//------------------------------------------------------------------------
+
+void Context::BeginGpuScope(const char* const name)
+{
+  profiler.BeginScope(name);
+}
+
+//------------------------------------------------------------------------
+
+void Context::EndGpuScope()
+{
+  profiler.EndScope();
+}
+
+//------------------------------------------------------------------------
+
+void Context::EndFrame()
+{
+  profiler.EndFrame();
+  StreamingBuffer::EndFrame();
 }
 
 //------------------------------------------------------------------------
@@ -84,29 +194,26 @@ static void ForceClearState(const ClearState& state)
 
 static void ForceDrawState(const DrawState& state)
 {
-  glColorMask(
-    state.renderState.colourMask.r,
-    state.renderState.colourMask.g,
-    state.renderState.colourMask.b,
-    state.renderState.colourMask.a);
-  
-  glDepthMask(state.renderState.depthMask);
+  const RenderState& renderState = state.renderState->Description();
 
-  state.renderState.depthTest.enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
-  glDepthFunc(state.renderState.depthTest.function);
+  glColorMask(renderState.colourMask.r, renderState.colourMask.g, renderState.colourMask.b, renderState.colourMask.a);
+  glDepthMask(renderState.depthMask);
 
-  state.renderState.culling.enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
-  glCullFace(state.renderState.culling.faceToCull);
-  glFrontFace(state.renderState.culling.windingOrder);
+  renderState.depthTest.enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+  glDepthFunc(renderState.depthTest.function);
 
-  glPolygonMode(GL_FRONT_AND_BACK, state.renderState.mode);
+  renderState.culling.enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+  glCullFace(renderState.culling.faceToCull);
+  glFrontFace(renderState.culling.windingOrder);
 
-  state.renderState.blending.enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+  glPolygonMode(GL_FRONT_AND_BACK, renderState.mode);
+
+  renderState.blending.enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
 
   glBlendFuncSeparate(
-    state.renderState.blending.srcRGB, state.renderState.blending.dstRGB,
-    state.renderState.blending.srcAlpha, state.renderState.blending.dstAlpha);
-  glBlendEquationSeparate(state.renderState.blending.rgbEquation, state.renderState.blending.alphaEquation);
+    renderState.blending.srcRGB, renderState.blending.dstRGB,
+    renderState.blending.srcAlpha, renderState.blending.dstAlpha);
+  glBlendEquationSeparate(renderState.blending.rgbEquation, renderState.blending.alphaEquation);
 }
 
 //------------------------------------------------------------------------
@@ -124,9 +231,6 @@ static void ApplyClearState(const ClearState& newState, ClearState& oldState)
     glClearDepth(newState.depthValue);
     oldState.depthValue = newState.depthValue;
   }
-
-  ApplyColourMask(newState.colourMask, oldState.colourMask);
-  ApplyDepthMask(newState.depthBufferMask, oldState.depthBufferMask);
 }
 
 //------------------------------------------------------------------------
@@ -135,78 +239,68 @@ static void ApplyDrawState(const DrawState& newState, DrawState& oldState)
 {
   ApplyEffect(newState.effect, oldState);
   ApplyVertexArray(newState.vertexArray, oldState);
+  ApplyTextureUnits(newState.textureUnits, oldState.textureUnits);
   ApplyRenderState(newState.renderState, oldState.renderState);
 }
 
-static void ApplyRenderState(const RenderState& newState, RenderState& oldState)
-{
-  ApplyColourMask(newState.colourMask, oldState.colourMask);
-  ApplyDepthMask(newState.depthMask, oldState.depthMask);
-}
-
 //------------------------------------------------------------------------
 
-static void ApplyColourMask(const glm::bvec4& newState, glm::bvec4& oldState)
+// Render states are compared by id, and only the groups of GL state which differ between
+// the two (worked out when the newer of them was created) are changed.
+static void ApplyRenderState(const RenderStatePtr& newState, RenderStatePtr& oldState)
 {
-  if (newState != oldState)
+  if (newState->Id() == oldState->Id())
   {
-    glColorMask(newState.r, newState.g, newState.b, newState.a);
-    oldState = newState;
+    return;
   }
-}
 
-//------------------------------------------------------------------------
-
-static void ApplyDepthMask(bool newState, bool& oldState)
-{
-  if (newState != oldState)
+  typedef RenderStateObject::Change Change;
+  const unsigned int changes = RenderStateObject::Changes(*oldState, *newState);
+  const RenderState& state = newState->Description();
+
+  if (changes & Change::ColourMask)     { glColorMask(state.colourMask.r, state.colourMask.g, state.colourMask.b, state.colourMask.a); }
+  if (changes & Change::DepthMask)      { glDepthMask(state.depthMask); }
+  if (changes & Change::DepthTest)      { state.depthTest.enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST); }
+  if (changes & Change::DepthFunction)  { glDepthFunc(state.depthTest.function); }
+  if (changes & Change::Culling)        { state.culling.enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE); }
+  if (changes & Change::CullFace)       { glCullFace(state.culling.faceToCull); }
+  if (changes & Change::FrontFace)      { glFrontFace(state.culling.windingOrder); }
+  if (changes & Change::PolygonMode)    { glPolygonMode(GL_FRONT_AND_BACK, state.mode); }
+  if (changes & Change::Blending)       { state.blending.enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND); }
+
+  if (changes & Change::BlendFunction)
   {
-    glDepthMask(newState);
-    oldState = newState;
+    glBlendFuncSeparate(state.blending.srcRGB, state.blending.dstRGB, state.blending.srcAlpha, state.blending.dstAlpha);
   }
-}
 
-//------------------------------------------------------------------------
-
-static void ApplyCulling(const Culling& newState, Culling& oldState)
-{
-  if (oldState.enabled != newState.enabled)
+  if (changes & Change::BlendEquation)
   {
-    oldState.enabled = newState.enabled;
-    if (oldState.enabled)
-    {
-      glEnable(GL_CULL_FACE);
-    }
-    else
-    {
-      glDisable(GL_CULL_FACE);
-    }
-  }
-  if (oldState.faceToCull != newState.faceToCull)
-  {
-    oldState.faceToCull = newState.faceToCull;
-    glCullFace(newState.faceToCull);
-  }
-  if (oldState.windingOrder != newState.windingOrder)
-  {
-    oldState.windingOrder = newState.windingOrder;
-    glFrontFace(newState.windingOrder);
+    glBlendEquationSeparate(state.blending.rgbEquation, state.blending.alphaEquation);
   }
+
+  oldState = newState;
 }
 
 //------------------------------------------------------------------------
 
-static void ApplyPolygonMode(GLenum newMode, GLenum& oldMode)
+static void ApplyRestartIndex(GLenum indexType, GLenum& oldIndexType)
 {
-  if (newMode != oldMode)
+  if (indexType != oldIndexType)
   {
-    oldMode = newMode;
-    glPolygonMode(GL_FRONT_AND_BACK, newMode);
+    oldIndexType = indexType;
+    switch (indexType)
+    {
+    case GL_UNSIGNED_BYTE:  glPrimitiveRestartIndex(0xFF); break;
+    case GL_UNSIGNED_SHORT: glPrimitiveRestartIndex(0xFFFF); break;
+    default:                glPrimitiveRestartIndex(0xFFFFFFFF); break;
+    }
   }
 }
 
 //------------------------------------------------------------------------
 
+// Binds the effect's program, then uploads any of its uniforms Set since it was last
+// applied, so every draw (queued or not) sees its own effect's current values.
 static void ApplyEffect(Effect* const effect, DrawState& oldState)
 {
   if (effect != oldState.effect)
@@ -214,6 +308,8 @@ static void ApplyEffect(Effect* const effect, DrawState& oldState)
     oldState.effect = effect;
     effect->Enable();
   }
+
+  effect->Apply();
 }
 
 //------------------------------------------------------------------------
@@ -226,3 +322,38 @@ static void ApplyVertexArray(VertexArrayPtr vertexArray, DrawState& oldState)
     vertexArray->Enable();
   }
 }
+
+//------------------------------------------------------------------------
+
+static void ApplyTextureUnits(const TextureUnit newUnits[], TextureUnit oldUnits[])
+{
+  for (unsigned int i = 0; i < DrawState::MaxTextureUnits; ++i)
+  {
+    if (newUnits[i].texture != oldUnits[i].texture)
+    {
+      glActiveTexture(GL_TEXTURE0 + i);
+      if (newUnits[i].texture)
+      {
+        newUnits[i].texture->Bind();
+      }
+      else
+      {
+        oldUnits[i].texture->Unbind();
+      }
+      oldUnits[i].texture = newUnits[i].texture;
+    }
+
+    if (newUnits[i].sampler != oldUnits[i].sampler)
+    {
+      if (newUnits[i].sampler)
+      {
+        newUnits[i].sampler->Bind(i);
+      }
+      else
+      {
+        Sampler::Unbind(i);
+      }
+      oldUnits[i].sampler = newUnits[i].sampler;
+    }
+  }
+}
@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <vector>
+#include <core/logging.h>
+#include <core/cpuprofiler.h>
+
+//------------------------------------------------------------------------
+
+struct Zone
+{
+  const char* name;
+  Uint64 start;
+  Uint64 end;
+};
+
+// A thread's completed zones. Only the thread itself writes zones and advances written, and
+// only EndFrame reads them and advances read, so neither needs a lock.
+struct ThreadBuffer
+{
+  static const unsigned int Size = 16384;   // zones; a power of two
+
+  SDL_threadID thread;
+  const char* name;
+  SDL_atomic_t written;
+  SDL_atomic_t read;
+  SDL_atomic_t dropped;                     // zones lost to a full buffer
+  Zone zones[Size];
+};
+
+struct CapturedZone
+{
+  Zone zone;
+  unsigned int thread;
+};
+
+//------------------------------------------------------------------------
+
+static const unsigned int MaxThreads = 64;
+static const size_t MaxCapturedZones = 4 * 1024 * 1024;
+
+// Buffers are added, under registerLock, but never removed; a thread's is found by a search
+// of the first threadCount without locking.
+static ThreadBuffer* threads[MaxThreads];
+static SDL_atomic_t threadCount;
+static SDL_SpinLock registerLock;
+
+static std::vector<CapturedZone> capture;
+static unsigned int zonesDropped = 0;
+
+// Zones from threads which started after there were already MaxThreads, so have no buffer.
+static SDL_atomic_t unbufferedZones;
+
+volatile int CpuProfiler::recording = 0;
+
+//------------------------------------------------------------------------
+
+static ThreadBuffer* GetThreadBuffer();
+
+//------------------------------------------------------------------------
+
+void CpuProfiler::StartRecording()
+{
+  // Anything left over from before is stale...
+  recording = 0;
+  EndFrame();
+
+  capture.clear();
+  zonesDropped = 0;
+  SDL_AtomicSet(&unbufferedZones, 0);
+  recording = 1;
+}
+
+//------------------------------------------------------------------------
+
+void CpuProfiler::StopRecording()
+{
+  EndFrame();
+  recording = 0;
+}
+
+//------------------------------------------------------------------------
+
+bool CpuProfiler::Recording()
+{
+  return 0 != recording;
+}
+
+//------------------------------------------------------------------------
+
+void CpuProfiler::NameThread(const char* const name)
+{
+  ThreadBuffer* const buffer = GetThreadBuffer();
+  if (buffer)
+  {
+    buffer->name = name;
+  }
+}
+
+//------------------------------------------------------------------------
+
+void CpuProfiler::Record(const char* const name, Uint64 start, Uint64 end)
+{
+  ThreadBuffer* const buffer = GetThreadBuffer();
+  if (!buffer)
+  {
+    SDL_AtomicAdd(&unbufferedZones, 1);
+    return;
+  }
+
+  const unsigned int written = (unsigned int)SDL_AtomicGet(&buffer->written);
+  if ((written - (unsigned int)SDL_AtomicGet(&buffer->read)) >= ThreadBuffer::Size)
+  {
+    SDL_AtomicAdd(&buffer->dropped, 1);
+    return;
+  }
+
+  Zone& zone = buffer->zones[written & (ThreadBuffer::Size - 1)];
+  zone.name = name;
+  zone.start = start;
+  zone.end = end;
+
+  // The zone must be complete before EndFrame can see it...
+  SDL_MemoryBarrierRelease();
+  SDL_AtomicSet(&buffer->written, int(written + 1));
+}
+
+//------------------------------------------------------------------------
+
+void CpuProfiler::EndFrame()
+{
+  const unsigned int count = (unsigned int)SDL_AtomicGet(&threadCount);
+  SDL_MemoryBarrierAcquire();
+  for (unsigned int t = 0; t < count; ++t)
+  {
+    ThreadBuffer* const buffer = threads[t];
+    const unsigned int written = (unsigned int)SDL_AtomicGet(&buffer->written);
+    SDL_MemoryBarrierAcquire();
+
+    unsigned int read = (unsigned int)SDL_AtomicGet(&buffer->read);
+    if (recording)
+    {
+      for (; read != written; ++read)
+      {
+        if (capture.size() >= MaxCapturedZones)
+        {
+          zonesDropped += written - read;
+          break;
+        }
+
+        const CapturedZone captured = { buffer->zones[read & (ThreadBuffer::Size - 1)], t };
+        capture.push_back(captured);
+      }
+    }
+
+    SDL_AtomicSet(&buffer->read, int(written));
+    zonesDropped += (unsigned int)SDL_AtomicSet(&buffer->dropped, 0);
+  }
+}
+
+//------------------------------------------------------------------------
+
+bool CpuProfiler::WriteTrace(const char* const filename)
+{
+  FILE* const file = fopen(filename, "w");
+  if (!file)
+  {
+    LOG("couldn't write CPU trace %s\n", filename);
+    return false;
+  }
+
+  // Times are in microseconds from the first zone's start...
+  Uint64 origin = ~Uint64(0);
+  for (size_t i = 0; i < capture.size(); ++i)
+  {
+    origin = (capture[i].zone.start < origin) ? capture[i].zone.start : origin;
+  }
+  const double microseconds = 1000000.0 / double(SDL_GetPerformanceFrequency());
+
+  fprintf(file, "{\"traceEvents\":[\n");
+
+  const unsigned int count = (unsigned int)SDL_AtomicGet(&threadCount);
+  SDL_MemoryBarrierAcquire();
+  for (unsigned int t = 0; t < count; ++t)
+  {
+    if (threads[t]->name)
+    {
+      fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n", t, threads[t]->name);
+    }
+  }
+
+  for (size_t i = 0; i < capture.size(); ++i)
+  {
+    const Zone& zone = capture[i].zone;
+    fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+      zone.name, capture[i].thread, double(zone.start - origin) * microseconds, double(zone.end - zone.start) * microseconds);
+  }
+
+  // The array may not end with a comma, so close it with one last event...
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"yala\"}}\n]}\n");
+  fclose(file);
+
+  LOG("CPU trace %s: %u zones written, %u dropped\n", filename, (unsigned int)capture.size(), zonesDropped);
+
+  const unsigned int unbuffered = (unsigned int)SDL_AtomicGet(&unbufferedZones);
+  if (unbuffered > 0)
+  {
+    LOG("CPU trace %s: %u zones dropped from threads beyond the first %u\n", filename, unbuffered, MaxThreads);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------
+
+// The calling thread's buffer, added the first time it's needed. NULL if there are already
+// MaxThreads.
+static ThreadBuffer* GetThreadBuffer()
+{
+  const SDL_threadID thread = SDL_ThreadID();
+
+  const unsigned int count = (unsigned int)SDL_AtomicGet(&threadCount);
+  SDL_MemoryBarrierAcquire();
+  for (unsigned int t = 0; t < count; ++t)
+  {
+    if (thread == threads[t]->thread)
+    {
+      return threads[t];
+    }
+  }
+
+  // Only this thread can add its own buffer, so it can't have been added since the search...
+  ThreadBuffer* buffer = NULL;
+  SDL_AtomicLock(&registerLock);
+  const unsigned int index = (unsigned int)SDL_AtomicGet(&threadCount);
+  if (index < MaxThreads)
+  {
+    buffer = new ThreadBuffer;
+    buffer->thread = thread;
+    buffer->name = NULL;
+    SDL_AtomicSet(&buffer->written, 0);
+    SDL_AtomicSet(&buffer->read, 0);
+    SDL_AtomicSet(&buffer->dropped, 0);
+    threads[index] = buffer;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&threadCount, int(index + 1));
+  }
+  SDL_AtomicUnlock(&registerLock);
+
+  return buffer;
+}
@@ -1,8 +1,23 @@
+#include <map>
 #include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
 #include <core/device.h>
 
 //------------------------------------------------------------------------
 
+// Bytes in each of a buffer heap's GL buffers.
+static const size_t HeapBlockSize = 4 * 1024 * 1024;
+
+// A heap of each usage for each of vertices and indices, kept while any buffer uses it...
+static std::map<GLenum, boost::weak_ptr<BufferHeap> > vertexHeaps;
+static std::map<GLenum, boost::weak_ptr<BufferHeap> > indexHeaps;
+
+//------------------------------------------------------------------------
+
+static BufferHeapPtr GetHeap(std::map<GLenum, boost::weak_ptr<BufferHeap> >& heaps, GLenum usage);
+
+//------------------------------------------------------------------------
+
 WindowPtr Device::NewWindow(
   const char* const title,
   const glm::ivec2& size,
@@ -40,11 +55,23 @@ VertexArrayPtr Device::NewVertexArray(VertexBufferPtr vertexBuffer, IndexBufferP
   return va;
 }
 
+VertexArrayPtr Device::NewSharedVertexArray(VertexBufferPtr vertexBuffer)
+{
+  VertexArrayPtr va(new VertexArray(vertexBuffer, IndexBufferPtr(), true));
+  return va;
+}
+
+VertexArrayPtr Device::NewSharedVertexArray(VertexBufferPtr vertexBuffer, IndexBufferPtr indexBuffer)
+{
+  VertexArrayPtr va(new VertexArray(vertexBuffer, indexBuffer, true));
+  return va;
+}
+
 //------------------------------------------------------------------------
 
 VertexBufferPtr Device::NewVertexBuffer(const VertexLayout& layout, size_t vertexCount, GLenum usage)
 {
-  VertexBufferPtr vb(new VertexBuffer(layout, vertexCount, usage));
+  VertexBufferPtr vb(new VertexBuffer(layout, vertexCount, GetHeap(vertexHeaps, usage)));
   return vb;
 }
 
@@ -52,6 +79,76 @@ VertexBufferPtr Device::NewVertexBuffer(const VertexLayout& layout, size_t verte
 
 IndexBufferPtr Device::NewIndexBuffer(size_t indexCount, GLenum indexType, GLenum usage)
 {
-  IndexBufferPtr ib(new IndexBuffer(indexCount, indexType, usage));
+  IndexBufferPtr ib(new IndexBuffer(indexCount, indexType, GetHeap(indexHeaps, usage)));
+  return ib;
+}
+
+//------------------------------------------------------------------------
+
+StreamingBufferPtr Device::NewStreamingBuffer(size_t size)
+{
+  StreamingBufferPtr sb(new StreamingBuffer(size));
+  return sb;
+}
+
+VertexBufferPtr Device::NewVertexBuffer(const VertexLayout& layout, StreamingBufferPtr streamingBuffer)
+{
+  VertexBufferPtr vb(new VertexBuffer(layout, streamingBuffer));
+  return vb;
+}
+
+IndexBufferPtr Device::NewIndexBuffer(GLenum indexType, StreamingBufferPtr streamingBuffer)
+{
+  IndexBufferPtr ib(new IndexBuffer(indexType, streamingBuffer));
   return ib;
 }
+
+//------------------------------------------------------------------------
+
+Texture2DPtr Device::NewTexture2D(const Texture2DDescription& description)
+{
+  Texture2DPtr texture(new Texture2D(description));
+  return texture;
+}
+
+Texture3DPtr Device::NewTexture3D(const Texture3DDescription& description)
+{
+  Texture3DPtr texture(new Texture3D(description));
+  return texture;
+}
+
+//------------------------------------------------------------------------
+
+SamplerPtr Device::NewSampler()
+{
+  SamplerPtr sampler(new Sampler());
+  return sampler;
+}
+
+//------------------------------------------------------------------------
+
+RenderStatePtr Device::NewRenderState(const RenderState& description)
+{
+  return RenderStateObject::Get(description);
+}
+
+//------------------------------------------------------------------------
+
+FramebufferPtr Device::NewFramebuffer(const glm::uvec2& size, GLenum colourFormat)
+{
+  FramebufferPtr framebuffer(new Framebuffer(size, colourFormat));
+  return framebuffer;
+}
+
+//------------------------------------------------------------------------
+
+static BufferHeapPtr GetHeap(std::map<GLenum, boost::weak_ptr<BufferHeap> >& heaps, GLenum usage)
+{
+  BufferHeapPtr heap = heaps[usage].lock();
+  if (!heap)
+  {
+    heap.reset(new BufferHeap(usage, HeapBlockSize));
+    heaps[usage] = heap;
+  }
+  return heap;
+}
@@ -10,6 +10,8 @@
 #include <gl_loader/gl_loader.h>
 
 #include <core/logging.h>
+#include <core/cpuprofiler.h>
+#include <core/frameconstants.h>
 #include <core/effect/effect.h>
 
 //--------------------------------------------------------------
@@ -32,68 +34,104 @@ void Effect::Enable()
 //--------------------------------------------------------------
 void Effect::Apply()
 {
-  BOOST_FOREACH(auto param, parameters)
+  // Only the parameters Set to a new value since the last Apply. They're written to this
+  // effect's program whichever program is in use, so Apply may come before Enable...
+  BOOST_FOREACH(const unsigned int i, parameters.dirty)
   {
-    if (param.second.modified)
+    EffectUniform& param = parameters.uniforms[i];
+    const GLint location = param.location;
+    const void* const value = parameters.Value(param.offset);
+
+    switch (param.type)
     {
-      switch (param.second.type)
-      {
-      case GL_INT:          glUniform1iv(param.second.location, 1, (int*)param.second.cache); break;
-      case GL_UNSIGNED_INT: glUniform1uiv(param.second.location, 1, (unsigned int*)param.second.cache); break;
-
-      case GL_FLOAT:        glUniform1fv(param.second.location, 1, (float*)param.second.cache); break;
-      case GL_FLOAT_VEC2:   glUniform2fv(param.second.location, 1, (float*)param.second.cache); break;
-      case GL_FLOAT_VEC3:   glUniform3fv(param.second.location, 1, (float*)param.second.cache); break;
-      case GL_FLOAT_VEC4:   glUniform4fv(param.second.location, 1, (float*)param.second.cache); break;
-
-      case GL_DOUBLE:       glUniform1dv(param.second.location, 1, param.second.cache); break;
-      case GL_DOUBLE_VEC2:  glUniform2dv(param.second.location, 1, param.second.cache); break;
-      case GL_DOUBLE_VEC3:  glUniform3dv(param.second.location, 1, param.second.cache); break;
-      case GL_DOUBLE_VEC4:  glUniform4dv(param.second.location, 1, param.second.cache); break;
-
-      case GL_FLOAT_MAT2:   glUniformMatrix2fv(param.second.location, 1, GL_FALSE, (float*)param.second.cache); break;
-      case GL_FLOAT_MAT3:   glUniformMatrix3fv(param.second.location, 1, GL_FALSE, (float*)param.second.cache); break;
-      case GL_FLOAT_MAT4:   glUniformMatrix4fv(param.second.location, 1, GL_FALSE, (float*)param.second.cache); break;
-
-      case GL_DOUBLE_MAT2:  glUniformMatrix2dv(param.second.location, 1, GL_FALSE, param.second.cache); break;
-      case GL_DOUBLE_MAT3:  glUniformMatrix3dv(param.second.location, 1, GL_FALSE, param.second.cache); break;
-      case GL_DOUBLE_MAT4:  glUniformMatrix4dv(param.second.location, 1, GL_FALSE, param.second.cache); break;
-
-      case GL_SAMPLER_1D:   glUniform1iv(param.second.location, 1, (int*)param.second.cache); break;
-      case GL_SAMPLER_2D:   glUniform1iv(param.second.location, 1, (int*)param.second.cache); break;
-      case GL_SAMPLER_3D:   glUniform1iv(param.second.location, 1, (int*)param.second.cache); break;
-        
-      default: break;
-      }
-      param.second.modified = false;
+    case GL_INT:          glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+    case GL_UNSIGNED_INT: glProgramUniform1uiv(programHandle, location, 1, (const unsigned int*)value); break;
+
+    case GL_FLOAT:        glProgramUniform1fv(programHandle, location, 1, (const float*)value); break;
+    case GL_FLOAT_VEC2:   glProgramUniform2fv(programHandle, location, 1, (const float*)value); break;
+    case GL_FLOAT_VEC3:   glProgramUniform3fv(programHandle, location, 1, (const float*)value); break;
+    case GL_FLOAT_VEC4:   glProgramUniform4fv(programHandle, location, 1, (const float*)value); break;
+
+    case GL_DOUBLE:       glProgramUniform1dv(programHandle, location, 1, (const double*)value); break;
+    case GL_DOUBLE_VEC2:  glProgramUniform2dv(programHandle, location, 1, (const double*)value); break;
+    case GL_DOUBLE_VEC3:  glProgramUniform3dv(programHandle, location, 1, (const double*)value); break;
+    case GL_DOUBLE_VEC4:  glProgramUniform4dv(programHandle, location, 1, (const double*)value); break;
+
+    case GL_FLOAT_MAT2:   glProgramUniformMatrix2fv(programHandle, location, 1, GL_FALSE, (const float*)value); break;
+    case GL_FLOAT_MAT3:   glProgramUniformMatrix3fv(programHandle, location, 1, GL_FALSE, (const float*)value); break;
+    case GL_FLOAT_MAT4:   glProgramUniformMatrix4fv(programHandle, location, 1, GL_FALSE, (const float*)value); break;
+
+    case GL_DOUBLE_MAT2:  glProgramUniformMatrix2dv(programHandle, location, 1, GL_FALSE, (const double*)value); break;
+    case GL_DOUBLE_MAT3:  glProgramUniformMatrix3dv(programHandle, location, 1, GL_FALSE, (const double*)value); break;
+    case GL_DOUBLE_MAT4:  glProgramUniformMatrix4dv(programHandle, location, 1, GL_FALSE, (const double*)value); break;
+
+    case GL_SAMPLER_1D:   glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+    case GL_SAMPLER_2D:   glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+    case GL_SAMPLER_3D:   glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+    case GL_SAMPLER_2D_ARRAY: glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+    case GL_UNSIGNED_INT_SAMPLER_2D: glProgramUniform1iv(programHandle, location, 1, (const int*)value); break;
+
+    default: break;
     }
+    param.dirty = false;
   }
+
+  UniformTable::uploadsIssued += parameters.dirty.size();
+  parameters.dirty.clear();
+}
+
+//--------------------------------------------------------------
+Effect::Counters Effect::GetCounters()
+{
+  const Counters counters = { UniformTable::uploadsIssued, UniformTable::uploadsSkipped };
+  return counters;
+}
+
+//--------------------------------------------------------------
+void Effect::ResetCounters()
+{
+  UniformTable::uploadsIssued = 0;
+  UniformTable::uploadsSkipped = 0;
+}
+
+//--------------------------------------------------------------
+bool Effect::BindBlock(const char* const blockName, GLuint bindingPoint)
+{
+  const GLuint block = glGetUniformBlockIndex(programHandle, blockName);
+  if (GL_INVALID_INDEX == block)
+  {
+    return false;
+  }
+
+  glUniformBlockBinding(programHandle, block, bindingPoint);
+  return true;
 }
 
 //--------------------------------------------------------------
 void Effect::Initialise()
 {
   WorldMatrix = &parameters["WorldMatrix"];
-  ViewMatrix = &parameters["ViewMatrix"];
-  ProjectionMatrix = &parameters["ProjectionMatrix"];
-  ViewProjectionMatrix = &parameters["ViewProjectionMatrix"];
   WorldViewProjectionMatrix = &parameters["WorldViewProjectionMatrix"];
-  CameraPosition = &parameters["CameraPosition"];
-  LogDepthDivisor = &parameters["LogDepthDivisor"];
-  LogDepthConstant = &parameters["LogDepthConstant"];
-  LogDepthOffset = &parameters["LogDepthOffset"];
+  NoiseTexture2D = &parameters["NoiseTexture2D"];
+  NoiseTexture3D = &parameters["NoiseTexture3D"];
 }
 
 //--------------------------------------------------------------
 bool Effect::Load(const char* const effectFilename)
 {
+  PROFILE_ZONE("effect load");
+
   bool loaded = false;
 
-  const char* programName = std::strrchr(effectFilename, '.');
-  if (!programName)
-  {
-    programName = effectFilename;
-  }
+  // The program to compile is named after the file, e.g. "assets/effects/planet.glsl" holds
+  // "program planet". Paths may use either separator on Windows...
+  const char* const slash = std::strrchr(effectFilename, '/');
+  const char* const backslash = std::strrchr(effectFilename, '\\');
+  const char* nameStart = (slash && (!backslash || (slash > backslash))) ? slash : backslash;
+  nameStart = nameStart ? (nameStart + 1) : effectFilename;
+  const char* const nameEnd = std::strrchr(nameStart, '.');
+  const std::string programNameString(nameStart, nameEnd ? nameEnd : (nameStart + std::strlen(nameStart)));
+  const char* const programName = programNameString.c_str();
 
   const int glfx = glfxGenEffect();
   if (glfxParseEffectFromFile(glfx, effectFilename))
@@ -101,12 +139,11 @@ bool Effect::Load(const char* const effectFilename)
     programHandle = glfxCompileProgram(glfx, programName);
     if (-1 != programHandle)
     {
-      ParseParams();
+      // Effects which include common.glsl all read the same buffer of per-frame values...
+      BindBlock("FrameConstants", FrameConstants::BindingPoint);
+
       LOG("effect %s::%s compiled - uniform parameters:\n", effectFilename, programName);
-      BOOST_FOREACH(auto v, parameters)
-      {
-        LOG("  %s\n", v.first.c_str());
-      }
+      ParseParams();
       Initialise();
       loaded = true;
     }
@@ -152,10 +189,8 @@ void Effect::ParseParams()
 			char uniformName[256] = { 0 };
 			glGetActiveUniformName(programHandle, i, sizeof(uniformName)-1, NULL, uniformName);
 
-      EffectUniform u;
-      u.location = glGetUniformLocation(programHandle, uniformName);
-      u.type = types[i];
-      parameters[uniformName] = u;
+      parameters.Add(uniformName, glGetUniformLocation(programHandle, uniformName), types[i]);
+      LOG("  %s\n", uniformName);
 		}
 	}
 }
@@ -1,41 +1,120 @@
 #include <glm/ext.hpp>
+#include <cstring>
 #include <memory>
 #include <gl_loader/gl_loader.h>
 #include <core/effect/effectuniform.h>
 
 //---------------------------------------------------------------------------------------
 
-static bool SetValue(const void* const value, size_t size, void* const cache);
+static unsigned int TypeSize(GLenum type);
+
+unsigned int UniformTable::uploadsIssued = 0;
+unsigned int UniformTable::uploadsSkipped = 0;
 
 //---------------------------------------------------------------------------------------
 
-void EffectUniform::Set(float value)            { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(double value)           { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(int value)              { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(unsigned int value)     { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::vec2& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::vec3& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::vec4& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dvec2& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dvec3& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dvec4& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::mat2& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::mat3& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::mat4& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dmat2& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dmat3& value) { modified |= SetValue(&value, sizeof(value), cache); }
-void EffectUniform::Set(const glm::dmat4& value) { modified |= SetValue(&value, sizeof(value), cache); }
+void EffectUniform::Set(float value)            { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(double value)           { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(int value)              { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(unsigned int value)     { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::vec2& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::vec3& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::vec4& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dvec2& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dvec3& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dvec4& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::mat2& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::mat3& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::mat4& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dmat2& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dmat3& value) { SetValue(&value, sizeof(value)); }
+void EffectUniform::Set(const glm::dmat4& value) { SetValue(&value, sizeof(value)); }
 
 //---------------------------------------------------------------------------------------
-static bool SetValue(const void* const value, size_t size, void* const cache)
+
+void EffectUniform::SetValue(const void* const value, size_t valueSize)
 {
-  bool cached = false;
-  
-  if (0 != std::memcmp(cache, value, size))
+  if (!table)
+  {
+    return;
+  }
+
+  // The value's type should match the uniform's, but never write past its slot...
+  const size_t bytes = (valueSize < size) ? valueSize : size;
+  unsigned char* const cache = table->Value(offset);
+  if (0 == std::memcmp(cache, value, bytes))
+  {
+    ++UniformTable::uploadsSkipped;
+    return;
+  }
+
+  std::memcpy(cache, value, bytes);
+  if (!dirty)
   {
-    std::memcpy(cache, value, size);
-    cached = true;
+    dirty = true;
+    table->dirty.push_back(index);
+  }
+}
+
+//---------------------------------------------------------------------------------------
+
+void UniformTable::Add(const char* const name, GLint location, GLenum type)
+{
+  EffectUniform uniform;
+  uniform.table = this;
+  uniform.location = location;
+  uniform.type = type;
+  uniform.size = TypeSize(type);
+  uniform.offset = values.size() * sizeof(double);
+  uniform.index = uniforms.size();
+
+  values.resize(values.size() + ((uniform.size + sizeof(double) - 1) / sizeof(double)), 0.0);
+  names[name] = uniform.index;
+  uniforms.push_back(uniform);
+}
+
+//---------------------------------------------------------------------------------------
+
+EffectUniform& UniformTable::operator[](const char* const name)
+{
+  const std::map<std::string, unsigned int>::const_iterator i = names.find(name);
+  return (names.end() != i) ? uniforms[i->second] : missing;
+}
+
+//---------------------------------------------------------------------------------------
+
+static unsigned int TypeSize(GLenum type)
+{
+  switch (type)
+  {
+  case GL_INT:
+  case GL_UNSIGNED_INT:
+  case GL_FLOAT:
+  case GL_SAMPLER_1D:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_2D_ARRAY:
+  case GL_UNSIGNED_INT_SAMPLER_2D:
+    return 4;
+
+  case GL_FLOAT_VEC2:   return 2 * sizeof(float);
+  case GL_FLOAT_VEC3:   return 3 * sizeof(float);
+  case GL_FLOAT_VEC4:   return 4 * sizeof(float);
+
+  case GL_DOUBLE:       return sizeof(double);
+  case GL_DOUBLE_VEC2:  return 2 * sizeof(double);
+  case GL_DOUBLE_VEC3:  return 3 * sizeof(double);
+  case GL_DOUBLE_VEC4:  return 4 * sizeof(double);
+
+  case GL_FLOAT_MAT2:   return 4 * sizeof(float);
+  case GL_FLOAT_MAT3:   return 9 * sizeof(float);
+  case GL_FLOAT_MAT4:   return 16 * sizeof(float);
+
+  case GL_DOUBLE_MAT2:  return 4 * sizeof(double);
+  case GL_DOUBLE_MAT3:  return 9 * sizeof(double);
+  case GL_DOUBLE_MAT4:  return 16 * sizeof(double);
+
+  // Not uploaded by Effect::Apply, so nothing is kept...
+  default:              return 0;
   }
- 
-  return cached;
 }
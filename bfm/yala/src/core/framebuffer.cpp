@@ -0,0 +1,181 @@
+#include <cstring>
+#include <core/logging.h>
+#include <core/framebuffer.h>
+
+//------------------------------------------------------------------------
+
+static size_t BytesPerPixel(GLenum dataFormat, GLenum dataType);
+
+//------------------------------------------------------------------------
+
+Framebuffer::Framebuffer(const glm::uvec2& size, GLenum colourFormat)
+  : size(size),
+    colour(new Texture2D(Texture2DDescription(colourFormat, size))),
+    nextRead(0),
+    queuedReads(0)
+{
+  glGenRenderbuffers(1, &depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colour->GetHandle(), 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (GL_FRAMEBUFFER_COMPLETE != status)
+  {
+    LOG("framebuffer %ux%u incomplete: 0x%x\n", size.x, size.y, status);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  for (unsigned int i = 0; i < ReadBufferCount; ++i)
+  {
+    glGenBuffers(1, &reads[i].buffer);
+    reads[i].fence = 0;
+    reads[i].size = 0;
+  }
+}
+
+//------------------------------------------------------------------------
+
+Framebuffer::~Framebuffer()
+{
+  for (unsigned int i = 0; i < ReadBufferCount; ++i)
+  {
+    if (reads[i].fence)
+    {
+      glDeleteSync(reads[i].fence);
+    }
+    glDeleteBuffers(1, &reads[i].buffer);
+  }
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteRenderbuffers(1, &depth);
+}
+
+//------------------------------------------------------------------------
+
+void Framebuffer::Bind()
+{
+  glGetIntegerv(GL_VIEWPORT, savedViewport);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(0, 0, size.x, size.y);
+}
+
+//------------------------------------------------------------------------
+
+void Framebuffer::Unbind()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+//------------------------------------------------------------------------
+
+void Framebuffer::ReadColour(GLenum dataFormat, GLenum dataType)
+{
+  ReadBuffer& read = reads[nextRead];
+  if (read.fence)
+  {
+    // Overwriting a read that was never collected...
+    glDeleteSync(read.fence);
+    --queuedReads;
+  }
+
+  read.size = size.x * size.y * BytesPerPixel(dataFormat, dataType);
+
+  // Reading into a pixel pack buffer returns immediately; the copy happens on the GPU
+  // once the draws before it have finished...
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER, read.size, NULL, GL_STREAM_READ);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glReadPixels(0, 0, size.x, size.y, dataFormat, dataType, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  read.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  nextRead = (nextRead + 1) % ReadBufferCount;
+  ++queuedReads;
+}
+
+//------------------------------------------------------------------------
+
+bool Framebuffer::GetColour(void* const data, size_t size)
+{
+  if (0 == queuedReads)
+  {
+    return false;
+  }
+
+  ReadBuffer& read = reads[(nextRead + ReadBufferCount - queuedReads) % ReadBufferCount];
+
+  // Poll rather than wait: an unfinished read is simply collected on a later call...
+  const GLenum status = glClientWaitSync(read.fence, 0, 0);
+  if ((GL_ALREADY_SIGNALED != status) && (GL_CONDITION_SATISFIED != status))
+  {
+    return false;
+  }
+
+  glDeleteSync(read.fence);
+  read.fence = 0;
+  --queuedReads;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer);
+  const void* const pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, read.size, GL_MAP_READ_BIT);
+  const bool copied = (NULL != pixels);
+  if (copied)
+  {
+    std::memcpy(data, pixels, glm::min(size, read.size));
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return copied;
+}
+
+//------------------------------------------------------------------------
+
+static size_t BytesPerPixel(GLenum dataFormat, GLenum dataType)
+{
+  size_t components = 4;
+  switch (dataFormat)
+  {
+  case GL_RED:
+  case GL_RED_INTEGER:
+  case GL_DEPTH_COMPONENT:
+    components = 1;
+    break;
+  case GL_RG:
+  case GL_RG_INTEGER:
+    components = 2;
+    break;
+  case GL_RGB:
+  case GL_BGR:
+  case GL_RGB_INTEGER:
+    components = 3;
+    break;
+  default:
+    break;
+  }
+
+  size_t componentSize = 1;
+  switch (dataType)
+  {
+  case GL_UNSIGNED_SHORT:
+  case GL_SHORT:
+  case GL_HALF_FLOAT:
+    componentSize = 2;
+    break;
+  case GL_UNSIGNED_INT:
+  case GL_INT:
+  case GL_FLOAT:
+    componentSize = 4;
+    break;
+  default:
+    break;
+  }
+
+  return components * componentSize;
+}
@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <gl_loader/gl_loader.h>
+#include <core/logging.h>
+#include <core/context.h>
+#include <core/gpuprofiler.h>
+
+//------------------------------------------------------------------------
+
+struct GpuProfiler::Impl
+{
+  // A scope timed in a frame; its queries are indices into the frame's.
+  struct Scope
+  {
+    unsigned int name;
+    unsigned int depth;
+    unsigned int begin;
+    unsigned int end;
+  };
+
+  struct Frame
+  {
+    Frame() : number(0), used(0), pending(false) {}
+
+    unsigned int number;
+    std::vector<GLuint> queries;  // grown as needed and reused
+    unsigned int used;
+    std::vector<Scope> scopes;
+    bool pending;                 // ended and not yet collected
+  };
+
+  // The last HistoryFrames timings of a scope.
+  struct History
+  {
+    History() : depth(0), next(0) {}
+
+    unsigned int depth;
+    std::vector<float> samples;
+    unsigned int next;            // where the next sample goes once samples is full
+  };
+
+  Impl();
+  ~Impl();
+
+  unsigned int NameIndex(const char* const name);
+  void WriteTimestamp(Frame& frame, unsigned int& index);
+  void Collect(Frame& frame);
+
+  Frame frames[Frames];
+  unsigned int current;         // frame being recorded
+  unsigned int frameNumber;
+  std::vector<unsigned int> open;
+  bool unbalanced;              // reported an unbalanced scope (only done once)
+
+  std::map<std::string, unsigned int> nameIndices;
+  std::vector<std::string> names;
+  std::vector<History> histories;
+
+  FILE* log;
+  unsigned int framesDropped;
+};
+
+//------------------------------------------------------------------------
+
+static double Percentile(const std::vector<float>& sorted, double fraction);
+
+//------------------------------------------------------------------------
+
+GpuProfiler::GpuProfiler()
+  : impl(new Impl)
+{
+}
+
+//------------------------------------------------------------------------
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+//------------------------------------------------------------------------
+
+GpuProfiler::Impl::Impl()
+  : current(0),
+    frameNumber(0),
+    unbalanced(false),
+    log(NULL),
+    framesDropped(0)
+{
+}
+
+//------------------------------------------------------------------------
+
+GpuProfiler::Impl::~Impl()
+{
+  for (unsigned int f = 0; f < Frames; ++f)
+  {
+    if (!frames[f].queries.empty())
+    {
+      glDeleteQueries(frames[f].queries.size(), &frames[f].queries[0]);
+    }
+  }
+
+  if (log)
+  {
+    fclose(log);
+  }
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::BeginScope(const char* const name)
+{
+  Impl::Frame& frame = impl->frames[impl->current];
+
+  Impl::Scope scope;
+  scope.name = impl->NameIndex(name);
+  scope.depth = impl->open.size();
+  scope.end = 0;
+  impl->WriteTimestamp(frame, scope.begin);
+
+  impl->open.push_back(frame.scopes.size());
+  frame.scopes.push_back(scope);
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::EndScope()
+{
+  if (impl->open.empty())
+  {
+    if (!impl->unbalanced)
+    {
+      LOG("%s\n", "GPU profiler: EndScope without a BeginScope");
+      impl->unbalanced = true;
+    }
+    return;
+  }
+
+  Impl::Frame& frame = impl->frames[impl->current];
+  impl->WriteTimestamp(frame, frame.scopes[impl->open.back()].end);
+  impl->open.pop_back();
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::EndFrame()
+{
+  if (!impl->open.empty())
+  {
+    if (!impl->unbalanced)
+    {
+      LOG("GPU profiler: scope \"%s\" still open at the end of a frame\n", impl->names[impl->frames[impl->current].scopes[impl->open.back()].name].c_str());
+      impl->unbalanced = true;
+    }
+
+    while (!impl->open.empty())
+    {
+      EndScope();
+    }
+  }
+
+  Impl::Frame& ended = impl->frames[impl->current];
+  ended.number = impl->frameNumber++;
+  ended.pending = !ended.scopes.empty();
+
+  // The next frame reuses the oldest's queries, so collect its timings first...
+  impl->current = (impl->current + 1) % Frames;
+  Impl::Frame& oldest = impl->frames[impl->current];
+  impl->Collect(oldest);
+  oldest.used = 0;
+  oldest.scopes.clear();
+}
+
+//------------------------------------------------------------------------
+
+std::vector<GpuProfiler::Stats> GpuProfiler::GetStats() const
+{
+  std::vector<Stats> stats;
+  for (unsigned int n = 0; n < impl->histories.size(); ++n)
+  {
+    const Impl::History& history = impl->histories[n];
+    if (history.samples.empty())
+    {
+      continue;
+    }
+
+    std::vector<float> sorted(history.samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (unsigned int i = 0; i < sorted.size(); ++i)
+    {
+      total += sorted[i];
+    }
+
+    Stats scope;
+    scope.name = impl->names[n];
+    scope.depth = history.depth;
+    scope.samples = sorted.size();
+    scope.averageMS = total / sorted.size();
+    scope.minimumMS = sorted.front();
+    scope.maximumMS = sorted.back();
+    scope.medianMS = Percentile(sorted, 0.5);
+    scope.percentile95MS = Percentile(sorted, 0.95);
+    scope.percentile99MS = Percentile(sorted, 0.99);
+    stats.push_back(scope);
+  }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------
+
+bool GpuProfiler::StartLog(const char* const filename)
+{
+  StopLog();
+
+  impl->log = fopen(filename, "w");
+  if (!impl->log)
+  {
+    LOG("GPU profiler: couldn't open %s\n", filename);
+    return false;
+  }
+
+  fprintf(impl->log, "frame,scope,depth,ms\n");
+  return true;
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::StopLog()
+{
+  if (impl->log)
+  {
+    fclose(impl->log);
+    impl->log = NULL;
+  }
+}
+
+//------------------------------------------------------------------------
+
+bool GpuProfiler::Logging() const
+{
+  return NULL != impl->log;
+}
+
+//------------------------------------------------------------------------
+
+unsigned int GpuProfiler::FramesDropped() const
+{
+  return impl->framesDropped;
+}
+
+//------------------------------------------------------------------------
+
+unsigned int GpuProfiler::Impl::NameIndex(const char* const name)
+{
+  const std::map<std::string, unsigned int>::const_iterator i = nameIndices.find(name);
+  if (nameIndices.end() != i)
+  {
+    return i->second;
+  }
+
+  const unsigned int index = names.size();
+  nameIndices[name] = index;
+  names.push_back(name);
+  histories.push_back(History());
+  histories.back().depth = open.size();
+  return index;
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::Impl::WriteTimestamp(Frame& frame, unsigned int& index)
+{
+  if (frame.used == frame.queries.size())
+  {
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    frame.queries.push_back(query);
+  }
+
+  index = frame.used++;
+  glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+}
+
+//------------------------------------------------------------------------
+
+void GpuProfiler::Impl::Collect(Frame& frame)
+{
+  if (!frame.pending)
+  {
+    return;
+  }
+  frame.pending = false;
+
+  // Queries complete in order, so if the frame's last is available they all are...
+  GLint available = GL_FALSE;
+  glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (GL_FALSE == available)
+  {
+    ++framesDropped;
+    return;
+  }
+
+  std::vector<GLuint64> timestamps(frame.used);
+  for (unsigned int q = 0; q < frame.used; ++q)
+  {
+    glGetQueryObjectui64v(frame.queries[q], GL_QUERY_RESULT, &timestamps[q]);
+  }
+
+  // Sum the scopes of each name, in nanoseconds...
+  std::vector<GLuint64> totals(names.size(), 0);
+  std::vector<bool> timed(names.size(), false);
+  for (unsigned int s = 0; s < frame.scopes.size(); ++s)
+  {
+    const Scope& scope = frame.scopes[s];
+    totals[scope.name] += timestamps[scope.end] - timestamps[scope.begin];
+    timed[scope.name] = true;
+  }
+
+  for (unsigned int n = 0; n < names.size(); ++n)
+  {
+    if (!timed[n])
+    {
+      continue;
+    }
+
+    const float ms = float(double(totals[n]) / 1000000.0);
+    History& history = histories[n];
+    if (history.samples.size() < HistoryFrames)
+    {
+      history.samples.push_back(ms);
+    }
+    else
+    {
+      history.samples[history.next] = ms;
+      history.next = (history.next + 1) % HistoryFrames;
+    }
+
+    if (log)
+    {
+      fprintf(log, "%u,%s,%u,%.4f\n", frame.number, names[n].c_str(), history.depth, ms);
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+// The value a fraction of the way through sorted samples, interpolating between the two
+// either side.
+static double Percentile(const std::vector<float>& sorted, double fraction)
+{
+  const double position = fraction * (sorted.size() - 1);
+  const size_t below = size_t(position);
+  const size_t above = std::min(below + 1, sorted.size() - 1);
+  const double t = position - below;
+  return (sorted[below] * (1.0 - t)) + (sorted[above] * t);
+}
+
+//------------------------------------------------------------------------
+
+GpuScope::GpuScope(Context& context, const char* const name)
+  : context(context)
+{
+  context.BeginGpuScope(name);
+}
+
+//------------------------------------------------------------------------
+
+GpuScope::~GpuScope()
+{
+  context.EndGpuScope();
+}
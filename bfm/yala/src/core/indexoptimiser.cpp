@@ -0,0 +1,210 @@
+#include <deque>
+#include <core/logging.h>
+#include <core/indexoptimiser.h>
+
+//------------------------------------------------------------------------
+
+static int GetNextVertex(
+  const std::vector<int>& candidates,
+  const std::vector<unsigned int>& liveTriangles,
+  const std::vector<int>& cacheTime,
+  int timestamp,
+  unsigned int cacheSize,
+  std::vector<int>& deadEnds,
+  size_t& cursor);
+
+//------------------------------------------------------------------------
+
+void IndexOptimiser::OptimiseTriangles(std::vector<unsigned short>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+  const size_t triangleCount = indices.size() / 3;
+  if (0 == triangleCount) { return; }
+
+  // Build the vertex-to-triangle adjacency as one flat array with per-vertex offsets...
+  std::vector<unsigned int> liveTriangles(vertexCount, 0);
+  for (size_t i = 0; i < triangleCount * 3; ++i)
+  {
+    ++liveTriangles[indices[i]];
+  }
+
+  std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v)
+  {
+    adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+  }
+
+  std::vector<size_t> adjacencyFill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+  std::vector<unsigned int> adjacency(triangleCount * 3);
+  for (size_t t = 0; t < triangleCount; ++t)
+  {
+    for (int corner = 0; corner < 3; ++corner)
+    {
+      adjacency[adjacencyFill[indices[(t * 3) + corner]]++] = (unsigned int)t;
+    }
+  }
+
+  std::vector<int> cacheTime(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<int> deadEnds;
+  std::vector<int> candidates;
+  std::vector<unsigned short> output;
+  output.reserve(triangleCount * 3);
+
+  int timestamp = int(cacheSize) + 1;
+  size_t cursor = 1;
+  int fanningVertex = 0;
+
+  while (fanningVertex >= 0)
+  {
+    candidates.clear();
+
+    // Emit every remaining triangle around the fanning vertex...
+    for (size_t a = adjacencyStart[fanningVertex]; a < adjacencyStart[fanningVertex + 1]; ++a)
+    {
+      const unsigned int t = adjacency[a];
+      if (emitted[t]) { continue; }
+
+      for (int corner = 0; corner < 3; ++corner)
+      {
+        const unsigned short v = indices[(t * 3) + corner];
+        output.push_back(v);
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        --liveTriangles[v];
+
+        // Only count the vertex as newly cached if it has dropped out of the cache...
+        if ((timestamp - cacheTime[v]) > int(cacheSize))
+        {
+          cacheTime[v] = timestamp++;
+        }
+      }
+      emitted[t] = true;
+    }
+
+    fanningVertex = GetNextVertex(candidates, liveTriangles, cacheTime, timestamp, cacheSize, deadEnds, cursor);
+  }
+
+  indices.swap(output);
+}
+
+//------------------------------------------------------------------------
+
+// Choose the next vertex to fan around: the candidate which will still be in the cache
+// after all its remaining triangles are emitted and which entered the cache earliest.
+static int GetNextVertex(
+  const std::vector<int>& candidates,
+  const std::vector<unsigned int>& liveTriangles,
+  const std::vector<int>& cacheTime,
+  int timestamp,
+  unsigned int cacheSize,
+  std::vector<int>& deadEnds,
+  size_t& cursor)
+{
+  int best = -1;
+  int bestPriority = -1;
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    const int v = candidates[i];
+    if (liveTriangles[v] > 0)
+    {
+      int priority = 0;
+      if ((timestamp - cacheTime[v] + (2 * int(liveTriangles[v]))) <= int(cacheSize))
+      {
+        priority = timestamp - cacheTime[v];
+      }
+      if (priority > bestPriority)
+      {
+        bestPriority = priority;
+        best = v;
+      }
+    }
+  }
+
+  if (-1 == best)
+  {
+    // Dead end: back-track through the recently emitted vertices, and if that fails,
+    // move on to the next vertex in input order that still has triangles...
+    while (!deadEnds.empty())
+    {
+      const int v = deadEnds.back();
+      deadEnds.pop_back();
+      if (liveTriangles[v] > 0) { return v; }
+    }
+    while (cursor < liveTriangles.size())
+    {
+      const size_t v = cursor++;
+      if (liveTriangles[v] > 0) { return int(v); }
+    }
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------
+
+IndexOptimiser::CacheStats IndexOptimiser::Measure(const std::vector<unsigned short>& indices, size_t vertexCount, GLenum primitiveType, unsigned int cacheSize)
+{
+  CacheStats stats = { 0, 0, 0.0, 0.0 };
+
+  std::deque<unsigned short> cache;
+  std::vector<bool> referenced(vertexCount, false);
+  unsigned int uniqueVertices = 0;
+  unsigned int stripLength = 0;
+
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    const unsigned short v = indices[i];
+
+    if ((GL_TRIANGLE_STRIP == primitiveType) && (RestartIndex == v))
+    {
+      stripLength = 0;
+      continue;
+    }
+
+    bool hit = false;
+    for (size_t c = 0; c < cache.size(); ++c)
+    {
+      if (cache[c] == v) { hit = true; break; }
+    }
+
+    if (!hit)
+    {
+      ++stats.transforms;
+      cache.push_back(v);
+      if (cache.size() > cacheSize) { cache.pop_front(); }
+    }
+
+    if (!referenced[v])
+    {
+      referenced[v] = true;
+      ++uniqueVertices;
+    }
+
+    if (GL_TRIANGLE_STRIP == primitiveType)
+    {
+      if (++stripLength >= 3) { ++stats.triangles; }
+    }
+  }
+
+  if (GL_TRIANGLES == primitiveType)
+  {
+    stats.triangles = (unsigned int)(indices.size() / 3);
+  }
+
+  stats.acmr = stats.triangles ? double(stats.transforms) / double(stats.triangles) : 0.0;
+  stats.atvr = uniqueVertices ? double(stats.transforms) / double(uniqueVertices) : 0.0;
+
+  return stats;
+}
+
+//------------------------------------------------------------------------
+
+void IndexOptimiser::Report(const char* const name, const CacheStats& before, const CacheStats& after)
+{
+  LOG("%s: %u triangles, vertex shader invocations %u -> %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+    name,
+    after.triangles,
+    before.transforms, after.transforms,
+    before.acmr, after.acmr,
+    before.atvr, after.atvr);
+}
@@ -0,0 +1,242 @@
+#include <cstring>
+#include <cerrno>
+#include <core/logging.h>
+#include <core/mappedfile.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//-----------------------------------------------------------------------
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+  : size(0), windowLock(0), file(INVALID_HANDLE_VALUE), mapping(NULL)
+{
+}
+
+//-----------------------------------------------------------------------
+
+bool MappedFile::Open(const char* const filename)
+{
+  Close();
+
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+  if (INVALID_HANDLE_VALUE == file)
+  {
+    LOG("%s - cannot open for mapping (error %lu)\n", filename, GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    LOG("%s - cannot get the file's size (error %lu)\n", filename, GetLastError());
+    Close();
+    return false;
+  }
+
+  // An empty file can't be mapped at all...
+  if (fileSize.QuadPart <= 0)
+  {
+    LOG("%s - cannot map an empty file\n", filename);
+    Close();
+    return false;
+  }
+  size = (boost::uint64_t)fileSize.QuadPart;
+
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping)
+  {
+    LOG("%s - cannot map (error %lu)\n", filename, GetLastError());
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------
+
+void MappedFile::Close()
+{
+  for (std::map<boost::uint64_t, const char*>::const_iterator w = windows.begin(); w != windows.end(); ++w)
+  {
+    UnmapWindow(w->first, w->second);
+  }
+  windows.clear();
+
+  if (mapping) { CloseHandle(mapping); }
+  if (INVALID_HANDLE_VALUE != file) { CloseHandle(file); }
+
+  size = 0;
+  mapping = NULL;
+  file = INVALID_HANDLE_VALUE;
+}
+
+//-----------------------------------------------------------------------
+
+bool MappedFile::IsOpen() const
+{
+  return NULL != mapping;
+}
+
+//-----------------------------------------------------------------------
+
+// Views start at a multiple of the allocation granularity (64KB), which WindowSize is.
+const char* MappedFile::MapWindow(boost::uint64_t window) const
+{
+  const boost::uint64_t start = window * WindowSize;
+  const void* const view = MapViewOfFile(mapping, FILE_MAP_READ, DWORD(start >> 32), DWORD(start), WindowBytes(window));
+  if (!view)
+  {
+    LOG("cannot map window %u of a file (error %lu)\n", (unsigned int)window, GetLastError());
+  }
+  return (const char*)view;
+}
+
+//-----------------------------------------------------------------------
+
+void MappedFile::UnmapWindow(boost::uint64_t, const char* const view) const
+{
+  UnmapViewOfFile(view);
+}
+
+#else
+
+MappedFile::MappedFile()
+  : size(0), windowLock(0), file(-1)
+{
+}
+
+//-----------------------------------------------------------------------
+
+bool MappedFile::Open(const char* const filename)
+{
+  Close();
+
+  errno = 0;
+  file = open(filename, O_RDONLY);
+  if (file < 0)
+  {
+    LOG("%s - cannot open for mapping: %s\n", filename, strerror(errno));
+    return false;
+  }
+
+  struct stat info;
+  if (0 != fstat(file, &info))
+  {
+    LOG("%s - cannot get the file's size: %s\n", filename, strerror(errno));
+    Close();
+    return false;
+  }
+
+  if (info.st_size <= 0)
+  {
+    LOG("%s - cannot map an empty file\n", filename);
+    Close();
+    return false;
+  }
+  size = (boost::uint64_t)info.st_size;
+
+  return true;
+}
+
+//-----------------------------------------------------------------------
+
+void MappedFile::Close()
+{
+  for (std::map<boost::uint64_t, const char*>::const_iterator w = windows.begin(); w != windows.end(); ++w)
+  {
+    UnmapWindow(w->first, w->second);
+  }
+  windows.clear();
+
+  if (file >= 0) { close(file); }
+
+  size = 0;
+  file = -1;
+}
+
+//-----------------------------------------------------------------------
+
+bool MappedFile::IsOpen() const
+{
+  return file >= 0;
+}
+
+//-----------------------------------------------------------------------
+
+// Views start at a multiple of the page size, which WindowSize is.
+const char* MappedFile::MapWindow(boost::uint64_t window) const
+{
+  void* const view = mmap(NULL, WindowBytes(window), PROT_READ, MAP_SHARED, file, off_t(window * WindowSize));
+  if (MAP_FAILED == view)
+  {
+    LOG("cannot map window %u of a file: %s\n", (unsigned int)window, strerror(errno));
+    return NULL;
+  }
+  return (const char*)view;
+}
+
+//-----------------------------------------------------------------------
+
+void MappedFile::UnmapWindow(boost::uint64_t window, const char* const view) const
+{
+  munmap((void*)view, WindowBytes(window));
+}
+
+#endif
+
+//-----------------------------------------------------------------------
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+//-----------------------------------------------------------------------
+
+const void* MappedFile::Read(boost::uint64_t offset, size_t bytes) const
+{
+  if ((bytes > MaxRead) || (offset > size) || (bytes > (size - offset)))
+  {
+    return NULL;
+  }
+
+  // A window, once mapped, stays mapped until Close, so the pointer is good without the
+  // lock...
+  const boost::uint64_t window = offset / WindowSize;
+
+  SDL_AtomicLock(&windowLock);
+  std::map<boost::uint64_t, const char*>::const_iterator w = windows.find(window);
+  const char* view = (windows.end() != w) ? w->second : NULL;
+  if (!view)
+  {
+    view = MapWindow(window);
+    if (view)
+    {
+      windows[window] = view;
+    }
+  }
+  SDL_AtomicUnlock(&windowLock);
+
+  return view ? (view + (offset - (window * WindowSize))) : NULL;
+}
+
+//-----------------------------------------------------------------------
+
+// A window runs MaxRead bytes past the start of the next, or to the end of the file.
+size_t MappedFile::WindowBytes(boost::uint64_t window) const
+{
+  const boost::uint64_t start = window * WindowSize;
+  const boost::uint64_t end = start + WindowSize + MaxRead;
+  return size_t(((end < size) ? end : size) - start);
+}
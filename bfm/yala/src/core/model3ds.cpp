@@ -0,0 +1,144 @@
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <core/fileio.h>
+#include <core/logging.h>
+#include <core/model3ds.h>
+
+//-----------------------------------------------------------------------
+
+// The chunks on the way down to mesh data; everything else is skipped.
+namespace Chunk
+{
+  enum Enum
+  {
+    Main      = 0x4D4D,
+    Editor    = 0x3D3D,
+    Object    = 0x4000,   // followed by the object's zero-terminated name
+    TriMesh   = 0x4100,
+    Vertices  = 0x4110,
+    Faces     = 0x4120
+  };
+}
+
+static const size_t ChunkHeaderSize = 6;  // 16-bit id then 32-bit length, header included
+
+//-----------------------------------------------------------------------
+
+template <typename T> static T Read(const char* const data)
+{
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+//-----------------------------------------------------------------------
+
+// Walk the chunks in [begin, end), descending into those which lead to meshes. Vertices
+// are numbered from firstVertex, the first vertex of the mesh being read.
+static bool ReadChunks(
+  const char* begin,
+  const char* const end,
+  size_t& firstVertex,
+  std::vector<glm::vec3>& positions,
+  std::vector<unsigned short>& indices)
+{
+  while ((begin + ChunkHeaderSize) <= end)
+  {
+    const boost::uint16_t id = Read<boost::uint16_t>(begin);
+    const boost::uint32_t length = Read<boost::uint32_t>(begin + 2);
+    const char* const body = begin + ChunkHeaderSize;
+    const char* const next = begin + length;
+    if ((length < ChunkHeaderSize) || (next > end))
+    {
+      return false;
+    }
+
+    switch (id)
+    {
+    case Chunk::Main:
+    case Chunk::Editor:
+      if (!ReadChunks(body, next, firstVertex, positions, indices)) { return false; }
+      break;
+
+    case Chunk::Object:
+      {
+        const char* const name = (const char*)memchr(body, 0, next - body);
+        if (!name || !ReadChunks(name + 1, next, firstVertex, positions, indices)) { return false; }
+      }
+      break;
+
+    case Chunk::TriMesh:
+      firstVertex = positions.size();
+      if (!ReadChunks(body, next, firstVertex, positions, indices)) { return false; }
+      break;
+
+    case Chunk::Vertices:
+      {
+        const boost::uint16_t count = Read<boost::uint16_t>(body);
+        if ((body + 2 + (count * 3 * sizeof(float))) > next) { return false; }
+        for (boost::uint16_t i = 0; i < count; ++i)
+        {
+          const char* const vertex = body + 2 + (i * 3 * sizeof(float));
+          positions.push_back(glm::vec3(Read<float>(vertex), Read<float>(vertex + 4), Read<float>(vertex + 8)));
+        }
+      }
+      break;
+
+    case Chunk::Faces:
+      {
+        // Each face is three vertex indices and a flags word. The face's own sub-chunks
+        // (materials, smoothing groups) follow the list and are ignored...
+        const boost::uint16_t count = Read<boost::uint16_t>(body);
+        if ((body + 2 + (count * 4 * sizeof(boost::uint16_t))) > next) { return false; }
+        for (boost::uint16_t i = 0; i < count; ++i)
+        {
+          const char* const face = body + 2 + (i * 4 * sizeof(boost::uint16_t));
+          for (int corner = 0; corner < 3; ++corner)
+          {
+            const size_t index = firstVertex + Read<boost::uint16_t>(face + (corner * sizeof(boost::uint16_t)));
+            if (index > 0xFFFF) { return false; }
+            indices.push_back((unsigned short)index);
+          }
+        }
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    begin = next;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------
+
+bool Model3ds::Load(const char* const filename, std::vector<glm::vec3>& positions, std::vector<unsigned short>& indices)
+{
+  std::vector<char> content;
+  if (!LoadFile(filename, content))
+  {
+    return false;
+  }
+
+  std::vector<glm::vec3> filePositions;
+  std::vector<unsigned short> fileIndices;
+  size_t firstVertex = 0;
+  if (content.empty() || !ReadChunks(&content[0], &content[0] + content.size(), firstVertex, filePositions, fileIndices))
+  {
+    LOG("%s: not a valid 3ds file\n", filename);
+    return false;
+  }
+
+  if (fileIndices.empty())
+  {
+    LOG("%s: no meshes\n", filename);
+    return false;
+  }
+
+  positions.swap(filePositions);
+  indices.swap(fileIndices);
+  return true;
+}
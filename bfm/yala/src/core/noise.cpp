@@ -0,0 +1,513 @@
+#include <cmath>
+#include <boost/cstdint.hpp>
+#include <core/noise.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------
+// The noise and fractals are written once, as templates over a set of "lanes": the types
+// and operations for one point (ScalarLanes) or several at once (Sse2Lanes, Avx2Lanes).
+// Every lane type does the same arithmetic in the same order, so the single point and
+// batched forms agree.
+//------------------------------------------------------------------------
+
+// Skewing factors between the simplex grid and the cubic lattice.
+static const float F3 = 1.0f / 3.0f;
+static const float G3 = 1.0f / 6.0f;
+
+// Multipliers hashing a lattice point's coordinates together with the seed.
+static const boost::uint32_t PrimeX = 501125321u;
+static const boost::uint32_t PrimeY = 1136930381u;
+static const boost::uint32_t PrimeZ = 1720413743u;
+static const boost::uint32_t HashMultiplier = 0x27d4eb2du;
+
+// Scale taking the sum of the simplex's corner contributions out to [-1,1].
+static const float SimplexScale = 32.0f;
+
+// How quickly a ridged multifractal's weight grows with the signal.
+static const float RidgeSharpness = 2.0f;
+
+//------------------------------------------------------------------------
+
+struct ScalarLanes
+{
+  typedef float Float;
+  typedef boost::uint32_t Int;
+  typedef bool Mask;
+
+  static const size_t Width = 1;
+
+  static Float Load(const float* const p)                         { return *p; }
+  static void Store(float* const p, const Float& a)               { *p = a; }
+  static Float Set(float a)                                       { return a; }
+  static Float Add(const Float& a, const Float& b)                { return a + b; }
+  static Float Sub(const Float& a, const Float& b)                { return a - b; }
+  static Float Mul(const Float& a, const Float& b)                { return a * b; }
+  static Float Min(const Float& a, const Float& b)                { return (a < b) ? a : b; }
+  static Float Max(const Float& a, const Float& b)                { return (a > b) ? a : b; }
+  static Float Abs(const Float& a)                                { return std::fabs(a); }
+  static Float Negate(const Float& a)                             { return -a; }
+  static Float Floor(const Float& a)                              { const Float t = Float(int(a)); return (t > a) ? (t - 1.0f) : t; }
+
+  static Mask GreaterEqual(const Float& a, const Float& b)        { return a >= b; }
+  static Mask And(const Mask& a, const Mask& b)                   { return a && b; }
+  static Mask Or(const Mask& a, const Mask& b)                    { return a || b; }
+  static Mask Not(const Mask& a)                                  { return !a; }
+  static Float Select(const Mask& m, const Float& a, const Float& b) { return m ? a : b; }
+  static Float MaskToFloat(const Mask& m)                         { return m ? 1.0f : 0.0f; }
+  static Int MaskToInt(const Mask& m)                             { return m ? 1u : 0u; }
+
+  static Int SetInt(boost::uint32_t a)                            { return a; }
+  static Int ToInt(const Float& a)                                 { return Int(int(a)); }
+  static Int IntAdd(const Int& a, const Int& b)                   { return a + b; }
+  static Int IntMul(const Int& a, const Int& b)                   { return a * b; }
+  static Int IntXor(const Int& a, const Int& b)                   { return a ^ b; }
+  static Int IntAnd(const Int& a, const Int& b)                   { return a & b; }
+  static Int IntShiftRight15(const Int& a)                        { return a >> 15; }
+  static Mask IntLess(const Int& a, const Int& b)                 { return a < b; }
+  static Mask IntEqual(const Int& a, const Int& b)                { return a == b; }
+};
+
+//------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+struct Avx2Lanes
+{
+  typedef __m256 Float;
+  typedef __m256i Int;
+  typedef __m256 Mask;
+
+  static const size_t Width = 8;
+
+  static Float Load(const float* const p)                         { return _mm256_loadu_ps(p); }
+  static void Store(float* const p, const Float& a)               { _mm256_storeu_ps(p, a); }
+  static Float Set(float a)                                       { return _mm256_set1_ps(a); }
+  static Float Add(const Float& a, const Float& b)                { return _mm256_add_ps(a, b); }
+  static Float Sub(const Float& a, const Float& b)                { return _mm256_sub_ps(a, b); }
+  static Float Mul(const Float& a, const Float& b)                { return _mm256_mul_ps(a, b); }
+  static Float Min(const Float& a, const Float& b)                { return _mm256_min_ps(a, b); }
+  static Float Max(const Float& a, const Float& b)                { return _mm256_max_ps(a, b); }
+  static Float Abs(const Float& a)                                { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+  static Float Negate(const Float& a)                             { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+  static Float Floor(const Float& a)                              { return _mm256_floor_ps(a); }
+
+  static Mask GreaterEqual(const Float& a, const Float& b)        { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+  static Mask And(const Mask& a, const Mask& b)                   { return _mm256_and_ps(a, b); }
+  static Mask Or(const Mask& a, const Mask& b)                    { return _mm256_or_ps(a, b); }
+  static Mask Not(const Mask& a)                                  { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+  static Float Select(const Mask& m, const Float& a, const Float& b) { return _mm256_blendv_ps(b, a, m); }
+  static Float MaskToFloat(const Mask& m)                         { return _mm256_and_ps(m, _mm256_set1_ps(1.0f)); }
+  static Int MaskToInt(const Mask& m)                             { return _mm256_and_si256(_mm256_castps_si256(m), _mm256_set1_epi32(1)); }
+
+  static Int SetInt(boost::uint32_t a)                            { return _mm256_set1_epi32(int(a)); }
+  static Int ToInt(const Float& a)                                 { return _mm256_cvttps_epi32(a); }
+  static Int IntAdd(const Int& a, const Int& b)                   { return _mm256_add_epi32(a, b); }
+  static Int IntMul(const Int& a, const Int& b)                   { return _mm256_mullo_epi32(a, b); }
+  static Int IntXor(const Int& a, const Int& b)                   { return _mm256_xor_si256(a, b); }
+  static Int IntAnd(const Int& a, const Int& b)                   { return _mm256_and_si256(a, b); }
+  static Int IntShiftRight15(const Int& a)                        { return _mm256_srli_epi32(a, 15); }
+  static Mask IntLess(const Int& a, const Int& b)                 { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+  static Mask IntEqual(const Int& a, const Int& b)                { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+};
+
+typedef Avx2Lanes BatchLanes;
+static const char* const BatchKernelName = "AVX2";
+
+#else
+
+struct Sse2Lanes
+{
+  typedef __m128 Float;
+  typedef __m128i Int;
+  typedef __m128 Mask;
+
+  static const size_t Width = 4;
+
+  static Float Load(const float* const p)                         { return _mm_loadu_ps(p); }
+  static void Store(float* const p, const Float& a)               { _mm_storeu_ps(p, a); }
+  static Float Set(float a)                                       { return _mm_set1_ps(a); }
+  static Float Add(const Float& a, const Float& b)                { return _mm_add_ps(a, b); }
+  static Float Sub(const Float& a, const Float& b)                { return _mm_sub_ps(a, b); }
+  static Float Mul(const Float& a, const Float& b)                { return _mm_mul_ps(a, b); }
+  static Float Min(const Float& a, const Float& b)                { return _mm_min_ps(a, b); }
+  static Float Max(const Float& a, const Float& b)                { return _mm_max_ps(a, b); }
+  static Float Abs(const Float& a)                                { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+  static Float Negate(const Float& a)                             { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+
+  // Truncate, then step down where that rounded up (negative non-integers)...
+  static Float Floor(const Float& a)
+  {
+    const Float t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+  }
+
+  static Mask GreaterEqual(const Float& a, const Float& b)        { return _mm_cmpge_ps(a, b); }
+  static Mask And(const Mask& a, const Mask& b)                   { return _mm_and_ps(a, b); }
+  static Mask Or(const Mask& a, const Mask& b)                    { return _mm_or_ps(a, b); }
+  static Mask Not(const Mask& a)                                  { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+  static Float Select(const Mask& m, const Float& a, const Float& b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+  static Float MaskToFloat(const Mask& m)                         { return _mm_and_ps(m, _mm_set1_ps(1.0f)); }
+  static Int MaskToInt(const Mask& m)                             { return _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(1)); }
+
+  static Int SetInt(boost::uint32_t a)                            { return _mm_set1_epi32(int(a)); }
+  static Int ToInt(const Float& a)                                 { return _mm_cvttps_epi32(a); }
+  static Int IntAdd(const Int& a, const Int& b)                   { return _mm_add_epi32(a, b); }
+  static Int IntXor(const Int& a, const Int& b)                   { return _mm_xor_si128(a, b); }
+  static Int IntAnd(const Int& a, const Int& b)                   { return _mm_and_si128(a, b); }
+  static Int IntShiftRight15(const Int& a)                        { return _mm_srli_epi32(a, 15); }
+  static Mask IntLess(const Int& a, const Int& b)                 { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+  static Mask IntEqual(const Int& a, const Int& b)                { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+
+  // SSE2 has no 32-bit multiply keeping the low halves: multiply the even and odd lanes
+  // to 64 bits and gather the low halves back together...
+  static Int IntMul(const Int& a, const Int& b)
+  {
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+  }
+};
+
+typedef Sse2Lanes BatchLanes;
+static const char* const BatchKernelName = "SSE2";
+
+#endif
+
+//------------------------------------------------------------------------
+
+template <class L>
+static typename L::Int Hash(const typename L::Int& seed, const typename L::Int& i, const typename L::Int& j, const typename L::Int& k)
+{
+  typename L::Int h = L::IntXor(seed, L::IntMul(i, L::SetInt(PrimeX)));
+  h = L::IntXor(h, L::IntMul(j, L::SetInt(PrimeY)));
+  h = L::IntXor(h, L::IntMul(k, L::SetInt(PrimeZ)));
+  h = L::IntMul(h, L::SetInt(HashMultiplier));
+  return L::IntXor(h, L::IntShiftRight15(h));
+}
+
+//------------------------------------------------------------------------
+
+// Dot product of the offset from a lattice point with one of 12 cube edge gradients (4
+// repeated to make 16), chosen by the point's hash. As Perlin's "improved noise".
+template <class L>
+static typename L::Float Gradient(const typename L::Int& hash, const typename L::Float& x, const typename L::Float& y, const typename L::Float& z)
+{
+  typedef typename L::Float Float;
+  typedef typename L::Int Int;
+
+  const Int h = L::IntAnd(hash, L::SetInt(15));
+  const Float u = L::Select(L::IntLess(h, L::SetInt(8)), x, y);
+  const Float v = L::Select(L::IntLess(h, L::SetInt(4)), y, L::Select(L::Or(L::IntEqual(h, L::SetInt(12)), L::IntEqual(h, L::SetInt(14))), x, z));
+
+  const Int zero = L::SetInt(0);
+  const Float signedU = L::Select(L::IntEqual(L::IntAnd(h, L::SetInt(1)), zero), u, L::Negate(u));
+  const Float signedV = L::Select(L::IntEqual(L::IntAnd(h, L::SetInt(2)), zero), v, L::Negate(v));
+  return L::Add(signedU, signedV);
+}
+
+//------------------------------------------------------------------------
+
+// One simplex corner's contribution, falling smoothly to zero at a fixed distance.
+template <class L>
+static typename L::Float Corner(const typename L::Int& hash, const typename L::Float& x, const typename L::Float& y, const typename L::Float& z)
+{
+  typedef typename L::Float Float;
+
+  Float t = L::Sub(L::Sub(L::Sub(L::Set(0.6f), L::Mul(x, x)), L::Mul(y, y)), L::Mul(z, z));
+  t = L::Max(t, L::Set(0.0f));
+  t = L::Mul(t, t);
+  return L::Mul(L::Mul(t, t), Gradient<L>(hash, x, y, z));
+}
+
+//------------------------------------------------------------------------
+
+// 3D simplex noise (Gustavson, "Simplex noise demystified"), branch free so every lane
+// follows the same path.
+template <class L>
+static typename L::Float SimplexKernel(const typename L::Float& x, const typename L::Float& y, const typename L::Float& z, const typename L::Int& seed)
+{
+  typedef typename L::Float Float;
+  typedef typename L::Int Int;
+  typedef typename L::Mask Mask;
+
+  // Skew the input space to find which cell of the lattice the point is in...
+  const Float s = L::Mul(L::Add(L::Add(x, y), z), L::Set(F3));
+  const Float i = L::Floor(L::Add(x, s));
+  const Float j = L::Floor(L::Add(y, s));
+  const Float k = L::Floor(L::Add(z, s));
+
+  // ...and unskew the cell's origin back to find the offset to it...
+  const Float t = L::Mul(L::Add(L::Add(i, j), k), L::Set(G3));
+  const Float x0 = L::Sub(x, L::Sub(i, t));
+  const Float y0 = L::Sub(y, L::Sub(j, t));
+  const Float z0 = L::Sub(z, L::Sub(k, t));
+
+  // Which of the cell's six simplices the point is in gives the offsets of its second and
+  // third corners...
+  const Mask xy = L::GreaterEqual(x0, y0);
+  const Mask yz = L::GreaterEqual(y0, z0);
+  const Mask xz = L::GreaterEqual(x0, z0);
+  const Mask i1 = L::And(xy, xz);
+  const Mask j1 = L::And(L::Not(xy), yz);
+  const Mask k1 = L::And(L::Not(xz), L::Not(yz));
+  const Mask i2 = L::Or(xy, xz);
+  const Mask j2 = L::Or(L::Not(xy), yz);
+  const Mask k2 = L::Not(L::And(xz, yz));
+
+  const Float x1 = L::Add(L::Sub(x0, L::MaskToFloat(i1)), L::Set(G3));
+  const Float y1 = L::Add(L::Sub(y0, L::MaskToFloat(j1)), L::Set(G3));
+  const Float z1 = L::Add(L::Sub(z0, L::MaskToFloat(k1)), L::Set(G3));
+  const Float x2 = L::Add(L::Sub(x0, L::MaskToFloat(i2)), L::Set(2.0f * G3));
+  const Float y2 = L::Add(L::Sub(y0, L::MaskToFloat(j2)), L::Set(2.0f * G3));
+  const Float z2 = L::Add(L::Sub(z0, L::MaskToFloat(k2)), L::Set(2.0f * G3));
+  const Float x3 = L::Add(L::Sub(x0, L::Set(1.0f)), L::Set(3.0f * G3));
+  const Float y3 = L::Add(L::Sub(y0, L::Set(1.0f)), L::Set(3.0f * G3));
+  const Float z3 = L::Add(L::Sub(z0, L::Set(1.0f)), L::Set(3.0f * G3));
+
+  const Int ii = L::ToInt(i);
+  const Int jj = L::ToInt(j);
+  const Int kk = L::ToInt(k);
+  const Int one = L::SetInt(1);
+
+  const Float n0 = Corner<L>(Hash<L>(seed, ii, jj, kk), x0, y0, z0);
+  const Float n1 = Corner<L>(Hash<L>(seed, L::IntAdd(ii, L::MaskToInt(i1)), L::IntAdd(jj, L::MaskToInt(j1)), L::IntAdd(kk, L::MaskToInt(k1))), x1, y1, z1);
+  const Float n2 = Corner<L>(Hash<L>(seed, L::IntAdd(ii, L::MaskToInt(i2)), L::IntAdd(jj, L::MaskToInt(j2)), L::IntAdd(kk, L::MaskToInt(k2))), x2, y2, z2);
+  const Float n3 = Corner<L>(Hash<L>(seed, L::IntAdd(ii, one), L::IntAdd(jj, one), L::IntAdd(kk, one)), x3, y3, z3);
+
+  return L::Mul(L::Add(L::Add(n0, n1), L::Add(n2, n3)), L::Set(SimplexScale));
+}
+
+//------------------------------------------------------------------------
+// The functions evaluated per point by Batch. Each holds its parameters, and the fractals
+// their octave loops, so that a batch stays in registers from the first octave to the last.
+//------------------------------------------------------------------------
+
+template <class L>
+struct SimplexFunction
+{
+  typedef typename L::Float Float;
+
+  SimplexFunction(unsigned int seed) : seed(seed) { }
+
+  Float operator()(const Float& x, const Float& y, const Float& z) const
+  {
+    return SimplexKernel<L>(x, y, z, L::SetInt(seed));
+  }
+
+  const unsigned int seed;
+};
+
+//------------------------------------------------------------------------
+
+template <class L>
+struct FBmFunction
+{
+  typedef typename L::Float Float;
+
+  FBmFunction(const Noise::Fractal& fractal, unsigned int seed) : fractal(fractal), seed(seed) { }
+
+  Float operator()(const Float& px, const Float& py, const Float& pz) const
+  {
+    Float x = px;
+    Float y = py;
+    Float z = pz;
+    const Float lacunarity = L::Set(fractal.lacunarity);
+    Float result = L::Set(0.0f);
+    float amplitude = 1.0f;
+    for (unsigned int octave = 0; octave < fractal.octaves; ++octave)
+    {
+      result = L::Add(result, L::Mul(SimplexKernel<L>(x, y, z, L::SetInt(seed + octave)), L::Set(amplitude)));
+
+      amplitude *= fractal.gain;
+      x = L::Mul(x, lacunarity);
+      y = L::Mul(y, lacunarity);
+      z = L::Mul(z, lacunarity);
+    }
+    return result;
+  }
+
+  const Noise::Fractal fractal;
+  const unsigned int seed;
+};
+
+//------------------------------------------------------------------------
+
+template <class L>
+struct HybridMultifractalFunction
+{
+  typedef typename L::Float Float;
+
+  HybridMultifractalFunction(const Noise::Fractal& fractal, unsigned int seed) : fractal(fractal), seed(seed) { }
+
+  Float operator()(const Float& px, const Float& py, const Float& pz) const
+  {
+    Float x = px;
+    Float y = py;
+    Float z = pz;
+    const Float lacunarity = L::Set(fractal.lacunarity);
+    const Float offset = L::Set(fractal.offset);
+    const Float one = L::Set(1.0f);
+    Float result = L::Set(0.0f);
+    Float weight = one;
+    float amplitude = 1.0f;
+    for (unsigned int octave = 0; octave < fractal.octaves; ++octave)
+    {
+      const Float signal = L::Mul(L::Add(SimplexKernel<L>(x, y, z, L::SetInt(seed + octave)), offset), L::Set(amplitude));
+      result = L::Add(result, L::Mul(weight, signal));
+      weight = L::Min(L::Mul(weight, signal), one);
+
+      amplitude *= fractal.gain;
+      x = L::Mul(x, lacunarity);
+      y = L::Mul(y, lacunarity);
+      z = L::Mul(z, lacunarity);
+    }
+    return result;
+  }
+
+  const Noise::Fractal fractal;
+  const unsigned int seed;
+};
+
+//------------------------------------------------------------------------
+
+template <class L>
+struct RidgedFunction
+{
+  typedef typename L::Float Float;
+
+  RidgedFunction(const Noise::Fractal& fractal, unsigned int seed) : fractal(fractal), seed(seed) { }
+
+  Float operator()(const Float& px, const Float& py, const Float& pz) const
+  {
+    Float x = px;
+    Float y = py;
+    Float z = pz;
+    const Float lacunarity = L::Set(fractal.lacunarity);
+    const Float offset = L::Set(fractal.offset);
+    const Float sharpness = L::Set(RidgeSharpness);
+    const Float zero = L::Set(0.0f);
+    const Float one = L::Set(1.0f);
+    Float result = zero;
+    Float weight = one;
+    float amplitude = 1.0f;
+    for (unsigned int octave = 0; octave < fractal.octaves; ++octave)
+    {
+      Float signal = L::Sub(offset, L::Abs(SimplexKernel<L>(x, y, z, L::SetInt(seed + octave))));
+      signal = L::Mul(L::Mul(signal, signal), weight);
+      weight = L::Min(L::Max(L::Mul(signal, sharpness), zero), one);
+      result = L::Add(result, L::Mul(signal, L::Set(amplitude)));
+
+      amplitude *= fractal.gain;
+      x = L::Mul(x, lacunarity);
+      y = L::Mul(y, lacunarity);
+      z = L::Mul(z, lacunarity);
+    }
+    return result;
+  }
+
+  const Noise::Fractal fractal;
+  const unsigned int seed;
+};
+
+//------------------------------------------------------------------------
+
+// Evaluate a function over arrays of points a batch at a time. The last partial batch is
+// padded out through a small buffer rather than handled a point at a time.
+template <class L, class Function>
+static void Batch(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Function& function)
+{
+  size_t i = 0;
+  for (; (i + L::Width) <= count; i += L::Width)
+  {
+    L::Store(&results[i], function(L::Load(&x[i]), L::Load(&y[i]), L::Load(&z[i])));
+  }
+
+  if (i < count)
+  {
+    float px[L::Width] = { 0 };
+    float py[L::Width] = { 0 };
+    float pz[L::Width] = { 0 };
+    float pr[L::Width];
+    for (size_t lane = 0; (i + lane) < count; ++lane)
+    {
+      px[lane] = x[i + lane];
+      py[lane] = y[i + lane];
+      pz[lane] = z[i + lane];
+    }
+
+    L::Store(pr, function(L::Load(px), L::Load(py), L::Load(pz)));
+
+    for (size_t lane = 0; (i + lane) < count; ++lane)
+    {
+      results[i + lane] = pr[lane];
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+float Noise::Simplex(const glm::vec3& p, unsigned int seed)
+{
+  return SimplexFunction<ScalarLanes>(seed)(p.x, p.y, p.z);
+}
+
+//------------------------------------------------------------------------
+
+float Noise::FBm(const glm::vec3& p, const Fractal& fractal, unsigned int seed)
+{
+  return FBmFunction<ScalarLanes>(fractal, seed)(p.x, p.y, p.z);
+}
+
+//------------------------------------------------------------------------
+
+float Noise::HybridMultifractal(const glm::vec3& p, const Fractal& fractal, unsigned int seed)
+{
+  return HybridMultifractalFunction<ScalarLanes>(fractal, seed)(p.x, p.y, p.z);
+}
+
+//------------------------------------------------------------------------
+
+float Noise::Ridged(const glm::vec3& p, const Fractal& fractal, unsigned int seed)
+{
+  return RidgedFunction<ScalarLanes>(fractal, seed)(p.x, p.y, p.z);
+}
+
+//------------------------------------------------------------------------
+
+void Noise::Simplex(const float* const x, const float* const y, const float* const z, float* const results, size_t count, unsigned int seed)
+{
+  Batch<BatchLanes>(x, y, z, results, count, SimplexFunction<BatchLanes>(seed));
+}
+
+//------------------------------------------------------------------------
+
+void Noise::FBm(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed)
+{
+  Batch<BatchLanes>(x, y, z, results, count, FBmFunction<BatchLanes>(fractal, seed));
+}
+
+//------------------------------------------------------------------------
+
+void Noise::HybridMultifractal(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed)
+{
+  Batch<BatchLanes>(x, y, z, results, count, HybridMultifractalFunction<BatchLanes>(fractal, seed));
+}
+
+//------------------------------------------------------------------------
+
+void Noise::Ridged(const float* const x, const float* const y, const float* const z, float* const results, size_t count, const Fractal& fractal, unsigned int seed)
+{
+  Batch<BatchLanes>(x, y, z, results, count, RidgedFunction<BatchLanes>(fractal, seed));
+}
+
+//------------------------------------------------------------------------
+
+const char* Noise::KernelName()
+{
+  return BatchKernelName;
+}
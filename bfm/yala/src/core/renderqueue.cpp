@@ -0,0 +1,100 @@
+#include <core/renderqueue.h>
+
+//------------------------------------------------------------------------
+
+static unsigned int HashPointer(const void* const pointer, unsigned int bits);
+
+//------------------------------------------------------------------------
+
+boost::uint64_t RenderQueue::MakeKey(unsigned int pass, const DrawState& drawState, float depth)
+{
+  // Textures are hashed together, in unit order...
+  unsigned int textures = 0;
+  for (unsigned int unit = 0; unit < DrawState::MaxTextureUnits; ++unit)
+  {
+    textures = (textures * 31) + HashPointer(drawState.textureUnits[unit].texture.get(), 32);
+  }
+
+  const float clamped = (depth < 0.0f) ? 0.0f : ((depth > 1.0f) ? 1.0f : depth);
+  const boost::uint64_t quantisedDepth = boost::uint64_t(clamped * ((1 << DepthBits) - 1));
+
+  boost::uint64_t key = pass & ((1 << PassBits) - 1);
+  key = (key << EffectBits) | HashPointer(drawState.effect, EffectBits);
+  key = (key << VertexArrayBits) | HashPointer(drawState.vertexArray.get(), VertexArrayBits);
+  key = (key << TextureBits) | (textures & ((1 << TextureBits) - 1));
+  key = (key << DepthBits) | quantisedDepth;
+  return key;
+}
+
+//------------------------------------------------------------------------
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+  packets.push_back(packet);
+}
+
+//------------------------------------------------------------------------
+
+void RenderQueue::Clear()
+{
+  packets.clear();
+  order.clear();
+}
+
+//------------------------------------------------------------------------
+
+void RenderQueue::Sort()
+{
+  const unsigned int count = packets.size();
+
+  keys.resize(count);
+  order.resize(count);
+  scratch.resize(count);
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    keys[i] = packets[i].key;
+    order[i] = i;
+  }
+
+  // Least significant digit radix sort a byte at a time, which keeps equal keys in
+  // submission order. Bytes which are the same in every key (often the pass, and the
+  // effect within a pass) need no pass over the packets...
+  for (unsigned int shift = 0; shift < 64; shift += 8)
+  {
+    unsigned int counts[256] = { 0 };
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      ++counts[(keys[order[i]] >> shift) & 0xFF];
+    }
+
+    if ((0 == count) || (count == counts[(keys[order[0]] >> shift) & 0xFF]))
+    {
+      continue;
+    }
+
+    unsigned int offsets[256];
+    unsigned int total = 0;
+    for (unsigned int digit = 0; digit < 256; ++digit)
+    {
+      offsets[digit] = total;
+      total += counts[digit];
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      scratch[offsets[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+    }
+    order.swap(scratch);
+  }
+}
+
+//------------------------------------------------------------------------
+
+// Fold a pointer into a number of bits (at most 32), mixing so that nearby allocations
+// spread out.
+static unsigned int HashPointer(const void* const pointer, unsigned int bits)
+{
+  const boost::uint64_t value = boost::uint64_t(size_t(pointer)) >> 4;
+  const unsigned int mixed = (unsigned int)((value ^ (value >> 32)) * 2654435761u);
+  return (bits < 32) ? (mixed >> (32 - bits)) : mixed;
+}
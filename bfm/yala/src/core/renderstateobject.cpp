@@ -0,0 +1,154 @@
+#include <map>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <core/renderstate/renderstateobject.h>
+
+//------------------------------------------------------------------------
+
+// Every object ever created, indexed by id, and the changes between each pair: changes[a][b]
+// going from object a to object b. Objects live as long as the program. Only used from the
+// drawing thread.
+struct Registry
+{
+  std::vector<RenderStatePtr> objects;
+  std::vector<std::vector<unsigned short> > changes;
+  std::multimap<boost::uint64_t, unsigned int> byHash;
+};
+
+//------------------------------------------------------------------------
+
+static Registry& GetRegistry();
+static boost::uint64_t Hash(const RenderState& state);
+static unsigned int Compare(const RenderState& from, const RenderState& to);
+static bool Equal(const RenderState& a, const RenderState& b);
+
+//------------------------------------------------------------------------
+
+RenderStateObject::RenderStateObject(unsigned int id, const RenderState& description)
+  : id(id), description(description)
+{
+}
+
+//------------------------------------------------------------------------
+
+RenderStatePtr RenderStateObject::Get(const RenderState& description)
+{
+  Registry& registry = GetRegistry();
+  std::vector<RenderStatePtr>& objects = registry.objects;
+  std::vector<std::vector<unsigned short> >& changes = registry.changes;
+  const boost::uint64_t hash = Hash(description);
+
+  typedef std::multimap<boost::uint64_t, unsigned int>::const_iterator Iterator;
+  const std::pair<Iterator, Iterator> matches = registry.byHash.equal_range(hash);
+  for (Iterator i = matches.first; i != matches.second; ++i)
+  {
+    if (Equal(objects[i->second]->description, description))
+    {
+      return objects[i->second];
+    }
+  }
+
+  // A new state: work out its changes to and from every existing one...
+  const unsigned int id = objects.size();
+  const RenderStatePtr object(new RenderStateObject(id, description));
+  objects.push_back(object);
+  registry.byHash.insert(std::make_pair(hash, id));
+
+  changes.push_back(std::vector<unsigned short>(id + 1, 0));
+  for (unsigned int other = 0; other < id; ++other)
+  {
+    changes[other].push_back((unsigned short)Compare(objects[other]->description, description));
+    changes[id][other] = (unsigned short)Compare(description, objects[other]->description);
+  }
+
+  return object;
+}
+
+//------------------------------------------------------------------------
+
+RenderStatePtr RenderStateObject::Default()
+{
+  static const RenderStatePtr defaultState = Get(RenderState());
+  return defaultState;
+}
+
+//------------------------------------------------------------------------
+
+unsigned int RenderStateObject::Changes(const RenderStateObject& from, const RenderStateObject& to)
+{
+  return GetRegistry().changes[from.id][to.id];
+}
+
+//------------------------------------------------------------------------
+
+// Created on first use, so that render states may be made during static initialisation.
+static Registry& GetRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+//------------------------------------------------------------------------
+
+static boost::uint64_t Hash(const RenderState& state)
+{
+  // FNV-1a over the fields...
+  const boost::uint64_t fields[] =
+  {
+    state.mode, state.depthMask,
+    state.colourMask.r, state.colourMask.g, state.colourMask.b, state.colourMask.a,
+    state.blending.enabled, state.blending.srcRGB, state.blending.srcAlpha,
+    state.blending.dstRGB, state.blending.dstAlpha,
+    state.blending.rgbEquation, state.blending.alphaEquation,
+    state.culling.enabled, state.culling.faceToCull, state.culling.windingOrder,
+    state.depthTest.enabled, state.depthTest.function
+  };
+
+  boost::uint64_t hash = 14695981039346656037ull;
+  for (unsigned int i = 0; i < (sizeof(fields) / sizeof(fields[0])); ++i)
+  {
+    hash = (hash ^ fields[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+//------------------------------------------------------------------------
+
+static unsigned int Compare(const RenderState& from, const RenderState& to)
+{
+  typedef RenderStateObject::Change Change;
+
+  unsigned int changed = 0;
+  if (from.colourMask != to.colourMask)                                 { changed |= Change::ColourMask; }
+  if (from.depthMask != to.depthMask)                                   { changed |= Change::DepthMask; }
+  if (from.depthTest.enabled != to.depthTest.enabled)                   { changed |= Change::DepthTest; }
+  if (from.depthTest.function != to.depthTest.function)                 { changed |= Change::DepthFunction; }
+  if (from.culling.enabled != to.culling.enabled)                       { changed |= Change::Culling; }
+  if (from.culling.faceToCull != to.culling.faceToCull)                 { changed |= Change::CullFace; }
+  if (from.culling.windingOrder != to.culling.windingOrder)             { changed |= Change::FrontFace; }
+  if (from.mode != to.mode)                                             { changed |= Change::PolygonMode; }
+  if (from.blending.enabled != to.blending.enabled)                     { changed |= Change::Blending; }
+
+  if ((from.blending.srcRGB != to.blending.srcRGB) ||
+      (from.blending.dstRGB != to.blending.dstRGB) ||
+      (from.blending.srcAlpha != to.blending.srcAlpha) ||
+      (from.blending.dstAlpha != to.blending.dstAlpha))
+  {
+    changed |= Change::BlendFunction;
+  }
+
+  if ((from.blending.rgbEquation != to.blending.rgbEquation) ||
+      (from.blending.alphaEquation != to.blending.alphaEquation))
+  {
+    changed |= Change::BlendEquation;
+  }
+
+  return changed;
+}
+
+//------------------------------------------------------------------------
+
+static bool Equal(const RenderState& a, const RenderState& b)
+{
+  return 0 == Compare(a, b);
+}
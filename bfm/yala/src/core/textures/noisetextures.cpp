@@ -0,0 +1,264 @@
+#include <emmintrin.h>
+#include <vector>
+#include <core/device.h>
+#include <core/textures/noisetextures.h>
+
+//------------------------------------------------------------------------
+
+// Gradients: Perlin's 8 for 2D and his "improved noise" 12 cube edges (4 repeated to make
+// 16) for 3D.
+static const float Gradients2D[8][2] =
+{
+  {  1,  0 }, { -1,  0 }, {  0,  1 }, {  0, -1 },
+  {  0.70710678f,  0.70710678f }, { -0.70710678f,  0.70710678f },
+  {  0.70710678f, -0.70710678f }, { -0.70710678f, -0.70710678f }
+};
+
+static const float Gradients3D[16][3] =
+{
+  {  1,  1,  0 }, { -1,  1,  0 }, {  1, -1,  0 }, { -1, -1,  0 },
+  {  1,  0,  1 }, { -1,  0,  1 }, {  1,  0, -1 }, { -1,  0, -1 },
+  {  0,  1,  1 }, {  0, -1,  1 }, {  0,  1, -1 }, {  0, -1, -1 },
+  {  1,  1,  0 }, { -1,  1,  0 }, {  0, -1,  1 }, {  0, -1, -1 }
+};
+
+// Scales taking each noise's extremes out to roughly [-1,1].
+static const float Scale2D = 1.41421356f;
+static const float Scale3D = 1.0f;
+
+//------------------------------------------------------------------------
+
+// A shuffled permutation of 0-255, doubled so that nested lookups need no wrapping.
+struct Permutation
+{
+  Permutation(unsigned int seed);
+
+  unsigned char values[512];
+};
+
+//------------------------------------------------------------------------
+
+static __m128 Fade(__m128 t);
+static __m128 Lerp(__m128 a, __m128 b, __m128 t);
+
+//------------------------------------------------------------------------
+
+NoiseTextures::NoiseTextures()
+{
+}
+
+//------------------------------------------------------------------------
+
+NoiseTextures::~NoiseTextures()
+{
+}
+
+//------------------------------------------------------------------------
+
+void NoiseTextures::Initialise(unsigned int seed)
+{
+  // Mip maps fade the 2D noise towards zero in the distance rather than letting it alias;
+  // the volume is small enough to be used close up only...
+  std::vector<float> texels(Size2D * Size2D);
+  Generate2D(Size2D, Cells2D, seed, &texels[0]);
+  texture2D = Device::NewTexture2D(Texture2DDescription(GL_R16F, glm::uvec2(Size2D), true));
+  texture2D->SetData(&texels[0], GL_RED, GL_FLOAT);
+
+  texels.resize(Size3D * Size3D * Size3D);
+  Generate3D(Size3D, Cells3D, seed, &texels[0]);
+  texture3D = Device::NewTexture3D(Texture3DDescription(GL_R16F, glm::uvec3(Size3D)));
+  texture3D->SetData(&texels[0], GL_RED, GL_FLOAT);
+
+  sampler = Device::NewSampler();
+  sampler->SetMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+  sampler->SetMagFilter(GL_LINEAR);
+  sampler->SetWrap(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+}
+
+//------------------------------------------------------------------------
+
+void NoiseTextures::Apply(Effect& effect, DrawState& drawState) const
+{
+  effect.NoiseTexture2D->Set(int(Unit2D));
+  effect.NoiseTexture3D->Set(int(Unit3D));
+
+  drawState.textureUnits[Unit2D].texture = texture2D;
+  drawState.textureUnits[Unit2D].sampler = sampler;
+  drawState.textureUnits[Unit3D].texture = texture3D;
+  drawState.textureUnits[Unit3D].sampler = sampler;
+}
+
+//------------------------------------------------------------------------
+
+void NoiseTextures::Generate2D(unsigned int size, unsigned int cells, unsigned int seed, float* const output)
+{
+  const Permutation perm(seed);
+  const unsigned int mask = cells - 1;
+  const float cellsPerTexel = float(cells) / size;
+
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(Scale2D);
+
+  for (unsigned int y = 0; y < size; ++y)
+  {
+    const float py = (y + 0.5f) * cellsPerTexel;
+    const unsigned int iy = (unsigned int)py;
+    const __m128 fy = _mm_set1_ps(py - iy);
+    const __m128 fy1 = _mm_sub_ps(fy, one);
+    const __m128 v = Fade(fy);
+
+    for (unsigned int x = 0; x < size; x += 4)
+    {
+      // Gather each lane's corner gradients; the rest is done four lanes at once...
+      float fx[4];
+      float g00x[4], g00y[4], g10x[4], g10y[4], g01x[4], g01y[4], g11x[4], g11y[4];
+      for (unsigned int lane = 0; lane < 4; ++lane)
+      {
+        const float px = (x + lane + 0.5f) * cellsPerTexel;
+        const unsigned int ix = (unsigned int)px;
+        fx[lane] = px - ix;
+
+        const unsigned int x0 = perm.values[ix & mask];
+        const unsigned int x1 = perm.values[(ix + 1) & mask];
+        const unsigned int y0 = iy & mask;
+        const unsigned int y1 = (iy + 1) & mask;
+
+        const float* g = Gradients2D[perm.values[x0 + y0] & 7];
+        g00x[lane] = g[0]; g00y[lane] = g[1];
+        g = Gradients2D[perm.values[x1 + y0] & 7];
+        g10x[lane] = g[0]; g10y[lane] = g[1];
+        g = Gradients2D[perm.values[x0 + y1] & 7];
+        g01x[lane] = g[0]; g01y[lane] = g[1];
+        g = Gradients2D[perm.values[x1 + y1] & 7];
+        g11x[lane] = g[0]; g11y[lane] = g[1];
+      }
+
+      const __m128 fx0 = _mm_loadu_ps(fx);
+      const __m128 fx1 = _mm_sub_ps(fx0, one);
+
+      const __m128 n00 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(g00x), fx0), _mm_mul_ps(_mm_loadu_ps(g00y), fy));
+      const __m128 n10 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(g10x), fx1), _mm_mul_ps(_mm_loadu_ps(g10y), fy));
+      const __m128 n01 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(g01x), fx0), _mm_mul_ps(_mm_loadu_ps(g01y), fy1));
+      const __m128 n11 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(g11x), fx1), _mm_mul_ps(_mm_loadu_ps(g11y), fy1));
+
+      const __m128 u = Fade(fx0);
+      const __m128 value = Lerp(Lerp(n00, n10, u), Lerp(n01, n11, u), v);
+      _mm_storeu_ps(&output[x + (y * size)], _mm_mul_ps(value, scale));
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+void NoiseTextures::Generate3D(unsigned int size, unsigned int cells, unsigned int seed, float* const output)
+{
+  const Permutation perm(seed);
+  const unsigned int mask = cells - 1;
+  const float cellsPerTexel = float(cells) / size;
+
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(Scale3D);
+
+  for (unsigned int z = 0; z < size; ++z)
+  {
+    const float pz = (z + 0.5f) * cellsPerTexel;
+    const unsigned int iz = (unsigned int)pz;
+    const __m128 fz = _mm_set1_ps(pz - iz);
+    const __m128 fz1 = _mm_sub_ps(fz, one);
+    const __m128 w = Fade(fz);
+
+    for (unsigned int y = 0; y < size; ++y)
+    {
+      const float py = (y + 0.5f) * cellsPerTexel;
+      const unsigned int iy = (unsigned int)py;
+      const __m128 fy = _mm_set1_ps(py - iy);
+      const __m128 fy1 = _mm_sub_ps(fy, one);
+      const __m128 v = Fade(fy);
+
+      for (unsigned int x = 0; x < size; x += 4)
+      {
+        // Corner c is at (c & 1, (c >> 1) & 1, c >> 2) in the lattice cell...
+        float fx[4];
+        float gx[8][4], gy[8][4], gz[8][4];
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+          const float px = (x + lane + 0.5f) * cellsPerTexel;
+          const unsigned int ix = (unsigned int)px;
+          fx[lane] = px - ix;
+
+          for (unsigned int corner = 0; corner < 8; ++corner)
+          {
+            const unsigned int cx = (ix + (corner & 1)) & mask;
+            const unsigned int cy = (iy + ((corner >> 1) & 1)) & mask;
+            const unsigned int cz = (iz + (corner >> 2)) & mask;
+            const float* const g = Gradients3D[perm.values[perm.values[perm.values[cx] + cy] + cz] & 15];
+            gx[corner][lane] = g[0];
+            gy[corner][lane] = g[1];
+            gz[corner][lane] = g[2];
+          }
+        }
+
+        const __m128 fx0 = _mm_loadu_ps(fx);
+        const __m128 fx1 = _mm_sub_ps(fx0, one);
+
+        __m128 n[8];
+        for (unsigned int corner = 0; corner < 8; ++corner)
+        {
+          const __m128 dx = (corner & 1) ? fx1 : fx0;
+          const __m128 dy = ((corner >> 1) & 1) ? fy1 : fy;
+          const __m128 dz = (corner >> 2) ? fz1 : fz;
+          n[corner] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx[corner]), dx), _mm_mul_ps(_mm_loadu_ps(gy[corner]), dy)),
+            _mm_mul_ps(_mm_loadu_ps(gz[corner]), dz));
+        }
+
+        const __m128 u = Fade(fx0);
+        const __m128 front = Lerp(Lerp(n[0], n[1], u), Lerp(n[2], n[3], u), v);
+        const __m128 back = Lerp(Lerp(n[4], n[5], u), Lerp(n[6], n[7], u), v);
+        _mm_storeu_ps(&output[x + ((y + (z * size)) * size)], _mm_mul_ps(Lerp(front, back, w), scale));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+Permutation::Permutation(unsigned int seed)
+{
+  for (unsigned int i = 0; i < 256; ++i)
+  {
+    values[i] = (unsigned char)i;
+  }
+
+  // Fisher-Yates shuffle driven by a simple LCG; only needs to be repeatable...
+  unsigned int state = seed * 2654435761u + 1;
+  for (unsigned int i = 255; i > 0; --i)
+  {
+    state = (state * 1664525u) + 1013904223u;
+    const unsigned int j = (state >> 8) % (i + 1);
+    const unsigned char swap = values[i];
+    values[i] = values[j];
+    values[j] = swap;
+  }
+
+  for (unsigned int i = 0; i < 256; ++i)
+  {
+    values[i + 256] = values[i];
+  }
+}
+
+//------------------------------------------------------------------------
+
+static __m128 Fade(__m128 t)
+{
+  // 6t^5 - 15t^4 + 10t^3
+  const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+  return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+//------------------------------------------------------------------------
+
+static __m128 Lerp(__m128 a, __m128 b, __m128 t)
+{
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
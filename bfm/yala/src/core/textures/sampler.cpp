@@ -0,0 +1,42 @@
+#include <core/textures/sampler.h>
+
+//------------------------------------------------------------------------
+
+Sampler::Sampler()
+  : minFilter(GL_NEAREST_MIPMAP_LINEAR),
+    magFilter(GL_LINEAR)
+{
+  glGenSamplers(1, &sampler);
+}
+
+//------------------------------------------------------------------------
+
+Sampler::~Sampler()
+{
+  glDeleteSamplers(1, &sampler);
+}
+
+//------------------------------------------------------------------------
+
+void Sampler::SetMinFilter(GLenum value)
+{
+  minFilter = value;
+  glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, value);
+}
+
+//------------------------------------------------------------------------
+
+void Sampler::SetMagFilter(GLenum value)
+{
+  magFilter = value;
+  glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, value);
+}
+
+//------------------------------------------------------------------------
+
+void Sampler::SetWrap(GLenum s, GLenum t, GLenum r)
+{
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, s);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, t);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, r);
+}
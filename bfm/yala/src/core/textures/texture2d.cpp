@@ -0,0 +1,70 @@
+#include <core/textures/texture2d.h>
+
+//------------------------------------------------------------------------
+
+static unsigned int LevelCount(const glm::uvec2& size);
+
+//------------------------------------------------------------------------
+
+Texture2D::Texture2D(const Texture2DDescription& description)
+  : Texture(GL_TEXTURE_2D, description.internalFormat),
+    description(description)
+{
+  BindForUpdate();
+  glTexStorage2D(
+    GL_TEXTURE_2D,
+    description.makeMipMaps ? LevelCount(description.size) : 1,
+    description.internalFormat,
+    description.size.x,
+    description.size.y);
+  Unbind();
+}
+
+//------------------------------------------------------------------------
+
+Texture2D::~Texture2D()
+{
+}
+
+//------------------------------------------------------------------------
+
+void Texture2D::SetData(const void* const data, GLenum dataFormat, GLenum dataType)
+{
+  BindForUpdate();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, description.size.x, description.size.y, dataFormat, dataType, data);
+  if (description.makeMipMaps)
+  {
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  Unbind();
+}
+
+//------------------------------------------------------------------------
+
+void Texture2D::SetData(unsigned int level, const glm::uvec2& offset, const glm::uvec2& size, const void* const data, GLenum dataFormat, GLenum dataType)
+{
+  BindForUpdate();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, level, offset.x, offset.y, size.x, size.y, dataFormat, dataType, data);
+  Unbind();
+}
+
+//------------------------------------------------------------------------
+
+unsigned int Texture2D::GetLevelCount() const
+{
+  return description.makeMipMaps ? LevelCount(description.size) : 1;
+}
+
+//------------------------------------------------------------------------
+
+static unsigned int LevelCount(const glm::uvec2& size)
+{
+  unsigned int levels = 1;
+  for (unsigned int largest = glm::max(size.x, size.y); largest > 1; largest >>= 1)
+  {
+    ++levels;
+  }
+  return levels;
+}
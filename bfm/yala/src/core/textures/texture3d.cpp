@@ -0,0 +1,38 @@
+#include <core/textures/texture3d.h>
+
+//------------------------------------------------------------------------
+
+Texture3D::Texture3D(const Texture3DDescription& description)
+  : Texture(GL_TEXTURE_3D, description.internalFormat),
+    description(description)
+{
+  BindForUpdate();
+  glTexStorage3D(
+    GL_TEXTURE_3D,
+    1,
+    description.internalFormat,
+    description.size.x,
+    description.size.y,
+    description.size.z);
+  Unbind();
+}
+
+//------------------------------------------------------------------------
+
+Texture3D::~Texture3D()
+{
+}
+
+//------------------------------------------------------------------------
+
+void Texture3D::SetData(const void* const data, GLenum dataFormat, GLenum dataType)
+{
+  BindForUpdate();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(
+    GL_TEXTURE_3D, 0,
+    0, 0, 0,
+    description.size.x, description.size.y, description.size.z,
+    dataFormat, dataType, data);
+  Unbind();
+}
@@ -12,47 +12,82 @@ VertexArray::~VertexArray()
 
 VertexArray::VertexArray(boost::shared_ptr<VertexBuffer> vertexBuffer)
 {
-  Initialise(vertexBuffer, NULL);
+  Initialise(vertexBuffer, NULL, false);
 }
 
 //------------------------------------------------------------------------
 
 VertexArray::VertexArray(boost::shared_ptr<VertexBuffer> vertexBuffer, boost::shared_ptr<IndexBuffer> indexBuffer)
 {
-  Initialise(vertexBuffer, indexBuffer);
+  Initialise(vertexBuffer, indexBuffer, false);
 }
 
 //------------------------------------------------------------------------
 
-void VertexArray::Initialise(boost::shared_ptr<VertexBuffer> vertexBuffer, boost::shared_ptr<IndexBuffer> indexBuffer)
+VertexArray::VertexArray(boost::shared_ptr<VertexBuffer> vertexBuffer, boost::shared_ptr<IndexBuffer> indexBuffer, bool shared)
+{
+  Initialise(vertexBuffer, indexBuffer, shared);
+}
+
+//------------------------------------------------------------------------
+
+void VertexArray::Initialise(boost::shared_ptr<VertexBuffer> vertexBuffer, boost::shared_ptr<IndexBuffer> indexBuffer, bool shared)
 {
   this->vertexBuffer = vertexBuffer;
   this->indexBuffer = indexBuffer;
+  indexOffset = (indexBuffer && !shared) ? indexBuffer->GetOffset() : 0;
+
+  // Arrays may be made mid-frame (e.g. by Scatter::Draw), and Context skips binding the
+  // array it last bound, so whatever's bound now must be bound again afterwards...
+  GLint previous = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
 
   glGenVertexArrays(1, &vao);
   glBindVertexArray(vao);
-  vertexBuffer->Enable();
   if (indexBuffer)
   {
     indexBuffer->Enable();
   }
 
-  BOOST_FOREACH(auto attr, vertexBuffer->GetVertexLayout().GetAttributes())
+  // Without a vertex buffer there are no attributes; the vertex shader derives everything
+  // it needs from gl_VertexID...
+  if (vertexBuffer)
   {
-    glEnableVertexAttribArray(attr.semantic);
-    glVertexAttribPointer(
-      attr.semantic,
-      attr.elements,
-      attr.type,
-      GL_FALSE,
-      vertexBuffer->GetVertexLayout().GetStride(),
-      (const void*)attr.offset);
+    vertexBuffer->Enable();
+
+    const VertexLayout& layout = vertexBuffer->GetVertexLayout();
+    const size_t base = shared ? 0 : vertexBuffer->GetOffset();
+    BOOST_FOREACH(const VertexAttribute& attr, layout.GetAttributes())
+    {
+      glEnableVertexAttribArray(attr.semantic);
+      if (VertexFormat::Integer == attr.format)
+      {
+        glVertexAttribIPointer(
+          attr.semantic,
+          attr.elements,
+          attr.type,
+          layout.GetStride(),
+          (const void*)(base + attr.offset));
+      }
+      else
+      {
+        glVertexAttribPointer(
+          attr.semantic,
+          attr.elements,
+          attr.type,
+          (VertexFormat::Normalised == attr.format) ? GL_TRUE : GL_FALSE,
+          layout.GetStride(),
+          (const void*)(base + attr.offset));
+      }
+      glVertexAttribDivisor(attr.semantic, attr.divisor);
+    }
   }
 
   glBindVertexArray(0);
-  vertexBuffer->Disable();
+  VertexBuffer::Disable();
   if (indexBuffer)
   {
     indexBuffer->Disable();
   }
+  glBindVertexArray((GLuint)previous);
 }
@@ -13,11 +13,26 @@ void VertexLayout::AddAttribute(const VertexAttribute& attr)
 {
   attributes.push_back(attr);
 
+  size_t size = 0;
   switch (attr.type)
   {
-  case GL_INT: stride += sizeof(int) * attr.elements; break;
-  case GL_FLOAT: stride += sizeof(float) * attr.elements; break;
-  case GL_UNSIGNED_INT: stride += sizeof(unsigned int) * attr.elements; break;
+  case GL_BYTE:           size = sizeof(GLbyte) * attr.elements; break;
+  case GL_UNSIGNED_BYTE:  size = sizeof(GLubyte) * attr.elements; break;
+  case GL_SHORT:          size = sizeof(GLshort) * attr.elements; break;
+  case GL_UNSIGNED_SHORT: size = sizeof(GLushort) * attr.elements; break;
+  case GL_HALF_FLOAT:     size = sizeof(GLhalf) * attr.elements; break;
+  case GL_INT:            size = sizeof(int) * attr.elements; break;
+  case GL_FLOAT:          size = sizeof(float) * attr.elements; break;
+  case GL_UNSIGNED_INT:   size = sizeof(unsigned int) * attr.elements; break;
+  case GL_INT_2_10_10_10_REV:
+  case GL_UNSIGNED_INT_2_10_10_10_REV: size = sizeof(GLuint); break;
   default: break;
   }
+
+  // Vertices are kept 4-byte aligned, so e.g. a snorm16 xyz position occupies 8 bytes...
+  const size_t end = (attr.offset + size + 3) & ~size_t(3);
+  if (end > stride)
+  {
+    stride = end;
+  }
 }
@@ -1,5 +1,6 @@
 #include <boost/make_shared.hpp>
 
+#include <gl_loader/gl_loader.h>
 #include <core/logging.h>
 #include <core/window.h>
 
@@ -125,7 +126,9 @@ void Window::MakeWindow(const char* const title)
 
 void Window::EndFrame()
 {
+  context->EndFrame();
   SDL_GL_SwapWindow(window);
+  glTraceEndFrame();
 }
 
 //------------------------------------------------------------------------
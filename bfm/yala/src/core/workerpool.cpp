@@ -0,0 +1,185 @@
+#include <SDL.h>
+#include <deque>
+#include <vector>
+#include <boost/bind.hpp>
+#include <core/cpuprofiler.h>
+#include <core/workerpool.h>
+
+//------------------------------------------------------------------------
+
+struct WorkerPool::Impl
+{
+  Impl() : mutex(SDL_CreateMutex()), jobReady(SDL_CreateCond()), jobsDone(SDL_CreateCond()), pending(0), quit(false) { }
+
+  ~Impl()
+  {
+    SDL_DestroyCond(jobsDone);
+    SDL_DestroyCond(jobReady);
+    SDL_DestroyMutex(mutex);
+  }
+
+  SDL_mutex* mutex;
+  SDL_cond* jobReady;
+  SDL_cond* jobsDone;
+
+  std::deque<Job> jobs;
+  size_t pending;       // jobs queued or currently executing
+  bool quit;
+
+  std::vector<SDL_Thread*> threads;
+
+  static int WorkerMain(void* data);
+
+  // Run one batch of a ParallelFor and count it off.
+  static void RunRange(const RangeJob& job, size_t begin, size_t end, size_t* const remaining, Impl* const impl);
+};
+
+//------------------------------------------------------------------------
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+  : impl(new Impl())
+{
+  if (0 == threadCount)
+  {
+    threadCount = (unsigned int)SDL_GetCPUCount();
+  }
+  if (0 == threadCount)
+  {
+    threadCount = 1;
+  }
+
+  for (unsigned int i = 0; i < threadCount; ++i)
+  {
+    impl->threads.push_back(SDL_CreateThread(Impl::WorkerMain, "worker", impl.get()));
+  }
+}
+
+//------------------------------------------------------------------------
+
+WorkerPool::~WorkerPool()
+{
+  SDL_LockMutex(impl->mutex);
+  impl->quit = true;
+  SDL_CondBroadcast(impl->jobReady);
+  SDL_UnlockMutex(impl->mutex);
+
+  for (size_t i = 0; i < impl->threads.size(); ++i)
+  {
+    SDL_WaitThread(impl->threads[i], NULL);
+  }
+}
+
+//------------------------------------------------------------------------
+
+unsigned int WorkerPool::ThreadCount() const
+{
+  return (unsigned int)impl->threads.size();
+}
+
+//------------------------------------------------------------------------
+
+void WorkerPool::Submit(const Job& job)
+{
+  SDL_LockMutex(impl->mutex);
+  impl->jobs.push_back(job);
+  ++impl->pending;
+  SDL_CondSignal(impl->jobReady);
+  SDL_UnlockMutex(impl->mutex);
+}
+
+//------------------------------------------------------------------------
+
+void WorkerPool::Wait()
+{
+  SDL_LockMutex(impl->mutex);
+  while (impl->pending > 0)
+  {
+    SDL_CondWait(impl->jobsDone, impl->mutex);
+  }
+  SDL_UnlockMutex(impl->mutex);
+}
+
+//------------------------------------------------------------------------
+
+void WorkerPool::ParallelFor(size_t count, const RangeJob& job)
+{
+  if (0 == count) { return; }
+
+  // A few batches per thread keeps the workers busy when batches take uneven time...
+  const size_t batchCount = impl->threads.size() * 4;
+  const size_t batchSize = (count + batchCount - 1) / batchCount;
+
+  // Batches are queued in order at the front of the queue and counted down as they
+  // complete; jobs submitted earlier carry on once they're done...
+  size_t remaining = 0;
+
+  SDL_LockMutex(impl->mutex);
+  for (size_t begin = 0; begin < count; begin += batchSize)
+  {
+    const size_t end = (begin + batchSize < count) ? (begin + batchSize) : count;
+    impl->jobs.insert(impl->jobs.begin() + remaining, boost::bind(Impl::RunRange, job, begin, end, &remaining, impl.get()));
+    ++remaining;
+    ++impl->pending;
+  }
+  SDL_CondBroadcast(impl->jobReady);
+
+  while (remaining > 0)
+  {
+    SDL_CondWait(impl->jobsDone, impl->mutex);
+  }
+  SDL_UnlockMutex(impl->mutex);
+}
+
+//------------------------------------------------------------------------
+
+void WorkerPool::Impl::RunRange(const RangeJob& job, size_t begin, size_t end, size_t* const remaining, Impl* const impl)
+{
+  job(begin, end);
+
+  SDL_LockMutex(impl->mutex);
+  if (0 == --(*remaining))
+  {
+    SDL_CondBroadcast(impl->jobsDone);
+  }
+  SDL_UnlockMutex(impl->mutex);
+}
+
+//------------------------------------------------------------------------
+
+int WorkerPool::Impl::WorkerMain(void* data)
+{
+  Impl* const impl = (Impl*)data;
+  CpuProfiler::NameThread("worker");
+
+  SDL_LockMutex(impl->mutex);
+  for (;;)
+  {
+    while (impl->jobs.empty() && !impl->quit)
+    {
+      SDL_CondWait(impl->jobReady, impl->mutex);
+    }
+
+    if (impl->jobs.empty())
+    {
+      break;  // quitting and nothing left to do
+    }
+
+    Job job = impl->jobs.front();
+    impl->jobs.pop_front();
+
+    SDL_UnlockMutex(impl->mutex);
+    {
+      PROFILE_ZONE("job");
+      job();
+    }
+    SDL_LockMutex(impl->mutex);
+
+    if (0 == --impl->pending)
+    {
+      SDL_CondBroadcast(impl->jobsDone);
+    }
+  }
+  SDL_UnlockMutex(impl->mutex);
+
+  return 0;
+}
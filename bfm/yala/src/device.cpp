@@ -341,6 +341,10 @@ static void ConfigureOpenGL(const ClearState& clearState, const DrawState& drawS
 
   glPolygonMode(GL_FRONT_AND_BACK, drawState.polygonMode);
 
+  // Index buffers are 16-bit, so strips are split with 0xFFFF...
+  glEnable(GL_PRIMITIVE_RESTART);
+  glPrimitiveRestartIndex(0xFFFF);
+
   drawState.blending.enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
   glBlendFuncSeparate(
     drawState.blending.rgb.source, drawState.blending.rgb.destination,
@@ -1,6 +1,7 @@
 #include <SDL.h>
 #include <game/game.h>
 #include <core/device.h>
+#include <core/cpuprofiler.h>
 
 //------------------------------------------------------------------------
 
@@ -21,28 +22,46 @@ Game::~Game()
 
 void Game::Run()
 {
+  CpuProfiler::NameThread("main");
   Initialise();
 
   unsigned int lastTime = 0;
   while (running)
   {
-    const unsigned int now = SDL_GetTicks();
-    if (0 == lastTime) { lastTime  = now; }
-    const float elapsedMS = float(now - lastTime);
+    {
+      PROFILE_ZONE("frame");
 
-    Update(elapsedMS);
-    Render(elapsedMS);
+      const unsigned int now = SDL_GetTicks();
+      if (0 == lastTime) { lastTime  = now; }
+      const float elapsedMS = float(now - lastTime);
 
-    window->EndFrame();
+      {
+        PROFILE_ZONE("update");
+        Update(elapsedMS);
+      }
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
-    {
-      if (SDL_QUIT == event.type)
       {
-        Stop();
+        PROFILE_ZONE("render");
+        Render(elapsedMS);
+      }
+
+      {
+        PROFILE_ZONE("end frame");
+        window->EndFrame();
+      }
+
+      PROFILE_ZONE("events");
+      SDL_Event event;
+      while (SDL_PollEvent(&event))
+      {
+        if (SDL_QUIT == event.type)
+        {
+          Stop();
+        }
       }
     }
+
+    CpuProfiler::EndFrame();
   }
 
   Shutdown();
@@ -1,7 +1,11 @@
 #include <SDL.h>
 #include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+#include <gl_loader/gl_loader.h>
 #include <core/logging.h>
+#include <core/cpuprofiler.h>
 #include <core/device.h>
+#include <core/gpuprofiler.h>
 #include <core/keyboard.h>
 #include <game/game.h>
 #include <game/cameras/freecamera.h>
@@ -24,6 +28,7 @@ private:
   virtual void Shutdown();
 
   void HandleInput();
+  void LogGpuStats();
 
   ClearState clearState;
   Keyboard::KeyState oldKeyState;
@@ -72,7 +77,9 @@ void MyGame::Initialise()
   camera.aspectRatio = double(window->Size().x) / double(window->Size().y);
 
   planet = boost::make_shared<Planet>(6000);
-  planet->Initialise();
+  planet->UseTileCache("assets/planet.tiles");
+  planet->UsePageFile("assets/planet.pages");
+  planet->Initialise(window->Size());
 
   sunPosition = glm::dvec3(100000000, 0, 0);
 }
@@ -84,6 +91,7 @@ void MyGame::Update(float elapsedMS)
   HandleInput();
 
   camera.Update(elapsedMS);
+  planet->Update(elapsedMS, camera);
 }
 
 //------------------------------------------------------------------------
@@ -98,11 +106,75 @@ void MyGame::HandleInput()
     Stop();
   }
 
+  // GL call statistics, when the loader is instrumented: F9 logs the last frame's, F10 the
+  // averages since the last F10...
+  if (keyState.KeyIsDown(SDL_SCANCODE_F9) && oldKeyState.KeyIsUp(SDL_SCANCODE_F9))
+  {
+    LOG("%s", glTraceFrameReport().c_str());
+  }
+
+  if (keyState.KeyIsDown(SDL_SCANCODE_F10) && oldKeyState.KeyIsUp(SDL_SCANCODE_F10))
+  {
+    LOG("%s", glTraceRunningReport().c_str());
+    glTraceReset();
+  }
+
+  // F7 starts a CPU trace, and pressed again saves it for chrome://tracing...
+  if (keyState.KeyIsDown(SDL_SCANCODE_F7) && oldKeyState.KeyIsUp(SDL_SCANCODE_F7))
+  {
+    if (CpuProfiler::Recording())
+    {
+      CpuProfiler::StopRecording();
+      CpuProfiler::WriteTrace("cputrace.json");
+    }
+    else
+    {
+      CpuProfiler::StartRecording();
+    }
+  }
+
+  // GPU timings: F11 logs each scope's statistics, F8 starts or stops writing them to a CSV
+  // file every frame...
+  if (keyState.KeyIsDown(SDL_SCANCODE_F11) && oldKeyState.KeyIsUp(SDL_SCANCODE_F11))
+  {
+    LogGpuStats();
+  }
+
+  if (keyState.KeyIsDown(SDL_SCANCODE_F8) && oldKeyState.KeyIsUp(SDL_SCANCODE_F8))
+  {
+    GpuProfiler& profiler = window->context->Profiler();
+    if (profiler.Logging())
+    {
+      profiler.StopLog();
+    }
+    else
+    {
+      profiler.StartLog("gputimings.csv");
+    }
+  }
+
   oldKeyState = keyState;
 }
 
 //------------------------------------------------------------------------
 
+void MyGame::LogGpuStats()
+{
+  const GpuProfiler& profiler = window->context->Profiler();
+  const std::vector<GpuProfiler::Stats> stats = profiler.GetStats();
+
+  LOG("GPU timings (ms), %u frames dropped\n", profiler.FramesDropped());
+  LOG("  %-24s %8s %8s %8s %8s %8s %8s\n", "scope", "average", "min", "median", "95%", "99%", "max");
+  BOOST_FOREACH(const GpuProfiler::Stats& scope, stats)
+  {
+    const std::string name = std::string(2 * scope.depth, ' ') + scope.name;
+    LOG("  %-24s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", name.c_str(), scope.averageMS, scope.minimumMS,
+      scope.medianMS, scope.percentile95MS, scope.percentile99MS, scope.maximumMS);
+  }
+}
+
+//------------------------------------------------------------------------
+
 void MyGame::PreRender(float elapsedMS)
 {
   window->context->Clear(clearState);
@@ -112,6 +184,21 @@ void MyGame::PreRender(float elapsedMS)
 
 void MyGame::Render(float elapsedMS)
 {
+  // Constants controlling depth precision (smaller increases precision at distance at the
+  // expense of loosing precision close-in); see ComputeDepth in common.glsl...
+  static const float LogDepthConstant = 1.0f;
+  static const float LogDepthOffset = 2.0f;
+
+  FrameConstants frameConstants;
+  frameConstants.viewMatrix = glm::mat4(camera.viewMatrix);
+  frameConstants.projectionMatrix = glm::mat4(camera.projectionMatrix);
+  frameConstants.viewProjectionMatrix = glm::mat4(camera.projectionMatrix * camera.viewMatrix);
+  frameConstants.cameraPosition = glm::vec3(camera.position);
+  frameConstants.logDepthConstant = LogDepthConstant;
+  frameConstants.logDepthOffset = LogDepthOffset;
+  frameConstants.logDepthDivisor = float(1.0 / glm::log((LogDepthConstant * camera.farClip) + LogDepthOffset));
+  window->context->SetFrameConstants(frameConstants);
+
   const glm::vec3 sunDir = -glm::vec3(glm::normalize(sunPosition));
   planet->Draw(window->context, camera, sunDir);
 }
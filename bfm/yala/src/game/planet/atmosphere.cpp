@@ -0,0 +1,572 @@
+#include <SDL.h>
+#include <vector>
+#include <glm/ext.hpp>
+#include <boost/bind.hpp>
+#include <core/cpuprofiler.h>
+#include <core/device.h>
+#include <core/logging.h>
+#include <game/planet/atmosphere.h>
+
+//---------------------------------------------------------------------------
+
+// Which tables a parameter change invalidates. Each table depends on the ones before it.
+namespace Table
+{
+  enum Enum
+  {
+    Transmittance = 1 << 0,
+    Scattering    = 1 << 1,
+    Irradiance    = 1 << 2,
+    All           = Transmittance | Scattering | Irradiance
+  };
+}
+
+static const unsigned int TransmittanceSteps = 256;
+static const unsigned int ScatteringSteps = 64;
+static const unsigned int IrradianceThetaSteps = 16;
+static const unsigned int IrradiancePhiSteps = 32;
+
+//---------------------------------------------------------------------------
+
+// CPU copies of the tables, kept so that a partial rebuild can use the tables it depends on.
+struct Tables
+{
+  Tables()
+    : transmittance(Atmosphere::TransmittanceMuSize * Atmosphere::TransmittanceRSize),
+      scattering(Atmosphere::ScatteringMuSize * Atmosphere::ScatteringMuSSize * Atmosphere::ScatteringRSize),
+      irradiance(Atmosphere::IrradianceMuSSize * Atmosphere::IrradianceRSize)
+  {
+  }
+
+  std::vector<glm::vec3> transmittance;
+  std::vector<glm::vec4> scattering;
+  std::vector<glm::vec3> irradiance;
+};
+
+//---------------------------------------------------------------------------
+
+struct Atmosphere::Impl
+{
+  Impl(WorkerPool& workers)
+    : workers(workers),
+      parameters(6360.0),
+      buildParameters(6360.0),
+      tableParameters(6360.0),
+      pendingTables(0),
+      buildTables(0),
+      builder(NULL)
+  {
+    SDL_AtomicSet(&buildFinished, 0);
+  }
+
+  WorkerPool& workers;
+
+  AtmosphereParameters parameters;        // most recently requested
+  AtmosphereParameters buildParameters;   // in use by the builder thread
+  AtmosphereParameters tableParameters;   // those the uploaded tables were built with
+  unsigned int pendingTables;             // tables invalidated since the last build started
+  unsigned int buildTables;               // tables the builder thread is working on
+  SDL_Thread* builder;
+  SDL_atomic_t buildFinished;
+
+  Tables tables;
+
+  Texture2DPtr transmittanceTexture;
+  Texture3DPtr scatteringTexture;
+  Texture2DPtr irradianceTexture;
+  SamplerPtr sampler;
+
+  AtmosphereEffect skyEffect;
+  DrawState skyDrawState;
+
+  void Build();
+  void Upload(unsigned int tables);
+  void StartBuild();
+
+  static int BuilderMain(void* data);
+};
+
+//---------------------------------------------------------------------------
+
+static unsigned int ChangedTables(const AtmosphereParameters& oldParams, const AtmosphereParameters& newParams);
+
+static void BuildTransmittance(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end);
+static void BuildScattering(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end);
+static void BuildIrradiance(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end);
+
+static glm::dvec3 LookupTransmittance(const AtmosphereParameters& params, const Tables& tables, double r, double mu);
+static glm::dvec4 LookupScattering(const AtmosphereParameters& params, const Tables& tables, double r, double mu, double muS);
+
+//---------------------------------------------------------------------------
+
+AtmosphereParameters::AtmosphereParameters(double groundRadius)
+  : groundRadius(groundRadius),
+    topRadius(groundRadius + 60.0),
+    rayleighScattering(5.8e-3, 13.5e-3, 33.1e-3),
+    rayleighScaleHeight(8.0),
+    mieScattering(4.0e-3),
+    mieExtinction(4.0e-3 / 0.9),
+    mieScaleHeight(1.2),
+    mieG(0.8),
+    sunIntensity(20.0)
+{
+}
+
+//---------------------------------------------------------------------------
+
+Atmosphere::Atmosphere(WorkerPool& workers)
+  : impl(new Impl(workers))
+{
+}
+
+//---------------------------------------------------------------------------
+
+Atmosphere::~Atmosphere()
+{
+  if (impl->builder)
+  {
+    SDL_WaitThread(impl->builder, NULL);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Initialise(const AtmosphereParameters& parameters)
+{
+  impl->transmittanceTexture = Device::NewTexture2D(Texture2DDescription(GL_RGB16F, glm::uvec2(TransmittanceMuSize, TransmittanceRSize)));
+  impl->scatteringTexture = Device::NewTexture3D(Texture3DDescription(GL_RGBA16F, glm::uvec3(ScatteringMuSize, ScatteringMuSSize, ScatteringRSize)));
+  impl->irradianceTexture = Device::NewTexture2D(Texture2DDescription(GL_RGB16F, glm::uvec2(IrradianceMuSSize, IrradianceRSize)));
+
+  impl->sampler = Device::NewSampler();
+  impl->sampler->SetMinFilter(GL_LINEAR);
+  impl->sampler->SetMagFilter(GL_LINEAR);
+  impl->sampler->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+  const Uint32 startTime = SDL_GetTicks();
+  impl->parameters = parameters;
+  impl->buildParameters = parameters;
+  impl->buildTables = Table::All;
+  impl->Build();
+  impl->Upload(Table::All);
+  impl->tableParameters = parameters;
+  LOG("atmosphere tables built in %ums\n", SDL_GetTicks() - startTime);
+
+  // The sky is a single triangle covering the screen, generated from gl_VertexID...
+  impl->skyEffect.Load("assets/effects/atmosphere.glsl");
+  impl->skyDrawState.effect = &impl->skyEffect;
+  impl->skyDrawState.vertexArray = Device::NewVertexArray(VertexBufferPtr());
+
+  RenderState skyState;
+  skyState.depthMask = false;
+  impl->skyDrawState.renderState = Device::NewRenderState(skyState);
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::SetParameters(const AtmosphereParameters& parameters)
+{
+  impl->pendingTables |= ChangedTables(impl->parameters, parameters);
+  impl->parameters = parameters;
+}
+
+//---------------------------------------------------------------------------
+
+const AtmosphereParameters& Atmosphere::GetParameters() const
+{
+  return impl->parameters;
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Update()
+{
+  if (impl->builder && SDL_AtomicGet(&impl->buildFinished))
+  {
+    SDL_WaitThread(impl->builder, NULL);
+    impl->builder = NULL;
+    impl->Upload(impl->buildTables);
+    impl->tableParameters = impl->buildParameters;
+  }
+
+  // Changes made while a build is in progress wait for it to finish...
+  if (!impl->builder && impl->pendingTables)
+  {
+    impl->StartBuild();
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Apply(AtmosphereEffect& effect, DrawState& drawState) const
+{
+  // Uniforms follow the tables rather than the latest parameters so the two always match...
+  const AtmosphereParameters& params = impl->tableParameters;
+  effect.GroundRadius->Set(float(params.groundRadius));
+  effect.TopRadius->Set(float(params.topRadius));
+  effect.RayleighScattering->Set(glm::vec3(params.rayleighScattering));
+  effect.MieG->Set(float(params.mieG));
+  effect.SunIntensity->Set(glm::vec3(impl->parameters.sunIntensity));
+
+  effect.TransmittanceTable->Set(int(TransmittanceUnit));
+  effect.ScatteringTable->Set(int(ScatteringUnit));
+  effect.IrradianceTable->Set(int(IrradianceUnit));
+
+  drawState.textureUnits[TransmittanceUnit].texture = impl->transmittanceTexture;
+  drawState.textureUnits[TransmittanceUnit].sampler = impl->sampler;
+  drawState.textureUnits[ScatteringUnit].texture = impl->scatteringTexture;
+  drawState.textureUnits[ScatteringUnit].sampler = impl->sampler;
+  drawState.textureUnits[IrradianceUnit].texture = impl->irradianceTexture;
+  drawState.textureUnits[IrradianceUnit].sampler = impl->sampler;
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection)
+{
+  // The view matrix's translation is dropped so that the inverse maps clip space straight
+  // to a view direction without losing precision to the camera's distance from the planet...
+  const glm::dmat4 rotation = glm::dmat4(glm::dmat3(camera.viewMatrix));
+  const glm::dmat4 inverseViewProjection = glm::inverse(camera.projectionMatrix * rotation);
+
+  Apply(impl->skyEffect, impl->skyDrawState);
+  impl->skyEffect.SunDirection->Set(sunDirection);
+  impl->skyEffect.InverseViewProjection->Set(glm::mat4(inverseViewProjection));
+  impl->skyEffect.Apply();
+
+  context->Draw(GL_TRIANGLES, 3, impl->skyDrawState);
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Impl::StartBuild()
+{
+  // A change to one table invalidates every table built from it...
+  buildTables = pendingTables;
+  if (buildTables & Table::Transmittance) { buildTables |= Table::Scattering; }
+  if (buildTables & Table::Scattering) { buildTables |= Table::Irradiance; }
+  pendingTables = 0;
+
+  buildParameters = parameters;
+  SDL_AtomicSet(&buildFinished, 0);
+  builder = SDL_CreateThread(BuilderMain, "atmosphere", this);
+}
+
+//---------------------------------------------------------------------------
+
+int Atmosphere::Impl::BuilderMain(void* data)
+{
+  Impl* const impl = (Impl*)data;
+  CpuProfiler::NameThread("atmosphere");
+  impl->Build();
+  SDL_AtomicSet(&impl->buildFinished, 1);
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Impl::Build()
+{
+  if (buildTables & Table::Transmittance)
+  {
+    workers.ParallelFor(TransmittanceRSize, boost::bind(BuildTransmittance, boost::cref(buildParameters), boost::ref(tables), _1, _2));
+  }
+  if (buildTables & Table::Scattering)
+  {
+    workers.ParallelFor(ScatteringRSize * ScatteringMuSSize, boost::bind(BuildScattering, boost::cref(buildParameters), boost::ref(tables), _1, _2));
+  }
+  if (buildTables & Table::Irradiance)
+  {
+    workers.ParallelFor(IrradianceRSize, boost::bind(BuildIrradiance, boost::cref(buildParameters), boost::ref(tables), _1, _2));
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Atmosphere::Impl::Upload(unsigned int tablesToUpload)
+{
+  if (tablesToUpload & Table::Transmittance)
+  {
+    transmittanceTexture->SetData(&tables.transmittance[0], GL_RGB, GL_FLOAT);
+  }
+  if (tablesToUpload & Table::Scattering)
+  {
+    scatteringTexture->SetData(&tables.scattering[0], GL_RGBA, GL_FLOAT);
+  }
+  if (tablesToUpload & Table::Irradiance)
+  {
+    irradianceTexture->SetData(&tables.irradiance[0], GL_RGB, GL_FLOAT);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static unsigned int ChangedTables(const AtmosphereParameters& oldParams, const AtmosphereParameters& newParams)
+{
+  unsigned int changed = 0;
+
+  if ((oldParams.groundRadius != newParams.groundRadius) ||
+      (oldParams.topRadius != newParams.topRadius) ||
+      (oldParams.rayleighScattering != newParams.rayleighScattering) ||
+      (oldParams.rayleighScaleHeight != newParams.rayleighScaleHeight) ||
+      (oldParams.mieExtinction != newParams.mieExtinction) ||
+      (oldParams.mieScaleHeight != newParams.mieScaleHeight))
+  {
+    changed |= Table::Transmittance;
+  }
+
+  if (oldParams.mieScattering != newParams.mieScattering)
+  {
+    changed |= Table::Scattering;
+  }
+
+  if (oldParams.mieG != newParams.mieG)
+  {
+    changed |= Table::Irradiance;
+  }
+
+  return changed;
+}
+
+//---------------------------------------------------------------------------
+// Table parameterisation, shared with scattering.glsl. Each coordinate is in [0,1] with
+// 0 and 1 falling on the centres of the first and last texels.
+
+static double RFromCoord(const AtmosphereParameters& params, double u)
+{
+  return params.groundRadius + (u * u * (params.topRadius - params.groundRadius));
+}
+
+static double CoordFromR(const AtmosphereParameters& params, double r)
+{
+  return glm::sqrt(glm::clamp((r - params.groundRadius) / (params.topRadius - params.groundRadius), 0.0, 1.0));
+}
+
+static double MuFromCoord(double u)   { return (u * 2.0) - 1.0; }
+static double CoordFromMu(double mu)  { return glm::clamp((mu + 1.0) * 0.5, 0.0, 1.0); }
+static double MuSFromCoord(double u)  { return (u * 1.2) - 0.2; }
+static double CoordFromMuS(double mu) { return glm::clamp((mu + 0.2) / 1.2, 0.0, 1.0); }
+
+static double TexelCoord(unsigned int i, unsigned int size) { return double(i) / double(size - 1); }
+
+//---------------------------------------------------------------------------
+
+// Distance from a point at radius r along a ray with zenith cosine mu to the top of the
+// atmosphere or, if the ray hits it, the ground.
+static double RayLength(const AtmosphereParameters& params, double r, double mu, bool& hitsGround)
+{
+  const double groundDiscriminant = (r * r * ((mu * mu) - 1.0)) + (params.groundRadius * params.groundRadius);
+  hitsGround = (mu < 0.0) && (groundDiscriminant >= 0.0);
+  if (hitsGround)
+  {
+    return glm::max(0.0, (-r * mu) - glm::sqrt(groundDiscriminant));
+  }
+
+  const double topDiscriminant = (r * r * ((mu * mu) - 1.0)) + (params.topRadius * params.topRadius);
+  return glm::max(0.0, (-r * mu) + glm::sqrt(glm::max(topDiscriminant, 0.0)));
+}
+
+//---------------------------------------------------------------------------
+
+// Extinction at radius r.
+static glm::dvec3 Extinction(const AtmosphereParameters& params, double r)
+{
+  const double height = glm::max(0.0, r - params.groundRadius);
+  return
+    (params.rayleighScattering * glm::exp(-height / params.rayleighScaleHeight)) +
+    glm::dvec3(params.mieExtinction * glm::exp(-height / params.mieScaleHeight));
+}
+
+//---------------------------------------------------------------------------
+
+static void BuildTransmittance(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end)
+{
+  for (size_t y = begin; y < end; ++y)
+  {
+    const double r = RFromCoord(params, TexelCoord(y, Atmosphere::TransmittanceRSize));
+    for (unsigned int x = 0; x < Atmosphere::TransmittanceMuSize; ++x)
+    {
+      const double mu = MuFromCoord(TexelCoord(x, Atmosphere::TransmittanceMuSize));
+
+      bool hitsGround;
+      const double length = RayLength(params, r, mu, hitsGround);
+      const double dt = length / TransmittanceSteps;
+
+      glm::dvec3 opticalDepth(0);
+      for (unsigned int i = 0; i < TransmittanceSteps; ++i)
+      {
+        const double t = (i + 0.5) * dt;
+        const double ry = glm::sqrt((r * r) + (t * t) + (2.0 * r * mu * t));
+        opticalDepth += Extinction(params, ry) * dt;
+      }
+
+      tables.transmittance[x + (y * Atmosphere::TransmittanceMuSize)] = glm::vec3(glm::exp(-opticalDepth));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// Each item is one (altitude, sun angle) row of view angles.
+static void BuildScattering(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end)
+{
+  for (size_t row = begin; row < end; ++row)
+  {
+    const unsigned int z = row / Atmosphere::ScatteringMuSSize;
+    const unsigned int y = row % Atmosphere::ScatteringMuSSize;
+    const double r = RFromCoord(params, TexelCoord(z, Atmosphere::ScatteringRSize));
+    const double muS = MuSFromCoord(TexelCoord(y, Atmosphere::ScatteringMuSSize));
+
+    for (unsigned int x = 0; x < Atmosphere::ScatteringMuSize; ++x)
+    {
+      const double mu = MuFromCoord(TexelCoord(x, Atmosphere::ScatteringMuSize));
+
+      // The sun is assumed to be in the same vertical plane as the view direction...
+      const double nu = (mu * muS) + glm::sqrt(glm::max(0.0, (1.0 - (mu * mu)) * (1.0 - (muS * muS))));
+
+      bool hitsGround;
+      const double length = RayLength(params, r, mu, hitsGround);
+      const double dt = length / ScatteringSteps;
+
+      glm::dvec3 rayleigh(0);
+      glm::dvec3 mie(0);
+      glm::dvec3 opticalDepth(0);
+      for (unsigned int i = 0; i < ScatteringSteps; ++i)
+      {
+        const double t = (i + 0.5) * dt;
+        const double ry = glm::sqrt((r * r) + (t * t) + (2.0 * r * mu * t));
+        const double muSy = glm::clamp(((r * muS) + (t * nu)) / ry, -1.0, 1.0);
+
+        opticalDepth += Extinction(params, ry) * (dt * 0.5);
+
+        // Light only arrives at y if the sun is above its horizon...
+        bool sunBlocked;
+        RayLength(params, ry, muSy, sunBlocked);
+        if (!sunBlocked)
+        {
+          const glm::dvec3 transmittance = glm::exp(-opticalDepth) * LookupTransmittance(params, tables, ry, muSy);
+          const double height = ry - params.groundRadius;
+          rayleigh += transmittance * glm::exp(-height / params.rayleighScaleHeight) * dt;
+          mie += transmittance * glm::exp(-height / params.mieScaleHeight) * dt;
+        }
+
+        opticalDepth += Extinction(params, ry) * (dt * 0.5);
+      }
+
+      rayleigh *= params.rayleighScattering;
+      mie *= params.mieScattering;
+
+      const size_t index = x + (Atmosphere::ScatteringMuSize * (y + (Atmosphere::ScatteringMuSSize * z)));
+      tables.scattering[index] = glm::vec4(glm::vec3(rayleigh), float(mie.r));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static double RayleighPhase(double nu)
+{
+  return (3.0 / (16.0 * glm::pi<double>())) * (1.0 + (nu * nu));
+}
+
+static double MiePhase(double nu, double g)
+{
+  const double g2 = g * g;
+  return
+    ((3.0 / (8.0 * glm::pi<double>())) * (1.0 - g2) * (1.0 + (nu * nu))) /
+    ((2.0 + g2) * glm::pow(1.0 + g2 - (2.0 * g * nu), 1.5));
+}
+
+//---------------------------------------------------------------------------
+
+// Sky irradiance on a horizontal surface: single scattered light integrated over the hemisphere.
+static void BuildIrradiance(const AtmosphereParameters& params, Tables& tables, size_t begin, size_t end)
+{
+  const double dTheta = (0.5 * glm::pi<double>()) / IrradianceThetaSteps;
+  const double dPhi = (2.0 * glm::pi<double>()) / IrradiancePhiSteps;
+
+  for (size_t y = begin; y < end; ++y)
+  {
+    const double r = RFromCoord(params, TexelCoord(y, Atmosphere::IrradianceRSize));
+    for (unsigned int x = 0; x < Atmosphere::IrradianceMuSSize; ++x)
+    {
+      const double muS = MuSFromCoord(TexelCoord(x, Atmosphere::IrradianceMuSSize));
+      const glm::dvec3 sun(glm::sqrt(glm::max(0.0, 1.0 - (muS * muS))), 0.0, muS);
+
+      glm::dvec3 irradiance(0);
+      for (unsigned int i = 0; i < IrradianceThetaSteps; ++i)
+      {
+        const double theta = (i + 0.5) * dTheta;
+        const double mu = glm::cos(theta);
+        const double sinTheta = glm::sin(theta);
+
+        const glm::dvec4 scattering = LookupScattering(params, tables, r, mu, muS);
+        const glm::dvec3 rayleigh(scattering);
+        const glm::dvec3 mie = rayleigh * (scattering.w / glm::max(scattering.x, 1e-9)) * (params.rayleighScattering.x / params.rayleighScattering);
+
+        for (unsigned int j = 0; j < IrradiancePhiSteps; ++j)
+        {
+          const double phi = (j + 0.5) * dPhi;
+          const glm::dvec3 w(glm::cos(phi) * sinTheta, glm::sin(phi) * sinTheta, mu);
+          const double nu = glm::dot(w, sun);
+
+          const glm::dvec3 radiance = (rayleigh * RayleighPhase(nu)) + (mie * MiePhase(nu, params.mieG));
+          irradiance += radiance * mu * sinTheta * dTheta * dPhi;
+        }
+      }
+
+      tables.irradiance[x + (y * Atmosphere::IrradianceMuSSize)] = glm::vec3(irradiance);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// Split a coordinate in [0,1] into the two texels either side of it and the weight of the second.
+static void TexelPair(double u, unsigned int size, unsigned int& i0, unsigned int& i1, double& weight)
+{
+  const double texel = u * (size - 1);
+  i0 = glm::min((unsigned int)texel, size - 1);
+  i1 = glm::min(i0 + 1, size - 1);
+  weight = texel - i0;
+}
+
+//---------------------------------------------------------------------------
+
+static glm::dvec3 LookupTransmittance(const AtmosphereParameters& params, const Tables& tables, double r, double mu)
+{
+  unsigned int x0, x1, y0, y1;
+  double wx, wy;
+  TexelPair(CoordFromMu(mu), Atmosphere::TransmittanceMuSize, x0, x1, wx);
+  TexelPair(CoordFromR(params, r), Atmosphere::TransmittanceRSize, y0, y1, wy);
+
+  const std::vector<glm::vec3>& t = tables.transmittance;
+  const unsigned int w = Atmosphere::TransmittanceMuSize;
+  return glm::mix(
+    glm::mix(glm::dvec3(t[x0 + (y0 * w)]), glm::dvec3(t[x1 + (y0 * w)]), wx),
+    glm::mix(glm::dvec3(t[x0 + (y1 * w)]), glm::dvec3(t[x1 + (y1 * w)]), wx),
+    wy);
+}
+
+//---------------------------------------------------------------------------
+
+static glm::dvec4 LookupScattering(const AtmosphereParameters& params, const Tables& tables, double r, double mu, double muS)
+{
+  unsigned int x0, x1, y0, y1, z0, z1;
+  double wx, wy, wz;
+  TexelPair(CoordFromMu(mu), Atmosphere::ScatteringMuSize, x0, x1, wx);
+  TexelPair(CoordFromMuS(muS), Atmosphere::ScatteringMuSSize, y0, y1, wy);
+  TexelPair(CoordFromR(params, r), Atmosphere::ScatteringRSize, z0, z1, wz);
+
+  const std::vector<glm::vec4>& s = tables.scattering;
+  const unsigned int w = Atmosphere::ScatteringMuSize;
+  const unsigned int wh = Atmosphere::ScatteringMuSize * Atmosphere::ScatteringMuSSize;
+  const glm::dvec4 lower = glm::mix(
+    glm::mix(glm::dvec4(s[x0 + (y0 * w) + (z0 * wh)]), glm::dvec4(s[x1 + (y0 * w) + (z0 * wh)]), wx),
+    glm::mix(glm::dvec4(s[x0 + (y1 * w) + (z0 * wh)]), glm::dvec4(s[x1 + (y1 * w) + (z0 * wh)]), wx),
+    wy);
+  const glm::dvec4 upper = glm::mix(
+    glm::mix(glm::dvec4(s[x0 + (y0 * w) + (z1 * wh)]), glm::dvec4(s[x1 + (y0 * w) + (z1 * wh)]), wx),
+    glm::mix(glm::dvec4(s[x0 + (y1 * w) + (z1 * wh)]), glm::dvec4(s[x1 + (y1 * w) + (z1 * wh)]), wx),
+    wy);
+  return glm::mix(lower, upper, wz);
+}
@@ -0,0 +1,31 @@
+#include <game/planet/atmosphereeffect.h>
+
+//-------------------------------------------------------------------------------------------
+
+AtmosphereEffect::AtmosphereEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+AtmosphereEffect::~AtmosphereEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+void AtmosphereEffect::Initialise()
+{
+  SunDirection = &parameters["SunDirection"];
+  GroundRadius = &parameters["GroundRadius"];
+  TopRadius = &parameters["TopRadius"];
+  RayleighScattering = &parameters["RayleighScattering"];
+  MieG = &parameters["MieG"];
+  SunIntensity = &parameters["SunIntensity"];
+  TransmittanceTable = &parameters["TransmittanceTable"];
+  ScatteringTable = &parameters["ScatteringTable"];
+  IrradianceTable = &parameters["IrradianceTable"];
+  InverseViewProjection = &parameters["InverseViewProjection"];
+
+  Effect::Initialise();
+}
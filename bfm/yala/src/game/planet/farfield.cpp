@@ -0,0 +1,275 @@
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <core/device.h>
+#include <core/logging.h>
+#include <core/model3ds.h>
+#include <game/planet/farfield.h>
+#include <game/planet/impostoreffect.h>
+#include <game/planet/planeteffect.h>
+#include <game/planet/planettile.h>
+
+//---------------------------------------------------------------------------
+
+static const char* const MeshFilename = "models/icosphere.3ds";
+
+// A representation is only given up for a more detailed one once the planet is this much
+// bigger than the threshold between them.
+static const double Hysteresis = 1.1;
+
+// Changes which make the impostor be rendered again: the angle (in radians) through which
+// the view or the sun has turned, and the fraction by which the distance has changed.
+static const double ImpostorViewAngle = 0.02;
+static const double ImpostorSunAngle = 0.02;
+static const double ImpostorDistanceChange = 0.1;
+
+//---------------------------------------------------------------------------
+
+struct FarField::Impl
+{
+  Impl(double radius)
+    : radius(radius),
+      boundingRadius(radius * (1.0 + PlanetTile::MaxRelativeHeight)),
+      indexCount(0),
+      representation(PlanetRepresentation::Quadtree),
+      impostorValid(false)
+  {
+  }
+
+  const double radius;
+  const double boundingRadius;
+
+  PlanetEffect meshEffect;
+  DrawState meshDrawState;
+  size_t indexCount;
+
+  ImpostorEffect impostorEffect;
+  DrawState impostorDrawState;
+  FramebufferPtr impostor;
+  ClearState impostorClearState;
+
+  PlanetRepresentation::Enum representation;
+
+  // The view the impostor was last rendered for, and the billboard's half-extents...
+  bool impostorValid;
+  glm::dvec3 impostorDirection;
+  double impostorDistance;
+  glm::vec3 impostorSun;
+  glm::vec3 impostorRight;
+  glm::vec3 impostorUp;
+
+  void DrawMesh(
+    ContextPtr context,
+    const glm::dmat4& viewProjection,
+    const glm::vec3& sunDirection,
+    const Atmosphere& atmosphere,
+    const VirtualTexture& virtualTexture);
+
+  void UpdateImpostor(
+    ContextPtr context,
+    const Camera& camera,
+    const glm::vec3& sunDirection,
+    const Atmosphere& atmosphere,
+    const VirtualTexture& virtualTexture);
+};
+
+//---------------------------------------------------------------------------
+
+FarField::FarField(double radius)
+  : impl(new Impl(radius))
+{
+}
+
+//---------------------------------------------------------------------------
+
+FarField::~FarField()
+{
+}
+
+//---------------------------------------------------------------------------
+
+void FarField::Initialise()
+{
+  // The sphere mesh. Its vertices are unit directions, pushed out to the planet's radius
+  // by the vertex shader...
+  {
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned short> indices;
+    if (!Model3ds::Load(MeshFilename, positions, indices))
+    {
+      LOG("far field: no sphere mesh in %s, the quadtree will be used at all distances\n", MeshFilename);
+      return;
+    }
+
+    VertexLayout layout;
+    const VertexAttribute position = { VertexSemantic::Position, GL_FLOAT, 3, 0 };
+    layout.AddAttribute(position);
+
+    VertexBufferPtr vertexBuffer = Device::NewVertexBuffer(layout, positions.size(), GL_STATIC_DRAW);
+    vertexBuffer->Enable();
+    vertexBuffer->SetData(&positions[0], positions.size());
+    VertexBuffer::Disable();
+
+    IndexBufferPtr indexBuffer = Device::NewIndexBuffer(indices.size(), GL_UNSIGNED_SHORT, GL_STATIC_DRAW);
+    indexBuffer->Enable();
+    indexBuffer->SetData(&indices[0], indices.size());
+    IndexBuffer::Disable();
+
+    impl->meshDrawState.vertexArray = Device::NewVertexArray(vertexBuffer, indexBuffer);
+    impl->indexCount = indices.size();
+  }
+
+  impl->meshEffect.Load("assets/effects/farfield.glsl");
+  impl->meshEffect.Radius->Set(impl->radius);
+  impl->meshDrawState.effect = &impl->meshEffect;
+
+  // The impostor: a billboard with no vertex data, showing an off-screen picture of the
+  // sphere on a transparent background...
+  impl->impostor = Device::NewFramebuffer(glm::uvec2(ImpostorSize), GL_RGBA8);
+  impl->impostorClearState.colourValue = glm::vec4(0);
+
+  SamplerPtr sampler = Device::NewSampler();
+  sampler->SetMinFilter(GL_LINEAR);
+  sampler->SetMagFilter(GL_LINEAR);
+  sampler->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+  impl->impostorEffect.Load("assets/effects/impostor.glsl");
+  impl->impostorEffect.ImpostorTexture->Set(0);
+  impl->impostorDrawState.effect = &impl->impostorEffect;
+  impl->impostorDrawState.vertexArray = Device::NewVertexArray(VertexBufferPtr());
+  impl->impostorDrawState.textureUnits[0].texture = impl->impostor->GetColourTexture();
+  impl->impostorDrawState.textureUnits[0].sampler = sampler;
+}
+
+//---------------------------------------------------------------------------
+
+PlanetRepresentation::Enum FarField::Select(const Camera& camera, unsigned int viewportHeight)
+{
+  const double distance = glm::length(camera.position);
+  if ((0 == impl->indexCount) || (distance <= impl->boundingRadius))
+  {
+    impl->representation = PlanetRepresentation::Quadtree;
+    return impl->representation;
+  }
+
+  // The planet's diameter on screen, from the angle it subtends...
+  const double halfAngle = glm::asin(impl->radius / distance);
+  const double diameter = (glm::tan(halfAngle) / glm::tan(glm::radians(camera.fieldOfViewAngle) * 0.5)) * viewportHeight;
+
+  PlanetRepresentation::Enum wanted = PlanetRepresentation::Quadtree;
+  if (diameter < ImpostorDiameter)  { wanted = PlanetRepresentation::Impostor; }
+  else if (diameter < MeshDiameter) { wanted = PlanetRepresentation::Mesh; }
+
+  if (wanted < impl->representation)
+  {
+    const double threshold = (PlanetRepresentation::Impostor == impl->representation) ? ImpostorDiameter : MeshDiameter;
+    if (diameter < (threshold * Hysteresis))
+    {
+      wanted = impl->representation;
+    }
+  }
+
+  if (wanted != impl->representation)
+  {
+    LOG("far field: planet is %.0f pixels across, switching from representation %d to %d\n", diameter, impl->representation, wanted);
+    impl->representation = wanted;
+  }
+
+  return impl->representation;
+}
+
+//---------------------------------------------------------------------------
+
+void FarField::Draw(
+  ContextPtr context,
+  const Camera& camera,
+  const glm::vec3& sunDirection,
+  const Atmosphere& atmosphere,
+  const VirtualTexture& virtualTexture,
+  PlanetRepresentation::Enum representation)
+{
+  const glm::dmat4 viewProjection(camera.projectionMatrix * camera.viewMatrix);
+
+  switch (representation)
+  {
+  case PlanetRepresentation::Mesh:
+    impl->DrawMesh(context, viewProjection, sunDirection, atmosphere, virtualTexture);
+    break;
+
+  case PlanetRepresentation::Impostor:
+    impl->UpdateImpostor(context, camera, sunDirection, atmosphere, virtualTexture);
+    impl->impostorEffect.ImpostorRight->Set(impl->impostorRight);
+    impl->impostorEffect.ImpostorUp->Set(impl->impostorUp);
+    impl->impostorEffect.Apply();
+    context->Draw(GL_TRIANGLE_STRIP, 4, impl->impostorDrawState);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void FarField::Impl::DrawMesh(
+  ContextPtr context,
+  const glm::dmat4& viewProjection,
+  const glm::vec3& sunDirection,
+  const Atmosphere& atmosphere,
+  const VirtualTexture& virtualTexture)
+{
+  atmosphere.Apply(meshEffect, meshDrawState);
+  virtualTexture.Apply(meshEffect, meshDrawState);
+  meshEffect.SunDirection->Set(sunDirection);
+  meshEffect.WorldViewProjectionMatrix->Set(glm::mat4(viewProjection));
+  meshEffect.Apply();
+
+  context->DrawIndexed(GL_TRIANGLES, indexCount, meshDrawState);
+}
+
+//---------------------------------------------------------------------------
+
+void FarField::Impl::UpdateImpostor(
+  ContextPtr context,
+  const Camera& camera,
+  const glm::vec3& sunDirection,
+  const Atmosphere& atmosphere,
+  const VirtualTexture& virtualTexture)
+{
+  const double distance = glm::length(camera.position);
+  const glm::dvec3 direction = camera.position / distance;
+
+  if (impostorValid &&
+      (glm::dot(direction, impostorDirection) >= glm::cos(ImpostorViewAngle)) &&
+      (glm::dot(sunDirection, impostorSun) >= glm::cos(float(ImpostorSunAngle))) &&
+      (glm::abs((distance / impostorDistance) - 1.0) < ImpostorDistanceChange))
+  {
+    return;
+  }
+
+  // Look at the planet from the camera's position through a frustum which just encloses
+  // it. The billboard is the frustum's cross-section through the planet's centre, so from
+  // this view it covers exactly the pixels the planet would...
+  const double halfAngle = glm::asin(glm::min(boundingRadius / distance, 1.0));
+  const glm::dvec3 forward = -direction;
+  const glm::dvec3 worldUp = (glm::abs(forward.y) < 0.99) ? glm::dvec3(0, 1, 0) : glm::dvec3(1, 0, 0);
+  const glm::dvec3 right = glm::normalize(glm::cross(forward, worldUp));
+  const glm::dvec3 up = glm::cross(right, forward);
+
+  const glm::dmat4 view = glm::lookAt(camera.position, glm::dvec3(0), worldUp);
+  const glm::dmat4 projection = glm::perspective(glm::degrees(halfAngle * 2.0), 1.0, distance - boundingRadius, distance + boundingRadius);
+
+  impostor->Bind();
+  context->Clear(impostorClearState);
+  DrawMesh(context, projection * view, sunDirection, atmosphere, virtualTexture);
+  impostor->Unbind();
+
+  const double halfSize = distance * glm::tan(halfAngle);
+  impostorRight = glm::vec3(right * halfSize);
+  impostorUp = glm::vec3(up * halfSize);
+
+  impostorValid = true;
+  impostorDirection = direction;
+  impostorDistance = distance;
+  impostorSun = sunDirection;
+}
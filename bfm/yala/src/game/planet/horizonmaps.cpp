@@ -0,0 +1,173 @@
+#include <SDL.h>
+#include <cstring>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <core/device.h>
+#include <game/planet/horizonmaps.h>
+
+//---------------------------------------------------------------------------
+
+// Samples taken along each azimuth. Spaced geometrically, from one map texel out to a
+// distance at which even the tallest mountain subtends only a few degrees.
+static const unsigned int MarchSteps = 16;
+static const double MaxDistanceHeights = 10.0;
+
+// Texels in a map: two RGBA texels (eight azimuths) per grid point.
+static const unsigned int TexelBytes = HorizonMaps::Size * 2 * HorizonMaps::Size * 4;
+
+//---------------------------------------------------------------------------
+
+// Filled in by a worker thread. Kept apart from PatchHorizon so that a job finishing after
+// its patch has been freed only ever releases CPU memory on the worker.
+struct GeneratedHorizon
+{
+  GeneratedHorizon() { SDL_AtomicSet(&ready, 0); }
+
+  SDL_atomic_t ready;
+  unsigned char texels[TexelBytes];
+};
+
+typedef boost::shared_ptr<GeneratedHorizon> GeneratedHorizonPtr;
+
+//---------------------------------------------------------------------------
+
+struct PatchHorizon
+{
+  GeneratedHorizonPtr generated;
+  Texture2DPtr texture;       // created on the GL thread once generation has finished
+};
+
+//---------------------------------------------------------------------------
+
+struct HorizonMaps::Impl
+{
+  Impl(WorkerPool& workers, double radius)
+    : workers(workers), radius(radius)
+  {
+  }
+
+  WorkerPool& workers;
+  const double radius;
+
+  Texture2DPtr unshadowed;
+  SamplerPtr sampler;
+};
+
+//---------------------------------------------------------------------------
+
+static void GenerateHorizon(const PatchInfo& patch, double radius, GeneratedHorizonPtr output);
+
+//---------------------------------------------------------------------------
+
+HorizonMaps::HorizonMaps(WorkerPool& workers, double radius)
+  : impl(new Impl(workers, radius))
+{
+}
+
+//---------------------------------------------------------------------------
+
+HorizonMaps::~HorizonMaps()
+{
+}
+
+//---------------------------------------------------------------------------
+
+void HorizonMaps::Initialise()
+{
+  // A horizon elevation sine of -1 everywhere: the sun is never below it...
+  static const unsigned char nothing[2 * 4] = { 0 };
+  impl->unshadowed = Device::NewTexture2D(Texture2DDescription(GL_RGBA8, glm::uvec2(2, 1)));
+  impl->unshadowed->SetData(nothing, GL_RGBA, GL_UNSIGNED_BYTE);
+
+  impl->sampler = Device::NewSampler();
+  impl->sampler->SetMinFilter(GL_LINEAR);
+  impl->sampler->SetMagFilter(GL_LINEAR);
+  impl->sampler->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
+
+//---------------------------------------------------------------------------
+
+PatchHorizonPtr HorizonMaps::Generate(const PatchInfo& patch)
+{
+  PatchHorizonPtr horizon = boost::make_shared<PatchHorizon>();
+  horizon->generated = boost::make_shared<GeneratedHorizon>();
+
+  impl->workers.Submit(boost::bind(GenerateHorizon, patch, impl->radius, horizon->generated));
+
+  return horizon;
+}
+
+//---------------------------------------------------------------------------
+
+void HorizonMaps::Apply(PlanetEffect& effect, DrawState& drawState, PatchHorizon* const patch)
+{
+  if (patch && !patch->texture && SDL_AtomicGet(&patch->generated->ready))
+  {
+    patch->texture = Device::NewTexture2D(Texture2DDescription(GL_RGBA8, glm::uvec2(2 * Size, Size)));
+    patch->texture->SetData(patch->generated->texels, GL_RGBA, GL_UNSIGNED_BYTE);
+
+    // The CPU copy is no longer needed...
+    patch->generated.reset();
+  }
+
+  effect.HorizonMap->Set(int(HorizonUnit));
+  drawState.textureUnits[HorizonUnit].texture = (patch && patch->texture) ? patch->texture : impl->unshadowed;
+  drawState.textureUnits[HorizonUnit].sampler = impl->sampler;
+}
+
+//---------------------------------------------------------------------------
+
+static unsigned char EncodeSine(double sine)
+{
+  return (unsigned char)((glm::clamp(sine, -1.0, 1.0) * 127.5) + 127.5 + 0.5);
+}
+
+//---------------------------------------------------------------------------
+
+static void GenerateHorizon(const PatchInfo& patch, double radius, GeneratedHorizonPtr output)
+{
+  const double spacing = (patch.width / (HorizonMaps::Size - 1)) * (radius / glm::length(patch.centre));
+  const double maxDistance = glm::max(spacing * (HorizonMaps::Size - 1) * 4.0, radius * PlanetTile::MaxRelativeHeight * MaxDistanceHeights);
+  const double stepRatio = glm::pow(maxDistance / spacing, 1.0 / (MarchSteps - 1));
+
+  for (unsigned int j = 0; j < HorizonMaps::Size; ++j)
+  {
+    const double v = double(j) / (HorizonMaps::Size - 1);
+    for (unsigned int i = 0; i < HorizonMaps::Size; ++i)
+    {
+      const double u = double(i) / (HorizonMaps::Size - 1);
+
+      const glm::dvec3 cubePos = patch.centre + (((patch.right * (u - 0.5)) + (patch.forward * (v - 0.5))) * patch.width);
+      const glm::dvec3 up = glm::normalize(cubePos);
+      const glm::dvec3 origin = up * (radius + PlanetTile::SampleHeight(*patch.tile, u, v));
+
+      // The local tangent frame, as rebuilt by planet.glsl...
+      const glm::dvec3 east = glm::normalize(patch.right - (up * glm::dot(patch.right, up)));
+      const glm::dvec3 north = glm::cross(up, east);
+
+      unsigned char* const texel = &output->texels[((i * 4) + (j * HorizonMaps::Size * 2 * 4))];
+      for (unsigned int a = 0; a < HorizonMaps::Azimuths; ++a)
+      {
+        const double azimuth = (2.0 * glm::pi<double>() * a) / HorizonMaps::Azimuths;
+        const glm::dvec3 direction = (east * glm::cos(azimuth)) + (north * glm::sin(azimuth));
+
+        // Highest elevation of the terrain along the azimuth. Measured from the tangent
+        // plane so the planet's curvature is accounted for...
+        double horizon = -1.0;
+        double distance = spacing;
+        for (unsigned int step = 0; step < MarchSteps; ++step, distance *= stepRatio)
+        {
+          const glm::dvec3 sampleUp = glm::normalize(origin + (direction * distance));
+          const glm::dvec3 sample = sampleUp * (radius + PlanetTile::ComputeHeight(sampleUp, radius));
+          horizon = glm::max(horizon, glm::dot(glm::normalize(sample - origin), up));
+        }
+
+        // Azimuths 0-3 in the left half of the map, 4-7 in the right...
+        const unsigned int half = a / 4;
+        texel[(half * HorizonMaps::Size * 4) + (a % 4)] = EncodeSine(horizon);
+      }
+    }
+  }
+
+  SDL_AtomicSet(&output->ready, 1);
+}
@@ -0,0 +1,24 @@
+#include <game/planet/impostoreffect.h>
+
+//-------------------------------------------------------------------------------------------
+
+ImpostorEffect::ImpostorEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+ImpostorEffect::~ImpostorEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+void ImpostorEffect::Initialise()
+{
+  ImpostorRight = &parameters["ImpostorRight"];
+  ImpostorUp = &parameters["ImpostorUp"];
+  ImpostorTexture = &parameters["ImpostorTexture"];
+
+  Effect::Initialise();
+}
@@ -0,0 +1,22 @@
+#include <game/planet/pagefeedbackeffect.h>
+
+//-------------------------------------------------------------------------------------------
+
+PageFeedbackEffect::PageFeedbackEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+PageFeedbackEffect::~PageFeedbackEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+void PageFeedbackEffect::Initialise()
+{
+  FeedbackBias = &parameters["FeedbackBias"];
+
+  PlanetEffect::Initialise();
+}
@@ -0,0 +1,88 @@
+#include <cstring>
+#include <core/logging.h>
+#include <game/planet/pagesource.h>
+#include <game/planet/planettile.h>
+
+//---------------------------------------------------------------------------
+
+ProceduralPageSource::ProceduralPageSource(double radius)
+  : radius(radius)
+{
+}
+
+//---------------------------------------------------------------------------
+
+bool ProceduralPageSource::Load(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned char* const texels) const
+{
+  PlanetPage::Generate(face, level, x, y, radius, texels);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+
+PageFile::PageFile(PageSourcePtr fallback)
+  : header(NULL), fallback(fallback)
+{
+}
+
+//---------------------------------------------------------------------------
+
+PageFile::~PageFile()
+{
+}
+
+//---------------------------------------------------------------------------
+
+bool PageFile::Open(const char* const filename, double radius)
+{
+  header = NULL;
+  file.Close();
+
+  if (!file.Open(filename))
+  {
+    return false;
+  }
+
+  const FileHeader* const fileHeader = (const FileHeader*)file.Read(0, sizeof(FileHeader));
+  const bool valid =
+    fileHeader &&
+    (0 == std::memcmp(fileHeader->magic, "BFMP", 4)) &&
+    (Version == fileHeader->version) &&
+    (PlanetPage::Size == fileHeader->pageSize) &&
+    (fileHeader->pageCount == (6 * PlanetTile::TilesAboveLevel(fileHeader->levels))) &&
+    (fileHeader->dataOffset + (boost::uint64_t(fileHeader->pageCount) * PlanetPage::ByteSize) <= file.Size()) &&
+    (radius == fileHeader->radius);
+
+  if (!valid)
+  {
+    LOG("%s - not a page file for a planet of radius %f\n", filename, radius);
+    file.Close();
+    return false;
+  }
+
+  header = fileHeader;
+
+  LOG("%s - %u pages, %u levels\n", filename, header->pageCount, header->levels);
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+
+bool PageFile::Load(unsigned int face, unsigned int level, unsigned int x, unsigned int y, unsigned char* const texels) const
+{
+  if (!header || (level >= header->levels))
+  {
+    return fallback ? fallback->Load(face, level, x, y, texels) : false;
+  }
+
+  const unsigned int pageIndex = PlanetTile::TileIndex(face, level, x, y, header->levels);
+  const void* const page = file.Read(header->dataOffset + (boost::uint64_t(pageIndex) * PlanetPage::ByteSize), PlanetPage::ByteSize);
+  if (!page)
+  {
+    return fallback ? fallback->Load(face, level, x, y, texels) : false;
+  }
+
+  std::memcpy(texels, page, PlanetPage::ByteSize);
+  return true;
+}
@@ -1,24 +1,56 @@
+#include <SDL.h>
 #include <climits>
+#include <cstring>
 #include <vector>
 #include <memory>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#include <core/cpuprofiler.h>
 #include <core/device.h>
 #include <core/drawstate.h>
+#include <core/frameconstants.h>
+#include <core/gpuprofiler.h>
+#include <core/buffers/uniformring.h>
+#include <core/indexoptimiser.h>
+#include <core/renderqueue.h>
+#include <core/workerpool.h>
+#include <game/planet/atmosphere.h>
+#include <game/planet/farfield.h>
+#include <game/planet/horizonmaps.h>
+#include <game/planet/pagefeedbackeffect.h>
+#include <game/planet/pagesource.h>
+#include <game/planet/scatter.h>
 #include <game/planet/planet.h>
 #include <game/planet/planeteffect.h>
+#include <game/planet/planettile.h>
+#include <game/planet/tilecache.h>
+#include <game/planet/virtualtexture.h>
 
 //---------------------------------------------------------------------------
 
 static const double maxError = 4.0;
-static const unsigned int gridSize = 17;
+static const unsigned int gridSize = PlanetTile::GridSize;
 static const unsigned int vertexCount = gridSize * gridSize;
 static const unsigned int indexCount = (gridSize - 1) * (gridSize - 1) * 6;
 static const unsigned int primitiveCount = indexCount / 3;
 
+// Ground detail is scattered over visible patches within this many levels of the deepest.
+static const unsigned int scatterLevels = 3;
+
+// Ray marching over a patch: the step as a fraction of the grid spacing, and the number of
+// bisections used to refine a crossing once found.
+static const double rayStepSpacing = 0.5;
+static const unsigned int rayBisections = 16;
+
+// Uniform buffer binding point of the PatchConstants block, and the patches a frame is
+// expected to draw (more just grows the buffer).
+static const GLuint patchConstantsBinding = FrameConstants::BindingPoint + 1;
+static const size_t expectedPatches = 1024;
+
 //---------------------------------------------------------------------------
 
 // A quadtree patch.
@@ -32,11 +64,27 @@ struct Patch
   };
 
   unsigned int level;
+  unsigned int x;             // position within the level, along the face's right axis
+  unsigned int y;             // position within the level, along the face's forward axis
   double width;
   glm::dvec3 centre;
   glm::dvec3 corners[4];
   PatchPtr parent;
   PatchPtr children[4];
+
+  // Height data, either pointing into the tile cache or at generatedTile.
+  const PlanetTile::Data* tile;
+  boost::shared_ptr<PlanetTile::Data> generatedTile;
+
+  // Range of heights over the patch and all of its descendants.
+  float minHeight;
+  float maxHeight;
+
+  // Ground detail instances, if the patch has been close enough to need them.
+  PatchScatterPtr scatter;
+
+  // Terrain self-shadowing, once the patch has been visible.
+  PatchHorizonPtr horizon;
 };
 
 //---------------------------------------------------------------------------
@@ -46,6 +94,7 @@ struct Face
 {
   Face() : rootNode(new Patch()) { }
 
+  unsigned int index;
   glm::dvec3 right;
   glm::dvec3 forward;
   glm::dvec3 up;
@@ -62,52 +111,171 @@ typedef boost::shared_ptr<Face> FacePtr;
 
 //---------------------------------------------------------------------------
 
+// The outcome of one level of detail pass, handed from the LoD thread to Draw. Patches are
+// never freed, so the raw pointers stay valid however long Draw holds on to a set.
+struct VisibleSet
+{
+  VisibleSet() : representation(PlanetRepresentation::Quadtree), deepestLoDLevel(0) { }
+
+  PlanetRepresentation::Enum representation;
+  unsigned int deepestLoDLevel;
+  std::vector<Patch*> patches[6];
+  std::vector<PatchScatter*> scatter;
+};
+
+// Flags the set waiting in Planet::Impl::readySet as one Draw hasn't taken yet.
+static const int NewSet = 0x4;
+
+//---------------------------------------------------------------------------
+
+// What each patch's draw reads from the PatchConstants block in patch.glsl, laid out to
+// match its std140 layout (a dvec3 starts on a 32 byte boundary).
+struct PatchConstants
+{
+  glm::dvec3 centre;
+  double width;
+  glm::dvec3 faceRight;
+  int face;
+  int padding0;
+  glm::dvec3 faceForward;
+  double padding1;
+};
+
+//---------------------------------------------------------------------------
+
 struct Planet::Impl
 {
   Impl(double radius)
     : radius(radius),
-      maxLevel(unsigned int(glm::log2(radius * 2 * 1000) - glm::log2(gridSize * gridSize)))
-  { }
+      maxLevel((unsigned int)(glm::log2(radius * 2 * 1000) - glm::log2(double(gridSize * gridSize)))),
+      horizonAngle(0),
+      deepestLoDLevel(0),
+      atmosphere(workers),
+      scatter(workers, radius),
+      horizonMaps(workers, radius),
+      virtualTexture(workers),
+      farField(radius),
+      lodThread(NULL),
+      lodMutex(SDL_CreateMutex()),
+      lodWake(SDL_CreateCond()),
+      lodCameraPending(false),
+      lodQuit(false),
+      treeMutex(SDL_CreateMutex()),
+      lodSet(0),
+      drawSet(1)
+  {
+    for (int i = 0; i < 6; ++i)
+    {
+      faces[i] = boost::make_shared<Face>();
+      faces[i]->index = i;
+    }
+    SDL_AtomicSet(&readySet, 2);
+  }
+
+  ~Impl()
+  {
+    if (lodThread)
+    {
+      SDL_LockMutex(lodMutex);
+      lodQuit = true;
+      SDL_CondSignal(lodWake);
+      SDL_UnlockMutex(lodMutex);
+      SDL_WaitThread(lodThread, NULL);
+    }
+
+    SDL_DestroyMutex(treeMutex);
+    SDL_DestroyCond(lodWake);
+    SDL_DestroyMutex(lodMutex);
+  }
 
   const double radius;
   const unsigned int maxLevel;
 
   double horizonAngle;
   unsigned int deepestLoDLevel;
+  glm::ivec2 viewportSize;
 
   FacePtr faces[6];
 
   PlanetEffect effect;
   DrawState drawState;
 
-  VertexLayout vertexLayout;
-
+  PageFeedbackEffect feedbackEffect;
+  DrawState feedbackDrawState;
+
+  // Every visible patch's PatchConstants, written once a frame and read by both passes.
+  boost::scoped_ptr<UniformRing> patchConstants;
+  RenderQueue queue;
+
+  TileCache tileCache;
+  PageSourcePtr pageSource;
+
+  // Background jobs. Declared after everything the jobs read (so it is destroyed, finishing
+  // its queue, first) and before everything which submits jobs.
+  WorkerPool workers;
+  Atmosphere atmosphere;
+  Scatter scatter;
+  HorizonMaps horizonMaps;
+  VirtualTexture virtualTexture;
+
+  // Stand-ins for when the planet is small on screen.
+  FarField farField;
+
+  // Level of detail selection runs on its own thread against the latest camera handed to
+  // Update, so a slow pass (splitting the quadtree generates tiles) never holds up a frame:
+  // Draw carries on with the last set published. Three sets rotate between the thread,
+  // which fills one, Draw, which reads another, and the hand-over slot, so neither side
+  // ever waits for the other.
+  SDL_Thread* lodThread;
+  SDL_mutex* lodMutex;          // guards the camera snapshot and quit flag
+  SDL_cond* lodWake;
+  Camera lodCamera;
+  bool lodCameraPending;
+  bool lodQuit;
+
+  SDL_mutex* treeMutex;         // held while the quadtree is being split or queried
+
+  VisibleSet visibleSets[3];
+  unsigned int lodSet;          // being filled (LoD thread only)
+  unsigned int drawSet;         // being drawn (drawing thread only)
+  SDL_atomic_t readySet;        // handed over: a set index, plus NewSet until Draw takes it
+
+  static int LoDMain(void* data);
+  void SelectLoD(const Camera& camera);
+  const VisibleSet& AcquireVisibleSet();
+
+  PatchInfo GetPatchInfo(FacePtr face, Patch* const patch) const;
+  void WritePatchConstants(const VisibleSet& visible);
+  void DrawPatches(ContextPtr context, const Camera& camera, const VisibleSet& visible, PlanetEffect& effect, DrawState& drawState, bool shadowed);
+  void LoadTile(PatchPtr patch, unsigned int face);
+  void ScatterDetail(FacePtr face, Patch* const patch, std::vector<PatchScatter*>& visible);
   void GetVisiblePatches(const Camera& camera, const unsigned int maxLevel);
   void GetVisiblePatches(const Camera& camera, const unsigned int maxLevel, FacePtr face, PatchPtr patch);
   void SplitNode(FacePtr face, PatchPtr parent, Patch::Corner::Enum corner);
-};
-
-//---------------------------------------------------------------------------
 
-struct Vertex
-{
-  glm::vec3 position;
-  glm::vec2 textureCoord;
+  double SurfaceHeight(const glm::dvec3& direction) const;
+  Patch* FindPatch(const glm::dvec3& direction, const Face*& face, glm::dvec2& coord) const;
+  void Intersect(const Face& face, const Patch& patch, const Ray& ray, RayHit& hit) const;
+  void IntersectLeaf(const Face& face, const Patch& patch, const Ray& ray, double start, double end, RayHit& hit) const;
+  void SurfaceHeightRange(const glm::dvec3* const directions, double* const heights, size_t begin, size_t end) const;
+  void IntersectRange(const Ray* const rays, RayHit* const hits, size_t begin, size_t end) const;
 };
 
 //---------------------------------------------------------------------------
 
 static void CreateFace(double radius, const glm::dvec3& right, const glm::dvec3& forward, FacePtr face);
 static void InitPatch(FacePtr face, unsigned int level, double width, const glm::dvec3& centre, PatchPtr patch);
-static void CreateVertices(Vertex* const vertices, const glm::dvec3& right, const glm::dvec3& forward);
 static void CreateIndices(std::vector<unsigned short>& indices);
+static glm::dvec2 GetPatchCoord(const Face& face, const Patch& patch, const glm::dvec3& position);
+static bool InPatch(const glm::dvec2& coord);
+static glm::dvec3 SampleNormal(const PlanetTile::Data& tile, const glm::dvec2& coord);
+static bool IntersectSphere(const glm::dvec3& origin, const glm::dvec3& direction, const glm::dvec3& centre, double radius, double& near, double& far);
 
 //---------------------------------------------------------------------------
 
 Planet::Planet(double radius)
   : impl(new Impl(radius))
 {
-  std::memset(impl.get(), 0, sizeof(Impl));
 }
 
 //---------------------------------------------------------------------------
@@ -118,7 +286,7 @@ Planet::~Planet()
 
 //---------------------------------------------------------------------------
 
-unsigned int Planet::DeepestLoDLevel() const { return impl->deepestLoDLevel; }
+unsigned int Planet::DeepestLoDLevel() const { return impl->visibleSets[impl->drawSet].deepestLoDLevel; }
 
 //---------------------------------------------------------------------------
 
@@ -127,7 +295,7 @@ unsigned int Planet::PatchCount(unsigned int patchesPerFace[6])
   unsigned int totalPatches = 0;
   for (int i = 0; i < 6; ++i)
   {
-    patchesPerFace[i] = impl->faces[i]->visiblePatches.size();
+    patchesPerFace[i] = impl->visibleSets[impl->drawSet].patches[i].size();
     totalPatches += patchesPerFace[i];
   }
   return totalPatches;
@@ -135,8 +303,86 @@ unsigned int Planet::PatchCount(unsigned int patchesPerFace[6])
 
 //---------------------------------------------------------------------------
 
-void Planet::Initialise()
+double Planet::SurfaceHeight(const glm::dvec3& direction) const
+{
+  SDL_LockMutex(impl->treeMutex);
+  const double height = impl->SurfaceHeight(direction);
+  SDL_UnlockMutex(impl->treeMutex);
+  return height;
+}
+
+//---------------------------------------------------------------------------
+
+double Planet::Altitude(const glm::dvec3& position) const
+{
+  SDL_LockMutex(impl->treeMutex);
+  const double altitude = glm::length(position) - (impl->radius + impl->SurfaceHeight(position));
+  SDL_UnlockMutex(impl->treeMutex);
+  return altitude;
+}
+
+//---------------------------------------------------------------------------
+
+bool Planet::Intersect(const Ray& ray, RayHit& hit) const
+{
+  SDL_LockMutex(impl->treeMutex);
+  impl->IntersectRange(&ray, &hit, 0, 1);
+  SDL_UnlockMutex(impl->treeMutex);
+
+  return hit.hit;
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::SurfaceHeights(const glm::dvec3* const directions, double* const heights, size_t count) const
+{
+  SDL_LockMutex(impl->treeMutex);
+  impl->workers.ParallelFor(count, boost::bind(&Impl::SurfaceHeightRange, impl.get(), directions, heights, _1, _2));
+  SDL_UnlockMutex(impl->treeMutex);
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Intersect(const Ray* const rays, RayHit* const hits, size_t count) const
+{
+  SDL_LockMutex(impl->treeMutex);
+  impl->workers.ParallelFor(count, boost::bind(&Impl::IntersectRange, impl.get(), rays, hits, _1, _2));
+  SDL_UnlockMutex(impl->treeMutex);
+}
+
+//---------------------------------------------------------------------------
+
+bool Planet::UseTileCache(const char* const filename)
+{
+  return impl->tileCache.Open(filename, impl->radius);
+}
+
+//---------------------------------------------------------------------------
+
+bool Planet::UsePageFile(const char* const filename)
+{
+  boost::shared_ptr<PageFile> pageFile = boost::make_shared<PageFile>(boost::make_shared<ProceduralPageSource>(impl->radius));
+  if (!pageFile->Open(filename, impl->radius))
+  {
+    return false;
+  }
+  impl->pageSource = pageFile;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::SetAtmosphere(const AtmosphereParameters& parameters)
+{
+  impl->atmosphere.SetParameters(parameters);
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Initialise(const glm::ivec2& viewportSize)
 {
+  impl->viewportSize = viewportSize;
+
   // Create the cube that represents the spherical planet...
   {
     static const glm::dvec3 up(0,1,0);
@@ -151,34 +397,33 @@ void Planet::Initialise()
     CreateFace(impl->radius, backward, up, impl->faces[3]);     // left
     CreateFace(impl->radius, right, forward, impl->faces[4]);   // top
     CreateFace(impl->radius, right, backward, impl->faces[5]);  // bottom
-  }
-
-  // Create the geometry...
-  {
-    static const VertexAttribute vertexAttributes[] =
-    {
-      { VertexSemantic::Position, GL_FLOAT, 3, offsetof(Vertex, position) },
-      { VertexSemantic::Texture0, GL_FLOAT, 2, offsetof(Vertex, textureCoord) }
-    };
-    static const unsigned int attributeCount = sizeof(vertexAttributes) / sizeof(vertexAttributes[0]);
 
-    for (int i = 0; i < attributeCount; ++i)
-    {
-      impl->vertexLayout.AddAttribute(vertexAttributes[i]);
-    }
-
-    std::vector<Vertex> vertices(vertexCount * 6);
     for (int i = 0; i < 6; ++i)
     {
-      CreateVertices(&vertices[vertexCount * 6], impl->faces[i]->right, impl->faces[i]->forward);
+      impl->LoadTile(impl->faces[i]->rootNode, i);
     }
+  }
 
+  // Create the geometry...
+  {
+    // There is no vertex buffer: the grid is regular, so the vertex shader derives each
+    // vertex's grid position from gl_VertexID and places it using the patch's centre, width
+    // and face axes. Only the index list exists, shared by every patch on every face, and
+    // reordered for the post-transform vertex cache...
     std::vector<unsigned short> indices(indexCount);
     CreateIndices(indices);
+    const IndexOptimiser::CacheStats before = IndexOptimiser::Measure(indices, vertexCount, GL_TRIANGLES);
+    IndexOptimiser::OptimiseTriangles(indices, vertexCount);
+    IndexOptimiser::Report("planet grid", before, IndexOptimiser::Measure(indices, vertexCount, GL_TRIANGLES));
 
-    VertexBufferPtr vertexBuffer = Device::NewVertexBuffer(impl->vertexLayout, vertexCount, GL_STATIC_DRAW);
     IndexBufferPtr indexBuffer = Device::NewIndexBuffer(indexCount, GL_UNSIGNED_SHORT, GL_STATIC_DRAW);
-    impl->drawState.vertexArray = Device::NewVertexArray(vertexBuffer, indexBuffer);
+    indexBuffer->Enable();
+    indexBuffer->SetData(&indices[0], indices.size());
+    IndexBuffer::Disable();
+
+    impl->drawState.vertexArray = Device::NewVertexArray(VertexBufferPtr(), indexBuffer);
+
+    impl->patchConstants.reset(new UniformRing(sizeof(PatchConstants), expectedPatches));
   }
 
   // Initialise the effect and its constant uniform parameters...
@@ -186,47 +431,263 @@ void Planet::Initialise()
     impl->effect.Load("assets/effects/planet.glsl");
     impl->effect.Radius->Set(impl->radius);
     impl->effect.WorldMatrix->Set(glm::mat4(1));
+    impl->effect.BindBlock("PatchConstants", patchConstantsBinding);
     impl->drawState.effect = &impl->effect;
+
+    impl->feedbackEffect.Load("assets/effects/pagefeedback.glsl");
+    impl->feedbackEffect.Radius->Set(impl->radius);
+    impl->feedbackEffect.BindBlock("PatchConstants", patchConstantsBinding);
+    impl->feedbackDrawState.effect = &impl->feedbackEffect;
+    impl->feedbackDrawState.vertexArray = impl->drawState.vertexArray;
   }
 
-  impl->drawState.renderState.mode = GL_LINE;
+  // Surface colour comes from a baked page file if one was given, otherwise every page is
+  // generated as it is needed...
+  if (!impl->pageSource)
+  {
+    impl->pageSource = boost::make_shared<ProceduralPageSource>(impl->radius);
+  }
+
+  impl->atmosphere.Initialise(AtmosphereParameters(impl->radius));
+  impl->scatter.Initialise();
+  impl->horizonMaps.Initialise();
+  impl->virtualTexture.Initialise(impl->pageSource, VirtualTexture::Description(), viewportSize);
+  impl->farField.Initialise();
+
+  impl->lodThread = SDL_CreateThread(Impl::LoDMain, "planet lod", impl.get());
 }
 
 //---------------------------------------------------------------------------
 
 void Planet::Update(float elapsedMS, const Camera& camera)
 {
-  // Find the angle between the camera position and the horizon...
-  const double height = glm::length(camera.position);
-  impl->horizonAngle = glm::acos(impl->radius / height);
-  // then add a small "fudge factor" for mountain tops that peek above the spherical horizon...
-  impl->horizonAngle += (height > 1000) ? 20 : 5;
+  PROFILE_ZONE("planet update");
+
+  // Hand the camera to the LoD thread. If it is still busy with an earlier one, this
+  // replaces whatever it hasn't yet picked up...
+  SDL_LockMutex(impl->lodMutex);
+  impl->lodCamera = camera;
+  impl->lodCameraPending = true;
+  SDL_CondSignal(impl->lodWake);
+  SDL_UnlockMutex(impl->lodMutex);
+
+  impl->atmosphere.Update();
+}
+
+//---------------------------------------------------------------------------
+
+int Planet::Impl::LoDMain(void* data)
+{
+  Impl* const impl = (Impl*)data;
+  CpuProfiler::NameThread("planet lod");
+
+  SDL_LockMutex(impl->lodMutex);
+  for (;;)
+  {
+    while (!impl->lodCameraPending && !impl->lodQuit)
+    {
+      SDL_CondWait(impl->lodWake, impl->lodMutex);
+    }
+
+    if (impl->lodQuit)
+    {
+      break;
+    }
+
+    const Camera camera(impl->lodCamera);
+    impl->lodCameraPending = false;
+
+    SDL_UnlockMutex(impl->lodMutex);
+    impl->SelectLoD(camera);
+    SDL_LockMutex(impl->lodMutex);
+  }
+  SDL_UnlockMutex(impl->lodMutex);
+
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::SelectLoD(const Camera& camera)
+{
+  PROFILE_ZONE("select lod");
+
+  VisibleSet& visible = visibleSets[lodSet];
+  visible.scatter.clear();
+  for (int i = 0; i < 6; ++i)
+  {
+    visible.patches[i].clear();
+  }
+
+  // A planet only a few hundred pixels across doesn't need its quadtree at all...
+  visible.representation = farField.Select(camera, (unsigned int)viewportSize.y);
+  if (PlanetRepresentation::Quadtree == visible.representation)
+  {
+    SDL_LockMutex(treeMutex);
+
+    // Find the angle between the camera position and the horizon...
+    const double height = glm::length(camera.position);
+    horizonAngle = glm::acos(radius / height);
+    // then add a small "fudge factor" for mountain tops that peek above the spherical horizon...
+    horizonAngle += (height > 1000) ? 20 : 5;
+
+    // Get the set of currently visible terrain patches...
+    GetVisiblePatches(camera, maxLevel);
+
+    // Start horizon maps for newly visible patches and scatter ground detail over the most
+    // detailed of them...
+    PROFILE_ZONE("horizons and scatter");
+    for (int i = 0; i < 6; ++i)
+    {
+      BOOST_FOREACH(Patch* const patch, faces[i]->visiblePatches)
+      {
+        if (!patch->horizon)
+        {
+          patch->horizon = horizonMaps.Generate(GetPatchInfo(faces[i], patch));
+        }
+
+        if ((patch->level + scatterLevels) > maxLevel)
+        {
+          ScatterDetail(faces[i], patch, visible.scatter);
+        }
+      }
+      visible.patches[i] = faces[i]->visiblePatches;
+    }
+
+    SDL_UnlockMutex(treeMutex);
+  }
+  visible.deepestLoDLevel = deepestLoDLevel;
+
+  // Publish the set, taking back whichever was waiting: either Draw has finished with it,
+  // or Draw never got to it and it is now out of date...
+  SDL_MemoryBarrierRelease();
+  lodSet = (unsigned int)(SDL_AtomicSet(&readySet, int(lodSet) | NewSet) & ~NewSet);
+}
 
-  // Get the set of currently visible terrain patches...
-  impl->GetVisiblePatches(camera, 0);
+//---------------------------------------------------------------------------
+
+const VisibleSet& Planet::Impl::AcquireVisibleSet()
+{
+  if (SDL_AtomicGet(&readySet) & NewSet)
+  {
+    drawSet = (unsigned int)(SDL_AtomicSet(&readySet, int(drawSet)) & ~NewSet);
+    SDL_MemoryBarrierAcquire();
+  }
+  return visibleSets[drawSet];
 }
 
 //---------------------------------------------------------------------------
 
 void Planet::Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection)
 {
+  const GpuScope planetScope(*context, "planet");
+  const VisibleSet& visible = impl->AcquireVisibleSet();
+
+  if (PlanetRepresentation::Quadtree != visible.representation)
+  {
+    // Only the virtual texture's resident pages are used, so no feedback is needed...
+    impl->virtualTexture.Update();
+
+    context->BeginGpuScope("atmosphere");
+    impl->atmosphere.Draw(context, camera, sunDirection);
+    context->EndGpuScope();
+
+    context->BeginGpuScope("far field");
+    impl->farField.Draw(context, camera, sunDirection, impl->atmosphere, impl->virtualTexture, visible.representation);
+    context->EndGpuScope();
+    return;
+  }
+
+  impl->WritePatchConstants(visible);
+
+  // Find out which virtual texture pages the view needs. The answer arrives a frame or two
+  // later, so the pages are loaded by the time the view has moved on to need them...
+  context->BeginGpuScope("page feedback");
+  impl->virtualTexture.BeginFeedback(context, impl->feedbackEffect);
+  impl->virtualTexture.Apply(impl->feedbackEffect, impl->feedbackDrawState);
+  impl->DrawPatches(context, camera, visible, impl->feedbackEffect, impl->feedbackDrawState, false);
+  impl->virtualTexture.EndFeedback();
+  context->EndGpuScope();
+
+  context->BeginGpuScope("page uploads");
+  impl->virtualTexture.Update();
+  context->EndGpuScope();
+
+  context->BeginGpuScope("atmosphere");
+  impl->atmosphere.Draw(context, camera, sunDirection);
+  context->EndGpuScope();
+
+  context->BeginGpuScope("patches");
+  impl->atmosphere.Apply(impl->effect, impl->drawState);
+  impl->virtualTexture.Apply(impl->effect, impl->drawState);
   impl->effect.SunDirection->Set(sunDirection);
-  impl->effect.WorldMatrix->Set(glm::mat4(1));
-  impl->effect.ViewMatrix->Set(camera.viewMatrix);
-  impl->effect.ProjectionMatrix->Set(camera.projectionMatrix);
-  impl->effect.WorldViewProjectionMatrix->Set(camera.projectionMatrix * camera.viewMatrix);
+  impl->DrawPatches(context, camera, visible, impl->effect, impl->drawState, true);
+  context->EndGpuScope();
+
+  context->BeginGpuScope("scatter");
+  impl->scatter.Draw(context, camera, sunDirection, impl->atmosphere, visible.scatter);
+  context->EndGpuScope();
+}
+
+//---------------------------------------------------------------------------
 
+// Upload the constants of every patch to be drawn this frame in one go, in the order
+// DrawPatches visits them.
+void Planet::Impl::WritePatchConstants(const VisibleSet& visible)
+{
+  patchConstants->BeginFrame();
+
+  PatchConstants constants;
+  std::memset(&constants, 0, sizeof(constants));
+  for (int face = 0; face < 6; ++face)
+  {
+    constants.face = face;
+    constants.faceRight = faces[face]->right;
+    constants.faceForward = faces[face]->forward;
+
+    BOOST_FOREACH(const Patch* const patch, visible.patches[face])
+    {
+      constants.centre = patch->centre;
+      constants.width = patch->width;
+      patchConstants->Add(&constants);
+    }
+  }
+
+  patchConstants->Upload();
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::DrawPatches(ContextPtr context, const Camera& camera, const VisibleSet& visible, PlanetEffect& effect, DrawState& drawState, bool shadowed)
+{
+  // Queued rather than drawn as they are visited, so that patches sharing a horizon map
+  // are drawn together and nearer ones first...
+  DrawPacket packet;
+  packet.primitiveType = GL_TRIANGLES;
+  packet.indexed = true;
+  packet.count = indexCount;
+  packet.uniformRing = patchConstants.get();
+  packet.uniformBinding = patchConstantsBinding;
+
+  size_t block = 0;
   for (int face = 0; face < 6; ++face)
   {
-    BOOST_FOREACH(auto patch, impl->faces[face]->visiblePatches)
+    BOOST_FOREACH(auto patch, visible.patches[face])
     {
-      impl->effect.Centre->Set(patch->centre);
-      impl->effect.Width->Set(patch->width);
-      impl->effect.Apply();
-      
-      context->Draw(GL_TRIANGLES, vertexCount, vertexCount * face, impl->drawState);
+      if (shadowed)
+      {
+        horizonMaps.Apply(effect, drawState, patch->horizon.get());
+      }
+
+      const double distance = glm::distance(camera.position, glm::normalize(patch->centre) * radius);
+      packet.key = RenderQueue::MakeKey(0, drawState, float(distance / camera.farClip));
+      packet.drawState = drawState;
+      packet.uniformBlock = block++;
+      queue.Submit(packet);
     }
   }
+
+  context->Execute(queue);
 }
 
 //---------------------------------------------------------------------------
@@ -244,6 +705,8 @@ static void CreateFace(double radius, const glm::dvec3& right, const glm::dvec3&
 static void InitPatch(FacePtr face, unsigned int level, double width, const glm::dvec3& centre, PatchPtr patch)
 {
   patch->level = level;
+  patch->x = 0;
+  patch->y = 0;
   patch->width = width;
   patch->centre = centre;
 
@@ -257,24 +720,6 @@ static void InitPatch(FacePtr face, unsigned int level, double width, const glm:
 
 //---------------------------------------------------------------------------
 
-static void CreateVertices(Vertex* const vertices, const glm::dvec3& right, const glm::dvec3& forward)
-{
-  static const double inc = 1.0 / double(gridSize - 1);
-  const glm::dvec3 start = (right + forward) * -0.5;
-  for (unsigned int z = 0; z < gridSize; ++z)
-  {
-    for (unsigned int x = 0; x < gridSize; ++x)
-    {
-      const glm::dvec3 p = start + (right * inc * double(x)) + (forward * inc * double(z));
-      const glm::vec2 t = glm::vec2(inc * x, inc * z);
-      vertices[x + (z * gridSize)].position = p;
-      vertices[x + (z * gridSize)].textureCoord = t;
-    }
-  }
-}
-
-//---------------------------------------------------------------------------
-
 static void CreateIndices(std::vector<unsigned short>& indices)
 {
   unsigned int counter = 0;
@@ -302,6 +747,8 @@ static void CreateIndices(std::vector<unsigned short>& indices)
 
 void Planet::Impl::GetVisiblePatches(const Camera& camera, const unsigned int maxLevel)
 {
+  PROFILE_ZONE("visible patches");
+
   deepestLoDLevel = 0;
 
   for (int i = 0; i < 6; ++i)
@@ -389,7 +836,294 @@ void Planet::Impl::SplitNode(FacePtr face, PatchPtr parent, Patch::Corner::Enum
 
     PatchPtr newNode(new Patch());
     InitPatch(face, parent->level + 1, parent->width * 0.5, centre, newNode);
+    newNode->x = (parent->x * 2) + (((Patch::Corner::TR == corner) || (Patch::Corner::BR == corner)) ? 1 : 0);
+    newNode->y = (parent->y * 2) + (((Patch::Corner::TL == corner) || (Patch::Corner::TR == corner)) ? 1 : 0);
     newNode->parent = parent;
+    LoadTile(newNode, face->index);
     parent->children[int(corner)] = newNode;
+
+    // A finer tile can reach higher or lower than its ancestors' coarser ones did, so widen
+    // their height ranges until one already covers it...
+    for (Patch* ancestor = parent.get(); ancestor; ancestor = ancestor->parent.get())
+    {
+      if ((ancestor->minHeight <= newNode->minHeight) && (ancestor->maxHeight >= newNode->maxHeight))
+      {
+        break;
+      }
+      ancestor->minHeight = glm::min(ancestor->minHeight, newNode->minHeight);
+      ancestor->maxHeight = glm::max(ancestor->maxHeight, newNode->maxHeight);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::ScatterDetail(FacePtr face, Patch* const patch, std::vector<PatchScatter*>& visible)
+{
+  if (!patch->scatter)
+  {
+    patch->scatter = scatter.Generate(GetPatchInfo(face, patch));
+  }
+
+  visible.push_back(patch->scatter.get());
+}
+
+//---------------------------------------------------------------------------
+
+PatchInfo Planet::Impl::GetPatchInfo(FacePtr face, Patch* const patch) const
+{
+  PatchInfo info;
+  info.face = face->index;
+  info.level = patch->level;
+  info.x = patch->x;
+  info.y = patch->y;
+  info.centre = patch->centre;
+  info.width = patch->width;
+  info.right = face->right;
+  info.forward = face->forward;
+  info.tile = patch->tile;
+  info.tileOwner = patch->generatedTile;
+  return info;
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::LoadTile(PatchPtr patch, unsigned int face)
+{
+  // Baked tiles are used as-is straight out of the file mapping. Anything deeper than
+  // the bake (or everything, if there is no cache) must be generated on demand...
+  patch->tile = tileCache.GetTile(face, patch->level, patch->x, patch->y);
+  if (!patch->tile)
+  {
+    patch->generatedTile = boost::make_shared<PlanetTile::Data>();
+    PlanetTile::Generate(face, patch->level, patch->x, patch->y, radius, *patch->generatedTile);
+    patch->tile = patch->generatedTile.get();
+  }
+
+  patch->minHeight = patch->tile->minHeight;
+  patch->maxHeight = patch->tile->maxHeight;
+}
+
+//---------------------------------------------------------------------------
+
+double Planet::Impl::SurfaceHeight(const glm::dvec3& direction) const
+{
+  const Face* face;
+  glm::dvec2 coord;
+  const Patch* const patch = FindPatch(glm::normalize(direction), face, coord);
+  return PlanetTile::SampleHeight(*patch->tile, coord.x, coord.y);
+}
+
+//---------------------------------------------------------------------------
+
+Patch* Planet::Impl::FindPatch(const glm::dvec3& direction, const Face*& face, glm::dvec2& coord) const
+{
+  // The direction passes through the face it is most closely aligned with...
+  face = faces[0].get();
+  for (int i = 1; i < 6; ++i)
+  {
+    if (glm::dot(direction, faces[i]->up) > glm::dot(direction, face->up))
+    {
+      face = faces[i].get();
+    }
+  }
+
+  // then down through the quadtree to the deepest patch containing it...
+  const glm::dvec3 cubePos = direction * (radius / glm::dot(direction, face->up));
+  Patch* patch = face->rootNode.get();
+  for (;;)
+  {
+    coord = glm::clamp(GetPatchCoord(*face, *patch, cubePos), 0.0, 1.0);
+    if (!patch->children[0])
+    {
+      return patch;
+    }
+
+    Patch::Corner::Enum corner;
+    if (coord.y >= 0.5) { corner = (coord.x < 0.5) ? Patch::Corner::TL : Patch::Corner::TR; }
+    else                { corner = (coord.x < 0.5) ? Patch::Corner::BL : Patch::Corner::BR; }
+    patch = patch->children[int(corner)].get();
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::Intersect(const Face& face, const Patch& patch, const Ray& ray, RayHit& hit) const
+{
+  // Bound the patch's terrain with a sphere. Seen from the planet's centre a patch is widest
+  // at its corners, so the corners at the lowest and highest heights enclose it...
+  const double middle = radius + ((patch.minHeight + patch.maxHeight) * 0.5);
+  const glm::dvec3 centre = glm::normalize(patch.centre) * middle;
+  double bound = 0.0;
+  for (int i = 0; i < 4; ++i)
+  {
+    const glm::dvec3 corner = glm::normalize(patch.corners[i]);
+    bound = glm::max(bound, glm::distance(centre, corner * (radius + patch.minHeight)));
+    bound = glm::max(bound, glm::distance(centre, corner * (radius + patch.maxHeight)));
+  }
+
+  double near, far;
+  if (!IntersectSphere(ray.origin, ray.direction, centre, bound, near, far) || (far < 0.0) || (near > hit.distance))
+  {
+    return;
+  }
+
+  if (!patch.children[0])
+  {
+    IntersectLeaf(face, patch, ray, glm::max(near, 0.0), glm::min(far, hit.distance), hit);
+    return;
+  }
+
+  for (int i = 0; i < 4; ++i)
+  {
+    Intersect(face, *patch.children[i], ray, hit);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::IntersectLeaf(const Face& face, const Patch& patch, const Ray& ray, double start, double end, RayHit& hit) const
+{
+  // Height of a point on the ray above the patch's terrain. Beyond the patch's edges the
+  // edge heights are carried on, so that a crossing just over an edge is still found (and
+  // then left to the neighbour, which has the real heights there)...
+  struct Height
+  {
+    static double Above(const Face& face, const Patch& patch, double radius, const glm::dvec3& position, glm::dvec2& coord)
+    {
+      const glm::dvec3 cubePos = position * (radius / glm::dot(position, face.up));
+      coord = GetPatchCoord(face, patch, cubePos);
+      const glm::dvec2 clamped = glm::clamp(coord, 0.0, 1.0);
+      return glm::length(position) - (radius + PlanetTile::SampleHeight(*patch.tile, clamped.x, clamped.y));
+    }
+  };
+
+  // March in steps of a fraction of the grid spacing, on the sphere...
+  const double step = (patch.width / (gridSize - 1)) * (radius / glm::length(patch.centre)) * rayStepSpacing;
+
+  glm::dvec2 coord;
+  if (Height::Above(face, patch, radius, ray.origin + (ray.direction * start), coord) <= 0.0)
+  {
+    // Starting beneath the terrain...
+    if ((0.0 == start) && InPatch(coord))
+    {
+      hit.hit = true;
+      hit.distance = 0.0;
+      hit.position = ray.origin;
+      hit.normal = SampleNormal(*patch.tile, coord);
+    }
+    return;
+  }
+
+  double previous = start;
+  for (double t = glm::min(start + step, end); previous < end; t = glm::min(t + step, end))
+  {
+    const double height = Height::Above(face, patch, radius, ray.origin + (ray.direction * t), coord);
+    if (height <= 0.0)
+    {
+      // Crossed the surface between the last two samples: narrow it down...
+      double above = previous;
+      double below = t;
+      for (unsigned int i = 0; i < rayBisections; ++i)
+      {
+        const double middle = (above + below) * 0.5;
+        if (Height::Above(face, patch, radius, ray.origin + (ray.direction * middle), coord) > 0.0) { above = middle; }
+        else                                                                                      { below = middle; }
+      }
+
+      const glm::dvec3 position = ray.origin + (ray.direction * below);
+      Height::Above(face, patch, radius, position, coord);
+      if (InPatch(coord))
+      {
+        hit.hit = true;
+        hit.distance = below;
+        hit.position = position;
+        hit.normal = SampleNormal(*patch.tile, coord);
+      }
+      return;
+    }
+
+    previous = t;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::SurfaceHeightRange(const glm::dvec3* const directions, double* const heights, size_t begin, size_t end) const
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    heights[i] = SurfaceHeight(directions[i]);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void Planet::Impl::IntersectRange(const Ray* const rays, RayHit* const hits, size_t begin, size_t end) const
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    hits[i].hit = false;
+    hits[i].distance = rays[i].maxDistance;
+    for (int face = 0; face < 6; ++face)
+    {
+      Intersect(*faces[face], *faces[face]->rootNode, rays[i], hits[i]);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// Position of a point on the cube within a patch: (0,0) at its BL corner, (1,1) at TR.
+static glm::dvec2 GetPatchCoord(const Face& face, const Patch& patch, const glm::dvec3& position)
+{
+  const glm::dvec3 offset = position - patch.corners[Patch::Corner::BL];
+  return glm::dvec2(glm::dot(offset, face.right), glm::dot(offset, face.forward)) / patch.width;
+}
+
+//---------------------------------------------------------------------------
+
+static bool InPatch(const glm::dvec2& coord)
+{
+  return (coord.x >= 0.0) && (coord.x <= 1.0) && (coord.y >= 0.0) && (coord.y <= 1.0);
+}
+
+//---------------------------------------------------------------------------
+
+// Bilinearly interpolated surface normal at coord in [0,1] across a tile.
+static glm::dvec3 SampleNormal(const PlanetTile::Data& tile, const glm::dvec2& coord)
+{
+  const glm::dvec2 grid = glm::clamp(coord, 0.0, 1.0) * double(gridSize - 1);
+  const unsigned int x0 = glm::min((unsigned int)grid.x, gridSize - 2);
+  const unsigned int y0 = glm::min((unsigned int)grid.y, gridSize - 2);
+  const glm::dvec2 f = grid - glm::dvec2(x0, y0);
+
+  const glm::i8vec4* const row0 = &tile.normals[y0 * gridSize];
+  const glm::i8vec4* const row1 = &tile.normals[(y0 + 1) * gridSize];
+  const glm::dvec3 n00(row0[x0].x, row0[x0].y, row0[x0].z);
+  const glm::dvec3 n10(row0[x0 + 1].x, row0[x0 + 1].y, row0[x0 + 1].z);
+  const glm::dvec3 n01(row1[x0].x, row1[x0].y, row1[x0].z);
+  const glm::dvec3 n11(row1[x0 + 1].x, row1[x0 + 1].y, row1[x0 + 1].z);
+
+  return glm::normalize(glm::mix(glm::mix(n00, n10, f.x), glm::mix(n01, n11, f.x), f.y));
+}
+
+//---------------------------------------------------------------------------
+
+// Distances along a ray (with unit direction) at which it enters and leaves a sphere.
+static bool IntersectSphere(const glm::dvec3& origin, const glm::dvec3& direction, const glm::dvec3& centre, double radius, double& near, double& far)
+{
+  const glm::dvec3 offset = origin - centre;
+  const double b = glm::dot(offset, direction);
+  const double c = glm::dot(offset, offset) - (radius * radius);
+  const double discriminant = (b * b) - c;
+  if (discriminant < 0.0)
+  {
+    return false;
   }
+
+  const double root = glm::sqrt(discriminant);
+  near = -b - root;
+  far = -b + root;
+  return true;
 }
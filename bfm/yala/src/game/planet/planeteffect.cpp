@@ -16,10 +16,12 @@ PlanetEffect::~PlanetEffect()
 
 void PlanetEffect::Initialise()
 {
-  SunDirection= &parameters["SunDirection"];
   Radius = &parameters["Radius"];
-  Centre = &parameters["Centre"];
-  Width = &parameters["Width"];
+  PageTable = &parameters["PageTable"];
+  PageCache = &parameters["PageCache"];
+  VirtualLevels = &parameters["VirtualLevels"];
+  CachePages = &parameters["CachePages"];
+  HorizonMap = &parameters["HorizonMap"];
 
-  Effect::Initialise();
+  AtmosphereEffect::Initialise();
 }
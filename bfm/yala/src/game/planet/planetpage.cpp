@@ -0,0 +1,114 @@
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <game/planet/planetpage.h>
+#include <game/planet/planettile.h>
+
+//---------------------------------------------------------------------------
+
+// Surface albedos (linear).
+static const glm::dvec3 lowland(0.06, 0.1, 0.03);
+static const glm::dvec3 upland(0.2, 0.16, 0.1);
+static const glm::dvec3 rock(0.25, 0.23, 0.2);
+static const glm::dvec3 snow(0.8, 0.8, 0.85);
+
+// Height fractions (of the tallest possible feature) at which the bands blend.
+static const double uplandHeight = 0.15;
+static const double rockHeight = 0.45;
+static const double equatorSnowHeight = 0.8;
+static const double poleSnowHeight = 0.2;
+
+// Slopes (cosine of the angle from vertical) below which bare rock shows through.
+static const double steepSlope = 0.75;
+static const double flatSlope = 0.9;
+
+//---------------------------------------------------------------------------
+
+static glm::dvec3 SurfaceColour(const glm::dvec3& direction, double heightFraction, double normalUp);
+static unsigned char ToSRGB(double value);
+
+//---------------------------------------------------------------------------
+
+void PlanetPage::Generate(unsigned int face, unsigned int level, unsigned int x, unsigned int y, double radius, unsigned char* const texels)
+{
+  // Positions are evaluated with a one texel apron for the normals...
+  static const int apronSize = Size + 2;
+
+  glm::dvec3 right, forward, up;
+  PlanetTile::GetFaceBasis(face, right, forward, up);
+
+  const double pagesPerEdge = double(1U << level);
+  const double maxHeight = radius * PlanetTile::MaxRelativeHeight;
+
+  std::vector<glm::dvec3> directions(apronSize * apronSize);
+  std::vector<double> heights(apronSize * apronSize);
+  std::vector<glm::dvec3> positions(apronSize * apronSize);
+
+  for (int j = 0; j < apronSize; ++j)
+  {
+    // Texel centres, with the page's content (not its border) spanning the page's area...
+    const double v = -1.0 + (2.0 * (y + ((j - 1.0 - Border + 0.5) / ContentSize)) / pagesPerEdge);
+    for (int i = 0; i < apronSize; ++i)
+    {
+      const double u = -1.0 + (2.0 * (x + ((i - 1.0 - Border + 0.5) / ContentSize)) / pagesPerEdge);
+      const size_t index = i + (j * apronSize);
+      directions[index] = glm::normalize(up + (right * u) + (forward * v));
+    }
+  }
+
+  PlanetTile::ComputeHeights(&directions[0], &heights[0], directions.size(), radius);
+  for (size_t index = 0; index < positions.size(); ++index)
+  {
+    positions[index] = directions[index] * (radius + heights[index]);
+  }
+
+  for (int j = 1; j <= int(Size); ++j)
+  {
+    for (int i = 1; i <= int(Size); ++i)
+    {
+      const size_t index = i + (j * apronSize);
+      const glm::dvec3 dRight = positions[index + 1] - positions[index - 1];
+      const glm::dvec3 dForward = positions[index + apronSize] - positions[index - apronSize];
+      const glm::dvec3 normal = glm::normalize(glm::cross(dRight, dForward));
+
+      const glm::dvec3 colour = SurfaceColour(directions[index], heights[index] / maxHeight, glm::dot(normal, directions[index]));
+
+      unsigned char* const texel = &texels[((i - 1) + ((j - 1) * Size)) * 4];
+      texel[0] = ToSRGB(colour.r);
+      texel[1] = ToSRGB(colour.g);
+      texel[2] = ToSRGB(colour.b);
+      texel[3] = 255;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static glm::dvec3 SurfaceColour(const glm::dvec3& direction, double heightFraction, double normalUp)
+{
+  // A little high frequency variation breaks up the bands' edges...
+  const double variation = glm::simplex(glm::vec3(direction * 2000.0)) * 0.05;
+  const double h = heightFraction + variation;
+
+  glm::dvec3 colour = glm::mix(lowland, upland, glm::smoothstep(0.0, uplandHeight, h));
+  colour = glm::mix(colour, rock, glm::smoothstep(uplandHeight, rockHeight, h));
+
+  // Bare rock on steep slopes...
+  colour = glm::mix(rock, colour, glm::smoothstep(steepSlope, flatSlope, normalUp));
+
+  // Snow lies lower towards the poles, and not on the steepest slopes...
+  const double snowHeight = glm::mix(equatorSnowHeight, poleSnowHeight, glm::abs(direction.y));
+  const double snowCover = glm::smoothstep(snowHeight, snowHeight + 0.05, h) * glm::smoothstep(steepSlope, flatSlope, normalUp);
+  colour = glm::mix(colour, snow, snowCover);
+
+  return colour;
+}
+
+//---------------------------------------------------------------------------
+
+static unsigned char ToSRGB(double value)
+{
+  value = glm::clamp(value, 0.0, 1.0);
+  const double encoded = (value <= 0.0031308) ? (value * 12.92) : ((1.055 * glm::pow(value, 1.0 / 2.4)) - 0.055);
+  return (unsigned char)((encoded * 255.0) + 0.5);
+}
@@ -0,0 +1,202 @@
+#include <cfloat>
+#include <vector>
+#include <core/noise.h>
+#include <game/planet/planettile.h>
+
+//---------------------------------------------------------------------------
+
+// Hybrid multifractal parameters (see Musgrave, Texturing & Modeling, p502).
+static const unsigned int octaves = 8;
+static const double roughness = 0.25;
+static const double lacunarity = 2.1;
+static const double offset = 0.7;
+static const double baseFrequency = 4.0;
+
+static Noise::Fractal MakeHeightFractal();
+static const Noise::Fractal heightFractal = MakeHeightFractal();
+
+//---------------------------------------------------------------------------
+
+void PlanetTile::GetFaceBasis(unsigned int face, glm::dvec3& right, glm::dvec3& forward, glm::dvec3& up)
+{
+  static const glm::dvec3 axes[6][2] =
+  {
+    { glm::dvec3( 1, 0, 0), glm::dvec3(0, 1,  0) },   // front
+    { glm::dvec3( 0, 0, 1), glm::dvec3(0, 1,  0) },   // right
+    { glm::dvec3(-1, 0, 0), glm::dvec3(0, 1,  0) },   // back
+    { glm::dvec3( 0, 0,-1), glm::dvec3(0, 1,  0) },   // left
+    { glm::dvec3( 1, 0, 0), glm::dvec3(0, 0,  1) },   // top
+    { glm::dvec3( 1, 0, 0), glm::dvec3(0, 0, -1) }    // bottom
+  };
+
+  right = axes[face][0];
+  forward = axes[face][1];
+  up = glm::cross(right, forward);
+}
+
+//---------------------------------------------------------------------------
+
+static Noise::Fractal MakeHeightFractal()
+{
+  Noise::Fractal fractal;
+  fractal.octaves = octaves;
+  fractal.lacunarity = float(lacunarity);
+  fractal.gain = float(glm::pow(lacunarity, -roughness));
+  fractal.offset = float(offset);
+  return fractal;
+}
+
+//---------------------------------------------------------------------------
+
+// The fractal lies (roughly) in [0, 2], so scale it into the permitted height range. The
+// clamp keeps the rare outliers inside the bounds everything else assumes...
+static double ScaleHeight(float fractal, double radius)
+{
+  return glm::clamp(fractal * 0.5, 0.0, 1.0) * radius * PlanetTile::MaxRelativeHeight;
+}
+
+//---------------------------------------------------------------------------
+
+double PlanetTile::ComputeHeight(const glm::dvec3& unitPosition, double radius)
+{
+  return ScaleHeight(Noise::HybridMultifractal(glm::vec3(unitPosition * baseFrequency), heightFractal), radius);
+}
+
+//---------------------------------------------------------------------------
+
+void PlanetTile::ComputeHeights(const glm::dvec3* const unitPositions, double* const heights, size_t count, double radius)
+{
+  std::vector<float> x(count);
+  std::vector<float> y(count);
+  std::vector<float> z(count);
+  std::vector<float> results(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    const glm::vec3 p(unitPositions[i] * baseFrequency);
+    x[i] = p.x;
+    y[i] = p.y;
+    z[i] = p.z;
+  }
+
+  Noise::HybridMultifractal(&x[0], &y[0], &z[0], &results[0], count, heightFractal);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    heights[i] = ScaleHeight(results[i], radius);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+double PlanetTile::ComputeHeightGlm(const glm::dvec3& unitPosition, double radius)
+{
+  glm::vec3 p = glm::vec3(unitPosition * baseFrequency);
+
+  double weight = 1.0;
+  double amplitude = 1.0;
+  double result = 0.0;
+  for (unsigned int i = 0; i < octaves; ++i)
+  {
+    const double signal = (glm::simplex(p) + offset) * amplitude;
+    result += weight * signal;
+    weight = glm::min(1.0, weight * signal);
+
+    amplitude *= glm::pow(lacunarity, -roughness);
+    p *= float(lacunarity);
+  }
+
+  // The sum lies (roughly) in [0, 2], so scale it into the permitted height range...
+  return glm::max(0.0, result * 0.5) * radius * MaxRelativeHeight;
+}
+
+//---------------------------------------------------------------------------
+
+float PlanetTile::SampleHeight(const Data& tile, double u, double v)
+{
+  const double gx = glm::clamp(u, 0.0, 1.0) * (GridSize - 1);
+  const double gy = glm::clamp(v, 0.0, 1.0) * (GridSize - 1);
+  const unsigned int x0 = glm::min((unsigned int)gx, GridSize - 2);
+  const unsigned int y0 = glm::min((unsigned int)gy, GridSize - 2);
+  const float fx = float(gx - x0);
+  const float fy = float(gy - y0);
+
+  const float* const h = &tile.heights[x0 + (y0 * GridSize)];
+  return glm::mix(
+    glm::mix(h[0], h[1], fx),
+    glm::mix(h[GridSize], h[GridSize + 1], fx),
+    fy);
+}
+
+//---------------------------------------------------------------------------
+
+void PlanetTile::GetApronDirections(unsigned int face, unsigned int level, unsigned int x, unsigned int y, glm::dvec3* const directions)
+{
+  glm::dvec3 right, forward, up;
+  GetFaceBasis(face, right, forward, up);
+
+  const double tilesPerEdge = double(1U << level);
+  const double step = 1.0 / double(GridSize - 1);
+
+  for (int j = 0; j < int(ApronSize); ++j)
+  {
+    const double v = -1.0 + (2.0 * (y + ((j - 1) * step)) / tilesPerEdge);
+    for (int i = 0; i < int(ApronSize); ++i)
+    {
+      const double u = -1.0 + (2.0 * (x + ((i - 1) * step)) / tilesPerEdge);
+      directions[i + (j * ApronSize)] = glm::normalize(up + (right * u) + (forward * v));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void PlanetTile::Build(const glm::dvec3* const directions, const double* const heights, double radius, Data& tile)
+{
+  glm::dvec3 positions[ApronVertexCount];
+
+  tile.minHeight = FLT_MAX;
+  tile.maxHeight = -FLT_MAX;
+
+  for (int j = 0; j < int(ApronSize); ++j)
+  {
+    for (int i = 0; i < int(ApronSize); ++i)
+    {
+      const double height = heights[i + (j * ApronSize)];
+      positions[i + (j * ApronSize)] = directions[i + (j * ApronSize)] * (radius + height);
+
+      const bool inside = (i > 0) && (j > 0) && (i <= int(GridSize)) && (j <= int(GridSize));
+      if (inside)
+      {
+        tile.heights[(i - 1) + ((j - 1) * GridSize)] = float(height);
+        tile.minHeight = glm::min(tile.minHeight, float(height));
+        tile.maxHeight = glm::max(tile.maxHeight, float(height));
+      }
+    }
+  }
+
+  for (int j = 1; j <= int(GridSize); ++j)
+  {
+    for (int i = 1; i <= int(GridSize); ++i)
+    {
+      const glm::dvec3 dRight = positions[(i + 1) + (j * ApronSize)] - positions[(i - 1) + (j * ApronSize)];
+      const glm::dvec3 dForward = positions[i + ((j + 1) * ApronSize)] - positions[i + ((j - 1) * ApronSize)];
+      const glm::dvec3 normal = glm::normalize(glm::cross(dRight, dForward)) * 127.0;
+      tile.normals[(i - 1) + ((j - 1) * GridSize)] = glm::i8vec4(glm::i8(normal.x), glm::i8(normal.y), glm::i8(normal.z), 0);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void PlanetTile::Generate(unsigned int face, unsigned int level, unsigned int x, unsigned int y, double radius, Data& tile)
+{
+  glm::dvec3 directions[ApronVertexCount];
+  double heights[ApronVertexCount];
+
+  GetApronDirections(face, level, x, y, directions);
+
+  // The whole grid's heights in one go...
+  ComputeHeights(directions, heights, ApronVertexCount, radius);
+
+  Build(directions, heights, radius, tile);
+}
@@ -0,0 +1,424 @@
+#include <SDL.h>
+#include <algorithm>
+#include <map>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <core/device.h>
+#include <game/planet/scatter.h>
+#include <game/planet/scattereffect.h>
+
+//---------------------------------------------------------------------------
+
+namespace ScatterMesh
+{
+  enum Enum { Rock, Shrub, Count };
+}
+
+// Must match the meshes in scatter.glsl. Sizes are in world units.
+struct MeshInfo
+{
+  unsigned int vertexCount;
+  double probability;     // chance of a candidate position being this mesh
+  double minScale;
+  double maxScale;
+  double minNormalUp;     // cosine of the steepest slope the mesh may stand on
+};
+
+static const MeshInfo meshes[ScatterMesh::Count] =
+{
+  { 24, 0.3, 0.0005, 0.002,  0.5 },   // rock
+  { 12, 0.5, 0.0005, 0.0015, 0.85 }   // shrub
+};
+
+// Candidate positions per patch; the remainder after the probabilities above are empty.
+static const unsigned int CandidatesPerPatch = 1024;
+
+// Frames a patch's instances stay on the GPU after it was last drawn (e.g. once it has been
+// split, or left behind by the camera).
+static const unsigned int EvictAfterFrames = 300;
+
+//---------------------------------------------------------------------------
+
+struct ScatterInstance
+{
+  glm::vec4 offsetScale;  // xyz: offset from the patch origin, w: scale
+  glm::vec2 yaw;          // cosine and sine of the rotation about the local up axis
+};
+
+// Filled in by a worker thread. Kept apart from PatchScatter so that a job finishing after
+// its patch has been freed only ever releases CPU memory on the worker.
+struct GeneratedInstances
+{
+  GeneratedInstances() { SDL_AtomicSet(&ready, 0); }
+
+  SDL_atomic_t ready;
+  std::vector<ScatterInstance> instances;
+  unsigned int first[ScatterMesh::Count];
+  unsigned int count[ScatterMesh::Count];
+};
+
+typedef boost::shared_ptr<GeneratedInstances> GeneratedInstancesPtr;
+
+//---------------------------------------------------------------------------
+
+struct PatchScatter
+{
+  PatchInfo info;             // to generate the instances again once evicted
+  glm::dvec3 origin;          // patch centre on the sphere surface
+  glm::vec3 faceRight;
+  double width;
+
+  // Set by Generate; afterwards only touched on the GL thread, which regenerates the
+  // instances if they're needed after being evicted...
+  GeneratedInstancesPtr generated;
+
+  // Created on the GL thread once generation has finished, and released by Evict. The
+  // vertex array is shared with the other patches whose instances are in the same GL
+  // buffer, and the instances start at baseInstance in it...
+  VertexBufferPtr instanceBuffer;
+  VertexArrayPtr vertexArray;
+  unsigned int baseInstance;
+  unsigned int lastDrawn;     // frame number
+  unsigned int first[ScatterMesh::Count];
+  unsigned int count[ScatterMesh::Count];
+};
+
+//---------------------------------------------------------------------------
+
+struct Scatter::Impl
+{
+  // A vertex array shared by the resident patches whose instances are in one GL buffer.
+  // It keeps the buffer of the patch it was made for, and so that part of the GL buffer,
+  // until the last of them is evicted.
+  struct SharedArray
+  {
+    SharedArray() : patches(0) {}
+
+    VertexArrayPtr vertexArray;
+    unsigned int patches;
+  };
+
+  Impl(WorkerPool& workers, double radius)
+    : workers(workers), radius(radius), fadeStart(1.0), fadeEnd(4.0), frame(0)
+  {
+  }
+
+  WorkerPool& workers;
+  const double radius;
+  double fadeStart;
+  double fadeEnd;
+
+  ScatterEffect effect;
+  DrawState drawState;
+  VertexLayout instanceLayout;
+
+  std::map<GLuint, SharedArray> vertexArrays;
+
+  // Patches whose instances are on the GPU. Patches are never freed, so the pointers stay
+  // valid.
+  std::vector<PatchScatter*> resident;
+  unsigned int frame;
+
+  void Regenerate(PatchScatter& patch);
+  void Upload(PatchScatter& patch);
+  void Evict(PatchScatter& patch);
+};
+
+//---------------------------------------------------------------------------
+
+static void GenerateInstances(const PatchInfo& patch, glm::dvec3 origin, double radius, GeneratedInstancesPtr output);
+
+//---------------------------------------------------------------------------
+
+Scatter::Scatter(WorkerPool& workers, double radius)
+  : impl(new Impl(workers, radius))
+{
+}
+
+//---------------------------------------------------------------------------
+
+Scatter::~Scatter()
+{
+}
+
+//---------------------------------------------------------------------------
+
+void Scatter::Initialise()
+{
+  static const VertexAttribute instanceAttributes[] =
+  {
+    { VertexSemantic::Texture0, GL_FLOAT, 4, offsetof(ScatterInstance, offsetScale), VertexFormat::Float, 1 },
+    { VertexSemantic::Texture1, GL_FLOAT, 2, offsetof(ScatterInstance, yaw), VertexFormat::Float, 1 }
+  };
+  impl->instanceLayout.AddAttribute(instanceAttributes[0]);
+  impl->instanceLayout.AddAttribute(instanceAttributes[1]);
+
+  impl->effect.Load("assets/effects/scatter.glsl");
+  impl->drawState.effect = &impl->effect;
+}
+
+//---------------------------------------------------------------------------
+
+void Scatter::SetFadeDistances(double start, double end)
+{
+  impl->fadeStart = start;
+  impl->fadeEnd = end;
+}
+
+//---------------------------------------------------------------------------
+
+PatchScatterPtr Scatter::Generate(const PatchInfo& patch)
+{
+  PatchScatterPtr scatter = boost::make_shared<PatchScatter>();
+  scatter->info = patch;
+  scatter->origin = glm::normalize(patch.centre) * impl->radius;
+  scatter->faceRight = glm::vec3(patch.right);
+  scatter->width = patch.width;
+  scatter->lastDrawn = 0;
+  impl->Regenerate(*scatter);
+
+  return scatter;
+}
+
+//---------------------------------------------------------------------------
+
+void Scatter::Draw(
+    ContextPtr context,
+    const Camera& camera,
+    const glm::vec3& sunDirection,
+    const Atmosphere& atmosphere,
+    const std::vector<PatchScatter*>& patches)
+{
+  atmosphere.Apply(impl->effect, impl->drawState);
+  impl->effect.SunDirection->Set(sunDirection);
+
+  ++impl->frame;
+
+  BOOST_FOREACH(PatchScatter* const patch, patches)
+  {
+    patch->lastDrawn = impl->frame;
+
+    if (!patch->vertexArray)
+    {
+      if (!patch->generated)
+      {
+        impl->Regenerate(*patch);
+      }
+      if (!SDL_AtomicGet(&patch->generated->ready))
+      {
+        continue;
+      }
+      impl->Upload(*patch);
+    }
+
+    // Instances within each mesh group are in random order, so drawing a prefix of the
+    // group thins it out evenly...
+    const double distance = glm::max(0.0, glm::distance(camera.position, patch->origin) - (patch->width * 0.5));
+    const double density = glm::clamp((impl->fadeEnd - distance) / (impl->fadeEnd - impl->fadeStart), 0.0, 1.0);
+    if (density <= 0.0)
+    {
+      continue;
+    }
+
+    impl->drawState.vertexArray = patch->vertexArray;
+    impl->effect.Origin->Set(patch->origin);
+    impl->effect.FaceRight->Set(patch->faceRight);
+
+    for (int mesh = 0; mesh < ScatterMesh::Count; ++mesh)
+    {
+      const unsigned int count = (unsigned int)(patch->count[mesh] * density);
+      if (count > 0)
+      {
+        impl->effect.MeshType->Set(mesh);
+        impl->effect.Apply();
+        context->DrawInstanced(GL_TRIANGLES, meshes[mesh].vertexCount, count, patch->baseInstance + patch->first[mesh], impl->drawState);
+      }
+    }
+  }
+
+  // Give back the GPU memory of patches which are no longer being drawn...
+  for (size_t i = 0; i < impl->resident.size();)
+  {
+    PatchScatter* const patch = impl->resident[i];
+    if ((impl->frame - patch->lastDrawn) > EvictAfterFrames)
+    {
+      impl->Evict(*patch);
+      impl->resident[i] = impl->resident.back();
+      impl->resident.pop_back();
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// Start generating a patch's instances on a worker.
+void Scatter::Impl::Regenerate(PatchScatter& patch)
+{
+  patch.generated = boost::make_shared<GeneratedInstances>();
+  workers.Submit(boost::bind(GenerateInstances, patch.info, patch.origin, radius, patch.generated));
+}
+
+//---------------------------------------------------------------------------
+
+void Scatter::Impl::Upload(PatchScatter& patch)
+{
+  const std::vector<ScatterInstance>& instances = patch.generated->instances;
+
+  // An empty patch still gets a vertex array so that it isn't checked again...
+  VertexBufferPtr instanceBuffer = Device::NewVertexBuffer(instanceLayout, glm::max(size_t(1), instances.size()), GL_STATIC_DRAW);
+  if (!instances.empty())
+  {
+    instanceBuffer->Enable();
+    instanceBuffer->SetData(&instances[0], instances.size());
+    VertexBuffer::Disable();
+  }
+
+  SharedArray& shared = vertexArrays[instanceBuffer->GetBuffer()];
+  if (!shared.vertexArray)
+  {
+    shared.vertexArray = Device::NewSharedVertexArray(instanceBuffer);
+  }
+  ++shared.patches;
+
+  patch.instanceBuffer = instanceBuffer;
+  patch.vertexArray = shared.vertexArray;
+  patch.baseInstance = instanceBuffer->GetBaseVertex();
+  resident.push_back(&patch);
+
+  for (int mesh = 0; mesh < ScatterMesh::Count; ++mesh)
+  {
+    patch.first[mesh] = patch.generated->first[mesh];
+    patch.count[mesh] = patch.generated->count[mesh];
+  }
+
+  // The CPU copy is no longer needed...
+  patch.generated.reset();
+}
+
+//---------------------------------------------------------------------------
+
+// Release a patch's instance buffer, and its GL buffer's vertex array once no other patch
+// uses it. Drawing the patch again generates its instances afresh.
+void Scatter::Impl::Evict(PatchScatter& patch)
+{
+  const std::map<GLuint, SharedArray>::iterator shared = vertexArrays.find(patch.instanceBuffer->GetBuffer());
+  if ((vertexArrays.end() != shared) && (0 == --shared->second.patches))
+  {
+    vertexArrays.erase(shared);
+  }
+
+  patch.vertexArray.reset();
+  patch.instanceBuffer.reset();
+}
+
+//---------------------------------------------------------------------------
+
+static boost::uint32_t Hash(boost::uint32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+// Uniform random number in [0,1) for one channel of one candidate.
+static double Random(boost::uint32_t seed, unsigned int candidate, unsigned int channel)
+{
+  return Hash(seed ^ Hash((candidate * 8) + channel)) / 4294967296.0;
+}
+
+//---------------------------------------------------------------------------
+
+struct Candidate
+{
+  int mesh;
+  double rank;
+  ScatterInstance instance;
+
+  bool operator<(const Candidate& other) const
+  {
+    return (mesh != other.mesh) ? (mesh < other.mesh) : (rank < other.rank);
+  }
+};
+
+//---------------------------------------------------------------------------
+
+static void GenerateInstances(const PatchInfo& patch, glm::dvec3 origin, double radius, GeneratedInstancesPtr output)
+{
+  const boost::uint32_t seed = Hash(patch.face ^ Hash(patch.level ^ Hash(patch.x ^ Hash(patch.y))));
+
+  std::vector<Candidate> candidates;
+  candidates.reserve(CandidatesPerPatch);
+
+  for (unsigned int i = 0; i < CandidatesPerPatch; ++i)
+  {
+    // Pick a mesh (or nothing)...
+    const double choice = Random(seed, i, 0);
+    int mesh = 0;
+    double cumulative = meshes[0].probability;
+    while ((mesh < ScatterMesh::Count) && (choice >= cumulative))
+    {
+      ++mesh;
+      cumulative += (mesh < ScatterMesh::Count) ? meshes[mesh].probability : 0.0;
+    }
+    if (mesh >= ScatterMesh::Count)
+    {
+      continue;
+    }
+
+    const double u = Random(seed, i, 1);
+    const double v = Random(seed, i, 2);
+
+    // Nearest grid normal is plenty to reject slopes too steep for the mesh...
+    const unsigned int gx = (unsigned int)((u * (PlanetTile::GridSize - 1)) + 0.5);
+    const unsigned int gy = (unsigned int)((v * (PlanetTile::GridSize - 1)) + 0.5);
+    const glm::i8vec4& n = patch.tile->normals[gx + (gy * PlanetTile::GridSize)];
+    const glm::dvec3 cubePos = patch.centre + (((patch.right * (u - 0.5)) + (patch.forward * (v - 0.5))) * patch.width);
+    const glm::dvec3 up = glm::normalize(cubePos);
+    const double normalUp = glm::dot(glm::dvec3(n.x, n.y, n.z) / 127.0, up);
+    if (normalUp < meshes[mesh].minNormalUp)
+    {
+      continue;
+    }
+
+    const double height = PlanetTile::SampleHeight(*patch.tile, u, v);
+    const glm::dvec3 position = up * (radius + height);
+    const double scale = glm::mix(meshes[mesh].minScale, meshes[mesh].maxScale, Random(seed, i, 3));
+    const double yaw = Random(seed, i, 4) * 2.0 * glm::pi<double>();
+
+    Candidate candidate;
+    candidate.mesh = mesh;
+    candidate.rank = Random(seed, i, 5);
+    candidate.instance.offsetScale = glm::vec4(glm::vec3(position - origin), float(scale));
+    candidate.instance.yaw = glm::vec2(float(glm::cos(yaw)), float(glm::sin(yaw)));
+    candidates.push_back(candidate);
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+
+  output->instances.resize(candidates.size());
+  for (int mesh = 0; mesh < ScatterMesh::Count; ++mesh)
+  {
+    output->count[mesh] = 0;
+  }
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    output->instances[i] = candidates[i].instance;
+    ++output->count[candidates[i].mesh];
+  }
+  output->first[0] = 0;
+  for (int mesh = 1; mesh < ScatterMesh::Count; ++mesh)
+  {
+    output->first[mesh] = output->first[mesh - 1] + output->count[mesh - 1];
+  }
+
+  SDL_AtomicSet(&output->ready, 1);
+}
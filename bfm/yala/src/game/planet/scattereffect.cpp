@@ -0,0 +1,24 @@
+#include <game/planet/scattereffect.h>
+
+//-------------------------------------------------------------------------------------------
+
+ScatterEffect::ScatterEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+ScatterEffect::~ScatterEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+void ScatterEffect::Initialise()
+{
+  Origin = &parameters["Origin"];
+  FaceRight = &parameters["FaceRight"];
+  MeshType = &parameters["MeshType"];
+
+  AtmosphereEffect::Initialise();
+}
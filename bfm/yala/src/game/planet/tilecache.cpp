@@ -0,0 +1,140 @@
+#include <cstring>
+#include <core/logging.h>
+#include <game/planet/tilecache.h>
+
+//---------------------------------------------------------------------------
+
+static bool ValidLayout(const TileCache::FileHeader& header, boost::uint64_t fileSize);
+static bool ValidTileOffset(const TileCache::FileHeader& header, boost::uint64_t offset);
+
+//---------------------------------------------------------------------------
+
+TileCache::TileCache()
+  : header(NULL)
+{
+}
+
+//---------------------------------------------------------------------------
+
+TileCache::~TileCache()
+{
+}
+
+//---------------------------------------------------------------------------
+
+bool TileCache::Open(const char* const filename, double radius)
+{
+  Close();
+
+  if (!file.Open(filename))
+  {
+    return false;
+  }
+
+  const FileHeader* const fileHeader = (const FileHeader*)file.Read(0, sizeof(FileHeader));
+  const bool valid =
+    fileHeader &&
+    (0 == std::memcmp(fileHeader->magic, "BFMT", 4)) &&
+    (Version == fileHeader->version) &&
+    (PlanetTile::GridSize == fileHeader->gridSize) &&
+    (radius == fileHeader->radius);
+
+  if (!valid)
+  {
+    LOG("%s - not a tile cache for a planet of radius %f\n", filename, radius);
+    file.Close();
+    return false;
+  }
+
+  if (!ValidLayout(*fileHeader, file.Size()))
+  {
+    LOG("%s - corrupt or truncated tile cache\n", filename);
+    file.Close();
+    return false;
+  }
+
+  // The index (a gigabyte at depth 12) is only read, and its entries checked, as tiles
+  // are asked for...
+  header = fileHeader;
+
+  LOG("%s - %u tiles, %u levels\n", filename, header->tileCount, header->levels);
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+
+void TileCache::Close()
+{
+  header = NULL;
+  file.Close();
+}
+
+//---------------------------------------------------------------------------
+
+const PlanetTile::Data* TileCache::GetTile(unsigned int face, unsigned int level, unsigned int x, unsigned int y) const
+{
+  if (!header || (face >= 6) || (level >= header->levels) || (x >= (1U << level)) || (y >= (1U << level)))
+  {
+    return NULL;
+  }
+
+  const unsigned int tileIndex = PlanetTile::TileIndex(face, level, x, y, header->levels);
+  const boost::uint64_t* const offset = (const boost::uint64_t*)file.Read(header->indexOffset + (boost::uint64_t(tileIndex) * sizeof(boost::uint64_t)), sizeof(boost::uint64_t));
+  if (!offset)
+  {
+    return NULL;
+  }
+
+  if (!ValidTileOffset(*header, *offset))
+  {
+    LOG("tile %u is outside the tile data\n", tileIndex);
+    return NULL;
+  }
+
+  return (const PlanetTile::Data*)file.Read(*offset, sizeof(PlanetTile::Data));
+}
+
+//---------------------------------------------------------------------------
+
+// Whether the header describes a complete pyramid whose index and tile data lie, in that
+// order and without overflow, within a file of the given size.
+static bool ValidLayout(const TileCache::FileHeader& header, boost::uint64_t fileSize)
+{
+  if ((header.levels < 1) || (header.levels > TileCache::MaxLevels) ||
+      (header.tileCount != (6 * PlanetTile::TilesAboveLevel(header.levels))) ||
+      (header.tileStride < sizeof(PlanetTile::Data)))
+  {
+    return false;
+  }
+
+  // The index is read as 64-bit values in place, so must be aligned for them...
+  const boost::uint64_t indexSize = boost::uint64_t(header.tileCount) * sizeof(boost::uint64_t);
+  if ((header.indexOffset < sizeof(TileCache::FileHeader)) ||
+      (0 != (header.indexOffset % sizeof(boost::uint64_t))) ||
+      (header.indexOffset > fileSize) ||
+      (indexSize > (fileSize - header.indexOffset)))
+  {
+    return false;
+  }
+
+  // Each size is compared with the room left after its offset, so nothing can wrap...
+  const boost::uint64_t dataSize = boost::uint64_t(header.tileCount) * header.tileStride;
+  return
+    (header.dataOffset >= (header.indexOffset + indexSize)) &&
+    (header.dataOffset <= fileSize) &&
+    (dataSize <= (fileSize - header.dataOffset));
+}
+
+//---------------------------------------------------------------------------
+
+// Whether a tile at offset lies wholly within the tile data (which ValidLayout has found to
+// be within the file), on a float boundary.
+static bool ValidTileOffset(const TileCache::FileHeader& header, boost::uint64_t offset)
+{
+  const boost::uint64_t dataEnd = header.dataOffset + (boost::uint64_t(header.tileCount) * header.tileStride);
+  return
+    (offset >= header.dataOffset) &&
+    (offset <= (dataEnd - sizeof(PlanetTile::Data))) &&
+    (0 == (offset % sizeof(float)));
+}
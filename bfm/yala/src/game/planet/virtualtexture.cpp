@@ -0,0 +1,418 @@
+#include <SDL.h>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <core/device.h>
+#include <core/logging.h>
+#include <game/planet/planetpage.h>
+#include <game/planet/virtualtexture.h>
+
+//---------------------------------------------------------------------------
+
+// A page address packed into 31 bits, exactly as written by pagefeedback.glsl:
+//
+//    bits 0-2    face
+//    bits 3-6    level
+//    bits 7-18   x
+//    bits 19-30  y
+//
+// The feedback buffer is cleared to all ones, which is never a valid address.
+typedef boost::uint32_t PageKey;
+
+static const PageKey NoPage = 0xFFFFFFFF;
+
+static PageKey MakeKey(unsigned int face, unsigned int level, unsigned int x, unsigned int y)
+{
+  return face | (level << 3) | (x << 7) | (y << 19);
+}
+
+static unsigned int KeyFace(PageKey key)  { return key & 0x7; }
+static unsigned int KeyLevel(PageKey key) { return (key >> 3) & 0xF; }
+static unsigned int KeyX(PageKey key)     { return (key >> 7) & 0xFFF; }
+static unsigned int KeyY(PageKey key)     { return (key >> 19) & 0xFFF; }
+
+static PageKey ParentKey(PageKey key)
+{
+  return MakeKey(KeyFace(key), KeyLevel(key) - 1, KeyX(key) >> 1, KeyY(key) >> 1);
+}
+
+// Coarse pages are wanted before fine ones, since they stand in for everything beneath them.
+static bool CoarserFirst(PageKey a, PageKey b)
+{
+  return KeyLevel(a) < KeyLevel(b);
+}
+
+//---------------------------------------------------------------------------
+
+// A page being loaded by a worker. Shared with the job so that it can finish safely even
+// if the virtual texture has given up on it.
+struct PageLoad
+{
+  PageLoad(PageKey key) : key(key), loaded(false), texels(PlanetPage::ByteSize) { SDL_AtomicSet(&ready, 0); }
+
+  const PageKey key;
+  SDL_atomic_t ready;
+  bool loaded;
+  std::vector<unsigned char> texels;
+};
+
+typedef boost::shared_ptr<PageLoad> PageLoadPtr;
+
+//---------------------------------------------------------------------------
+
+// A page-sized space in the cache.
+struct CacheSlot
+{
+  CacheSlot() : page(NoPage), lastUsed(0), pinned(false) { }
+
+  PageKey page;
+  unsigned int lastUsed;      // frame in which feedback last asked for the page
+  bool pinned;
+};
+
+//---------------------------------------------------------------------------
+
+struct VirtualTexture::Impl
+{
+  Impl(WorkerPool& workers)
+    : workers(workers), frame(0)
+  {
+  }
+
+  WorkerPool& workers;
+  PageSourcePtr source;
+  Description description;
+
+  Texture2DPtr pageTable;
+  Texture2DPtr pageCache;
+  SamplerPtr pageTableSampler;
+  SamplerPtr pageCacheSampler;
+
+  FramebufferPtr feedback;
+  ClearState feedbackClearState;
+  std::vector<PageKey> feedbackPixels;
+
+  unsigned int frame;
+  std::vector<CacheSlot> slots;
+  std::map<PageKey, unsigned int> residentPages;    // page -> slot
+  std::set<PageKey> loadingPages;
+  std::list<PageLoadPtr> loads;
+
+  void ProcessFeedback();
+  void FinishLoads();
+  void StartLoads(const std::vector<PageKey>& wanted);
+  bool FindSlot(unsigned int& slot) const;
+  void Upload(unsigned int slot, PageKey page, const unsigned char* const texels);
+  void SetTableEntry(PageKey page, const unsigned char entry[4]);
+};
+
+//---------------------------------------------------------------------------
+
+static void LoadPage(PageSourcePtr source, PageLoadPtr load);
+
+//---------------------------------------------------------------------------
+
+VirtualTexture::VirtualTexture(WorkerPool& workers)
+  : impl(new Impl(workers))
+{
+}
+
+//---------------------------------------------------------------------------
+
+VirtualTexture::~VirtualTexture()
+{
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Initialise(PageSourcePtr source, const Description& description, const glm::ivec2& viewportSize)
+{
+  impl->source = source;
+  impl->description = description;
+  impl->description.levels = glm::clamp(description.levels, 1U, MaxLevels);
+  impl->description.cachePages = glm::clamp(description.cachePages, 2U, 256U);
+
+  const unsigned int levels = impl->description.levels;
+  const unsigned int cachePages = impl->description.cachePages;
+
+  // The page table's top level has a texel per page of the finest level; each mip level
+  // below it serves the next coarser quadtree level. Every entry starts out non-resident...
+  {
+    const unsigned int faceSize = 1U << (levels - 1);
+    impl->pageTable = Device::NewTexture2D(Texture2DDescription(GL_RGBA8UI, glm::uvec2(3 * faceSize, 2 * faceSize), true));
+
+    const std::vector<unsigned char> zeros(3 * faceSize * 2 * faceSize * 4, 0);
+    for (unsigned int mip = 0; mip < levels; ++mip)
+    {
+      const glm::uvec2 size((3 * faceSize) >> mip, (2 * faceSize) >> mip);
+      impl->pageTable->SetData(mip, glm::uvec2(0), size, &zeros[0], GL_RGBA_INTEGER, GL_UNSIGNED_BYTE);
+    }
+
+    // Integer textures can't be filtered...
+    impl->pageTableSampler = Device::NewSampler();
+    impl->pageTableSampler->SetMinFilter(GL_NEAREST_MIPMAP_NEAREST);
+    impl->pageTableSampler->SetMagFilter(GL_NEAREST);
+    impl->pageTableSampler->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+  }
+
+  // Page borders mean bilinear filtering never reads outside a page...
+  {
+    const unsigned int size = cachePages * PlanetPage::Size;
+    impl->pageCache = Device::NewTexture2D(Texture2DDescription(GL_SRGB8_ALPHA8, glm::uvec2(size)));
+    impl->pageCacheSampler = Device::NewSampler();
+    impl->pageCacheSampler->SetMinFilter(GL_LINEAR);
+    impl->pageCacheSampler->SetMagFilter(GL_LINEAR);
+    impl->pageCacheSampler->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    impl->slots.resize(cachePages * cachePages);
+  }
+
+  // Feedback...
+  {
+    const glm::uvec2 size = glm::max(glm::uvec2(viewportSize) / glm::max(impl->description.feedbackDivisor, 1U), glm::uvec2(1));
+    impl->feedback = Device::NewFramebuffer(size, GL_RGBA8);
+    impl->feedbackPixels.resize(size.x * size.y);
+    impl->feedbackClearState.colourValue = glm::vec4(1);
+  }
+
+  // The root pages are always resident so there is something to fall back on everywhere...
+  std::vector<PageLoadPtr> roots;
+  for (unsigned int face = 0; face < 6; ++face)
+  {
+    roots.push_back(boost::make_shared<PageLoad>(MakeKey(face, 0, 0, 0)));
+    impl->workers.Submit(boost::bind(LoadPage, source, roots.back()));
+  }
+  impl->workers.Wait();
+
+  for (unsigned int face = 0; face < 6; ++face)
+  {
+    if (roots[face]->loaded)
+    {
+      impl->Upload(face, roots[face]->key, &roots[face]->texels[0]);
+      impl->slots[face].pinned = true;
+    }
+    else
+    {
+      LOG("virtual texture: no root page for face %u\n", face);
+    }
+  }
+
+  LOG("virtual texture: %u levels, %ux%u page cache, %ux%u feedback\n",
+    levels, cachePages, cachePages, impl->feedback->GetSize().x, impl->feedback->GetSize().y);
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::BeginFeedback(ContextPtr context, PageFeedbackEffect& effect)
+{
+  impl->feedback->Bind();
+  context->Clear(impl->feedbackClearState);
+
+  // The feedback buffer's pixels cover more of the surface than the screen's, so its
+  // derivatives over-estimate the footprint...
+  effect.FeedbackBias->Set(-glm::log2(float(impl->description.feedbackDivisor)));
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::EndFeedback()
+{
+  impl->feedback->ReadColour(GL_RGBA, GL_UNSIGNED_BYTE);
+  impl->feedback->Unbind();
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Update()
+{
+  ++impl->frame;
+  impl->ProcessFeedback();
+  impl->FinishLoads();
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Apply(PlanetEffect& effect, DrawState& drawState) const
+{
+  effect.VirtualLevels->Set(int(impl->description.levels));
+  effect.CachePages->Set(int(impl->description.cachePages));
+  effect.PageTable->Set(int(PageTableUnit));
+  effect.PageCache->Set(int(PageCacheUnit));
+
+  drawState.textureUnits[PageTableUnit].texture = impl->pageTable;
+  drawState.textureUnits[PageTableUnit].sampler = impl->pageTableSampler;
+  drawState.textureUnits[PageCacheUnit].texture = impl->pageCache;
+  drawState.textureUnits[PageCacheUnit].sampler = impl->pageCacheSampler;
+}
+
+//---------------------------------------------------------------------------
+
+unsigned int VirtualTexture::ResidentPages() const
+{
+  return impl->residentPages.size();
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Impl::ProcessFeedback()
+{
+  // Pixels are read as RGBA bytes, which on a little-endian machine is the key itself...
+  if (!feedback->GetColour(&feedbackPixels[0], feedbackPixels.size() * sizeof(PageKey)))
+  {
+    return;
+  }
+
+  std::vector<PageKey> requested(feedbackPixels);
+  std::sort(requested.begin(), requested.end());
+  requested.erase(std::unique(requested.begin(), requested.end()), requested.end());
+
+  // Mark each requested page and its ancestors as used, noting those not yet resident...
+  std::set<PageKey> missing;
+  BOOST_FOREACH(PageKey page, requested)
+  {
+    if ((NoPage == page) || (KeyFace(page) >= 6) || (KeyLevel(page) >= description.levels))
+    {
+      continue;
+    }
+
+    for (;;)
+    {
+      const std::map<PageKey, unsigned int>::const_iterator resident = residentPages.find(page);
+      if (resident != residentPages.end())
+      {
+        slots[resident->second].lastUsed = frame;
+      }
+      else if (loadingPages.find(page) == loadingPages.end())
+      {
+        missing.insert(page);
+      }
+
+      if (0 == KeyLevel(page))
+      {
+        break;
+      }
+      page = ParentKey(page);
+    }
+  }
+
+  std::vector<PageKey> wanted(missing.begin(), missing.end());
+  std::stable_sort(wanted.begin(), wanted.end(), CoarserFirst);
+  StartLoads(wanted);
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Impl::StartLoads(const std::vector<PageKey>& wanted)
+{
+  BOOST_FOREACH(PageKey page, wanted)
+  {
+    if (loads.size() >= description.loadsInFlight)
+    {
+      break;
+    }
+
+    PageLoadPtr load = boost::make_shared<PageLoad>(page);
+    loads.push_back(load);
+    loadingPages.insert(page);
+    workers.Submit(boost::bind(LoadPage, source, load));
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Impl::FinishLoads()
+{
+  unsigned int uploads = 0;
+  std::list<PageLoadPtr>::iterator load = loads.begin();
+  while ((load != loads.end()) && (uploads < description.uploadsPerFrame))
+  {
+    if (!SDL_AtomicGet(&(*load)->ready))
+    {
+      ++load;
+      continue;
+    }
+
+    const PageKey page = (*load)->key;
+    loadingPages.erase(page);
+
+    // If every slot holds a page seen this frame the cache is too small for the view and
+    // the page is dropped; it will be asked for again...
+    unsigned int slot;
+    if ((*load)->loaded && FindSlot(slot))
+    {
+      Upload(slot, page, &(*load)->texels[0]);
+      ++uploads;
+    }
+
+    load = loads.erase(load);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+bool VirtualTexture::Impl::FindSlot(unsigned int& slot) const
+{
+  bool found = false;
+  for (unsigned int i = 0; i < slots.size(); ++i)
+  {
+    if (NoPage == slots[i].page)
+    {
+      slot = i;
+      return true;
+    }
+
+    if (!slots[i].pinned && (slots[i].lastUsed < frame) && (!found || (slots[i].lastUsed < slots[slot].lastUsed)))
+    {
+      slot = i;
+      found = true;
+    }
+  }
+  return found;
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Impl::Upload(unsigned int slot, PageKey page, const unsigned char* const texels)
+{
+  CacheSlot& cacheSlot = slots[slot];
+  if (NoPage != cacheSlot.page)
+  {
+    static const unsigned char notResident[4] = { 0, 0, 0, 0 };
+    SetTableEntry(cacheSlot.page, notResident);
+    residentPages.erase(cacheSlot.page);
+  }
+
+  const glm::uvec2 slotPosition(slot % description.cachePages, slot / description.cachePages);
+  pageCache->SetData(0, slotPosition * PlanetPage::Size, glm::uvec2(PlanetPage::Size), texels, GL_RGBA, GL_UNSIGNED_BYTE);
+
+  const unsigned char entry[4] = { (unsigned char)slotPosition.x, (unsigned char)slotPosition.y, (unsigned char)KeyLevel(page), 255 };
+  SetTableEntry(page, entry);
+
+  cacheSlot.page = page;
+  cacheSlot.lastUsed = frame;
+  residentPages[page] = slot;
+}
+
+//---------------------------------------------------------------------------
+
+void VirtualTexture::Impl::SetTableEntry(PageKey page, const unsigned char entry[4])
+{
+  // Level L lives in mip (levels - 1 - L), where each face is 2^L texels across...
+  const unsigned int level = KeyLevel(page);
+  const unsigned int face = KeyFace(page);
+  const glm::uvec2 position(((face % 3) << level) + KeyX(page), ((face / 3) << level) + KeyY(page));
+  pageTable->SetData(description.levels - 1 - level, position, glm::uvec2(1), entry, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE);
+}
+
+//---------------------------------------------------------------------------
+
+static void LoadPage(PageSourcePtr source, PageLoadPtr load)
+{
+  load->loaded = source->Load(KeyFace(load->key), KeyLevel(load->key), KeyX(load->key), KeyY(load->key), &load->texels[0]);
+  SDL_AtomicSet(&load->ready, 1);
+}
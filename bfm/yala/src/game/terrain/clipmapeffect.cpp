@@ -0,0 +1,30 @@
+#include <game/terrain/clipmapeffect.h>
+
+//-------------------------------------------------------------------------------------------
+
+ClipmapEffect::ClipmapEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+ClipmapEffect::~ClipmapEffect()
+{
+}
+
+//-------------------------------------------------------------------------------------------
+
+void ClipmapEffect::Initialise()
+{
+  LevelHeights = &parameters["LevelHeights"];
+  CoarserHeights = &parameters["CoarserHeights"];
+  HasCoarser = &parameters["HasCoarser"];
+  LevelOffset = &parameters["LevelOffset"];
+  LevelSpacing = &parameters["LevelSpacing"];
+  TexelOrigin = &parameters["TexelOrigin"];
+  CoarserTexelOrigin = &parameters["CoarserTexelOrigin"];
+  CameraHeight = &parameters["CameraHeight"];
+  SunDirection = &parameters["SunDirection"];
+
+  Effect::Initialise();
+}
@@ -0,0 +1,382 @@
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/noise.hpp>
+#include <core/device.h>
+#include <core/indexoptimiser.h>
+#include <core/logging.h>
+#include <core/textures/noisetextures.h>
+#include <game/terrain/clipmapterrain.h>
+#include <game/terrain/clipmapeffect.h>
+
+//---------------------------------------------------------------------------
+
+static const unsigned int GridVertices = ClipmapTerrain::GridQuads + 1;
+static const unsigned int VertexCount = GridVertices * GridVertices;
+
+// A level's hole (the area covered by the level inside it) is half its grid across, and lies
+// either 1/4 or 1/4 + 1 quads in from its low edge on each axis depending on which side of
+// the coarser level's grid lines the camera is. Each of the four cases has its own ring.
+static const int HoleOffset = ClipmapTerrain::GridQuads / 4;
+static const int HoleQuads = ClipmapTerrain::GridQuads / 2;
+static const unsigned int RingVariants = 4;
+
+// A level is in use while the camera is lower above the ground than this fraction of the
+// level's width, so that its detail is never spread over more than part of the screen.
+static const double LevelInUseHeight = 0.4;
+
+// Texture units the level's heights and the coarser level's heights are bound to.
+static const unsigned int LevelUnit = 0;
+static const unsigned int CoarserUnit = 1;
+
+//---------------------------------------------------------------------------
+
+struct ClipmapLevel
+{
+  ClipmapLevel() : valid(false) { }
+
+  Texture2DPtr heights;
+  glm::ivec2 origin;      // world grid position, in this level's spacing, of the grid's first vertex
+  bool valid;             // heights have been evaluated for the whole of the grid at origin
+};
+
+//---------------------------------------------------------------------------
+
+struct IndexRange
+{
+  size_t start;
+  size_t count;
+};
+
+//---------------------------------------------------------------------------
+
+struct ClipmapTerrain::Impl
+{
+  Impl(const Description& description, const HeightFunction& height)
+    : description(description), height(height), levels(description.levels), finestLevel(0)
+  {
+  }
+
+  const Description description;
+  const HeightFunction height;
+
+  std::vector<ClipmapLevel> levels;
+  unsigned int finestLevel;   // the finest level in use, drawn as a full grid
+
+  ClipmapEffect effect;
+  DrawState drawState;
+  NoiseTextures noise;
+  IndexRange fullGrid;
+  IndexRange rings[RingVariants];
+
+  std::vector<float> uploadBuffer;
+
+  double LevelSpacing(unsigned int level) const { return description.spacing * double(1u << level); }
+
+  // Evaluate and upload the heights of a rectangle of vertices, given in world grid
+  // positions. Split wherever it wraps around the edges of the texture.
+  void UpdateRegion(unsigned int level, const glm::ivec2& start, const glm::ivec2& size);
+};
+
+//---------------------------------------------------------------------------
+
+static int WrapTexel(int index);
+static void AddQuad(std::vector<unsigned short>& indices, unsigned int x, unsigned int z);
+static IndexRange AddRange(std::vector<unsigned short>& allIndices, std::vector<unsigned short>& indices, const char* const name);
+
+//---------------------------------------------------------------------------
+
+ClipmapTerrain::ClipmapTerrain(const Description& description, const HeightFunction& height)
+  : impl(new Impl(description, height))
+{
+}
+
+//---------------------------------------------------------------------------
+
+ClipmapTerrain::~ClipmapTerrain()
+{
+}
+
+//---------------------------------------------------------------------------
+
+void ClipmapTerrain::Initialise()
+{
+  for (size_t i = 0; i < impl->levels.size(); ++i)
+  {
+    impl->levels[i].heights = Device::NewTexture2D(Texture2DDescription(GL_R32F, glm::uvec2(TextureSize)));
+  }
+
+  // Like the planet, there is no vertex buffer: the vertex shader places each vertex from
+  // its index. One index buffer holds the full grid followed by the four rings, each
+  // reordered for the post-transform vertex cache...
+  {
+    std::vector<unsigned short> allIndices;
+    std::vector<unsigned short> indices;
+
+    for (unsigned int z = 0; z < GridQuads; ++z)
+    {
+      for (unsigned int x = 0; x < GridQuads; ++x)
+      {
+        AddQuad(indices, x, z);
+      }
+    }
+    impl->fullGrid = AddRange(allIndices, indices, "clipmap grid");
+
+    for (unsigned int variant = 0; variant < RingVariants; ++variant)
+    {
+      const unsigned int holeX = HoleOffset + (variant & 1);
+      const unsigned int holeZ = HoleOffset + (variant >> 1);
+      for (unsigned int z = 0; z < GridQuads; ++z)
+      {
+        for (unsigned int x = 0; x < GridQuads; ++x)
+        {
+          const bool inHole = (x >= holeX) && (x < holeX + HoleQuads) && (z >= holeZ) && (z < holeZ + HoleQuads);
+          if (!inHole)
+          {
+            AddQuad(indices, x, z);
+          }
+        }
+      }
+      impl->rings[variant] = AddRange(allIndices, indices, "clipmap ring");
+    }
+
+    IndexBufferPtr indexBuffer = Device::NewIndexBuffer(allIndices.size(), GL_UNSIGNED_SHORT, GL_STATIC_DRAW);
+    indexBuffer->Enable();
+    indexBuffer->SetData(&allIndices[0], allIndices.size());
+    IndexBuffer::Disable();
+
+    impl->drawState.vertexArray = Device::NewVertexArray(VertexBufferPtr(), indexBuffer);
+  }
+
+  // The level's own heights are read with texelFetch, which ignores the sampler; the
+  // coarser level's are interpolated between its vertices and wrap like the level does...
+  SamplerPtr sampler = Device::NewSampler();
+  sampler->SetMinFilter(GL_LINEAR);
+  sampler->SetMagFilter(GL_LINEAR);
+  sampler->SetWrap(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+  impl->drawState.textureUnits[LevelUnit].sampler = sampler;
+  impl->drawState.textureUnits[CoarserUnit].sampler = sampler;
+
+  impl->effect.Load("assets/effects/clipmap.glsl");
+  impl->effect.LevelHeights->Set(int(LevelUnit));
+  impl->effect.CoarserHeights->Set(int(CoarserUnit));
+  impl->drawState.effect = &impl->effect;
+
+  impl->noise.Initialise();
+  impl->noise.Apply(impl->effect, impl->drawState);
+}
+
+//---------------------------------------------------------------------------
+
+void ClipmapTerrain::Update(const Camera& camera)
+{
+  const glm::dvec2 cameraXZ(camera.position.x, camera.position.z);
+  const double heightAboveGround = glm::abs(camera.position.y - impl->height(cameraXZ));
+
+  impl->finestLevel = impl->levels.size() - 1;
+  for (unsigned int level = 0; level < impl->levels.size(); ++level)
+  {
+    if (heightAboveGround < (LevelInUseHeight * GridQuads * impl->LevelSpacing(level)))
+    {
+      impl->finestLevel = level;
+      break;
+    }
+  }
+
+  // Levels finer than those in use are left alone, and refreshed completely when next
+  // needed...
+  for (unsigned int level = 0; level < impl->finestLevel; ++level)
+  {
+    impl->levels[level].valid = false;
+  }
+
+  for (unsigned int level = impl->finestLevel; level < impl->levels.size(); ++level)
+  {
+    ClipmapLevel& clipmapLevel = impl->levels[level];
+
+    // Centre the grid on the camera, snapped to every other vertex so that its vertices
+    // always coincide with those of the next coarser level...
+    const glm::dvec2 cameraCell = cameraXZ / impl->LevelSpacing(level);
+    const glm::ivec2 origin(
+      2 * int(glm::floor((cameraCell.x - (GridQuads / 2)) * 0.5)),
+      2 * int(glm::floor((cameraCell.y - (GridQuads / 2)) * 0.5)));
+
+    const glm::ivec2 moved = origin - clipmapLevel.origin;
+    const glm::ivec2 distance = glm::abs(moved);
+
+    if (!clipmapLevel.valid || (distance.x > int(GridQuads)) || (distance.y > int(GridQuads)))
+    {
+      impl->UpdateRegion(level, origin, glm::ivec2(GridVertices));
+    }
+    else
+    {
+      // The columns which have come in on one side, then the rows which have come in at
+      // the top or bottom over the columns which were already there...
+      if (moved.x > 0)      { impl->UpdateRegion(level, glm::ivec2(clipmapLevel.origin.x + GridVertices, origin.y), glm::ivec2(moved.x, GridVertices)); }
+      else if (moved.x < 0) { impl->UpdateRegion(level, origin, glm::ivec2(-moved.x, GridVertices)); }
+
+      const int keptStart = glm::max(origin.x, clipmapLevel.origin.x);
+      const int keptColumns = GridVertices - distance.x;
+      if (moved.y > 0)      { impl->UpdateRegion(level, glm::ivec2(keptStart, clipmapLevel.origin.y + GridVertices), glm::ivec2(keptColumns, moved.y)); }
+      else if (moved.y < 0) { impl->UpdateRegion(level, glm::ivec2(keptStart, origin.y), glm::ivec2(keptColumns, -moved.y)); }
+    }
+
+    clipmapLevel.origin = origin;
+    clipmapLevel.valid = true;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void ClipmapTerrain::Draw(ContextPtr context, const Camera& camera, const glm::vec3& sunDirection)
+{
+  // Positions are relative to the camera, so the view transform is only its rotation...
+  const glm::dmat4 rotation = glm::dmat4(glm::dmat3(camera.viewMatrix));
+  impl->effect.WorldViewProjectionMatrix->Set(glm::mat4(camera.projectionMatrix * rotation));
+  impl->effect.CameraHeight->Set(float(camera.position.y));
+  impl->effect.SunDirection->Set(sunDirection);
+
+  const glm::dvec2 cameraXZ(camera.position.x, camera.position.z);
+
+  for (unsigned int level = impl->finestLevel; level < impl->levels.size(); ++level)
+  {
+    const ClipmapLevel& clipmapLevel = impl->levels[level];
+    const double spacing = impl->LevelSpacing(level);
+
+    impl->effect.LevelOffset->Set(glm::vec2((glm::dvec2(clipmapLevel.origin) * spacing) - cameraXZ));
+    impl->effect.LevelSpacing->Set(float(spacing));
+    impl->effect.TexelOrigin->Set(glm::vec2(WrapTexel(clipmapLevel.origin.x), WrapTexel(clipmapLevel.origin.y)));
+    impl->drawState.textureUnits[LevelUnit].texture = clipmapLevel.heights;
+
+    // Origins are even, so the coarser level's vertex under our first one is exactly half
+    // its position. The coarsest level has nothing to blend into...
+    if ((level + 1) < impl->levels.size())
+    {
+      impl->effect.HasCoarser->Set(1);
+      impl->effect.CoarserTexelOrigin->Set(glm::vec2(WrapTexel(clipmapLevel.origin.x / 2), WrapTexel(clipmapLevel.origin.y / 2)));
+      impl->drawState.textureUnits[CoarserUnit].texture = impl->levels[level + 1].heights;
+    }
+    else
+    {
+      impl->effect.HasCoarser->Set(0);
+      impl->drawState.textureUnits[CoarserUnit].texture = clipmapLevel.heights;
+    }
+
+    IndexRange range = impl->fullGrid;
+    if (level > impl->finestLevel)
+    {
+      const glm::ivec2 hole = (impl->levels[level - 1].origin / 2) - clipmapLevel.origin;
+      range = impl->rings[(hole.x - HoleOffset) + ((hole.y - HoleOffset) * 2)];
+    }
+
+    impl->effect.Apply();
+    context->DrawIndexed(GL_TRIANGLES, range.count, range.start, impl->drawState);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+float ClipmapTerrain::FractalHeight(const glm::dvec2& position)
+{
+  static const int Octaves = 10;
+  static const double BaseFrequency = 1.0 / 4000.0;
+  static const float Lacunarity = 2.0f;
+  static const float Gain = 0.5f;
+  static const float Offset = 0.7f;
+  static const float MaxHeight = 400.0f;
+
+  // Each octave's contribution is scaled by those before it, so valleys stay smooth while
+  // the high ground gets rough...
+  glm::vec2 p(position * BaseFrequency);
+  float amplitude = 1.0f;
+  float result = (glm::simplex(p) + Offset) * amplitude;
+  float weight = result;
+  for (int i = 1; i < Octaves; ++i)
+  {
+    p *= Lacunarity;
+    amplitude *= Gain;
+    weight = glm::min(weight, 1.0f);
+    const float signal = (glm::simplex(p) + Offset) * amplitude;
+    result += weight * signal;
+    weight *= signal;
+  }
+
+  return glm::max(result - Offset, 0.0f) * MaxHeight;
+}
+
+//---------------------------------------------------------------------------
+
+void ClipmapTerrain::Impl::UpdateRegion(unsigned int level, const glm::ivec2& start, const glm::ivec2& size)
+{
+  const double spacing = LevelSpacing(level);
+  Texture2DPtr texture = levels[level].heights;
+
+  for (int zStart = start.y, rowsLeft = size.y; rowsLeft > 0; )
+  {
+    const int texelZ = WrapTexel(zStart);
+    const int rows = glm::min(rowsLeft, int(TextureSize) - texelZ);
+
+    for (int xStart = start.x, columnsLeft = size.x; columnsLeft > 0; )
+    {
+      const int texelX = WrapTexel(xStart);
+      const int columns = glm::min(columnsLeft, int(TextureSize) - texelX);
+
+      uploadBuffer.resize(rows * columns);
+      for (int z = 0; z < rows; ++z)
+      {
+        for (int x = 0; x < columns; ++x)
+        {
+          uploadBuffer[x + (z * columns)] = height(glm::dvec2(xStart + x, zStart + z) * spacing);
+        }
+      }
+      texture->SetData(0, glm::uvec2(texelX, texelZ), glm::uvec2(columns, rows), &uploadBuffer[0], GL_RED, GL_FLOAT);
+
+      xStart += columns;
+      columnsLeft -= columns;
+    }
+
+    zStart += rows;
+    rowsLeft -= rows;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static int WrapTexel(int index)
+{
+  return index & (ClipmapTerrain::TextureSize - 1);
+}
+
+//---------------------------------------------------------------------------
+
+static void AddQuad(std::vector<unsigned short>& indices, unsigned int x, unsigned int z)
+{
+  const unsigned short lowerLeft = (unsigned short)(x + (z * GridVertices));
+  const unsigned short lowerRight = (unsigned short)((x + 1) + (z * GridVertices));
+  const unsigned short topLeft = (unsigned short)(x + ((z + 1) * GridVertices));
+  const unsigned short topRight = (unsigned short)((x + 1) + ((z + 1) * GridVertices));
+
+  indices.push_back(topLeft);
+  indices.push_back(lowerRight);
+  indices.push_back(lowerLeft);
+
+  indices.push_back(topLeft);
+  indices.push_back(topRight);
+  indices.push_back(lowerRight);
+}
+
+//---------------------------------------------------------------------------
+
+static IndexRange AddRange(std::vector<unsigned short>& allIndices, std::vector<unsigned short>& indices, const char* const name)
+{
+  const IndexOptimiser::CacheStats before = IndexOptimiser::Measure(indices, VertexCount, GL_TRIANGLES);
+  IndexOptimiser::OptimiseTriangles(indices, VertexCount);
+  IndexOptimiser::Report(name, before, IndexOptimiser::Measure(indices, VertexCount, GL_TRIANGLES));
+
+  IndexRange range;
+  range.start = allIndices.size();
+  range.count = indices.size();
+  allIndices.insert(allIndices.end(), indices.begin(), indices.end());
+  indices.clear();
+
+  return range;
+}
@@ -0,0 +1,83 @@
+#include <logging.h>
+#include <utils.h>
+#include <device.h>
+#include <terrain/heightpool.h>
+
+//------------------------------------------------------------------------
+
+TerrainHeightPool::TerrainHeightPool()
+  : Texture(GL_TEXTURE_2D_ARRAY),
+    size(0)
+{
+}
+
+//------------------------------------------------------------------------
+TerrainHeightPool::~TerrainHeightPool()
+{
+}
+
+//------------------------------------------------------------------------
+void TerrainHeightPool::Initialise(size_t size, size_t layers)
+{
+  GLint maxLayers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+  if (layers > (size_t)maxLayers)
+  {
+    LOG("terrain height pool: %u layers requested but only %d allowed\n", layers, maxLayers);
+    layers = (size_t)maxLayers;
+  }
+
+  this->size = size;
+  dataFormat = GL_RED;
+  dataType = GL_FLOAT;
+  textureFormat = GL_R32F;
+
+  // Make sure none of the texture slots bound to the device are modified...
+  MakeActive(RenderState::MaxTextures);
+  Bind();
+  CALLONEXIT(glBindTexture, type, 0);
+
+  // Vertices fetch their texel directly, so there is no filtering or mip chain...
+  glTexImage3D(type, 0, textureFormat, size, size, layers, 0, dataFormat, dataType, NULL);
+  glTexParameteri(type, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(type, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(type, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // Hand out the lowest layers first...
+  freeLayers.clear();
+  for (int layer = (int)layers - 1; layer >= 0; --layer)
+  {
+    freeLayers.push_back(layer);
+  }
+
+  LOG("terrain height pool: %u layers of %ux%u\n", layers, size, size);
+}
+
+//------------------------------------------------------------------------
+int TerrainHeightPool::Allocate(const float* const heights)
+{
+  if (freeLayers.empty())
+  {
+    return -1;
+  }
+
+  const int layer = freeLayers.back();
+  freeLayers.pop_back();
+
+  MakeActive(RenderState::MaxTextures);
+  Bind();
+  CALLONEXIT(glBindTexture, type, 0);
+  glTexSubImage3D(type, 0, 0, 0, layer, size, size, 1, dataFormat, dataType, heights);
+
+  return layer;
+}
+
+//------------------------------------------------------------------------
+void TerrainHeightPool::Release(int layer)
+{
+  if (layer >= 0)
+  {
+    freeLayers.push_back(layer);
+  }
+}
@@ -24,8 +24,10 @@
 #include <vector>
 #include <logging.h>
 #include <terrain/terrain.h>
+#include <core/indexoptimiser.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/ref.hpp>
 
 //---------------------------------------------------------------
 
@@ -50,17 +52,28 @@ static const glm::vec3 quadrantOffsets[] =
 // Constants defining the basic grid geometry...
 static const size_t gridSize = 17;
 static const size_t vertexCount = gridSize * gridSize;
-static const size_t indexCount = 2 * gridSize * (gridSize - 1);
+
+// The grid is drawn as vertical bands narrow enough that both rows of a strip fit in the
+// post-transform cache, so each row of vertices is still cached when the next strip reuses it. Each row of a band is one
+// strip, ended with a restart index.
+static const size_t bandCount = ((gridSize - 2) / ((IndexOptimiser::DefaultCacheSize / 2) - 1)) + 1;
+static const size_t indexCount = (gridSize - 1) * ((2 * (gridSize - 1 + bandCount)) + bandCount);
+
+// Node heights: the most nodes which can exist at once, and the texture slot the pool is
+// bound to for drawing.
+static const size_t heightPoolLayers = 512;
+static const size_t heightPoolSlot = 0;
 
 //---------------------------------------------------------------
 
 static void BuildGeometry(VertexArray& geometry);
 static void BuildGrid(int size, TerrainVertex vertices[]);
 static void BuildIndices(int size, unsigned short indices[]);
+static int CreateHeights(const glm::vec3& centre, float width, TerrainHeightPool& heightPool);
 
 //---------------------------------------------------------------
 
-Terrain::Node::Node(float width, size_t startLoDLevel)
+Terrain::Node::Node(float width, size_t startLoDLevel, TerrainHeightPool& heightPool)
   : parent(NULL),
     width(width),
     lodLevel(startLoDLevel),
@@ -72,9 +85,10 @@ Terrain::Node::Node(float width, size_t startLoDLevel)
   {
     corners[q] = quadrantOffsets[q] * width * 0.5f;
   }
+  heightLayer = CreateHeights(centre, width, heightPool);
 }
 
-Terrain::Node::Node(const Node* const parent, size_t corner)
+Terrain::Node::Node(const Node* const parent, size_t corner, TerrainHeightPool& heightPool)
   : parent(parent),
     width(parent->width * 0.5f),
     lodLevel(parent->lodLevel - 1),
@@ -86,21 +100,23 @@ Terrain::Node::Node(const Node* const parent, size_t corner)
   {
     corners[q] = centre + (quadrantOffsets[q] * width * 0.5f);
   }
+  heightLayer = CreateHeights(centre, width, heightPool);
 }
 
-void Terrain::Node::Split()
+void Terrain::Node::Split(TerrainHeightPool& heightPool)
 {
-  // Don't go past maximum LOD level and don't duplicate child nodes...
-  if ((lodLevel > 0) && (!children[0]))
+  // Don't go past maximum LOD level and don't duplicate child nodes. A node whose children
+  // wouldn't all get heights stays as it is until others are merged away...
+  if ((lodLevel > 0) && (!children[0]) && (heightPool.FreeLayers() >= 4))
   {
     for (size_t q = 0; q < 4; ++q)
     {
-      children[q] = boost::make_shared<Node>(this, q);
+      children[q] = boost::make_shared<Node>(this, q, boost::ref(heightPool));
     }
   }
 }
 
-void Terrain::Node::Merge()
+void Terrain::Node::Merge(TerrainHeightPool& heightPool)
 {
   // Can't merge if already at root of quadtree...
   if (parent)
@@ -110,7 +126,8 @@ void Terrain::Node::Merge()
     {
       for (size_t q = 0; q < 4; ++q)
       {
-        children[q]->Merge();
+        children[q]->Merge(heightPool);
+        heightPool.Release(children[q]->heightLayer);
         children[q].reset();
       }
     }
@@ -148,7 +165,10 @@ bool Terrain::Initialise()
   if (!effect.Load("assets\\effects\\terrain.glsl", "Terrain")) { return false; }
   effect.MaxHeight->Set(abs(heightRange.x + heightRange.y));
 
-  rootNode = boost::make_shared<Node>(width, maxLodLevel);
+  heightPool.Initialise(gridSize, heightPoolLayers);
+  effect.HeightPool->Set((int)heightPoolSlot);
+
+  rootNode = boost::make_shared<Node>(width, maxLodLevel, boost::ref(heightPool));
 
   BuildGeometry(geometry);
 
@@ -183,9 +203,13 @@ void Terrain::Draw(SceneState& sceneState)
   visibleNodes.clear();
   GetVisibleNodes(sceneState, rootNode.get());
 
+  TerrainHeightPool::MakeActive(heightPoolSlot);
+  heightPool.Bind();
+
   for (size_t i = 0; i < visibleNodes.size(); ++i)
   {
     effect.WorldMatrix->Set(visibleNodes[i]->transform);
+    effect.HeightLayer->Set(visibleNodes[i]->heightLayer);
 
     sceneState.device->Draw(GL_TRIANGLE_STRIP, 0, indexCount, renderState);
   }
@@ -253,7 +277,7 @@ void Terrain::GetVisibleNodes(const SceneState& sceneState, Node* const node)
   if (rho >= maxError)
   {
     // Sub-divide the node if necessary and recurse into the child nodes to check them for visibility...
-    node->Split();
+    node->Split(heightPool);
     for (size_t i = 0; i < 4; ++i)
     {
       GetVisibleNodes(sceneState, node->children[i].get());
@@ -277,24 +301,20 @@ void Terrain::GetVisibleNodes(const SceneState& sceneState, Node* const node)
 // @return a value in the range [0, 2]
 static float ComputeHeight(glm::vec3 p, float octaves, float roughness, float lacunarity, float offset)
 {
-  // save some computation time by caching the exponent table...
+  // clamp input, leaving room for the fractional octave:
   static const size_t MaxOctaves = 20;
-  static float exponents[MaxOctaves];
-  static bool firstTime = true;
-  if (firstTime)
+  octaves = glm::clamp(octaves, 1.0f, float(MaxOctaves - 1));
+
+  // the exponent table depends on the parameters, so is built for each call (it's cheap
+  // next to the noise, and nothing is shared between threads)...
+  float exponents[MaxOctaves];
+  float frequency = 1;
+  for (size_t i = 0; i <= (size_t)octaves; ++i)
   {
-    firstTime = false;
-    float frequency = 1;
-    for (size_t i = 0; i < MaxOctaves; ++i)
-    {
-      exponents[i] = glm::pow(frequency, -roughness);
-      frequency *= lacunarity;
-    }
+    exponents[i] = glm::pow(frequency, -roughness);
+    frequency *= lacunarity;
   }
 
-  // clamp input:
-  octaves = glm::max(octaves, (float)MaxOctaves);
-
   // 1st octave...
   float result = (glm::noise1(p) + offset) * exponents[0];
   float weight = result;
@@ -328,6 +348,54 @@ static float ComputeHeight(glm::vec3 p, float octaves, float roughness, float la
 
 //---------------------------------------------------------------
 
+// Fractional Brownian motion: octaves of noise, each at lacunarity times the frequency of
+// the last and with amplitude falling off by maxRoughness.
+static float FractalHeight(glm::vec2 point, float maxRoughness, float lacunarity, float octaves)
+{
+  float value = 0;
+  int i;
+  for (i = 0; i < int(octaves); ++i)
+  {
+    value += glm::noise1(point) * glm::pow(lacunarity, -maxRoughness * i);
+    point *= lacunarity;
+  }
+  const float remainder = octaves - int(octaves);
+  if (remainder > 0)
+  {
+    value += remainder * glm::noise1(point) * glm::pow(lacunarity, -maxRoughness * i);
+  }
+  return value;
+}
+
+//---------------------------------------------------------------
+
+// Evaluate a node's heights, one per grid vertex in the same order as BuildGrid's positions
+// map onto texels (x along +X, y along +Z), and store them in the pool.
+// Returns the node's layer in the pool.
+static int CreateHeights(const glm::vec3& centre, float width, TerrainHeightPool& heightPool)
+{
+  float heights[vertexCount];
+  const float increment = 1.0f / (float)(gridSize - 1);
+  for (size_t y = 0; y < gridSize; ++y)
+  {
+    for (size_t x = 0; x < gridSize; ++x)
+    {
+      const glm::vec2 offset(-0.5f + (x * increment), -0.5f + (y * increment));
+      const glm::vec2 p = glm::vec2(centre.x, centre.z) + (offset * width);
+      heights[x + (y * gridSize)] = FractalHeight(p, 0.8f, 0.516273f, 6.3f);
+    }
+  }
+
+  const int layer = heightPool.Allocate(heights);
+  if (layer < 0)
+  {
+    LOG("terrain: height pool exhausted\n");
+  }
+  return layer;
+}
+
+//---------------------------------------------------------------
+
 static void BuildGrid(int size, TerrainVertex vertices[])
 {
   const float increment = 1.0f / (float)(size - 1);
@@ -344,25 +412,21 @@ static void BuildGrid(int size, TerrainVertex vertices[])
 //---------------------------------------------------------------
 static void BuildIndices(int size, unsigned short indices[])
 {
+  const int bandWidth = ((size - 1) + (int)bandCount - 1) / (int)bandCount;
+
   int i = 0;
-  int z = 0;
-  while (z < (size - 1))
+  for (int bandStart = 0; bandStart < (size - 1); bandStart += bandWidth)
   {
-    for (int x = 0; x < size; ++x)
-    {
-      indices[i++] = x + (z * size);
-      indices[i++] = x + ((z + 1) * size);
-    }
-    ++z;
-    if (z < (size - 1))
+    const int bandEnd = glm::min(bandStart + bandWidth, size - 1);
+    for (int z = 0; z < (size - 1); ++z)
     {
-      for (int x = size - 1; x >= 0; --x)
+      for (int x = bandStart; x <= bandEnd; ++x)
       {
-        indices[i++] = x + ((z + 1) * size);
         indices[i++] = x + (z * size);
+        indices[i++] = x + ((z + 1) * size);
       }
+      indices[i++] = IndexOptimiser::RestartIndex;
     }
-    ++z;
   }
 }
 
@@ -384,6 +448,11 @@ static void BuildGeometry(VertexArray& geometry)
 
   unsigned short indices[indexCount];
   BuildIndices(gridSize, indices);
+  {
+    const std::vector<unsigned short> banded(indices, indices + indexCount);
+    const IndexOptimiser::CacheStats stats = IndexOptimiser::Measure(banded, vertexCount, GL_TRIANGLE_STRIP);
+    LOG("terrain grid: %u triangles, ACMR %.3f, ATVR %.3f\n", stats.triangles, stats.acmr, stats.atvr);
+  }
   boost::shared_ptr<IndexBuffer> indexBuffer(new IndexBuffer());
   indexBuffer->Initialise(indexCount, GL_UNSIGNED_SHORT, GL_STATIC_DRAW, indices);
 